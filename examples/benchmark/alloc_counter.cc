@@ -0,0 +1,133 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file replaces the global operator new and delete with versions that
+// count calls and bytes.  Each block carries a small header holding its size
+// such that delete can maintain the live byte count.  The counters are not
+// thread safe.
+
+#include "alloc_counter.h"
+#include <stdlib.h>
+#include <new>
+
+namespace {
+
+size_t allocation_count = 0;
+size_t allocated_bytes = 0;
+size_t live_bytes = 0;
+size_t peak_live_bytes = 0;
+
+// The header is sized to preserve malloc's alignment guarantee.
+const size_t kHeaderSize = 16;
+
+void* CountedAlloc(size_t size) {
+  ++allocation_count;
+  allocated_bytes += size;
+  live_bytes += size;
+  if (live_bytes > peak_live_bytes) {
+    peak_live_bytes = live_bytes;
+  }
+  char* block = static_cast<char*>(malloc(size + kHeaderSize));
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  *reinterpret_cast<size_t*>(block) = size;
+  return block + kHeaderSize;
+}
+
+void CountedFree(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  char* block = static_cast<char*>(ptr) - kHeaderSize;
+  live_bytes -= *reinterpret_cast<size_t*>(block);
+  free(block);
+}
+
+}  // end anonymous namespace
+
+void* operator new(size_t size) throw(std::bad_alloc) {
+  return CountedAlloc(size);
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc) {
+  return CountedAlloc(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw() {
+  try {
+    return CountedAlloc(size);
+  } catch (const std::bad_alloc&) {
+    return NULL;
+  }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw() {
+  try {
+    return CountedAlloc(size);
+  } catch (const std::bad_alloc&) {
+    return NULL;
+  }
+}
+
+void operator delete(void* ptr) throw() {
+  CountedFree(ptr);
+}
+
+void operator delete[](void* ptr) throw() {
+  CountedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) throw() {
+  CountedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) throw() {
+  CountedFree(ptr);
+}
+
+namespace benchmark {
+
+size_t GetAllocationCount() {
+  return allocation_count;
+}
+
+size_t GetAllocatedBytes() {
+  return allocated_bytes;
+}
+
+size_t GetLiveBytes() {
+  return live_bytes;
+}
+
+size_t GetPeakLiveBytes() {
+  return peak_live_bytes;
+}
+
+void ResetPeakLiveBytes() {
+  peak_live_bytes = live_bytes;
+}
+
+}  // end namespace benchmark
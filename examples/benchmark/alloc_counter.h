@@ -0,0 +1,76 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file declares the allocation counters shared by the benchmark
+// programs.  alloc_counter.cc replaces the global operator new and delete
+// so any program linking it counts every C++ heap allocation.
+
+#ifndef EXAMPLES_BENCHMARK_ALLOC_COUNTER_H__
+#define EXAMPLES_BENCHMARK_ALLOC_COUNTER_H__
+
+#include <stddef.h>
+
+namespace benchmark {
+
+// The number of calls to operator new since program start.
+size_t GetAllocationCount();
+
+// The number of bytes requested of operator new since program start.
+size_t GetAllocatedBytes();
+
+// The number of bytes currently allocated through operator new.  This is
+// an approximation of the program's live C++ heap.
+size_t GetLiveBytes();
+
+// The high water mark of GetLiveBytes().  ResetPeakLiveBytes() sets the
+// mark to the current value of GetLiveBytes().
+size_t GetPeakLiveBytes();
+void ResetPeakLiveBytes();
+
+// A snapshot of the counters used to measure a span of code:
+// AllocationScope scope;
+// DoSomething();
+// std::cout << scope.allocations() << " allocations";
+class AllocationScope {
+ public:
+  AllocationScope()
+    : allocations_(GetAllocationCount()),
+      bytes_(GetAllocatedBytes()) {
+  }
+  size_t allocations() const {
+    return GetAllocationCount() - allocations_;
+  }
+  size_t bytes() const {
+    return GetAllocatedBytes() - bytes_;
+  }
+
+ private:
+  size_t allocations_;
+  size_t bytes_;
+};
+
+}  // end namespace benchmark
+
+#endif  // EXAMPLES_BENCHMARK_ALLOC_COUNTER_H__
@@ -0,0 +1,107 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This program compares the time taken to build the Element hierarchy of
+// each of the given KML files by kmldom::Parse() of its XML with that taken
+// by kmlengine::LoadBinary() of its binary snapshot, and the size of each.
+// Each file is loaded the given number of times (default 100) by each
+// function.  Parse() defers the decoding of <coordinates> until they are
+// accessed whereas LoadBinary() builds the tuples:
+//
+// $ ./examples/benchmark/binarybench [-n count] testdata/kml/*.kml
+
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include "kml/base/file.h"
+#include "kml/base/time_util.h"
+#include "kml/dom.h"
+#include "kml/engine.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+int main(int argc, char** argv) {
+  int first = 1;
+  int count = 100;
+  if (argc > 2 && string(argv[1]) == "-n") {
+    count = atoi(argv[2]);
+    first = 3;
+  }
+  if (first >= argc || count < 1) {
+    cerr << "usage: " << argv[0] << " [-n count] file.kml..." << endl;
+    return 1;
+  }
+  size_t xml_bytes = 0;
+  size_t binary_bytes = 0;
+  double parse_seconds = 0;
+  double load_seconds = 0;
+  int files = 0;
+  for (int i = first; i < argc; ++i) {
+    string xml;
+    if (!kmlbase::File::ReadFileToString(argv[i], &xml)) {
+      continue;
+    }
+    kmldom::ElementPtr root = kmldom::Parse(xml, NULL);
+    if (!root) {
+      continue;
+    }
+    string binary;
+    kmlengine::SaveBinary(root, &binary);
+    // The snapshot of what loads is the snapshot loaded.
+    string reloaded;
+    kmlengine::SaveBinary(kmlengine::LoadBinary(binary), &reloaded);
+    if (reloaded != binary) {
+      cerr << "round trip differs: " << argv[i] << endl;
+      return 1;
+    }
+    ++files;
+    xml_bytes += xml.size();
+    binary_bytes += binary.size();
+    double start = kmlbase::GetMicroTime();
+    for (int n = 0; n < count; ++n) {
+      kmldom::Parse(xml, NULL);
+    }
+    parse_seconds += kmlbase::GetMicroTime() - start;
+    start = kmlbase::GetMicroTime();
+    for (int n = 0; n < count; ++n) {
+      kmlengine::LoadBinary(binary);
+    }
+    load_seconds += kmlbase::GetMicroTime() - start;
+  }
+  if (files == 0) {
+    cerr << "no file parsed" << endl;
+    return 1;
+  }
+  cout << files << " files, each loaded " << count << " times" << endl;
+  cout << "Parse:      " << xml_bytes << " bytes, " << parse_seconds * 1000
+       << " ms" << endl;
+  cout << "LoadBinary: " << binary_bytes << " bytes ("
+       << binary_bytes * 100 / xml_bytes << "%), " << load_seconds * 1000
+       << " ms (" << parse_seconds / load_seconds << "x)" << endl;
+  return 0;
+}
@@ -0,0 +1,148 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This program benchmarks Clone() of a large document whose <coordinates>
+// share their tuples with the clone until changed, against a deep copy of
+// the tuples of every <coordinates> as Clone() made before.  The document is
+// a synthetic Document of the given number of LineString Placemarks
+// (default 10000) of the given number of vertices each (default 1000):
+//
+// $ ./examples/benchmark/clonebench [placemarks] [vertices]
+
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include "kml/base/time_util.h"
+#include "kml/dom.h"
+#include "kml/engine.h"
+
+using kmlbase::Vec3;
+using kmldom::CoordinatesPtr;
+using kmldom::DocumentPtr;
+using kmldom::KmlFactory;
+using std::cout;
+using std::endl;
+
+typedef std::vector<CoordinatesPtr> CoordinatesVector;
+
+static DocumentPtr CreateDocument(size_t placemarks, size_t vertices) {
+  KmlFactory* factory = KmlFactory::GetFactory();
+  DocumentPtr document = factory->CreateDocument();
+  unsigned int state = 1;
+  for (size_t i = 0; i < placemarks; ++i) {
+    CoordinatesPtr coordinates = factory->CreateCoordinates();
+    for (size_t j = 0; j < vertices; ++j) {
+      state = state * 1103515245 + 12345;
+      const double lon = -180.0 + (state >> 8) * (360.0 / (1 << 24));
+      state = state * 1103515245 + 12345;
+      const double lat = -90.0 + (state >> 8) * (180.0 / (1 << 24));
+      coordinates->add_latlngalt(lat, lon, static_cast<double>(j % 1000));
+    }
+    kmldom::LineStringPtr linestring = factory->CreateLineString();
+    linestring->set_coordinates(coordinates);
+    kmldom::PlacemarkPtr placemark = factory->CreatePlacemark();
+    placemark->set_name("placemark");
+    placemark->set_geometry(linestring);
+    document->add_feature(placemark);
+  }
+  return document;
+}
+
+// This gathers the <coordinates> of each Placemark of the Document.
+static void GetCoordinates(const DocumentPtr& document,
+                           CoordinatesVector* coordinates_vector) {
+  for (size_t i = 0; i < document->get_feature_array_size(); ++i) {
+    kmldom::PlacemarkPtr placemark =
+        kmldom::AsPlacemark(document->get_feature_array_at(i));
+    coordinates_vector->push_back(
+        kmldom::AsLineString(placemark->get_geometry())->get_coordinates());
+  }
+}
+
+// This gives each <coordinates> of the clone its own copy of its tuples.
+static void CopyTuples(const CoordinatesVector& coordinates_vector) {
+  std::vector<Vec3> tuples;
+  for (size_t i = 0; i < coordinates_vector.size(); ++i) {
+    const CoordinatesPtr& coordinates = coordinates_vector[i];
+    tuples.clear();
+    for (size_t j = 0; j < coordinates->get_coordinates_array_size(); ++j) {
+      tuples.push_back(coordinates->get_coordinates_array_at(j));
+    }
+    coordinates->Clear();
+    for (size_t j = 0; j < tuples.size(); ++j) {
+      coordinates->add_vec3(tuples[j]);
+    }
+  }
+}
+
+// This returns the bytes of tuple storage the clone does not share.
+static size_t GetOwnedBytes(const CoordinatesVector& coordinates_vector) {
+  size_t bytes = 0;
+  for (size_t i = 0; i < coordinates_vector.size(); ++i) {
+    const CoordinatesPtr& coordinates = coordinates_vector[i];
+    if (!coordinates->is_shared()) {
+      bytes += coordinates->GetAllocatedBytes();
+    }
+  }
+  return bytes;
+}
+
+static void Report(const char* label, double seconds,
+                   const CoordinatesVector& coordinates_vector) {
+  cout << label << ": " << seconds * 1000 << " ms, "
+       << GetOwnedBytes(coordinates_vector) / (1024 * 1024)
+       << " MB of tuples not shared" << endl;
+}
+
+int main(int argc, char** argv) {
+  const size_t placemarks = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+  const size_t vertices = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000;
+  DocumentPtr document = CreateDocument(placemarks, vertices);
+
+  // Clone() alone shares every tuple.
+  double start = kmlbase::GetMicroTime();
+  DocumentPtr clone = kmldom::AsDocument(kmlengine::Clone(document));
+  const double clone_seconds = kmlbase::GetMicroTime() - start;
+  CoordinatesVector coordinates_vector;
+  GetCoordinates(clone, &coordinates_vector);
+  Report("copy-on-write clone", clone_seconds, coordinates_vector);
+
+  // An edit of the tuples of a few Placemarks copies only those.
+  start = kmlbase::GetMicroTime();
+  for (size_t i = 0; i < coordinates_vector.size(); i += 100) {
+    coordinates_vector[i]->add_latlng(0, 0);
+  }
+  Report("copy-on-write clone, 1% edited",
+         clone_seconds + kmlbase::GetMicroTime() - start, coordinates_vector);
+  coordinates_vector.clear();
+
+  // A deep copy copies every tuple.
+  start = kmlbase::GetMicroTime();
+  clone = kmldom::AsDocument(kmlengine::Clone(document));
+  GetCoordinates(clone, &coordinates_vector);
+  CopyTuples(coordinates_vector);
+  Report("deep clone", kmlbase::GetMicroTime() - start, coordinates_vector);
+  return 0;
+}
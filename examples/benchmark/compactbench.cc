@@ -0,0 +1,120 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This program compares the size of the output and the time taken by
+// SerializePretty(), SerializeRaw() and SerializeCompact() over the given
+// KML files.  SerializeCompact() is run with its default options and with 6
+// decimal places and defaults stripped.  Each file is serialized the given
+// number of times (default 100) by each function:
+//
+// $ ./examples/benchmark/compactbench [-n count] testdata/kml/*.kml
+
+#include <stdlib.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "kml/base/file.h"
+#include "kml/base/time_util.h"
+#include "kml/dom.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+// The ways of serializing compared here.
+enum Method {
+  PRETTY,
+  RAW,
+  COMPACT,
+  COMPACT_STRIPPED,
+  METHOD_COUNT
+};
+
+static const char* kMethodNames[] = {
+  "SerializePretty", "SerializeRaw", "SerializeCompact",
+  "SerializeCompact(6, strip)"
+};
+
+static string Serialize(Method method, const kmldom::ElementPtr& root) {
+  kmldom::CompactOptions options;
+  switch (method) {
+    case PRETTY:
+      return kmldom::SerializePretty(root);
+    case RAW:
+      return kmldom::SerializeRaw(root);
+    case COMPACT_STRIPPED:
+      options.coordinate_precision = 6;
+      options.strip_defaults = true;
+      // Fall through.
+    default:
+      return kmldom::SerializeCompact(root, options);
+  }
+}
+
+int main(int argc, char** argv) {
+  int first = 1;
+  int count = 100;
+  if (argc > 2 && string(argv[1]) == "-n") {
+    count = atoi(argv[2]);
+    first = 3;
+  }
+  if (first >= argc || count < 1) {
+    cerr << "usage: " << argv[0] << " [-n count] file.kml..." << endl;
+    return 1;
+  }
+  size_t bytes[METHOD_COUNT] = { 0 };
+  double seconds[METHOD_COUNT] = { 0 };
+  int files = 0;
+  for (int i = first; i < argc; ++i) {
+    string data;
+    string errors;
+    if (!kmlbase::File::ReadFileToString(argv[i], &data)) {
+      continue;
+    }
+    kmldom::ElementPtr root = kmldom::Parse(data, &errors);
+    if (!root) {
+      continue;
+    }
+    ++files;
+    for (int m = 0; m < METHOD_COUNT; ++m) {
+      const Method method = static_cast<Method>(m);
+      bytes[m] += Serialize(method, root).size();
+      const double start = kmlbase::GetMicroTime();
+      for (int n = 0; n < count; ++n) {
+        Serialize(method, root);
+      }
+      seconds[m] += kmlbase::GetMicroTime() - start;
+    }
+  }
+  cout << files << " files, each serialized " << count << " times" << endl;
+  for (int m = 0; m < METHOD_COUNT; ++m) {
+    cout << std::setw(28) << std::left << kMethodNames[m]
+         << std::setw(10) << std::right << bytes[m] << " bytes ("
+         << std::setw(3) << bytes[m] * 100 / bytes[PRETTY] << "%), "
+         << seconds[m] * 1000 << " ms" << endl;
+  }
+  return 0;
+}
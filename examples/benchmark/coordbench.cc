@@ -0,0 +1,139 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This program benchmarks the parse of <coordinates> and <gx:coord> content
+// against the strtod() based parse Coordinates used previously.  The
+// coordinates are a synthetic polygon of the given number of vertices
+// (default 1000000) printed as a typical KML writer would print them:
+//
+// $ ./examples/benchmark/coordbench [vertices]
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "kml/base/time_util.h"
+#include "kml/dom.h"
+
+using kmlbase::Vec3;
+using std::cout;
+using std::endl;
+using std::string;
+
+// The parse Coordinates::ParseVec3 used before it had its own tokenizer.
+static bool StrtodParseVec3(const char* cstr, char** nextp, Vec3* vec) {
+  bool done = false;
+  char* endp = const_cast<char*>(cstr);
+  if (*endp == ',') {
+    ++endp;
+  }
+  vec->set(0, strtod(endp, &endp));
+  while (*endp != ',') {
+    if (*endp == '\0') {
+      *nextp = endp;
+      return done;
+    }
+    ++endp;
+  }
+  vec->set(1, strtod(endp+1, &endp));
+  done = true;
+  while (isspace(*endp)) {
+    ++endp;
+  }
+  if (*endp == ',') {
+    vec->set(2, strtod(endp+1, &endp));
+  }
+  while (isspace(*endp)) {
+    ++endp;
+  }
+  *nextp = endp;
+  return done;
+}
+
+static void StrtodParse(const string& char_data, std::vector<Vec3>* out) {
+  const char* endp = char_data.c_str() + char_data.size();
+  char* next = const_cast<char*>(char_data.c_str());
+  while (next != endp) {
+    Vec3 vec;
+    if (StrtodParseVec3(next, &next, &vec)) {
+      out->push_back(vec);
+    }
+  }
+}
+
+static void Report(const char* label, double seconds, size_t vertices) {
+  cout << label << ": " << seconds * 1000 << " ms, "
+       << seconds * 1e9 / vertices << " ns/vertex" << endl;
+}
+
+int main(int argc, char** argv) {
+  const size_t vertices = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+  string coordinates("\n");
+  std::vector<string> gx_coords;
+  char buf[128];
+  unsigned int state = 1;
+  for (size_t i = 0; i < vertices; ++i) {
+    state = state * 1103515245 + 12345;
+    const double lon = -180.0 + (state >> 8) * (360.0 / (1 << 24));
+    state = state * 1103515245 + 12345;
+    const double lat = -90.0 + (state >> 8) * (180.0 / (1 << 24));
+    sprintf(buf, "%.15g,%.15g,%d\n", lon, lat, static_cast<int>(i % 1000));
+    coordinates.append(buf);
+    if (i < vertices / 10) {
+      sprintf(buf, "%.6f %.6f %.1f", lon, lat, (i % 1000) / 10.0);
+      gx_coords.push_back(buf);
+    }
+  }
+
+  double start = kmlbase::GetMicroTime();
+  std::vector<Vec3> expected;
+  StrtodParse(coordinates, &expected);
+  Report("strtod coordinates", kmlbase::GetMicroTime() - start, vertices);
+
+  kmldom::CoordinatesPtr parsed =
+      kmldom::KmlFactory::GetFactory()->CreateCoordinates();
+  start = kmlbase::GetMicroTime();
+  parsed->Parse(coordinates);
+  Report("Coordinates::Parse", kmlbase::GetMicroTime() - start, vertices);
+
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (!(expected[i] == parsed->get_coordinates_array_at(i))) {
+      cout << "mismatch at vertex " << i << endl;
+      return 1;
+    }
+  }
+
+  kmldom::GxTrackPtr gx_track =
+      kmldom::KmlFactory::GetFactory()->CreateGxTrack();
+  std::vector<Vec3> gx_coord_array;
+  start = kmlbase::GetMicroTime();
+  for (size_t i = 0; i < gx_coords.size(); ++i) {
+    gx_track->Parse(gx_coords[i], &gx_coord_array);
+  }
+  Report("GxTrack::Parse", kmlbase::GetMicroTime() - start, gx_coords.size());
+  return 0;
+}
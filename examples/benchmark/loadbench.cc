@@ -0,0 +1,107 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This program compares loading a KML or KMZ file by reading it into a
+// string for KmlFile::CreateFromParse with KmlFile::CreateFromFile which
+// parses from a memory mapping of the file, and with
+// KmlFile::CreateFromParseLazy which parses each Feature of the top-level
+// Container only when it is accessed.  The lazy method then accesses the
+// first, middle and last Feature and optionally looks up an id.  Peak memory
+// is reported as the peak resident set size of the process so each method is
+// run in its own process:
+//
+// $ ./examples/benchmark/loadbench string big.kml
+// $ ./examples/benchmark/loadbench mmap big.kml
+// $ ./examples/benchmark/loadbench lazy big.kml [id]
+
+#include <sys/resource.h>
+#include <iostream>
+#include <string>
+#include "boost/scoped_ptr.hpp"
+#include "kml/base/file.h"
+#include "kml/base/time_util.h"
+#include "kml/engine.h"
+
+using kmlengine::KmlFile;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+int main(int argc, char** argv) {
+  if (argc != 3 && !(argc == 4 && string(argv[1]) == "lazy")) {
+    cerr << "usage: " << argv[0] << " string|mmap|lazy file.kml [id]"
+         << endl;
+    return 1;
+  }
+  const string method(argv[1]);
+  const string filename(argv[2]);
+  string errors;
+  const double start = kmlbase::GetMicroTime();
+  boost::scoped_ptr<KmlFile> kml_file;
+  if (method == "string" || method == "lazy") {
+    string data;
+    if (!kmlbase::File::ReadFileToString(filename, &data)) {
+      cerr << "read failed: " << filename << endl;
+      return 1;
+    }
+    kml_file.reset(method == "lazy" ?
+                   KmlFile::CreateFromParseLazy(data, &errors) :
+                   KmlFile::CreateFromParse(data, &errors));
+  } else {
+    kml_file.reset(KmlFile::CreateFromFile(filename, &errors));
+  }
+  if (!kml_file.get()) {
+    cerr << "parse failed: " << errors << endl;
+    return 1;
+  }
+  const double seconds = kmlbase::GetMicroTime() - start;
+  cout << method << ": " << seconds * 1000 << " ms";
+
+  if (method == "lazy") {
+    const double access_start = kmlbase::GetMicroTime();
+    kmldom::ContainerPtr container =
+        kmldom::AsContainer(kml_file->get_root());
+    if (kmldom::KmlPtr kml = kmldom::AsKml(kml_file->get_root())) {
+      container = kmldom::AsContainer(kml->get_feature());
+    }
+    const size_t size = container ? container->get_feature_array_size() : 0;
+    if (size > 0) {
+      container->get_feature_array_at(0);
+      container->get_feature_array_at(size / 2);
+      container->get_feature_array_at(size - 1);
+    }
+    if (argc == 4 && !kml_file->GetObjectById(argv[3])) {
+      cerr << "no such id: " << argv[3] << endl;
+    }
+    cout << ", access " << (kmlbase::GetMicroTime() - access_start) * 1000
+         << " ms";
+  }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  cout << ", peak RSS " << usage.ru_maxrss << " KB" << endl;
+  return 0;
+}
@@ -0,0 +1,99 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This program times kmldom::ParseParallel against kmldom::Parse for the
+// given KML file on 1, 2, 4, ... threads up to the given maximum (default
+// the number of processors) and checks that each parse produces the same
+// KML.  It then does the same for kmldom::SerializePrettyParallel against
+// kmldom::SerializePretty:
+//
+// $ ./examples/benchmark/parallelbench big.kml [max-threads]
+
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include "kml/base/file.h"
+#include "kml/base/thread.h"
+#include "kml/base/time_util.h"
+#include "kml/dom.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+int main(int argc, char** argv) {
+  if (argc != 2 && argc != 3) {
+    cerr << "usage: " << argv[0] << " file.kml [max-threads]" << endl;
+    return 1;
+  }
+  string kml;
+  if (!kmlbase::File::ReadFileToString(argv[1], &kml)) {
+    cerr << "read failed: " << argv[1] << endl;
+    return 1;
+  }
+  const size_t max_threads = argc == 3 ? atoi(argv[2]) :
+      kmlbase::GetProcessorCount();
+
+  string errors;
+  double start = kmlbase::GetMicroTime();
+  kmldom::ElementPtr root = kmldom::Parse(kml, &errors);
+  const double sequential = kmlbase::GetMicroTime() - start;
+  if (!root) {
+    cerr << "parse failed: " << errors << endl;
+    return 1;
+  }
+  const string expected = kmldom::SerializeRaw(root);
+  root = NULL;
+  cout << "Parse: " << sequential * 1000 << " ms" << endl;
+
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    start = kmlbase::GetMicroTime();
+    root = kmldom::ParseParallel(kml, threads, &errors);
+    const double parallel = kmlbase::GetMicroTime() - start;
+    const bool same = root && kmldom::SerializeRaw(root) == expected;
+    root = NULL;
+    cout << "ParseParallel " << threads << " threads: " << parallel * 1000
+         << " ms, speedup " << sequential / parallel
+         << (same ? "" : " (DIFFERENT RESULT)") << endl;
+  }
+
+  root = kmldom::Parse(kml, &errors);
+  start = kmlbase::GetMicroTime();
+  const string pretty = kmldom::SerializePretty(root);
+  const double sequential_serialize = kmlbase::GetMicroTime() - start;
+  cout << "SerializePretty: " << sequential_serialize * 1000 << " ms" << endl;
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    start = kmlbase::GetMicroTime();
+    const string parallel_pretty =
+        kmldom::SerializePrettyParallel(root, threads);
+    const double parallel = kmlbase::GetMicroTime() - start;
+    cout << "SerializePrettyParallel " << threads << " threads: "
+         << parallel * 1000 << " ms, speedup "
+         << sequential_serialize / parallel
+         << (parallel_pretty == pretty ? "" : " (DIFFERENT RESULT)") << endl;
+  }
+  return 0;
+}
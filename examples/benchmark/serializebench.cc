@@ -0,0 +1,156 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This program benchmarks the formatting of doubles by FormatDouble()
+// against the std::stringstream ToString() used before, and then the
+// serialization of a synthetic Document of the given number of LineString
+// Placemarks (default 10000) of the given number of vertices each (default
+// 100).  The heap allocations made by each serialization are counted:
+//
+// $ ./examples/benchmark/serializebench [placemarks] [vertices]
+
+#include <stdlib.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "alloc_counter.h"
+#include "kml/base/number_format.h"
+#include "kml/base/time_util.h"
+#include "kml/dom.h"
+
+using kmldom::KmlFactory;
+using std::cout;
+using std::endl;
+using std::string;
+
+// This is how ToString() formatted a double before FormatDouble().
+static string StreamFormat(double value) {
+  std::stringstream ss;
+  ss.precision(15);
+  ss << value;
+  return ss.str();
+}
+
+static kmldom::DocumentPtr CreateDocument(size_t placemarks,
+                                          size_t vertices) {
+  KmlFactory* factory = KmlFactory::GetFactory();
+  kmldom::DocumentPtr document = factory->CreateDocument();
+  unsigned int state = 1;
+  for (size_t i = 0; i < placemarks; ++i) {
+    kmldom::CoordinatesPtr coordinates = factory->CreateCoordinates();
+    for (size_t j = 0; j < vertices; ++j) {
+      state = state * 1103515245 + 12345;
+      const double lon = (static_cast<int>(state % 360000000) - 180000000) /
+          1e6;
+      state = state * 1103515245 + 12345;
+      const double lat = (static_cast<int>(state % 180000000) - 90000000) /
+          1e6;
+      coordinates->add_latlngalt(lat, lon, static_cast<double>(j % 1000));
+    }
+    kmldom::LineStringPtr linestring = factory->CreateLineString();
+    linestring->set_coordinates(coordinates);
+    linestring->set_tessellate(true);
+    linestring->set_altitudemode(kmldom::ALTITUDEMODE_ABSOLUTE);
+    kmldom::PlacemarkPtr placemark = factory->CreatePlacemark();
+    placemark->set_name("placemark");
+    placemark->set_description(i % 2 ? "a <b>bold</b> line" : "a line");
+    placemark->set_styleurl("#style");
+    placemark->set_geometry(linestring);
+    document->add_feature(placemark);
+  }
+  return document;
+}
+
+static void Report(const char* label, double seconds, size_t count,
+                   const char* unit) {
+  cout << label << ": " << seconds * 1000 << " ms, "
+       << seconds * 1e9 / count << " ns/" << unit << endl;
+}
+
+static void ReportAllocations(const benchmark::AllocationScope& scope,
+                              size_t placemarks) {
+  cout << "  " << scope.allocations() << " allocations, "
+       << static_cast<double>(scope.allocations()) / placemarks
+       << " per Placemark" << endl;
+}
+
+int main(int argc, char** argv) {
+  const size_t placemarks = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+  const size_t vertices = argc > 2 ? strtoul(argv[2], NULL, 10) : 100;
+
+  // Coordinates as printed to 6 decimal places and of full precision.
+  std::vector<double> short_values;
+  std::vector<double> long_values;
+  unsigned int state = 1;
+  for (size_t i = 0; i < 1000000; ++i) {
+    state = state * 1103515245 + 12345;
+    short_values.push_back(
+        (static_cast<int>(state % 360000000) - 180000000) / 1e6);
+    long_values.push_back(-180.0 + state * (360.0 / 4294967296.0));
+  }
+  size_t length = 0;
+  for (int i = 0; i < 2; ++i) {
+    const std::vector<double>& values = i == 0 ? short_values : long_values;
+    cout << (i == 0 ? "6 decimal places" : "full precision") << endl;
+    double start = kmlbase::GetMicroTime();
+    for (size_t j = 0; j < values.size(); ++j) {
+      length += StreamFormat(values[j]).size();
+    }
+    Report("  std::stringstream", kmlbase::GetMicroTime() - start,
+           values.size(), "double");
+    char buf[kmlbase::kMaxDoubleLength];
+    start = kmlbase::GetMicroTime();
+    for (size_t j = 0; j < values.size(); ++j) {
+      length += kmlbase::FormatDouble(values[j], buf);
+    }
+    Report("  FormatDouble", kmlbase::GetMicroTime() - start, values.size(),
+           "double");
+    start = kmlbase::GetMicroTime();
+    for (size_t j = 0; j < values.size(); ++j) {
+      length += kmlbase::FormatDoubleFixed(values[j], 6, buf);
+    }
+    Report("  FormatDoubleFixed", kmlbase::GetMicroTime() - start,
+           values.size(), "double");
+  }
+
+  kmldom::DocumentPtr document = CreateDocument(placemarks, vertices);
+  // The schema is built on first use.  This is left out of the counts.
+  kmldom::SerializeRaw(KmlFactory::GetFactory()->CreatePlacemark());
+  benchmark::AllocationScope pretty_scope;
+  double start = kmlbase::GetMicroTime();
+  const string pretty = kmldom::SerializePretty(document);
+  Report("SerializePretty", kmlbase::GetMicroTime() - start,
+         placemarks * vertices, "vertex");
+  ReportAllocations(pretty_scope, placemarks);
+  benchmark::AllocationScope raw_scope;
+  start = kmlbase::GetMicroTime();
+  const string raw = kmldom::SerializeRaw(document);
+  Report("SerializeRaw", kmlbase::GetMicroTime() - start,
+         placemarks * vertices, "vertex");
+  ReportAllocations(raw_scope, placemarks);
+  cout << pretty.size() + raw.size() + length << " bytes" << endl;
+  return 0;
+}
@@ -0,0 +1,158 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This program benchmarks the kmldom::Xsd lookups used on every start tag
+// (ElementId), every serialized tag (ElementName) and every enumerated field
+// (EnumId), then the parse and serialization of each given KML file:
+//
+// $ ./examples/benchmark/xsdbench testdata/kml/*.kml
+//
+// The lookups are compared against the std::map<string,int> approach used
+// before Xsd used a perfect hash.
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "kml/base/file.h"
+#include "kml/base/time_util.h"
+#include "kml/dom.h"
+#include "kml/dom/xsd.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+static const int kLookupIterations = 10000;
+static const int kFileIterations = 20;
+
+// Prints the time per call in nanoseconds.
+static void ReportLookup(const char* label, double seconds, size_t calls) {
+  cout << label << ": " << seconds * 1e9 / calls << " ns/call" << endl;
+}
+
+static void BenchmarkLookups() {
+  const kmldom::Xsd* xsd = kmldom::Xsd::GetSchema();
+  std::vector<string> names;
+  std::map<string, int> name_map;
+  for (int id = kmldom::Type_Unknown + 1; id < kmldom::Type_Invalid; ++id) {
+    names.push_back(xsd->ElementName(id));
+    name_map[xsd->ElementName(id)] = id;
+  }
+  // Add some names unknown to KML as found in typical files.
+  names.push_back("html");
+  names.push_back("atom:link");
+  names.push_back("Placemarks");
+  const size_t calls = names.size() * kLookupIterations;
+
+  int sum = 0;
+  double start = kmlbase::GetMicroTime();
+  for (int i = 0; i < kLookupIterations; ++i) {
+    for (size_t n = 0; n < names.size(); ++n) {
+      sum += xsd->ElementId(names[n]);
+    }
+  }
+  ReportLookup("Xsd::ElementId", kmlbase::GetMicroTime() - start, calls);
+
+  start = kmlbase::GetMicroTime();
+  for (int i = 0; i < kLookupIterations; ++i) {
+    for (size_t n = 0; n < names.size(); ++n) {
+      std::map<string, int>::const_iterator iter = name_map.find(names[n]);
+      sum += iter == name_map.end() ? 0 : iter->second;
+    }
+  }
+  ReportLookup("std::map find", kmlbase::GetMicroTime() - start, calls);
+
+  size_t length = 0;
+  start = kmlbase::GetMicroTime();
+  for (int i = 0; i < kLookupIterations; ++i) {
+    for (int id = 0; id < kmldom::Type_Invalid; ++id) {
+      length += xsd->ElementName(id).size();
+    }
+  }
+  ReportLookup("Xsd::ElementName", kmlbase::GetMicroTime() - start,
+               kLookupIterations * kmldom::Type_Invalid);
+
+  // Copying the name models ElementName() returning by value.
+  start = kmlbase::GetMicroTime();
+  for (int i = 0; i < kLookupIterations; ++i) {
+    for (int id = 0; id < kmldom::Type_Invalid; ++id) {
+      string name(xsd->ElementName(id));
+      length += name.size();
+    }
+  }
+  ReportLookup("ElementName by value", kmlbase::GetMicroTime() - start,
+               kLookupIterations * kmldom::Type_Invalid);
+
+  const string kEnumValue("relativeToGround");
+  start = kmlbase::GetMicroTime();
+  for (int i = 0; i < kLookupIterations * 100; ++i) {
+    sum += xsd->EnumId(kmldom::Type_altitudeMode, kEnumValue);
+  }
+  ReportLookup("Xsd::EnumId", kmlbase::GetMicroTime() - start,
+               kLookupIterations * 100);
+
+  // Keep the optimizer from discarding the loops.
+  if (sum == 0 || length == 0) {
+    cout << endl;
+  }
+}
+
+static void BenchmarkFile(const char* filename) {
+  string kml;
+  if (!kmlbase::File::ReadFileToString(filename, &kml)) {
+    cerr << "read failed: " << filename << endl;
+    return;
+  }
+  kmldom::ElementPtr root;
+  double start = kmlbase::GetMicroTime();
+  for (int i = 0; i < kFileIterations; ++i) {
+    root = kmldom::Parse(kml, NULL);
+  }
+  double parse_seconds = (kmlbase::GetMicroTime() - start) / kFileIterations;
+  if (!root) {
+    cerr << "parse failed: " << filename << endl;
+    return;
+  }
+  size_t size = 0;
+  start = kmlbase::GetMicroTime();
+  for (int i = 0; i < kFileIterations; ++i) {
+    size += kmldom::SerializePretty(root).size();
+  }
+  double serialize_seconds =
+      (kmlbase::GetMicroTime() - start) / kFileIterations;
+  cout << filename << ": " << kml.size() << " bytes, parse "
+       << parse_seconds * 1e6 << " us, serialize "
+       << serialize_seconds * 1e6 << " us" << endl;
+}
+
+int main(int argc, char** argv) {
+  BenchmarkLookups();
+  for (int i = 1; i < argc; ++i) {
+    BenchmarkFile(argv[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,120 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This program prints the memory held by the DOM of a KML file by
+// KmlDomType as computed by kmlengine::ComputeMemoryUsage().  The file may
+// be parsed into an Arena which interns strings (-a) and with the decoding
+// of <coordinates> deferred (-d) to compare the memory of these options.
+// For example:
+//   memoryusage -a -d big.kml
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "kml/base/file.h"
+#include "kml/dom.h"
+#include "kml/dom/xsd.h"
+#include "kml/engine.h"
+
+using kmlengine::ElementMemoryUsage;
+using kmlengine::ElementMemoryUsageMap;
+using kmlengine::MemoryUsage;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::setw;
+
+static void PrintRow(const std::string& name, const ElementMemoryUsage& usage) {
+  cout << std::left << setw(28) << name << std::right
+       << setw(10) << usage.element_count
+       << setw(14) << usage.object_bytes
+       << setw(14) << usage.string_bytes
+       << setw(14) << usage.coordinates_bytes
+       << setw(12) << usage.unknown_bytes
+       << setw(12) << usage.attribute_bytes
+       << setw(14) << usage.GetTotal() << endl;
+}
+
+static void PrintMemoryUsage(const MemoryUsage& memory_usage) {
+  cout << std::left << setw(28) << "type" << std::right
+       << setw(10) << "count"
+       << setw(14) << "objects"
+       << setw(14) << "strings"
+       << setw(14) << "coordinates"
+       << setw(12) << "unknown"
+       << setw(12) << "attributes"
+       << setw(14) << "total" << endl;
+  const kmldom::Xsd* xsd = kmldom::Xsd::GetSchema();
+  ElementMemoryUsageMap::const_iterator iter =
+      memory_usage.element_usage.begin();
+  for (; iter != memory_usage.element_usage.end(); ++iter) {
+    // The name with the type id as some types share a name.
+    std::stringstream name;
+    name << xsd->ElementName(iter->first) << " (" << iter->first << ")";
+    PrintRow(name.str(), iter->second);
+  }
+  PrintRow("(all elements)", memory_usage.GetElementTotal());
+  cout << endl
+       << "object id map:      " << memory_usage.object_id_map_bytes << endl
+       << "shared style map:   " << memory_usage.shared_style_map_bytes << endl
+       << "link parent vector: " << memory_usage.link_parent_vector_bytes
+       << endl
+       << "total:              " << memory_usage.GetTotal() << endl;
+}
+
+int main(int argc, char** argv) {
+  kmldom::ParseOptions options;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+    const std::string flag(argv[arg]);
+    if (flag == "-a") {
+      options.arena = new kmldom::Arena;
+      options.arena->set_intern_strings(true);
+    } else if (flag == "-d") {
+      options.defer_coordinates = true;
+    } else {
+      break;
+    }
+  }
+  if (arg != argc - 1) {
+    cerr << "usage: " << argv[0] << " [-a] [-d] file.kml" << endl;
+    return 1;
+  }
+  std::string kml_data;
+  if (!kmlbase::File::ReadFileToString(argv[arg], &kml_data)) {
+    cerr << "read failed: " << argv[arg] << endl;
+    return 1;
+  }
+  std::string errors;
+  kmlengine::KmlFilePtr kml_file =
+      kmlengine::KmlFile::CreateFromParse(kml_data, options, &errors);
+  if (!kml_file) {
+    cerr << "parse failed: " << errors << endl;
+    return 1;
+  }
+  PrintMemoryUsage(kmlengine::ComputeMemoryUsage(*kml_file));
+  return 0;
+}
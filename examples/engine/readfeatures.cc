@@ -0,0 +1,93 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This example shows how KmlFeatureReader is used to read the Features of an
+// extremely large file one at a time.  Unlike the ParserObserver used in
+// streamkml each Feature is pulled from the reader in a simple loop and the
+// Documents and Folders enclosing it are available.
+
+#include <iostream>
+#include <string>
+#include "boost/scoped_ptr.hpp"
+#include "kml/dom.h"
+#include "kml/engine.h"
+
+using kmldom::FeaturePtr;
+using kmldom::KmlFactory;
+using kmldom::LatLonBoxPtr;
+using kmldom::SerializePretty;
+using kmlengine::Bbox;
+using kmlengine::ContainerPath;
+using kmlengine::KmlFeatureReader;
+
+static int ReadFeatures(const char* filename) {
+  std::string errors;
+  boost::scoped_ptr<KmlFeatureReader> reader(
+      KmlFeatureReader::CreateFromFile(filename, &errors));
+  if (!reader.get()) {
+    std::cerr << errors << std::endl;
+    return 1;
+  }
+
+  Bbox bbox;
+  int feature_count = 0;
+  while (reader->Next()) {
+    const FeaturePtr& feature = reader->get_feature();
+    if (++feature_count % 10000 == 0) {
+      const ContainerPath& path = reader->get_container_path();
+      for (size_t i = 0; i < path.size(); ++i) {
+        std::cout << path[i]->get_name() << "/";
+      }
+      std::cout << feature->get_name() << std::endl;
+    }
+    kmlengine::GetFeatureBounds(feature, &bbox);
+  }
+  if (!reader->get_errors().empty()) {
+    std::cerr << "KmlFeatureReader error " << reader->get_errors()
+              << std::endl;
+    return 1;
+  }
+
+  std::cout << feature_count << " features, ";
+  std::cout << reader->get_shared_style_map().size() << " shared styles";
+  std::cout << std::endl;
+
+  // Emit the bounding box as KML.
+  LatLonBoxPtr llab = KmlFactory::GetFactory()->CreateLatLonBox();
+  llab->set_north(bbox.get_north());
+  llab->set_south(bbox.get_south());
+  llab->set_east(bbox.get_east());
+  llab->set_west(bbox.get_west());
+  std::cout << SerializePretty(llab);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " huge.kml" << std::endl;
+    return 1;
+  }
+  return ReadFeatures(argv[1]);
+}
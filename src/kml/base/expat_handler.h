@@ -33,8 +33,84 @@
 
 namespace kmlbase {
 class Attributes;
-// This declares the pure virtual ExpatHandler interface.
-class ExpatHandler {
+
+// This is a non-owning view of the NULL-terminated name/value array expat
+// hands to its start element callback.  The names and values are UTF-8 and
+// remain valid only for the duration of the StartElementRaw() call.
+class ExpatAttributeView {
+ public:
+  explicit ExpatAttributeView(const char** atts)
+    : atts_(atts), size_(0) {
+    while (atts_ && atts_[size_ * 2]) {
+      ++size_;
+    }
+  }
+
+  // The number of name/value pairs.
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  const char* name(size_t i) const {
+    return atts_[i * 2];
+  }
+  const char* value(size_t i) const {
+    return atts_[i * 2 + 1];
+  }
+
+  // Appends the attributes to the flattened name/value StringVector used by
+  // ExpatHandler::StartElement() and Attributes::Create().
+  void AppendToStringVector(StringVector* ovec) const {
+    if (!ovec) {
+      return;
+    }
+    for (size_t i = 0; i < size_; ++i) {
+      ovec->push_back(name(i));
+      ovec->push_back(value(i));
+    }
+  }
+
+ private:
+  const char** atts_;
+  size_t size_;
+};
+
+// This declares the allocation-free handler interface driven by ExpatParser.
+// Names and character data are passed as pointer and length into expat's own
+// buffers (always UTF-8) and are valid only for the duration of the call.
+// Implement this directly when per-event string construction matters.
+// Most handlers should instead derive from ExpatHandler below.
+class ExpatRawHandler {
+public:
+  ExpatRawHandler() : parser_(NULL) {}
+  virtual ~ExpatRawHandler() {}
+  virtual void StartElementRaw(const char* name, size_t name_len,
+                               const ExpatAttributeView& atts) = 0;
+  virtual void EndElementRaw(const char* name, size_t name_len) = 0;
+  virtual void CharDataRaw(const char* s, size_t len) = 0;
+
+  // Namespace handlers with an empty default implementation.  The prefix
+  // is empty for the default namespace.
+  virtual void StartNamespaceRaw(const char* prefix, size_t prefix_len,
+                                 const char* uri, size_t uri_len) {}
+  virtual void EndNamespaceRaw(const char* prefix, size_t prefix_len) {}
+
+  void set_parser(XML_Parser parser) {
+    parser_ = parser;
+  }
+  XML_Parser get_parser() {
+    return parser_;
+  }
+
+private:
+  XML_Parser parser_;
+};
+
+// This declares the pure virtual ExpatHandler interface.  This is an adapter
+// over ExpatRawHandler which hands each event to the handler as strings.
+class ExpatHandler : public ExpatRawHandler {
 public:
   virtual ~ExpatHandler() {}
   virtual void StartElement(const string& name,
@@ -47,15 +123,26 @@ public:
                               const string& uri) {}
   virtual void EndNamespace(const string& prefix) {}
 
-  void set_parser(XML_Parser parser) {
-    parser_ = parser;
+  // ExpatRawHandler methods.
+  virtual void StartElementRaw(const char* name, size_t name_len,
+                               const ExpatAttributeView& atts) {
+    StringVector flatatts;
+    atts.AppendToStringVector(&flatatts);
+    StartElement(string(name, name_len), flatatts);
   }
-  XML_Parser get_parser() {
-    return parser_;
+  virtual void EndElementRaw(const char* name, size_t name_len) {
+    EndElement(string(name, name_len));
+  }
+  virtual void CharDataRaw(const char* s, size_t len) {
+    CharData(string(s, len));
+  }
+  virtual void StartNamespaceRaw(const char* prefix, size_t prefix_len,
+                                 const char* uri, size_t uri_len) {
+    StartNamespace(string(prefix, prefix_len), string(uri, uri_len));
+  }
+  virtual void EndNamespaceRaw(const char* prefix, size_t prefix_len) {
+    EndNamespace(string(prefix, prefix_len));
   }
-
-private:
-  XML_Parser parser_;
 };
 
 const int kBitMask = 0x3f;
@@ -26,57 +26,118 @@
 // This file contains the implementation of the internal ExpatParser class.
 
 #include "kml/base/expat_parser.h"
-#include <cstring>  // For memcpy.
+#include <cstring>  // For memcpy, strlen.
 #include <sstream>
 #include "kml/base/expat_handler.h"
+#include "kml/base/file.h"
 
 namespace kmlbase {
 
+// The callbacks below hand expat's own buffers straight to the
+// ExpatRawHandler.  Nothing is copied or allocated per event unless expat was
+// built with XML_UNICODE, in which case each name and value is first
+// converted to UTF-8.
+
+#ifdef XML_UNICODE
+
 static void XMLCALL
 startElement(void *userData, const XML_Char *name, const XML_Char **atts) {
   string flatname = xml_char_to_string(name);
-  // TODO: kmlbase::Attributes would be a more appropriate type here.
   StringVector flatatts;
   xml_char_to_string_vec(atts, &flatatts);
-  static_cast<ExpatHandler*>(userData)->StartElement(flatname, flatatts);
+  std::vector<const char*> attptrs;
+  for (size_t i = 0; i < flatatts.size(); ++i) {
+    attptrs.push_back(flatatts[i].c_str());
+  }
+  attptrs.push_back(NULL);
+  static_cast<ExpatRawHandler*>(userData)->StartElementRaw(
+      flatname.data(), flatname.size(), ExpatAttributeView(&attptrs[0]));
 }
 
 static void XMLCALL
 endElement(void *userData, const XML_Char *name) {
   string flatname = xml_char_to_string(name);
-  static_cast<ExpatHandler*>(userData)->EndElement(flatname);
+  static_cast<ExpatRawHandler*>(userData)->EndElementRaw(flatname.data(),
+                                                         flatname.size());
 }
 
 static void XMLCALL
 charData(void *userData, const XML_Char *s, int length) {
-  string flatdata = xml_char_to_string_n(s, length);;
-  static_cast<ExpatHandler*>(userData)->CharData(flatdata);
+  string flatdata = xml_char_to_string_n(s, length);
+  static_cast<ExpatRawHandler*>(userData)->CharDataRaw(flatdata.data(),
+                                                       flatdata.size());
 }
 
 static void XMLCALL
 startNamespace(void *userData, const XML_Char *prefix, const XML_Char *uri) {
   string flatprefix = xml_char_to_string(prefix);
   string flaturi = xml_char_to_string(uri);
-  static_cast<ExpatHandler*>(userData)->StartNamespace(flatprefix, flaturi);
+  static_cast<ExpatRawHandler*>(userData)->StartNamespaceRaw(
+      flatprefix.data(), flatprefix.size(), flaturi.data(), flaturi.size());
 }
 
 static void XMLCALL
 endNamespace(void *userData, const XML_Char *prefix) {
   string flatprefix = xml_char_to_string(prefix);
-  static_cast<ExpatHandler*>(userData)->EndNamespace(flatprefix);
+  static_cast<ExpatRawHandler*>(userData)->EndNamespaceRaw(flatprefix.data(),
+                                                           flatprefix.size());
+}
+
+#else  // XML_UNICODE
+
+static void XMLCALL
+startElement(void *userData, const XML_Char *name, const XML_Char **atts) {
+  static_cast<ExpatRawHandler*>(userData)->StartElementRaw(
+      name, strlen(name), ExpatAttributeView(atts));
+}
+
+static void XMLCALL
+endElement(void *userData, const XML_Char *name) {
+  static_cast<ExpatRawHandler*>(userData)->EndElementRaw(name, strlen(name));
+}
+
+static void XMLCALL
+charData(void *userData, const XML_Char *s, int length) {
+  static_cast<ExpatRawHandler*>(userData)->CharDataRaw(
+      s, static_cast<size_t>(length));
+}
+
+// Expat passes a NULL prefix (and possibly a NULL uri) for the default
+// namespace.
+static void XMLCALL
+startNamespace(void *userData, const XML_Char *prefix, const XML_Char *uri) {
+  if (!prefix) {
+    prefix = "";
+  }
+  if (!uri) {
+    uri = "";
+  }
+  static_cast<ExpatRawHandler*>(userData)->StartNamespaceRaw(
+      prefix, strlen(prefix), uri, strlen(uri));
+}
+
+static void XMLCALL
+endNamespace(void *userData, const XML_Char *prefix) {
+  if (!prefix) {
+    prefix = "";
+  }
+  static_cast<ExpatRawHandler*>(userData)->EndNamespaceRaw(prefix,
+                                                           strlen(prefix));
 }
 
+#endif  // XML_UNICODE
+
 static void XMLCALL
 entityDeclHandler(void *userData, const XML_Char *entityName,
                   int is_parameter_entity, const XML_Char *value,
                   int value_length, const XML_Char *base,
                   const XML_Char *systemId, const XML_Char *publicId,
                   const XML_Char *notationName) {
-  XML_Parser parser = static_cast<ExpatHandler*>(userData)->get_parser();
+  XML_Parser parser = static_cast<ExpatRawHandler*>(userData)->get_parser();
   XML_StopParser(parser, XML_FALSE);
 }
 
-ExpatParser::ExpatParser(ExpatHandler* handler, bool namespace_aware)
+ExpatParser::ExpatParser(ExpatRawHandler* handler, bool namespace_aware)
   : expat_handler_(handler) {
   XML_Parser parser =
     namespace_aware ? XML_ParserCreateNS(NULL, kExpatNsSeparator)
@@ -97,10 +158,28 @@ ExpatParser::~ExpatParser() {
 }
 
 // Static.
-bool ExpatParser::ParseString(const string& xml, ExpatHandler* handler,
+bool ExpatParser::ParseString(const string& xml, ExpatRawHandler* handler,
                               string* errors, bool namespace_aware) {
   ExpatParser parser(handler, namespace_aware);
-  return parser._ParseString(xml, errors);
+  return parser._ParseBytes(xml.data(), xml.size(), NULL, errors);
+}
+
+bool ExpatParser::ParseBytes(const char* data, size_t size,
+                             ExpatRawHandler* handler, string* errors,
+                             bool namespace_aware) {
+  ExpatParser parser(handler, namespace_aware);
+  return parser._ParseBytes(data, size, NULL, errors);
+}
+
+bool ExpatParser::ParseMappedFile(MappedFile* mapped_file,
+                                  ExpatRawHandler* handler, string* errors,
+                                  bool namespace_aware) {
+  if (!mapped_file) {
+    return false;
+  }
+  ExpatParser parser(handler, namespace_aware);
+  return parser._ParseBytes(mapped_file->data(), mapped_file->size(),
+                            mapped_file, errors);
 }
 
 void* ExpatParser::GetInternalBuffer(size_t len) {
@@ -140,10 +219,49 @@ bool ExpatParser::ParseInternalBuffer(size_t len, string* errors,
   return status == XML_STATUS_OK;
 }
 
+XML_Status ExpatParser::ParseChunk(const char* data, size_t size,
+                                   bool is_final, string* errors) {
+  const XML_Status status = XML_Parse(parser_, data, static_cast<int>(size),
+                                      is_final);
+  if (status == XML_STATUS_ERROR) {
+    ReportError(parser_, errors);
+  }
+  return status;
+}
+
+XML_Status ExpatParser::Resume(string* errors) {
+  const XML_Status status = XML_ResumeParser(parser_);
+  if (status == XML_STATUS_ERROR) {
+    ReportError(parser_, errors);
+  }
+  return status;
+}
+
+void ExpatParser::Suspend() {
+  XML_StopParser(parser_, XML_TRUE);
+}
+
+// The most XML handed to expat in one XML_Parse() call.  expat (as built
+// with XML_CONTEXT_BYTES) copies each window into its own buffer so this
+// bounds that buffer rather than growing it to the size of the document.
+// This also keeps each call within expat's int length.
+static const size_t kParseWindowSize = 1024 * 1024;
+
 // Private.
-bool ExpatParser::_ParseString(const string& xml, string* errors) {
-  int xml_size = static_cast<int>(xml.size());
-  XML_Status status = XML_Parse(parser_, xml.c_str(), xml_size, xml_size);
+bool ExpatParser::_ParseBytes(const char* data, size_t size,
+                              MappedFile* mapped_file, string* errors) {
+  XML_Status status = XML_STATUS_OK;
+  do {
+    const size_t window = size < kParseWindowSize ? size : kParseWindowSize;
+    const bool is_final = window == size;
+    status = XML_Parse(parser_, data, static_cast<int>(window), is_final);
+    if (mapped_file) {
+      // expat keeps what it still needs of the window.
+      mapped_file->ReleasePages(data - mapped_file->data(), window);
+    }
+    data += window;
+    size -= window;
+  } while (status == XML_STATUS_OK && size > 0);
   if (status != XML_STATUS_OK && errors) {
     // This is the other half of XML_StopParser() which is our way of
     // stopping expat if the root element is not KML.
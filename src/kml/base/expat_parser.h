@@ -43,6 +43,8 @@ const char kExpatNsSeparator = '|';
 
 class ExpatHandler;
 class ExpatHandlerNs;
+class ExpatRawHandler;
+class MappedFile;
 
 typedef std::map<string, ExpatHandler*> ExpatHandlerMap;
 
@@ -83,20 +85,36 @@ class ExpatHandlerSet {
 // class SomeXmlLanguageHandler : public kmlbase::ExpatHandler {
 //   // See expat_handler.h for methods to implement.
 // };
+// (Handlers which must not allocate per event may instead implement the
+// pointer and length based kmlbase::ExpatRawHandler.)
 // SomeXmlLanguageHandler some_handler;
 // bool status = ExpatParser::ParseString(xml_file_contents, &some_handler,
 //                                        &errors, namespace_aware_bool);
 // State of parse (if any) is held in the class derived from ExpatHandler.
 class ExpatParser {
  public:
-  ExpatParser(ExpatHandler* handler, bool namespace_aware);
+  ExpatParser(ExpatRawHandler* handler, bool namespace_aware);
   ~ExpatParser();
 
   // Parses a string of XML data in one operation. The xml string must be a
   // complete, well-formed XML document.
-  static bool ParseString(const string& xml, ExpatHandler* handler,
+  static bool ParseString(const string& xml, ExpatRawHandler* handler,
                           string* errors, bool namespace_aware);
 
+  // As ParseString, but parses the size bytes of XML at data which need not
+  // be NUL terminated.  The XML is handed to expat in windows such that no
+  // copy of the whole document is made.
+  static bool ParseBytes(const char* data, size_t size,
+                         ExpatRawHandler* handler, string* errors,
+                         bool namespace_aware);
+
+  // As ParseBytes, but parses the contents of the given MappedFile and
+  // releases the pages of each window once expat is done with it.  The
+  // memory use of the parse thus does not include that of the file.
+  static bool ParseMappedFile(MappedFile* mapped_file,
+                              ExpatRawHandler* handler, string* errors,
+                              bool namespace_aware);
+
   // This allocates a buffer for use with ParseInternalBuffer.  The caller is
   // expected to put the next buffer's worth of XML to parse into this buffer.
   void* GetInternalBuffer(size_t size);
@@ -113,11 +131,26 @@ class ExpatParser {
   bool ParseBuffer(const string& input, string* errors,
                    bool is_final);
 
+  // These parse XML a chunk at a time as ParseBuffer does, but a handler may
+  // suspend the parse with Suspend().  Each returns the expat status:
+  // XML_STATUS_SUSPENDED if the parse is suspended, in which case no more
+  // data may be parsed until Resume(), or XML_STATUS_ERROR in which case
+  // any error message is stored in errors.
+  XML_Status ParseChunk(const char* data, size_t size, bool is_final,
+                        string* errors);
+  XML_Status Resume(string* errors);
+
+  // This is called from within a handler to suspend the parse once the
+  // handler returns.
+  void Suspend();
+
  private:
-  ExpatHandler* expat_handler_;
+  ExpatRawHandler* expat_handler_;
   XML_Parser parser_;
-  // Used by the static ParseString public method.
-  bool _ParseString(const string& xml, string* errors);
+  // Used by the static ParseString, ParseBytes and ParseMappedFile public
+  // methods.  If mapped_file is not NULL data is within it.
+  bool _ParseBytes(const char* data, size_t size, MappedFile* mapped_file,
+                   string* errors);
   void ReportError(XML_Parser parser, string* errors);
 };
 
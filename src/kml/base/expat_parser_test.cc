@@ -62,6 +62,37 @@ class TestXmlHandler : public ExpatHandler {
   string xml_;
 };
 
+// An ExpatRawHandler which reconstructs parsed XML including attributes.
+class TestXmlRawHandler : public ExpatRawHandler {
+ public:
+  virtual void StartElementRaw(const char* name, size_t name_len,
+                               const ExpatAttributeView& atts) {
+    xml_.append("<").append(name, name_len);
+    for (size_t i = 0; i < atts.size(); ++i) {
+      xml_.append(" ").append(atts.name(i)).append("=\"");
+      xml_.append(atts.value(i)).append("\"");
+    }
+    xml_.append(">");
+  }
+  virtual void EndElementRaw(const char* name, size_t name_len) {
+    xml_.append("</").append(name, name_len).append(">");
+  }
+  virtual void CharDataRaw(const char* s, size_t len) {
+    xml_.append(s, len);
+  }
+  virtual void StartNamespaceRaw(const char* prefix, size_t prefix_len,
+                                 const char* uri, size_t uri_len) {
+    namespaces_.append("[").append(prefix, prefix_len).append("=");
+    namespaces_.append(uri, uri_len).append("]");
+  }
+  const string& get_xml() const { return xml_; }
+  const string& get_namespaces() const { return namespaces_; }
+
+ private:
+  string xml_;
+  string namespaces_;
+};
+
 class ExpatParserTest : public testing::Test {
  protected:
   string errors_;
@@ -85,6 +116,35 @@ TEST_F(ExpatParserTest, TestFailingParseString) {
   ASSERT_EQ(kXml, handler_.get_xml());
 }
 
+// Verify ParseBytes parses exactly the given bytes.
+TEST_F(ExpatParserTest, TestParseBytes) {
+  const string kXml("<Tom><dick>foo</dick><harry>bar</harry></Tom>");
+  const string kBuffer(kXml + "trailing junk not to be parsed");
+  ASSERT_TRUE(ExpatParser::ParseBytes(kBuffer.data(), kXml.size(), &handler_,
+                                      &errors_, false));
+  ASSERT_TRUE(errors_.empty());
+  ASSERT_EQ(kXml, handler_.get_xml());
+
+  TestXmlHandler handler;
+  ASSERT_FALSE(ExpatParser::ParseBytes(kBuffer.data(), kXml.size() - 1,
+                                       &handler, &errors_, false));
+  ASSERT_FALSE(errors_.empty());
+}
+
+// Verify ParseBytes on XML spanning several parse windows.
+TEST_F(ExpatParserTest, TestParseBytesWindows) {
+  string xml("<Tom>");
+  const string kDick("<dick>foo</dick>");
+  while (xml.size() < 40 * 1024 * 1024) {
+    xml.append(kDick);
+  }
+  xml.append("</Tom>");
+  ASSERT_TRUE(ExpatParser::ParseBytes(xml.data(), xml.size(), &handler_,
+                                      &errors_, false));
+  ASSERT_TRUE(errors_.empty());
+  ASSERT_EQ(xml, handler_.get_xml());
+}
+
 // Verify basic usage of the ParseBuffer method.
 TEST_F(ExpatParserTest, TestPassingParseBuffer) {
   const string kXml("<Tom><dick>foo</dick><harry>bar</harry></Tom>");
@@ -173,6 +233,56 @@ TEST_F(ExpatParserTest, TestFailingInternalBuffer) {
   ASSERT_FALSE(errors_.empty());
 }
 
+// Verify that ExpatParser drives an ExpatRawHandler directly.
+TEST_F(ExpatParserTest, TestRawHandler) {
+  const string kXml("<Tom a=\"1\" b=\"two\"><dick>foo</dick>"
+                    "<harry c=\"\">bar</harry></Tom>");
+  TestXmlRawHandler raw_handler;
+  ASSERT_TRUE(ExpatParser::ParseString(kXml, &raw_handler, &errors_, false));
+  ASSERT_TRUE(errors_.empty());
+  ASSERT_EQ(kXml, raw_handler.get_xml());
+
+  // Also when the input is split at arbitrary points.
+  TestXmlRawHandler split_handler;
+  ExpatParser parser(&split_handler, false);
+  for (size_t i = 0; i < kXml.length(); ++i) {
+    ASSERT_TRUE(parser.ParseBuffer(kXml.substr(i, 1), &errors_,
+                                   i == kXml.length()-1));
+  }
+  ASSERT_EQ(kXml, split_handler.get_xml());
+}
+
+// Verify the namespace-aware raw callbacks, including the empty prefix
+// for the default namespace.
+TEST_F(ExpatParserTest, TestRawHandlerNamespaces) {
+  const string kXml("<a xmlns=\"urn:x\" xmlns:p=\"urn:p\"><p:b/></a>");
+  TestXmlRawHandler raw_handler;
+  ASSERT_TRUE(ExpatParser::ParseString(kXml, &raw_handler, &errors_, true));
+  ASSERT_EQ(string("<urn:x|a><urn:p|b></urn:p|b></urn:x|a>"),
+            raw_handler.get_xml());
+  ASSERT_EQ(string("[=urn:x][p=urn:p]"), raw_handler.get_namespaces());
+}
+
+// Verify the ExpatAttributeView accessors.
+TEST_F(ExpatParserTest, TestExpatAttributeView) {
+  const ExpatAttributeView kEmpty(NULL);
+  ASSERT_TRUE(kEmpty.empty());
+  ASSERT_EQ(static_cast<size_t>(0), kEmpty.size());
+
+  const char* kAtts[] = { "id", "x", "name", "y", NULL };
+  const ExpatAttributeView kView(kAtts);
+  ASSERT_FALSE(kView.empty());
+  ASSERT_EQ(static_cast<size_t>(2), kView.size());
+  ASSERT_EQ(string("name"), kView.name(1));
+  ASSERT_EQ(string("y"), kView.value(1));
+  StringVector flat;
+  kView.AppendToStringVector(&flat);
+  ASSERT_EQ(static_cast<size_t>(4), flat.size());
+  ASSERT_EQ(string("id"), flat[0]);
+  ASSERT_EQ(string("y"), flat[3]);
+  kView.AppendToStringVector(NULL);  // Verify no crash on NULL.
+}
+
 TEST_F(ExpatParserTest, TestBillionLaughsAttack) {
   // Ensure that the "billion laughs" buffer overflow attack is handled.
   // Previously, this would hang libkml.
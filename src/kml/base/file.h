@@ -26,6 +26,7 @@
 #ifndef KML_BASE_FILE_H__
 #define KML_BASE_FILE_H__
 
+#include <string.h>
 #include "kml/base/util.h"
 
 namespace kmlbase {
@@ -70,6 +71,129 @@ class File {
                             string* filename);
 };
 
+// This class provides read-only access to the contents of a file by way of
+// a memory mapping rather than a copy into a string.  The pages of the file
+// are read in as they are touched and, being backed by the file, are cheaply
+// dropped under memory pressure.  Intended usage:
+//   boost::scoped_ptr<MappedFile> mapped_file(MappedFile::Open(filename));
+//   if (mapped_file.get()) {
+//     Parse(mapped_file->data(), mapped_file->size());
+//   }
+class MappedFile {
+ public:
+  // Maps the named file.  Returns NULL if the file could not be opened or
+  // mapped, for example if it is larger than the address space.  The
+  // mapping is advised for sequential access.
+  static MappedFile* Open(const string& filename);
+
+  // Unmaps the file.  Any pointer into data() is invalid hereafter.
+  ~MappedFile();
+
+  // Returns the contents of the file.  This is NOT NUL terminated.  The
+  // contents of an empty file are a valid pointer and a size of 0.
+  const char* data() const {
+    return data_;
+  }
+  size_t size() const {
+    return size_;
+  }
+
+  // This tells the OS the given range of the file won't be read again soon.
+  // Its pages may be dropped from memory; they are read back from the file
+  // if touched.  Only the whole pages within the range are released.
+  void ReleasePages(size_t offset, size_t length);
+
+ private:
+  MappedFile(const char* data, size_t size) : data_(data), size_(size) {}
+  const char* data_;
+  size_t size_;
+  LIBKML_DISALLOW_EVIL_CONSTRUCTORS(MappedFile);
+};
+
+// This class writes a file by way of a buffer of its own which is handed to
+// the OS in large blocks.  The memory used is that of the one block however
+// much is written.  The write() and put() methods match those expected of
+// the output of kmldom::XmlSerializer.  Intended usage:
+//   boost::scoped_ptr<FileWriter> file_writer(FileWriter::Open(filename));
+//   if (file_writer.get()) {
+//     file_writer->write(data, size);
+//     ok = file_writer->Close();
+//   }
+class FileWriter {
+ public:
+  // These are the options to Open().
+  struct Options {
+    Options()
+      : block_size(kDefaultBlockSize), direct_io(false), drop_cache(false) {
+    }
+    // The size of the buffer and thus of each write to the file.  This is
+    // rounded up to a multiple of 4096.
+    size_t block_size;
+    // If true the file is written around the page cache (O_DIRECT or
+    // F_NOCACHE) where the OS and the file system support that.
+    bool direct_io;
+    // If true the pages of each block are advised as not needed once they
+    // are written (POSIX_FADV_DONTNEED) such that a large file does not
+    // push everything else out of the page cache.
+    bool drop_cache;
+  };
+
+  // The default block size is 1 MB.
+  static const size_t kDefaultBlockSize = 1 << 20;
+
+  // Creates or truncates the named file.  Returns NULL if the file could not
+  // be opened for writing.
+  static FileWriter* Open(const string& filename);
+  static FileWriter* Open(const string& filename, const Options& options);
+
+  // Writes anything buffered and closes the file.  Use Close() to learn if
+  // that failed.
+  ~FileWriter();
+
+  void write(const char* data, size_t size) {
+    while (size > 0) {
+      size_t n = block_size_ - size_;
+      if (n > size) {
+        n = size;
+      }
+      memcpy(buffer_ + size_, data, n);
+      size_ += n;
+      data += n;
+      size -= n;
+      if (size_ == block_size_) {
+        WriteBlock();
+      }
+    }
+  }
+
+  void put(char c) {
+    buffer_[size_++] = c;
+    if (size_ == block_size_) {
+      WriteBlock();
+    }
+  }
+
+  // Writes anything buffered and closes the file.  Returns false if this or
+  // any earlier write failed.  Anything written hereafter is dropped.
+  bool Close();
+
+ private:
+  FileWriter(int fd, char* buffer, size_t block_size, bool drop_cache)
+    : fd_(fd), buffer_(buffer), block_size_(block_size), size_(0),
+      offset_(0), drop_cache_(drop_cache), ok_(true) {
+  }
+  // Writes the buffer to the file and empties it.
+  void WriteBlock();
+  int fd_;
+  char* buffer_;
+  size_t block_size_;
+  size_t size_;
+  uint64_t offset_;
+  bool drop_cache_;
+  bool ok_;
+  LIBKML_DISALLOW_EVIL_CONSTRUCTORS(FileWriter);
+};
+
 }  // end namespace kmlbase
 
 #endif  // KML_BASE_FILE_H__
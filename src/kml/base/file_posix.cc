@@ -27,8 +27,11 @@
 // POSIX platforms.
 
 #include "kml/base/file.h"
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>  // For open.
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>  // For unlink, close.
@@ -71,4 +74,173 @@ bool File::CreateNewTempFile(string* path) {
   return true;
 }
 
+// static
+MappedFile* MappedFile::Open(const string& filename) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return NULL;
+  }
+  struct stat stat_data;
+  // A file larger than the address space can't be mapped.
+  if (fstat(fd, &stat_data) != 0 || !S_ISREG(stat_data.st_mode) ||
+      static_cast<off_t>(static_cast<size_t>(stat_data.st_size)) !=
+          stat_data.st_size) {
+    close(fd);
+    return NULL;
+  }
+  const size_t size = static_cast<size_t>(stat_data.st_size);
+  if (size == 0) {  // mmap() rejects a zero length.
+    close(fd);
+    return new MappedFile("", 0);
+  }
+  void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping holds its own reference to the file.
+  close(fd);
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+  madvise(data, size, MADV_SEQUENTIAL);
+  return new MappedFile(static_cast<const char*>(data), size);
+}
+
+void MappedFile::ReleasePages(size_t offset, size_t length) {
+  if (offset >= size_) {
+    return;
+  }
+  if (length > size_ - offset) {
+    length = size_ - offset;
+  }
+  // The mapping starts on a page boundary.
+  const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t begin = (offset + page_size - 1) / page_size * page_size;
+  const size_t end = (offset + length == size_) ?
+      size_ : (offset + length) / page_size * page_size;
+  if (begin < end) {
+    madvise(const_cast<char*>(data_) + begin, end - begin, MADV_DONTNEED);
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (size_ > 0) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+// Private.  The alignment of the buffer and of each block written, as is
+// needed for O_DIRECT.
+static const size_t kFileWriterAlignment = 4096;
+
+// static
+FileWriter* FileWriter::Open(const string& filename) {
+  return Open(filename, Options());
+}
+
+// static
+FileWriter* FileWriter::Open(const string& filename, const Options& options) {
+  if (filename.empty()) {
+    return NULL;
+  }
+  const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+  int fd = -1;
+#ifdef O_DIRECT
+  if (options.direct_io) {
+    fd = open(filename.c_str(), flags | O_DIRECT, 0666);
+  }
+#endif
+  // Some file systems, tmpfs for one, refuse O_DIRECT.
+  if (fd == -1) {
+    fd = open(filename.c_str(), flags, 0666);
+  }
+  if (fd == -1) {
+    return NULL;
+  }
+#if defined(F_NOCACHE)
+  if (options.direct_io) {
+    fcntl(fd, F_NOCACHE, 1);
+  }
+#endif
+  size_t block_size = options.block_size + kFileWriterAlignment - 1;
+  block_size -= block_size % kFileWriterAlignment;
+  if (block_size == 0) {
+    block_size = kFileWriterAlignment;
+  }
+  void* buffer = NULL;
+  if (posix_memalign(&buffer, kFileWriterAlignment, block_size) != 0) {
+    close(fd);
+    return NULL;
+  }
+  return new FileWriter(fd, static_cast<char*>(buffer), block_size,
+                        options.drop_cache);
+}
+
+void FileWriter::WriteBlock() {
+  const char* data = buffer_;
+  size_t size = size_;
+  size_ = 0;
+  if (fd_ == -1) {
+    return;
+  }
+  const uint64_t begin = offset_;
+  while (size > 0) {
+    const ssize_t n = ::write(fd_, data, size);
+    if (n == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ok_ = false;
+      return;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+    offset_ += static_cast<uint64_t>(n);
+  }
+  if (!drop_cache_ || begin < block_size_) {
+    return;
+  }
+  // Dirty pages can't be dropped.  This block is queued to be written back
+  // and the one before it, which had as long, is waited for and dropped.
+  const off_t previous = static_cast<off_t>(begin - block_size_);
+#ifdef SYNC_FILE_RANGE_WRITE
+  sync_file_range(fd_, static_cast<off_t>(begin), offset_ - begin,
+                  SYNC_FILE_RANGE_WRITE);
+  sync_file_range(fd_, previous, block_size_,
+                  SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                  SYNC_FILE_RANGE_WAIT_AFTER);
+#endif
+#ifdef POSIX_FADV_DONTNEED
+  posix_fadvise(fd_, previous, block_size_, POSIX_FADV_DONTNEED);
+#endif
+}
+
+bool FileWriter::Close() {
+  if (fd_ == -1) {
+    return ok_;
+  }
+#ifdef O_DIRECT
+  // The last block need not be a whole multiple of the alignment.
+  if (size_ % kFileWriterAlignment != 0) {
+    const int flags = fcntl(fd_, F_GETFL);
+    if (flags != -1 && (flags & O_DIRECT)) {
+      fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+    }
+  }
+#endif
+  WriteBlock();
+#ifdef POSIX_FADV_DONTNEED
+  if (drop_cache_ && ok_ && fdatasync(fd_) == 0) {
+    posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+  }
+#endif
+  if (close(fd_) != 0) {
+    ok_ = false;
+  }
+  fd_ = -1;
+  return ok_;
+}
+
+FileWriter::~FileWriter() {
+  Close();
+  free(buffer_);
+}
+
 }  // end namespace kmlbase
@@ -24,6 +24,8 @@
 // ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "kml/base/file.h"
+#include <algorithm>
+#include "boost/scoped_ptr.hpp"
 #include "gtest/gtest.h"
 
 // The following define is a convenience for testing inside Google.
@@ -158,4 +160,85 @@ TEST_F(FileTest, TestSplitFilePath) {
   }
 }
 
+TEST_F(FileTest, TestMappedFile) {
+  const string kDoc = string(DATADIR) + "/kmz/doc.kmz";
+  boost::scoped_ptr<MappedFile> mapped_file(MappedFile::Open(kDoc));
+  ASSERT_TRUE(mapped_file.get());
+  string file_data;
+  ASSERT_TRUE(File::ReadFileToString(kDoc, &file_data));
+  ASSERT_EQ(file_data.size(), mapped_file->size());
+  ASSERT_EQ(file_data, string(mapped_file->data(), mapped_file->size()));
+  // Released pages read back from the file.
+  mapped_file->ReleasePages(0, mapped_file->size());
+  mapped_file->ReleasePages(100, 1000);
+  ASSERT_EQ(file_data, string(mapped_file->data(), mapped_file->size()));
+
+  // An empty file maps to no data.
+  string tempfile;
+  ASSERT_TRUE(File::CreateNewTempFile(&tempfile));
+  mapped_file.reset(MappedFile::Open(tempfile));
+  ASSERT_TRUE(mapped_file.get());
+  ASSERT_EQ(static_cast<size_t>(0), mapped_file->size());
+  ASSERT_TRUE(mapped_file->data());
+  mapped_file.reset();
+  ASSERT_TRUE(File::Delete(tempfile));
+
+  // Neither a non-existent file nor a directory can be mapped.
+  ASSERT_FALSE(MappedFile::Open(string(DATADIR) + "/kmz/nosuchfile"));
+  ASSERT_FALSE(MappedFile::Open(DATADIR));
+}
+
+// Writes the given data through a FileWriter with the given options in
+// pieces of the given size and reads the file back.
+static string WriteAndReadBack(const string& data, size_t piece_size,
+                               const FileWriter::Options& options) {
+  string tempfile;
+  EXPECT_TRUE(File::CreateNewTempFile(&tempfile));
+  boost::scoped_ptr<FileWriter> file_writer(
+      FileWriter::Open(tempfile, options));
+  EXPECT_TRUE(file_writer.get());
+  for (size_t i = 0; i < data.size(); i += piece_size) {
+    if (piece_size == 1) {
+      file_writer->put(data[i]);
+    } else {
+      file_writer->write(data.data() + i,
+                         std::min(piece_size, data.size() - i));
+    }
+  }
+  EXPECT_TRUE(file_writer->Close());
+  // A closed FileWriter stays closed.
+  file_writer->write("more", 4);
+  EXPECT_TRUE(file_writer->Close());
+  file_writer.reset();
+  string file_data;
+  EXPECT_TRUE(File::ReadFileToString(tempfile, &file_data));
+  EXPECT_TRUE(File::Delete(tempfile));
+  return file_data;
+}
+
+TEST_F(FileTest, TestFileWriter) {
+  // Somewhat more than three blocks of 4096 bytes.
+  string data;
+  for (int i = 0; data.size() < 3 * 4096 + 1000; ++i) {
+    data.append(1, static_cast<char>('a' + i % 26));
+    data.append(i % 100, '.');
+  }
+  FileWriter::Options options;
+  options.block_size = 1;  // Rounds up to 4096.
+  ASSERT_EQ(data, WriteAndReadBack(data, 1, options));
+  ASSERT_EQ(data, WriteAndReadBack(data, 1000, options));
+  ASSERT_EQ(data, WriteAndReadBack(data, data.size(), options));
+  options.direct_io = true;
+  ASSERT_EQ(data, WriteAndReadBack(data, 999, options));
+  options.drop_cache = true;
+  ASSERT_EQ(data, WriteAndReadBack(data, 5000, options));
+  ASSERT_EQ(data, WriteAndReadBack(data, 3 * 4096, options));
+  ASSERT_EQ(data, WriteAndReadBack(data, 1, FileWriter::Options()));
+  ASSERT_EQ(string(""), WriteAndReadBack("", 1, FileWriter::Options()));
+
+  // Neither an empty name nor a directory can be written.
+  ASSERT_FALSE(FileWriter::Open(""));
+  ASSERT_FALSE(FileWriter::Open(DATADIR));
+}
+
 }  // end namespace kmlbase
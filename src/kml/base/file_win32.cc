@@ -31,6 +31,10 @@
 
 #include "kml/base/file.h"
 #include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 #include <tchar.h>
 #include <xstring>
 #include <algorithm>
@@ -100,4 +104,126 @@ bool File::CreateNewTempFile(string* path) {
   return true;
 }
 
+// static
+MappedFile* MappedFile::Open(const string& filename) {
+  if (filename.empty()) {
+    return NULL;
+  }
+  std::wstring wstr = Str2Wstr(filename);
+  HANDLE file = ::CreateFile(wstr.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return NULL;
+  }
+  LARGE_INTEGER file_size;
+  // A file larger than the address space can't be mapped.
+  if (!::GetFileSizeEx(file, &file_size) ||
+      static_cast<ULONGLONG>(file_size.QuadPart) !=
+          static_cast<size_t>(file_size.QuadPart)) {
+    ::CloseHandle(file);
+    return NULL;
+  }
+  const size_t size = static_cast<size_t>(file_size.QuadPart);
+  if (size == 0) {  // CreateFileMapping() rejects an empty file.
+    ::CloseHandle(file);
+    return new MappedFile("", 0);
+  }
+  HANDLE mapping = ::CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  ::CloseHandle(file);
+  if (!mapping) {
+    return NULL;
+  }
+  // The view holds its own reference to the mapping.
+  const void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  ::CloseHandle(mapping);
+  if (!data) {
+    return NULL;
+  }
+  return new MappedFile(static_cast<const char*>(data), size);
+}
+
+void MappedFile::ReleasePages(size_t offset, size_t length) {
+  if (offset >= size_) {
+    return;
+  }
+  if (length > size_ - offset) {
+    length = size_ - offset;
+  }
+  // Unlocking pages which are not locked removes them from the working set.
+  ::VirtualUnlock(const_cast<char*>(data_) + offset, length);
+}
+
+MappedFile::~MappedFile() {
+  if (size_ > 0) {
+    ::UnmapViewOfFile(data_);
+  }
+}
+
+// static
+FileWriter* FileWriter::Open(const string& filename) {
+  return Open(filename, Options());
+}
+
+// The direct_io and drop_cache options have no counterpart here.
+// static
+FileWriter* FileWriter::Open(const string& filename, const Options& options) {
+  if (filename.empty()) {
+    return NULL;
+  }
+  std::wstring wstr = Str2Wstr(filename);
+  const int fd = ::_wopen(wstr.c_str(),
+                          _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY |
+                          _O_SEQUENTIAL, _S_IREAD | _S_IWRITE);
+  if (fd == -1) {
+    return NULL;
+  }
+  size_t block_size = options.block_size + 4095;
+  block_size -= block_size % 4096;
+  if (block_size == 0) {
+    block_size = 4096;
+  }
+  char* buffer = static_cast<char*>(malloc(block_size));
+  if (!buffer) {
+    ::_close(fd);
+    return NULL;
+  }
+  return new FileWriter(fd, buffer, block_size, options.drop_cache);
+}
+
+void FileWriter::WriteBlock() {
+  const char* data = buffer_;
+  size_t size = size_;
+  size_ = 0;
+  if (fd_ == -1) {
+    return;
+  }
+  while (size > 0) {
+    const int n = ::_write(fd_, data, static_cast<unsigned int>(size));
+    if (n <= 0) {
+      ok_ = false;
+      return;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+    offset_ += static_cast<uint64_t>(n);
+  }
+}
+
+bool FileWriter::Close() {
+  if (fd_ == -1) {
+    return ok_;
+  }
+  WriteBlock();
+  if (::_close(fd_) != 0) {
+    ok_ = false;
+  }
+  fd_ = -1;
+  return ok_;
+}
+
+FileWriter::~FileWriter() {
+  Close();
+  free(buffer_);
+}
+
 }  // end namespace kmlbase
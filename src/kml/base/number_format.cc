@@ -0,0 +1,194 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of the double formatting functions.
+
+#include "kml/base/number_format.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "kml/base/util.h"
+
+namespace kmlbase {
+
+// Private.  The powers of ten each exactly a double.
+static const double kPowersOfTen[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+  1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19
+};
+
+// Private.  printf("%.15g") writes a value below this positionally.
+static const double kMaxPositional = 1e15;
+
+// Private.  Every integer below this is exactly a double.
+static const double kMaxExactInteger = 9007199254740992.0;
+
+// Private.  This writes the sign, then mantissa / 10^decimal_places in
+// positional notation, such that 1234 with 2 decimal places is 12.34 and
+// 5 with 3 is 0.005.  Trailing zeros after the decimal point are not
+// written.
+static size_t WriteDecimal(bool negative, uint64_t mantissa,
+                           int decimal_places, char* buf) {
+  while (decimal_places > 0 && mantissa % 10 == 0) {
+    mantissa /= 10;
+    --decimal_places;
+  }
+  // The digits are written backwards from the end of a scratch buffer.
+  char digits[24];
+  char* end = digits + sizeof(digits);
+  char* begin = end;
+  do {
+    *--begin = static_cast<char>('0' + mantissa % 10);
+    mantissa /= 10;
+  } while (mantissa);
+  int digit_count = static_cast<int>(end - begin);
+  char* out = buf;
+  if (negative) {
+    *out++ = '-';
+  }
+  if (decimal_places == 0) {
+    memcpy(out, begin, digit_count);
+    return out + digit_count - buf;
+  }
+  if (digit_count > decimal_places) {
+    const int integer_digits = digit_count - decimal_places;
+    memcpy(out, begin, integer_digits);
+    out += integer_digits;
+    *out++ = '.';
+    memcpy(out, begin + integer_digits, decimal_places);
+    return out + decimal_places - buf;
+  }
+  *out++ = '0';
+  *out++ = '.';
+  memset(out, '0', decimal_places - digit_count);
+  out += decimal_places - digit_count;
+  memcpy(out, begin, digit_count);
+  return out + digit_count - buf;
+}
+
+// Private.  This copies the text of printf("%g") to buf with the decimal
+// separator of the LC_NUMERIC locale written as '.' whatever the locale,
+// such that 1,5e-05 in a de_DE locale is 1.5e-05.  The separator is what
+// follows the integer digits up to the fraction digits or the exponent, as
+// it may be more than one character.
+static size_t WriteWithDecimalPoint(const char* text, char* buf) {
+  char* out = buf;
+  if (*text == '-') {
+    *out++ = *text++;
+  }
+  const char* digits = text;
+  while (isdigit(static_cast<unsigned char>(*text))) {
+    *out++ = *text++;
+  }
+  // There are no digits in inf or nan.
+  if (text != digits && *text && *text != 'e') {
+    while (*text && *text != 'e' &&
+           !isdigit(static_cast<unsigned char>(*text))) {
+      ++text;
+    }
+    *out++ = '.';
+  }
+  while (*text) {
+    *out++ = *text++;
+  }
+  return out - buf;
+}
+
+// Private.  This is the general case of FormatDouble(): the fewest of
+// min_precision to 17 significant digits from printf which read back as the
+// value.  As printf and strtod both follow the locale the text is read back
+// as it was written before its decimal separator is made a '.'.
+static size_t PrintDouble(double value, int min_precision, char* buf) {
+  char scratch[kMaxDoubleLength];
+  for (int precision = min_precision; ; ++precision) {
+    sprintf(scratch, "%.*g", precision, value);
+    if (precision == 17 || strtod(scratch, NULL) == value) {
+      break;
+    }
+  }
+  return WriteWithDecimalPoint(scratch, buf);
+}
+
+size_t FormatDouble(double value, char* buf) {
+  const double magnitude = fabs(value);
+  // printf("%.15g") writes this range in positional notation.  Within it
+  // the value is tried as an integer mantissa of each number of decimal
+  // places in turn.  The division of two integers exactly doubles is
+  // correctly rounded just as strtod() is, so the first mantissa which
+  // divides back to the value is the shortest text which reads back as it.
+  // No two texts of 15 or fewer digits read back as the same double which
+  // makes such a text also that of printf("%.15g").
+  if (magnitude >= 1e-4 && magnitude < kMaxPositional) {
+    const bool negative = value < 0;
+    for (int decimal_places = 0; decimal_places < 20; ++decimal_places) {
+      const double scaled = magnitude * kPowersOfTen[decimal_places];
+      if (scaled >= kMaxExactInteger - 1) {
+        break;
+      }
+      // The product is rounded, so the mantissa may be either neighbor of
+      // the nearest integer to it.
+      const uint64_t nearest = static_cast<uint64_t>(scaled + 0.5);
+      const uint64_t mantissas[] = {
+        nearest, nearest + 1, nearest > 0 ? nearest - 1 : nearest
+      };
+      for (int i = 0; i < 3; ++i) {
+        if (static_cast<double>(mantissas[i]) /
+            kPowersOfTen[decimal_places] == magnitude) {
+          return WriteDecimal(negative, mantissas[i], decimal_places, buf);
+        }
+      }
+    }
+    // Only 17 digits read back as the value.
+    return PrintDouble(value, 17, buf);
+  } else if (value == 0) {
+    if (1 / value < 0) {  // -0
+      memcpy(buf, "-0", 2);
+      return 2;
+    }
+    *buf = '0';
+    return 1;
+  }
+  return PrintDouble(value, 15, buf);
+}
+
+size_t FormatDoubleFixed(double value, int decimal_places, char* buf) {
+  if (decimal_places < 0) {
+    decimal_places = 0;
+  } else if (decimal_places > 15) {
+    decimal_places = 15;
+  }
+  const double scaled = fabs(value) * kPowersOfTen[decimal_places];
+  if (!(scaled < kMaxExactInteger)) {
+    return FormatDouble(value, buf);
+  }
+  const uint64_t mantissa = static_cast<uint64_t>(floor(scaled + 0.5));
+  // A value which rounds to 0 is written without its sign.
+  return WriteDecimal(value < 0 && mantissa != 0, mantissa, decimal_places,
+                      buf);
+}
+
+}  // end namespace kmlbase
@@ -0,0 +1,59 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declarations of the functions which format a
+// double as text.  These are what kmlbase::ToString() uses for a double and
+// what the XmlSerializer uses for each coordinate.  The decimal point is
+// always a '.' as KML requires whatever the LC_NUMERIC locale.
+
+#ifndef KML_BASE_NUMBER_FORMAT_H__
+#define KML_BASE_NUMBER_FORMAT_H__
+
+#include <stddef.h>
+
+namespace kmlbase {
+
+// The most characters FormatDouble() or FormatDoubleFixed() writes.  No
+// terminating NUL is written.
+const size_t kMaxDoubleLength = 32;
+
+// This writes the shortest decimal form of the value which reads back as
+// exactly the same double and returns the number of characters written.
+// Where 15 significant digits suffice the output is exactly that of
+// printf("%.15g") which ToString() used before: 0.1, 1e-05, -122.084143.
+// Otherwise as few as 16 or 17 digits are written where printf("%.15g")
+// loses the last bits of the value: 0.30000000000000004.
+size_t FormatDouble(double value, char* buf);
+
+// This writes the value rounded to the given number of decimal places,
+// 0 to 15, with no trailing zeros after the decimal point: 1.5 to 3 places
+// is 1.5, and 2.0004 to 3 places is 2.  A value of too great a magnitude
+// for its decimal places to hold any digit of it is written as by
+// FormatDouble().
+size_t FormatDoubleFixed(double value, int decimal_places, char* buf);
+
+}  // end namespace kmlbase
+
+#endif  // KML_BASE_NUMBER_FORMAT_H__
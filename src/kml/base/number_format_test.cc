@@ -0,0 +1,171 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the unit tests for the double formatting functions.
+
+#include "kml/base/number_format.h"
+#include <locale.h>
+#include <math.h>
+#include <stdlib.h>
+#include <sstream>
+#include "kml/base/util.h"
+#include "gtest/gtest.h"
+
+namespace kmlbase {
+
+static string Format(double value) {
+  char buf[kMaxDoubleLength];
+  return string(buf, FormatDouble(value, buf));
+}
+
+static string FormatFixed(double value, int decimal_places) {
+  char buf[kMaxDoubleLength];
+  return string(buf, FormatDoubleFixed(value, decimal_places, buf));
+}
+
+// This is how ToString() formatted a double before FormatDouble().
+static string StreamFormat(double value) {
+  std::stringstream ss;
+  ss.precision(15);
+  ss << value;
+  return ss.str();
+}
+
+TEST(NumberFormatTest, TestFormatDouble) {
+  ASSERT_EQ(string("0"), Format(0));
+  ASSERT_EQ(string("-0"), Format(-0.0));
+  ASSERT_EQ(string("1"), Format(1));
+  ASSERT_EQ(string("-42"), Format(-42));
+  ASSERT_EQ(string("0.1"), Format(0.1));
+  ASSERT_EQ(string("3.1415926535"), Format(3.1415926535));
+  ASSERT_EQ(string("-122.084143"), Format(-122.084143));
+  ASSERT_EQ(string("37.421972"), Format(37.4219720));
+  ASSERT_EQ(string("0.0001"), Format(0.0001));
+  ASSERT_EQ(string("1e-05"), Format(0.00001));
+  ASSERT_EQ(string("123456789012345"), Format(123456789012345.0));
+  ASSERT_EQ(string("1e+15"), Format(1e15));
+  ASSERT_EQ(string("1.5e+300"), Format(1.5e300));
+  ASSERT_EQ(string("inf"), Format(HUGE_VAL));
+  ASSERT_EQ(string("-inf"), Format(-HUGE_VAL));
+  // These need more than the 15 digits of printf("%.15g") to read back.
+  ASSERT_EQ(string("0.30000000000000004"), Format(0.1 + 0.2));
+  ASSERT_EQ(string("0.30000000000000004"),
+            Format(strtod(Format(0.1 + 0.2).c_str(), NULL)));
+  ASSERT_EQ(string("9007199254740992"), Format(9007199254740992.0));
+  ASSERT_EQ(string("2.2250738585072014e-308"), Format(2.2250738585072014e-308));
+}
+
+// FormatDouble() writes exactly what printf("%.15g") does where that reads
+// back as the same double, and otherwise the shortest text that does.
+TEST(NumberFormatTest, TestFormatDoubleMatchesStream) {
+  unsigned int state = 1;
+  for (int i = 0; i < 200000; ++i) {
+    state = state * 1103515245 + 12345;
+    const unsigned int high = state;
+    state = state * 1103515245 + 12345;
+    double value;
+    switch (i % 4) {
+      case 0:  // A longitude of up to 15 significant digits.
+        value = -180.0 + (high >> 4) * (360.0 / (1 << 28));
+        value = strtod(StreamFormat(value).c_str(), NULL);
+        break;
+      case 1:  // A longitude of the full precision of a double.
+        value = -180.0 + high * (360.0 / 4294967296.0) +
+            state * (1.0 / 4294967296.0 / 4294967296.0);
+        break;
+      case 2:  // A value of any magnitude.
+        value = ldexp(1.0 + high / 4294967296.0,
+                      static_cast<int>(state % 200) - 100);
+        break;
+      default:  // A coordinate printed to 6 decimal places.
+        value = (static_cast<int>(high % 360000000) - 180000000) / 1e6;
+        break;
+    }
+    const string formatted = Format(value);
+    ASSERT_EQ(value, strtod(formatted.c_str(), NULL)) << formatted;
+    const string streamed = StreamFormat(value);
+    if (strtod(streamed.c_str(), NULL) == value) {
+      ASSERT_EQ(streamed, formatted);
+    } else {
+      ASSERT_LE(streamed.size(), formatted.size());
+      ASSERT_GE(kMaxDoubleLength, formatted.size());
+    }
+  }
+}
+
+TEST(NumberFormatTest, TestFormatDoubleFixed) {
+  ASSERT_EQ(string("0"), FormatFixed(0, 6));
+  ASSERT_EQ(string("1.5"), FormatFixed(1.5, 3));
+  ASSERT_EQ(string("2"), FormatFixed(2.0004, 3));
+  ASSERT_EQ(string("2.01"), FormatFixed(2.0096, 3));
+  ASSERT_EQ(string("-122.084143"), FormatFixed(-122.0841430000001, 6));
+  ASSERT_EQ(string("0.000001"), FormatFixed(0.0000012, 6));
+  ASSERT_EQ(string("0"), FormatFixed(-0.0000001, 6));
+  ASSERT_EQ(string("-3"), FormatFixed(-2.5, 0));
+  ASSERT_EQ(string("100"), FormatFixed(100, 0));
+  // The decimal places are clamped to 0 to 15.
+  ASSERT_EQ(string("3"), FormatFixed(3.25, -1));
+  ASSERT_EQ(string("0.333333333333333"), FormatFixed(1.0 / 3, 20));
+  // A value too great for the decimal places is formatted as is.
+  ASSERT_EQ(string("1e+20"), FormatFixed(1e20, 2));
+  ASSERT_EQ(string("inf"), FormatFixed(HUGE_VAL, 2));
+}
+
+// The decimal point is a '.' even in a locale whose printf writes a ','.
+TEST(NumberFormatTest, TestFormatDoubleCommaLocale) {
+  const string saved(setlocale(LC_NUMERIC, NULL));
+  const char* kCommaLocales[] = {
+    "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8",
+    "fr_FR", "German_Germany.1252"
+  };
+  const size_t kCommaLocaleCount =
+      sizeof(kCommaLocales) / sizeof(kCommaLocales[0]);
+  size_t i = 0;
+  for (; i < kCommaLocaleCount; ++i) {
+    if (setlocale(LC_NUMERIC, kCommaLocales[i])) {
+      break;
+    }
+  }
+  if (i == kCommaLocaleCount) {
+    return;  // No comma locale is installed.
+  }
+  char buf[kMaxDoubleLength];
+  sprintf(buf, "%g", 1.5);
+  const string printed(buf);
+  const string point_formatted = Format(1.5);
+  const string exponent_formatted = Format(1.5e-05);
+  const string long_formatted = Format(0.1 + 0.2);
+  const string tiny_formatted = Format(2.2250738585072014e-308);
+  const string fixed_formatted = FormatFixed(1.5e20, 2);
+  setlocale(LC_NUMERIC, saved.c_str());
+  ASSERT_EQ(string("1,5"), printed);
+  ASSERT_EQ(string("1.5"), point_formatted);
+  ASSERT_EQ(string("1.5e-05"), exponent_formatted);
+  ASSERT_EQ(string("0.30000000000000004"), long_formatted);
+  ASSERT_EQ(string("2.2250738585072014e-308"), tiny_formatted);
+  ASSERT_EQ(string("1.5e+20"), fixed_formatted);
+}
+
+}  // end namespace kmlbase
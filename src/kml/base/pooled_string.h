@@ -0,0 +1,130 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of the PooledString class, the storage
+// of a string field of an Element which may share its value with others.
+
+#ifndef KML_BASE_POOLED_STRING_H__
+#define KML_BASE_POOLED_STRING_H__
+
+#include "kml/base/util.h"
+
+namespace kmlbase {
+
+// A PooledString holds either a string of its own or a pointer to a string
+// in a pool which outlives it, such as the strings interned by a
+// kmldom::Arena.  Many PooledStrings may refer to the same pooled string.
+// A PooledString is the size of one pointer: an unset PooledString costs
+// nothing more, and a pooled string is never copied.
+class PooledString {
+ public:
+  PooledString()
+    : bits_(0) {
+  }
+
+  PooledString(const PooledString& other)
+    : bits_(0) {
+    *this = other;
+  }
+
+  ~PooledString() {
+    clear();
+  }
+
+  // A pooled string is shared and a string of its own is copied.
+  PooledString& operator=(const PooledString& other) {
+    if (this != &other) {
+      if (other.is_pooled()) {
+        clear();
+        bits_ = other.bits_;
+      } else {
+        *this = other.get();
+      }
+    }
+    return *this;
+  }
+
+  // This sets a string of its own.
+  PooledString& operator=(const string& value) {
+    if (value.empty()) {
+      clear();
+    } else if (bits_ != 0 && !is_pooled()) {
+      *GetString() = value;
+    } else {
+      bits_ = reinterpret_cast<size_t>(new string(value));
+    }
+    return *this;
+  }
+
+  // This refers to the given string which must outlive this PooledString
+  // and never change.
+  void set_pooled(const string* value) {
+    clear();
+    bits_ = reinterpret_cast<size_t>(value) | kPooled;
+  }
+
+  bool is_pooled() const {
+    return (bits_ & kPooled) != 0;
+  }
+
+  const string& get() const {
+    return bits_ != 0 ? *GetString() : GetEmptyString();
+  }
+
+  // This returns the string for change.  A pooled string is first copied.
+  string* mutable_get() {
+    if (bits_ == 0 || is_pooled()) {
+      bits_ = reinterpret_cast<size_t>(new string(get()));
+    }
+    return GetString();
+  }
+
+  void clear() {
+    if (bits_ != 0 && !is_pooled()) {
+      delete GetString();
+    }
+    bits_ = 0;
+  }
+
+ private:
+  // The low bit of the pointer marks a pooled string.  Strings are at least
+  // this aligned.
+  static const size_t kPooled = 1;
+
+  string* GetString() const {
+    return reinterpret_cast<string*>(bits_ & ~kPooled);
+  }
+
+  static const string& GetEmptyString() {
+    static const string empty;
+    return empty;
+  }
+
+  size_t bits_;
+};
+
+}  // end namespace kmlbase
+
+#endif  // KML_BASE_POOLED_STRING_H__
@@ -0,0 +1,87 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the unit tests for the PooledString class.
+
+#include "kml/base/pooled_string.h"
+#include "gtest/gtest.h"
+
+namespace kmlbase {
+
+TEST(PooledStringTest, TestDefault) {
+  PooledString pooled_string;
+  ASSERT_TRUE(pooled_string.get().empty());
+  ASSERT_FALSE(pooled_string.is_pooled());
+  ASSERT_EQ(sizeof(void*), sizeof(pooled_string));
+}
+
+TEST(PooledStringTest, TestOwnString) {
+  PooledString pooled_string;
+  pooled_string = "abc";
+  ASSERT_EQ(string("abc"), pooled_string.get());
+  ASSERT_FALSE(pooled_string.is_pooled());
+  // A string of its own is copied.
+  PooledString copy(pooled_string);
+  ASSERT_EQ(string("abc"), copy.get());
+  ASSERT_NE(&pooled_string.get(), &copy.get());
+  copy.mutable_get()->append("d");
+  ASSERT_EQ(string("abc"), pooled_string.get());
+  ASSERT_EQ(string("abcd"), copy.get());
+  pooled_string = copy;
+  ASSERT_EQ(string("abcd"), pooled_string.get());
+  pooled_string = pooled_string.get();
+  ASSERT_EQ(string("abcd"), pooled_string.get());
+  pooled_string.clear();
+  ASSERT_TRUE(pooled_string.get().empty());
+}
+
+TEST(PooledStringTest, TestPooled) {
+  const string pooled("abc");
+  PooledString pooled_string;
+  pooled_string.set_pooled(&pooled);
+  ASSERT_TRUE(pooled_string.is_pooled());
+  ASSERT_EQ(&pooled, &pooled_string.get());
+  // A pooled string is shared.
+  PooledString copy;
+  copy = pooled_string;
+  ASSERT_TRUE(copy.is_pooled());
+  ASSERT_EQ(&pooled, &copy.get());
+  // A pooled string is copied for change.
+  copy.mutable_get()->append("d");
+  ASSERT_FALSE(copy.is_pooled());
+  ASSERT_EQ(string("abcd"), copy.get());
+  ASSERT_EQ(string("abc"), pooled);
+  // Setting a string of its own leaves the pooled string as it is.
+  pooled_string = "x";
+  ASSERT_FALSE(pooled_string.is_pooled());
+  ASSERT_EQ(string("x"), pooled_string.get());
+  ASSERT_EQ(string("abc"), pooled);
+  pooled_string.set_pooled(&pooled);
+  pooled_string.clear();
+  ASSERT_TRUE(pooled_string.get().empty());
+  ASSERT_EQ(string("abc"), pooled);
+}
+
+}  // end namespace kmlbase
@@ -27,9 +27,31 @@
 // boost::intrusive_ptr.  See boost/intrusive_ptr.hpp for more information.
 
 #include "kml/base/referent.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_InterlockedExchangeAdd)
+#pragma intrinsic(_InterlockedCompareExchangePointer)
+#endif
 
 namespace kmlbase {
 
+int AtomicAdd(int* value, int delta) {
+#ifdef _MSC_VER
+  return _InterlockedExchangeAdd(reinterpret_cast<long*>(value), delta) +
+      delta;
+#else
+  return __sync_add_and_fetch(value, delta);
+#endif
+}
+
+void* AtomicCompareAndSwap(void** target, void* expected, void* desired) {
+#ifdef _MSC_VER
+  return _InterlockedCompareExchangePointer(target, desired, expected);
+#else
+  return __sync_val_compare_and_swap(target, expected, desired);
+#endif
+}
+
 // This function is used from within boost::intrusive_ptr to increment the
 // reference count when a new intrusive_ptr to a Referent-derived object is
 // created.  This function is to be used only from within boost::intrusive_ptr.
@@ -39,7 +61,7 @@ void intrusive_ptr_add_ref(kmlbase::Referent* r) {
 
 // This function is used from within boost::intrusive_ptr to decrement the
 // reference count when an intrusive_ptr to a Referent-derived object goes out
-// of scope.  This is the only call to delete of a Referent-derived type.
+// of scope.  This is the only place a Referent-derived object is destroyed.
 // This function is to be used only from within boost::intrusive_ptr.
 void intrusive_ptr_release(kmlbase::Referent* r) {
   // Strictly speaking this need only be "if (r->release() == 0)" given that
@@ -49,7 +71,7 @@ void intrusive_ptr_release(kmlbase::Referent* r) {
   // An alternative implementation might assert r->release >= 0 to catch
   // usage that goes around the API in some way.
   if (r->release() <= 0) {
-    delete r;
+    r->Destroy();
   }
 } 
 
@@ -34,6 +34,23 @@
 
 namespace kmlbase {
 
+// This atomically adds delta to the value and returns the result.
+int AtomicAdd(int* value, int delta);
+
+// This atomically sets *target to desired if it holds expected, and returns
+// what it held before.
+void* AtomicCompareAndSwap(void** target, void* expected, void* desired);
+
+// This atomically reads the value, such that a change by AtomicAdd() on
+// another thread is seen whole and in order.  It costs a plain read.
+inline int AtomicLoad(const int* value) {
+#ifdef _MSC_VER
+  return *static_cast<const volatile int*>(value);
+#else
+  return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
 // This class implements the reference count used by boost::intrusive_ptr.
 class Referent {
  public:
@@ -46,21 +63,54 @@ class Referent {
   // This method is used by intrusive_ptr_add_ref() to increment the reference
   // count of a given Referent-derived object.
   void add_ref() {
-    ++ref_count_;
+    if (ref_count_ & kThreadShared) {
+      AtomicAdd(1);
+    } else {
+      ++ref_count_;
+    }
   }
 
   // This method is used by intrusive_ptr_release() to decrement the reference
   // count of a given Referent-derived object.
   int release() {
+    if (ref_count_ & kThreadShared) {
+      return AtomicAdd(-1) & ~kThreadShared;
+    }
     return --ref_count_;
   }
 
   // This is for debugging purposes only.
   int get_ref_count() const {
-    return ref_count_;
+    return ref_count_ & ~kThreadShared;
+  }
+
+  // This makes the reference count of this object atomic such that
+  // intrusive_ptrs to it may be copied and released from several threads at
+  // once.  This must be called before the object is shared between threads
+  // and cannot be undone.  The count of an object not shared costs no atomic
+  // operations.
+  void set_thread_shared() {
+    ref_count_ |= kThreadShared;
+  }
+  bool is_thread_shared() const {
+    return (ref_count_ & kThreadShared) != 0;
+  }
+
+  // This method is used by intrusive_ptr_release() to destroy a
+  // Referent-derived object once its reference count drops to zero.  A
+  // derived class whose objects are not all created with new overrides this.
+  virtual void Destroy() {
+    delete this;
   }
 
  private:
+  // This flag is kept in the top of the reference count.  It does not change
+  // once the object is shared, so a plain read of it is never stale.
+  static const int kThreadShared = 0x40000000;
+  // This atomically adds delta to the reference count and returns the result.
+  int AtomicAdd(int delta) {
+    return kmlbase::AtomicAdd(&ref_count_, delta);
+  }
   int ref_count_;
 };
 
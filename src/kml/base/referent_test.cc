@@ -30,6 +30,7 @@
 #include <vector>
 #include "boost/intrusive_ptr.hpp"
 #include "gtest/gtest.h"
+#include "kml/base/thread.h"
 
 namespace kmlbase {
 
@@ -223,4 +224,55 @@ TEST_F(ReferentTest, TestGetChild) {
   // The object is released when child goes out of scope.
 }
 
+// This verifies a thread-shared Referent counts as any other.
+TEST_F(ReferentTest, TestThreadShared) {
+  ASSERT_FALSE(derived_->is_thread_shared());
+  derived_->set_thread_shared();
+  ASSERT_TRUE(derived_->is_thread_shared());
+  ASSERT_EQ(1, derived_->get_ref_count());
+  {
+    DerivedPtr copy = derived_;
+    ASSERT_EQ(2, derived_->get_ref_count());
+    ASSERT_EQ(1, copy->release());
+    copy->add_ref();
+  }
+  ASSERT_EQ(1, derived_->get_ref_count());
+  ASSERT_TRUE(derived_->is_thread_shared());
+}
+
+// This copies and releases a pointer to a shared Referent many times.
+class CopyPointerRunnable : public Runnable {
+ public:
+  CopyPointerRunnable(const boost::intrusive_ptr<Referent>& referent)
+    : referent_(referent) {
+  }
+  virtual void Run() {
+    std::vector<boost::intrusive_ptr<Referent> > copies(100, referent_);
+    for (int i = 0; i < 1000; ++i) {
+      copies.assign(copies.size(), referent_);
+    }
+  }
+
+ private:
+  const boost::intrusive_ptr<Referent>& referent_;
+};
+
+// This verifies the reference count of a thread-shared Referent is exact
+// after pointers to it are copied from many threads at once.
+TEST_F(ReferentTest, TestThreadSharedFromThreads) {
+  boost::intrusive_ptr<Referent> referent = new Referent;
+  referent->set_thread_shared();
+  const size_t kThreadCount = 8;
+  std::vector<CopyPointerRunnable*> runnables;
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    runnables.push_back(new CopyPointerRunnable(referent));
+  }
+  RunInParallel(std::vector<Runnable*>(runnables.begin(), runnables.end()),
+                kThreadCount);
+  ASSERT_EQ(1, referent->get_ref_count());
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    delete runnables[i];
+  }
+}
+
 }  // end namespace kmlbase
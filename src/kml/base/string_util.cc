@@ -28,6 +28,10 @@
 #include "kml/base/string_util.h"
 #include <stdlib.h>  // strtod()
 #include <string.h>  // memcpy, strchr
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define KMLBASE_USE_SSE2 1
+#endif
 
 namespace kmlbase {
 
@@ -159,6 +163,111 @@ size_t SkipLeadingWhitespaceString(const string& str) {
   return SkipLeadingWhitespace(str.data(), str.data() + str.size());
 }
 
+// isspace() in the "C" locale: space, \t, \n, \v, \f and \r.
+static inline bool IsCSpace(char c) {
+  return c == ' ' || static_cast<unsigned char>(c - '\t') < 5;
+}
+
+static inline bool IsDigit(char c) {
+  return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Every integer below 10^15 and every power of ten up to 10^22 is exactly
+// representable as a double, so a mantissa of at most 15 digits divided by
+// one of these is a single correctly rounded IEEE operation, which is what
+// strtod() computes.  This is Clinger's fast path.
+static const int kMaxFastDigits = 15;
+static const double kPowersOfTen[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int kMaxFastExponent = 22;
+
+double ParseDouble(const char* cstr, char** endp) {
+#if defined(__FLT_EVAL_METHOD__) && __FLT_EVAL_METHOD__ != 0
+  // Extended precision intermediates would round twice.
+  return strtod(cstr, endp);
+#else
+  const char* cp = cstr;
+  while (IsCSpace(*cp)) {
+    ++cp;
+  }
+  bool negative = false;
+  if (*cp == '-' || *cp == '+') {
+    negative = *cp == '-';
+    ++cp;
+  }
+  double mantissa = 0.0;
+  int significant_digits = 0;
+  int exponent = 0;
+  bool saw_digit = false;
+  for (; IsDigit(*cp); ++cp) {
+    saw_digit = true;
+    if (significant_digits > 0 || *cp != '0') {
+      if (++significant_digits > kMaxFastDigits) {
+        return strtod(cstr, endp);
+      }
+      mantissa = mantissa * 10.0 + (*cp - '0');
+    }
+  }
+  if (*cp == '.') {
+    ++cp;
+    for (; IsDigit(*cp); ++cp) {
+      saw_digit = true;
+      --exponent;
+      if (significant_digits > 0 || *cp != '0') {
+        if (++significant_digits > kMaxFastDigits) {
+          return strtod(cstr, endp);
+        }
+        mantissa = mantissa * 10.0 + (*cp - '0');
+      }
+    }
+  }
+  // No digits at all means inf, nan or no number.  An exponent or hex
+  // prefix is left to strtod() as well.
+  if (!saw_digit || -exponent > kMaxFastExponent ||
+      *cp == 'e' || *cp == 'E' || *cp == 'x' || *cp == 'X') {
+    return strtod(cstr, endp);
+  }
+  if (endp) {
+    *endp = const_cast<char*>(cp);
+  }
+  const double value = mantissa / kPowersOfTen[-exponent];
+  return negative ? -value : value;
+#endif
+}
+
+const char* FindNonWhitespace(const char* begin, const char* end) {
+#ifdef KMLBASE_USE_SSE2
+  // A single separating space is the common case: don't bother with SIMD
+  // unless there's a run of whitespace.
+  if (begin < end && IsCSpace(*begin)) {
+    ++begin;
+    const __m128i blank = _mm_set1_epi8(' ');
+    // (c - '\t') < 5 as an unsigned compare, done as a signed compare on
+    // values biased by -128: c + (128 - '\t') < -128 + 5.
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(128 - '\t'));
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(-128 + 5));
+    while (end - begin >= 16) {
+      const __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+      const __m128i is_space = _mm_or_si128(
+          _mm_cmpeq_epi8(chunk, blank),
+          _mm_cmplt_epi8(_mm_add_epi8(chunk, bias), limit));
+      const int mask = _mm_movemask_epi8(is_space);
+      if (mask != 0xffff) {
+        return begin + __builtin_ctz(~mask);
+      }
+      begin += 16;
+    }
+  }
+#endif
+  while (begin < end && IsCSpace(*begin)) {
+    ++begin;
+  }
+  return begin;
+}
+
 // Derived from and compatible with google3's SplitCSVLineWithDelimiter.
 void SplitQuotedUsing(const char* input, size_t nbytes, const char delimiter,
                       std::vector<string>* cols) {
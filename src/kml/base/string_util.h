@@ -31,6 +31,7 @@
 #include <map>
 #include <sstream>
 #include <vector>
+#include "kml/base/number_format.h"
 #include "kml/base/util.h"
 
 namespace kmlbase {
@@ -96,6 +97,14 @@ inline string ToString(T value) {
   return ss.str();
 }
 
+// A double is written as the shortest text which reads back as the same
+// double.  See FormatDouble().
+template<>
+inline string ToString(double value) {
+  char buf[kMaxDoubleLength];
+  return string(buf, FormatDouble(value, buf));
+}
+
 // Split the input string on the split_string saving each string into the
 // output vector.
 void SplitStringUsing(const string& input, const string& split_string,
@@ -135,6 +144,20 @@ size_t SkipLeadingWhitespace(const char* begin, const char* end);
 // This returns the offset to the first non-whitespace character.
 size_t SkipLeadingWhitespaceString(const string& str);
 
+// This is a drop-in replacement for strtod() for the "C" locale: for any
+// input it returns the same value and sets *endp to the same position.
+// Plain decimal numbers of up to 15 significant digits, which covers nearly
+// all KML coordinates, are converted directly without the locale and errno
+// machinery of strtod().  Anything else (exponents, hex, inf, nan, longer
+// mantissas) is handed to strtod().  endp may be NULL.
+double ParseDouble(const char* cstr, char** endp);
+
+// This returns a pointer to the first character in [begin, end) which is not
+// whitespace as isspace() defines it in the "C" locale, or end if there is
+// none.  Long runs of whitespace are scanned 16 bytes at a time with SSE2
+// where available.
+const char* FindNonWhitespace(const char* begin, const char* end);
+
 }  // end namespace kmlbase
 
 #endif  // KML_BASE_STRING_UTIL_H__
@@ -24,6 +24,9 @@
 // ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "kml/base/string_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "gtest/gtest.h"
 
 namespace kmlbase {
@@ -283,6 +286,88 @@ TEST(StringUtilTest, TestSkipWhitespace) {
                                   kWsHello.data() + kWsHello.size()));
 }
 
+// Verify ParseDouble returns bit for bit what strtod returns and stops at
+// the same place.
+static void CheckParseDouble(const char* cstr) {
+  char* expected_end = NULL;
+  const double expected = strtod(cstr, &expected_end);
+  char* end = NULL;
+  const double value = ParseDouble(cstr, &end);
+  ASSERT_EQ(0, memcmp(&expected, &value, sizeof(double))) << "[" << cstr << "]";
+  ASSERT_EQ(expected_end, end) << "[" << cstr << "]";
+}
+
+TEST(StringUtilTest, TestParseDouble) {
+  const char* kCases[] = {
+    "", " ", "-", "+", ".", "-.", "0", "-0", "+0", "0.", ".0", "-.0",
+    "1", "-1", "1.5", " \t\n\v\f\r-122.0822035425683", "37.42228990140251,",
+    "0.1", "0.2", "0.3", "1e5", "1E5", "1e", "1e+", "1.5e-3", "0x1A", "0X1p4",
+    "inf", "-Infinity", "nan", "nan(42)", "123456789012345",
+    "1234567890123456", "0.000000000000000000001",
+    "0.0000000000000000000001", "0.00000000000000000000001",
+    "000000000000000000000000000000001.25", "1.000000000000000000000000001",
+    "9007199254740993", "179769313486231570000000000000000000000000000000",
+    "1..2", "1.2.3", "--1", "+-1", "1 2", "12abc", "1,2,3",
+  };
+  for (size_t i = 0; i < sizeof(kCases)/sizeof(kCases[0]); ++i) {
+    CheckParseDouble(kCases[i]);
+  }
+  char* end = NULL;
+  ASSERT_EQ(-122.25, ParseDouble("-122.25,37", &end));
+  ASSERT_EQ(',', *end);
+  ASSERT_EQ(1.5, ParseDouble("1.5", NULL));
+}
+
+TEST(StringUtilTest, TestParseDoubleMatchesStrtod) {
+  // Every decimal rendering of a spread of doubles at every precision.
+  unsigned int state = 1;
+  char buf[64];
+  for (int i = 0; i < 20000; ++i) {
+    state = state * 1103515245 + 12345;
+    const double value =
+        (static_cast<double>(state) / 4294967296.0 - 0.5) * 360.0;
+    for (int precision = 1; precision <= 20; ++precision) {
+      sprintf(buf, "%.*f", precision, value);
+      CheckParseDouble(buf);
+      sprintf(buf, "%.*g", precision, value / 1000.0);
+      CheckParseDouble(buf);
+    }
+  }
+}
+
+TEST(StringUtilTest, TestFindNonWhitespace) {
+  const string kEmpty;
+  ASSERT_EQ(kEmpty.data(),
+            FindNonWhitespace(kEmpty.data(), kEmpty.data() + kEmpty.size()));
+  const string kHello("hello");
+  ASSERT_EQ(kHello.data(),
+            FindNonWhitespace(kHello.data(), kHello.data() + kHello.size()));
+  // Check every position of the first non-whitespace character across the
+  // SIMD block boundaries, with every whitespace character.
+  const char kWhitespace[] = " \t\n\v\f\r";
+  for (size_t length = 0; length < 70; ++length) {
+    string s;
+    for (size_t i = 0; i < length; ++i) {
+      s.push_back(kWhitespace[i % (sizeof(kWhitespace) - 1)]);
+    }
+    const char* all_space = s.data() + s.size();
+    ASSERT_EQ(all_space, FindNonWhitespace(s.data(), all_space));
+    s.append("x \t");
+    ASSERT_EQ(s.data() + length,
+              FindNonWhitespace(s.data(), s.data() + s.size()));
+    // Characters just outside the whitespace range.
+    s[length] = '\b';
+    ASSERT_EQ(s.data() + length,
+              FindNonWhitespace(s.data(), s.data() + s.size()));
+    s[length] = 0x0e;
+    ASSERT_EQ(s.data() + length,
+              FindNonWhitespace(s.data(), s.data() + s.size()));
+    s[length] = static_cast<char>(0x89);
+    ASSERT_EQ(s.data() + length,
+              FindNonWhitespace(s.data(), s.data() + s.size()));
+  }
+}
+
 TEST(StringUtilTest, TestSplitQuotedUsing) {
   const string kStuff("\"a\",\"b\",\"c\"");
   std::vector<string> output;
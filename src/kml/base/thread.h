@@ -0,0 +1,58 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of RunInParallel, a minimal facility to
+// spread independent units of work over several threads.
+
+#ifndef KML_BASE_THREAD_H__
+#define KML_BASE_THREAD_H__
+
+#include <vector>
+#include "kml/base/util.h"
+
+namespace kmlbase {
+
+// A unit of work for RunInParallel.
+class Runnable {
+ public:
+  virtual ~Runnable() {}
+  virtual void Run() = 0;
+};
+
+// This calls Run() on each of the given Runnables exactly once and returns
+// when all have completed.  The Runnables are handed out in order to at most
+// thread_count threads, one of which is the calling thread.  If a thread
+// cannot be started the remaining threads pick up its share.  The Runnables
+// must not share unsynchronized state.
+void RunInParallel(const std::vector<Runnable*>& runnables,
+                   size_t thread_count);
+
+// Returns the number of processors available to this process, or 1 if that
+// is not known.
+size_t GetProcessorCount();
+
+}  // end namespace kmlbase
+
+#endif  // KML_BASE_THREAD_H__
@@ -0,0 +1,90 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The file contains the implementation of RunInParallel for POSIX platforms.
+
+#include "kml/base/thread.h"
+#include <pthread.h>
+#include <unistd.h>  // For sysconf.
+
+namespace kmlbase {
+
+// The Runnables of one RunInParallel and the index of the next to run.
+struct RunQueue {
+  const std::vector<Runnable*>* runnables;
+  size_t next;
+  pthread_mutex_t mutex;
+};
+
+// Returns the next Runnable from the queue or NULL if all have been handed
+// out.
+static Runnable* PopRunnable(RunQueue* queue) {
+  Runnable* runnable = NULL;
+  pthread_mutex_lock(&queue->mutex);
+  if (queue->next < queue->runnables->size()) {
+    runnable = (*queue->runnables)[queue->next++];
+  }
+  pthread_mutex_unlock(&queue->mutex);
+  return runnable;
+}
+
+// This is the body of each thread of a RunInParallel.
+static void* DrainRunQueue(void* arg) {
+  RunQueue* queue = static_cast<RunQueue*>(arg);
+  while (Runnable* runnable = PopRunnable(queue)) {
+    runnable->Run();
+  }
+  return NULL;
+}
+
+void RunInParallel(const std::vector<Runnable*>& runnables,
+                   size_t thread_count) {
+  RunQueue queue;
+  queue.runnables = &runnables;
+  queue.next = 0;
+  pthread_mutex_init(&queue.mutex, NULL);
+
+  // The calling thread is one of the thread_count.
+  std::vector<pthread_t> threads;
+  for (size_t i = 1; i < thread_count && i < runnables.size(); ++i) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, DrainRunQueue, &queue) != 0) {
+      break;
+    }
+    threads.push_back(thread);
+  }
+  DrainRunQueue(&queue);
+  for (size_t i = 0; i < threads.size(); ++i) {
+    pthread_join(threads[i], NULL);
+  }
+  pthread_mutex_destroy(&queue.mutex);
+}
+
+size_t GetProcessorCount() {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? static_cast<size_t>(count) : 1;
+}
+
+}  // end namespace kmlbase
@@ -0,0 +1,101 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the unit tests for RunInParallel.
+
+#include "kml/base/thread.h"
+#include "gtest/gtest.h"
+
+namespace kmlbase {
+
+// Counts its calls to Run() and does a little busy work to keep the threads
+// of a RunInParallel overlapping.
+class CountingRunnable : public Runnable {
+ public:
+  CountingRunnable() : run_count_(0), sum_(0) {}
+  virtual void Run() {
+    ++run_count_;
+    for (int i = 0; i < 100000; ++i) {
+      sum_ += i % 7;
+    }
+  }
+  int get_run_count() const { return run_count_; }
+  int get_sum() const { return sum_; }
+ private:
+  int run_count_;
+  int sum_;
+};
+
+class ThreadTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    for (size_t i = 0; i < kRunnableCount; ++i) {
+      runnables_.push_back(&counting_runnables_[i]);
+    }
+  }
+
+  void VerifyEachRanOnce() {
+    for (size_t i = 0; i < kRunnableCount; ++i) {
+      ASSERT_EQ(1, counting_runnables_[i].get_run_count());
+      ASSERT_EQ(counting_runnables_[0].get_sum(),
+                counting_runnables_[i].get_sum());
+    }
+  }
+
+  static const size_t kRunnableCount = 64;
+  CountingRunnable counting_runnables_[kRunnableCount];
+  std::vector<Runnable*> runnables_;
+};
+
+TEST_F(ThreadTest, TestRunInParallelOnCallingThread) {
+  RunInParallel(runnables_, 1);
+  VerifyEachRanOnce();
+}
+
+TEST_F(ThreadTest, TestRunInParallel) {
+  RunInParallel(runnables_, 8);
+  VerifyEachRanOnce();
+}
+
+TEST_F(ThreadTest, TestRunInParallelMoreThreadsThanRunnables) {
+  runnables_.resize(3);
+  RunInParallel(runnables_, 16);
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(1, counting_runnables_[i].get_run_count());
+  }
+  ASSERT_EQ(0, counting_runnables_[3].get_run_count());
+}
+
+TEST_F(ThreadTest, TestRunInParallelNothing) {
+  RunInParallel(std::vector<Runnable*>(), 4);
+  RunInParallel(runnables_, 0);
+  VerifyEachRanOnce();
+}
+
+TEST_F(ThreadTest, TestGetProcessorCount) {
+  ASSERT_LE(static_cast<size_t>(1), GetProcessorCount());
+}
+
+}  // end namespace kmlbase
@@ -0,0 +1,92 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The file contains the implementation of RunInParallel for Windows.
+
+#include "kml/base/thread.h"
+#include <windows.h>
+
+namespace kmlbase {
+
+// The Runnables of one RunInParallel and the index of the next to run.
+struct RunQueue {
+  const std::vector<Runnable*>* runnables;
+  size_t next;
+  CRITICAL_SECTION lock;
+};
+
+// Returns the next Runnable from the queue or NULL if all have been handed
+// out.
+static Runnable* PopRunnable(RunQueue* queue) {
+  Runnable* runnable = NULL;
+  EnterCriticalSection(&queue->lock);
+  if (queue->next < queue->runnables->size()) {
+    runnable = (*queue->runnables)[queue->next++];
+  }
+  LeaveCriticalSection(&queue->lock);
+  return runnable;
+}
+
+// This is the body of each thread of a RunInParallel.
+static DWORD WINAPI DrainRunQueue(LPVOID arg) {
+  RunQueue* queue = static_cast<RunQueue*>(arg);
+  while (Runnable* runnable = PopRunnable(queue)) {
+    runnable->Run();
+  }
+  return 0;
+}
+
+void RunInParallel(const std::vector<Runnable*>& runnables,
+                   size_t thread_count) {
+  RunQueue queue;
+  queue.runnables = &runnables;
+  queue.next = 0;
+  InitializeCriticalSection(&queue.lock);
+
+  // The calling thread is one of the thread_count.
+  std::vector<HANDLE> threads;
+  for (size_t i = 1; i < thread_count && i < runnables.size(); ++i) {
+    HANDLE thread = CreateThread(NULL, 0, DrainRunQueue, &queue, 0, NULL);
+    if (thread == NULL) {
+      break;
+    }
+    threads.push_back(thread);
+  }
+  DrainRunQueue(&queue);
+  for (size_t i = 0; i < threads.size(); ++i) {
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+  }
+  DeleteCriticalSection(&queue.lock);
+}
+
+size_t GetProcessorCount() {
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+  return system_info.dwNumberOfProcessors > 0 ?
+      static_cast<size_t>(system_info.dwNumberOfProcessors) : 1;
+}
+
+}  // end namespace kmlbase
@@ -25,9 +25,11 @@
 
 // This file contains the implementation of the ZipFile class.
 
-#include <exception>
 #include "kml/base/zip_file.h"
+#include <string.h>
+#include <exception>
 #include "kml/base/file.h"
+#include "kml/base/referent.h"
 #include "minizip/unzip.h"
 #include "minizip/zip.h"
 
@@ -62,6 +64,14 @@ ZipFile* ZipFile::OpenFromFile(const char* file_path) {
   if (!File::Exists(file_path)) {
     return NULL;
   }
+  if (MappedFile* mapped_file = MappedFile::Open(file_path)) {
+    if (!IsZipData(mapped_file->data(), mapped_file->size())) {
+      delete mapped_file;
+      return NULL;
+    }
+    return new ZipFile(mapped_file);
+  }
+  // Fall back to reading the file if it can't be mapped.
   string data;
   if (!File::ReadFileToString(file_path, &data)) {
     return NULL;
@@ -84,13 +94,27 @@ ZipFile* ZipFile::Create(const char* file_path) {
 
 // Private. Class constructed with static methods.
 ZipFile::ZipFile(const string& data)
-  : minizip_file_(NULL), data_(data),
+  : minizip_file_(NULL), data_(data), mapped_data_(NULL),
+    bytes_(data_.data()), size_(data_.size()),
     max_uncompressed_file_size_(kMaxUncompressedZipSize) {
-  // Fill the table of contents for this zipfile.
+  ReadToc();
+}
+
+// Private. Class constructed with static methods.
+ZipFile::ZipFile(MappedFile* mapped_file)
+  : minizip_file_(NULL), mapped_file_(mapped_file), mapped_data_(NULL),
+    bytes_(mapped_file->data()), size_(mapped_file->size()),
+    max_uncompressed_file_size_(kMaxUncompressedZipSize) {
+  ReadToc();
+}
+
+// Private.
+void ZipFile::ReadToc() {
+  // Fill the table of contents for this zipfile.  minizip only reads
+  // through the memory "file".
   zlib_filefunc_def api;
   if (voidpf mem_stream = mem_simple_create_file(
-      &api, const_cast<void*>(static_cast<const void*>(data.data())),
-      data.size())) {
+      &api, const_cast<void*>(static_cast<const void*>(bytes_)), size_)) {
     unzFile zfile = libkml_unzAttach(mem_stream, &api);
     if (zfile) {
       unz_file_info finfo;
@@ -108,16 +132,42 @@ ZipFile::ZipFile(const string& data)
 
 // Private. Class constructed with static methods.
 ZipFile::ZipFile(MinizipFile* minizip_file)
-  : minizip_file_(minizip_file),
+  : minizip_file_(minizip_file), mapped_data_(NULL), bytes_(NULL),
+    size_(0),
     max_uncompressed_file_size_(kMaxUncompressedZipSize) {}
 
 ZipFile::~ZipFile() {
   // Scoped ptr takes care of minizip_file_.
+  delete static_cast<string*>(mapped_data_);
 }
 
 // Static.
 bool ZipFile::IsZipData(const string& zip_data) {
-  return zip_data.substr(0, 4) == "PK\003\004" ? true : false;
+  return IsZipData(zip_data.data(), zip_data.size());
+}
+
+// Static.
+bool ZipFile::IsZipData(const char* data, size_t size) {
+  return size >= 4 && memcmp(data, "PK\003\004", 4) == 0;
+}
+
+const string& ZipFile::get_data() const {
+  if (!mapped_file_.get()) {
+    return data_;
+  }
+  // Each thread which finds no copy makes one, and only the first to
+  // publish its copy keeps it.
+  void* copy = AtomicCompareAndSwap(&mapped_data_, NULL, NULL);
+  if (!copy) {
+    string* own_copy = new string(bytes_, size_);
+    copy = AtomicCompareAndSwap(&mapped_data_, NULL, own_copy);
+    if (copy) {
+      delete own_copy;
+    } else {
+      copy = own_copy;
+    }
+  }
+  return *static_cast<string*>(copy);
 }
 
 bool ZipFile::FindFirstOf(const string& file_extension,
@@ -173,8 +223,7 @@ bool ZipFile::GetEntry(const string& path_in_zip,
   }
   zlib_filefunc_def api;
   voidpf mem_stream = mem_simple_create_file(
-      &api, const_cast<void*>(static_cast<const void*>(data_.data())),
-      data_.size());
+      &api, const_cast<void*>(static_cast<const void*>(bytes_)), size_);
   if (!mem_stream) {
     return false;
   }
@@ -29,6 +29,7 @@
 #define KML_BASE_ZIP_FILE_H__
 
 #include "boost/scoped_ptr.hpp"
+#include "kml/base/file.h"
 #include "kml/base/string_util.h"
 #include "kml/base/util.h"
 
@@ -48,7 +49,8 @@ class ZipFile {
   static ZipFile* OpenFromString(const string& zip_data);
 
   // Open a ZIP file at file_path suitable for reading. Will return NULL on any
-  // internal error.
+  // internal error.  The file is memory mapped where possible such that the
+  // central directory and the entries are read directly from the mapping.
   static ZipFile* OpenFromFile(const char* file_path);
 
   // Create a ZIP file suitable for writing. Will return NULL on any internal
@@ -69,6 +71,7 @@ class ZipFile {
   // Returns true if zip_data looks like a PK ZIP archive. This is the only
   // supported ZIP variant.
   static bool IsZipData(const string& zip_data);
+  static bool IsZipData(const char* data, size_t size);
 
   // Finds the first file in the ZIP file that ends with the given file
   // extension and writes the entire path into path_in_zip. Returns false
@@ -93,8 +96,10 @@ class ZipFile {
   // the data of path_in_zip are read into it.
   bool GetEntry(const string& path_in_zip, string* output) const;
 
-  // Returns the raw bytes of this ZipFile.
-  const string& get_data() const { return data_; }
+  // Returns the raw bytes of this ZipFile.  For a ZipFile opened from a
+  // mapped file this copies the mapping on first use, which is safe from
+  // several threads at once.
+  const string& get_data() const;
 
   // Writes data to path_in_zip. The path must be relative to the root of the
   // archive. e.g. AddEntry(data, "somedir/file.png"). Specifically, paths that
@@ -108,10 +113,22 @@ class ZipFile {
  private:
   // The constructor used to open a ZIP file in-memory, suitable for reading.
   ZipFile(const string& data);
+  // The constructor used to open a mapped ZIP file, suitable for reading.
+  // The ZipFile takes ownership of the MappedFile.
+  ZipFile(MappedFile* mapped_file);
   // The constructor used in creation of a ZIP file suitable for writing.
   ZipFile(MinizipFile* minizip_file);
+  // This reads the table of contents from the bytes of the ZIP file.
+  void ReadToc();
   boost::scoped_ptr<MinizipFile> minizip_file_;
+  // A ZIP file open for reading is held in data_ or in mapped_file_.
+  // bytes_ and size_ refer to whichever holds it.
   string data_;
+  boost::scoped_ptr<MappedFile> mapped_file_;
+  // The string get_data() copies the mapping to, set once.
+  mutable void* mapped_data_;
+  const char* bytes_;
+  size_t size_;
   StringVector zipfile_toc_;
   unsigned long max_uncompressed_file_size_;
   LIBKML_DISALLOW_EVIL_CONSTRUCTORS(ZipFile);
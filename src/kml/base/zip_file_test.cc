@@ -29,6 +29,7 @@
 #include "boost/scoped_ptr.hpp"
 #include "kml/base/file.h"
 #include "kml/base/tempfile.h"
+#include "kml/base/thread.h"
 #include "gtest/gtest.h"
 #include "minizip/zip.h"
 
@@ -196,6 +197,57 @@ TEST_F(ZipFileTest, TestGetKmzData) {
   ASSERT_EQ(kmz_data, zip_file_->get_data());
 }
 
+TEST_F(ZipFileTest, TestGetKmzDataFromFile) {
+  // The ZipFile is read from a mapping of the file.
+  const string kGoodKmz = string(DATADIR) + "/kmz/doc.kmz";
+  string kmz_data;
+  File::ReadFileToString(kGoodKmz, &kmz_data);
+  zip_file_.reset(ZipFile::OpenFromFile(kGoodKmz.c_str()));
+  ASSERT_TRUE(zip_file_);
+  string kml;
+  ASSERT_TRUE(zip_file_->GetEntry("doc.kml", &kml));
+  ASSERT_FALSE(kml.empty());
+  ASSERT_EQ(kmz_data, zip_file_->get_data());
+  ASSERT_TRUE(ZipFile::IsZipData(kmz_data.data(), kmz_data.size()));
+  ASSERT_FALSE(ZipFile::IsZipData(kmz_data.data(), 3));
+}
+
+// This gets the data of a ZipFile.
+class GetDataRunnable : public Runnable {
+ public:
+  GetDataRunnable(const ZipFile& zip_file)
+    : zip_file_(zip_file), data_(NULL) {}
+  virtual void Run() {
+    data_ = &zip_file_.get_data();
+  }
+  const string* get_data() const { return data_; }
+ private:
+  const ZipFile& zip_file_;
+  const string* data_;
+};
+
+TEST_F(ZipFileTest, TestGetKmzDataFromFileInParallel) {
+  // Every thread sees the one copy of the mapping.
+  const string kGoodKmz = string(DATADIR) + "/kmz/doc.kmz";
+  string kmz_data;
+  File::ReadFileToString(kGoodKmz, &kmz_data);
+  zip_file_.reset(ZipFile::OpenFromFile(kGoodKmz.c_str()));
+  ASSERT_TRUE(zip_file_);
+  const size_t kThreadCount = 8;
+  std::vector<GetDataRunnable*> get_datas;
+  std::vector<Runnable*> runnables;
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    get_datas.push_back(new GetDataRunnable(*zip_file_));
+    runnables.push_back(get_datas.back());
+  }
+  RunInParallel(runnables, kThreadCount);
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    ASSERT_EQ(&zip_file_->get_data(), get_datas[i]->get_data());
+    delete get_datas[i];
+  }
+  ASSERT_EQ(kmz_data, zip_file_->get_data());
+}
+
 TEST_F(ZipFileTest, TestAddEntry) {
   TempFilePtr tempfile = TempFile::CreateTempFile();
   ASSERT_TRUE(tempfile != NULL);
@@ -0,0 +1,124 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of the Arena class.
+
+#include "kml/dom/arena.h"
+#include <new>
+
+namespace kmldom {
+
+const size_t Arena::kMinBlockSize;
+const size_t Arena::kMaxBlockSize;
+const size_t Arena::kAlignment;
+
+Arena::Arena()
+  : next_(NULL),
+    end_(NULL),
+    allocated_size_(0),
+    block_size_(0),
+    intern_strings_(false),
+    interned_count_(0) {
+}
+
+Arena::~Arena() {
+  for (size_t i = 0; i < string_table_.size(); ++i) {
+    if (string_table_[i]) {
+      string_table_[i]->~string();
+    }
+  }
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    delete [] blocks_[i];
+  }
+}
+
+void* Arena::Allocate(size_t size) {
+  size = (size + kAlignment - 1) & ~(kAlignment - 1);
+  if (size > static_cast<size_t>(end_ - next_)) {
+    // Each block is as large as all before it such that the blocks are few.
+    size_t new_block_size = blocks_.empty() ? kMinBlockSize : block_size_;
+    if (new_block_size > kMaxBlockSize) {
+      new_block_size = kMaxBlockSize;
+    }
+    if (new_block_size < size) {
+      new_block_size = size;
+    }
+    // The memory of operator new[] is aligned for any type.
+    char* block = new char[new_block_size];
+    blocks_.push_back(block);
+    block_size_ += new_block_size;
+    next_ = block;
+    end_ = block + new_block_size;
+  }
+  void* p = next_;
+  next_ += size;
+  allocated_size_ += size;
+  return p;
+}
+
+// Private.  This is the FNV-1a hash of the string.
+static size_t HashString(const string& s) {
+  uint32_t hash = 2166136261U;
+  for (size_t i = 0; i < s.size(); ++i) {
+    hash = (hash ^ static_cast<unsigned char>(s[i])) * 16777619U;
+  }
+  return hash;
+}
+
+const string* Arena::Intern(const string& value) {
+  // The table is kept at most half full.
+  if (2 * (interned_count_ + 1) > string_table_.size()) {
+    GrowStringTable();
+  }
+  const size_t mask = string_table_.size() - 1;
+  size_t i = HashString(value) & mask;
+  while (string_table_[i]) {
+    if (*string_table_[i] == value) {
+      return string_table_[i];
+    }
+    i = (i + 1) & mask;
+  }
+  string_table_[i] = new (Allocate(sizeof(string))) string(value);
+  ++interned_count_;
+  return string_table_[i];
+}
+
+void Arena::GrowStringTable() {
+  std::vector<string*> string_table(
+      string_table_.empty() ? 64 : 2 * string_table_.size());
+  const size_t mask = string_table.size() - 1;
+  for (size_t i = 0; i < string_table_.size(); ++i) {
+    if (string* s = string_table_[i]) {
+      size_t j = HashString(*s) & mask;
+      while (string_table[j]) {
+        j = (j + 1) & mask;
+      }
+      string_table[j] = s;
+    }
+  }
+  string_table_.swap(string_table);
+}
+
+}  // end namespace kmldom
@@ -0,0 +1,113 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of the Arena class from which the
+// Elements of a parse may be allocated.  See ParseOptions::arena.
+
+#ifndef KML_DOM_ARENA_H__
+#define KML_DOM_ARENA_H__
+
+#include <vector>
+#include "boost/intrusive_ptr.hpp"
+#include "kml/base/referent.h"
+#include "kml/base/util.h"
+
+namespace kmldom {
+
+// An Arena hands out memory from large blocks and frees the blocks all at
+// once as it is destroyed.  Each Element allocated in an Arena holds a
+// reference to it such that the Arena lives as long as any of its Elements.
+// An Arena may also intern strings: the Elements of an Arena which interns
+// strings share one copy of each value of the fields most often repeated in
+// practice.  These are <description> and <styleUrl> of Features and Pairs,
+// the name of <Data> and <SimpleData> and the schemaUrl of <SchemaData>.
+// An Arena is not thread-safe.
+class Arena : public kmlbase::Referent {
+ public:
+  // The blocks start small and double in size up to kMaxBlockSize.
+  static const size_t kMinBlockSize = 4096;
+  static const size_t kMaxBlockSize = 1024 * 1024;
+
+  // Each allocation is aligned to this.  No Element has a member which
+  // needs a stricter alignment.
+  static const size_t kAlignment = 8;
+
+  Arena();
+  virtual ~Arena();
+
+  // This returns size bytes aligned to kAlignment.  The memory is freed only
+  // when the Arena is destroyed.
+  void* Allocate(size_t size);
+
+  // This is the number of bytes returned by Allocate() so far.
+  size_t get_allocated_size() const {
+    return allocated_size_;
+  }
+
+  // This is the number of bytes in the blocks of the Arena.
+  size_t get_block_size() const {
+    return block_size_;
+  }
+
+  // Whether the Elements of this Arena intern their strings.  The default
+  // is false.
+  void set_intern_strings(bool intern_strings) {
+    intern_strings_ = intern_strings;
+  }
+  bool get_intern_strings() const {
+    return intern_strings_;
+  }
+
+  // This returns the string equal to value held by this Arena, adding one
+  // if there is none.  The string is never changed and lives as long as the
+  // Arena.
+  const string* Intern(const string& value);
+
+  // This is the number of distinct strings interned.
+  size_t get_interned_count() const {
+    return interned_count_;
+  }
+
+ private:
+  // This doubles the size of the hash table of interned strings.
+  void GrowStringTable();
+  std::vector<char*> blocks_;
+  char* next_;
+  char* end_;
+  size_t allocated_size_;
+  size_t block_size_;
+  bool intern_strings_;
+  // An open addressed hash table of the interned strings.  Its size is a
+  // power of two.  The strings themselves are allocated in the Arena.
+  std::vector<string*> string_table_;
+  size_t interned_count_;
+  LIBKML_DISALLOW_EVIL_CONSTRUCTORS(Arena);
+};
+
+typedef boost::intrusive_ptr<Arena> ArenaPtr;
+
+}  // end namespace kmldom
+
+#endif  // KML_DOM_ARENA_H__
@@ -0,0 +1,283 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the unit tests for the Arena class and the Elements
+// created in an Arena.
+
+#include "kml/dom/arena.h"
+#include "gtest/gtest.h"
+#include "kml/base/string_util.h"
+#include "kml/dom/kml_cast.h"
+#include "kml/dom/kml_factory.h"
+#include "kml/dom/kml_funcs.h"
+#include "kml/dom/parser.h"
+
+namespace kmldom {
+
+class ArenaTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    arena_ = new Arena;
+  }
+
+  ArenaPtr arena_;
+};
+
+TEST_F(ArenaTest, TestAllocate) {
+  ASSERT_EQ(static_cast<size_t>(0), arena_->get_allocated_size());
+  ASSERT_EQ(static_cast<size_t>(0), arena_->get_block_size());
+  char* p = static_cast<char*>(arena_->Allocate(1));
+  ASSERT_TRUE(p);
+  ASSERT_EQ(static_cast<size_t>(0),
+            reinterpret_cast<size_t>(p) % Arena::kAlignment);
+  ASSERT_EQ(Arena::kAlignment, arena_->get_allocated_size());
+  ASSERT_EQ(Arena::kMinBlockSize, arena_->get_block_size());
+  // The next allocation follows the first.
+  ASSERT_EQ(p + Arena::kAlignment, arena_->Allocate(Arena::kAlignment));
+  ASSERT_EQ(2 * Arena::kAlignment, arena_->get_allocated_size());
+}
+
+TEST_F(ArenaTest, TestAllocateGrows) {
+  size_t allocated_size = 0;
+  while (arena_->get_block_size() < 2 * Arena::kMaxBlockSize) {
+    memset(arena_->Allocate(100), 0, 100);
+    allocated_size += 104;
+  }
+  ASSERT_EQ(allocated_size, arena_->get_allocated_size());
+  // A block never exceeds kMaxBlockSize unless one allocation does.
+  void* large = arena_->Allocate(Arena::kMaxBlockSize + 1);
+  ASSERT_TRUE(large);
+  memset(large, 0, Arena::kMaxBlockSize + 1);
+}
+
+TEST_F(ArenaTest, TestCreateInArena) {
+  KmlFactory* factory = KmlFactory::GetFactory();
+  ASSERT_EQ(1, arena_->get_ref_count());
+  ElementPtr placemark = factory->CreateElementById(Type_Placemark,
+                                                    arena_.get());
+  ASSERT_TRUE(AsPlacemark(placemark));
+  FieldPtr field = factory->CreateFieldById(Type_name, arena_.get());
+  ASSERT_EQ(Type_name, field->Type());
+  // Each Element holds a reference to the Arena.
+  ASSERT_EQ(3, arena_->get_ref_count());
+  ASSERT_LT(sizeof(Placemark) + sizeof(Field), arena_->get_allocated_size());
+  placemark = NULL;
+  ASSERT_EQ(2, arena_->get_ref_count());
+  field = NULL;
+  ASSERT_EQ(1, arena_->get_ref_count());
+  // No Arena is the same as CreateElementById(Type_Placemark).
+  placemark = factory->CreateElementById(Type_Placemark, NULL);
+  ASSERT_TRUE(AsPlacemark(placemark));
+  ASSERT_EQ(1, arena_->get_ref_count());
+}
+
+static const char kKml[] =
+  "<kml>"
+  "<Document>"
+  "<Placemark id=\"a\"><name>a</name>"
+  "<Point><coordinates>1,2,3</coordinates></Point></Placemark>"
+  "<Placemark id=\"b\"><name>b</name>"
+  "<LineString><coordinates>1,2 3,4</coordinates></LineString></Placemark>"
+  "<Folder><Placemark id=\"c\"><name>c</name></Placemark></Folder>"
+  "</Document>"
+  "</kml>";
+
+TEST_F(ArenaTest, TestParseInArena) {
+  ParseOptions options;
+  options.arena = arena_;
+  Parser parser;
+  parser.set_options(options);
+  ElementPtr root = parser.Parse(kKml, NULL);
+  ASSERT_TRUE(root);
+  ASSERT_EQ(SerializeRaw(ParseKml(kKml)), SerializeRaw(root));
+  ASSERT_LT(static_cast<size_t>(0), arena_->get_allocated_size());
+  options.arena = NULL;
+  parser.set_options(options);
+  ASSERT_LT(1, arena_->get_ref_count());
+
+  // An Element keeps the Arena when all else is gone.
+  PlacemarkPtr placemark = AsPlacemark(
+      AsDocument(AsKml(root)->get_feature())->get_feature_array_at(1));
+  ASSERT_TRUE(placemark);
+  root = NULL;
+  ASSERT_LT(1, arena_->get_ref_count());
+  arena_ = NULL;
+  ASSERT_EQ(string("b"), placemark->get_name());
+  ASSERT_EQ(static_cast<size_t>(2), AsLineString(placemark->get_geometry())->
+            get_coordinates()->get_coordinates_array_size());
+}
+
+TEST_F(ArenaTest, TestParseParallelInArena) {
+  string kml("<kml><Document>");
+  for (int i = 0; i < 1000; ++i) {
+    kml.append("<Placemark><name>a placemark</name>"
+               "<Point><coordinates>1,2,3</coordinates></Point></Placemark>");
+  }
+  kml.append("</Document></kml>");
+  ParseOptions options;
+  options.arena = arena_;
+  Parser parser;
+  parser.set_options(options);
+  ElementPtr root = parser.ParseParallel(kml, 4, 4096, NULL);
+  ASSERT_TRUE(root);
+  ASSERT_EQ(SerializeRaw(ParseKml(kml)), SerializeRaw(root));
+  root = NULL;
+  parser.set_options(ParseOptions());
+  options.arena = NULL;
+  ASSERT_EQ(1, arena_->get_ref_count());
+}
+
+TEST_F(ArenaTest, TestIntern) {
+  ASSERT_FALSE(arena_->get_intern_strings());
+  const string* a = arena_->Intern("a");
+  ASSERT_EQ(string("a"), *a);
+  ASSERT_EQ(a, arena_->Intern(string("a")));
+  ASSERT_NE(a, arena_->Intern("b"));
+  ASSERT_EQ(static_cast<size_t>(2), arena_->get_interned_count());
+  // The strings stay put as the table grows.
+  for (int i = 0; i < 1000; ++i) {
+    arena_->Intern(kmlbase::ToString(i));
+  }
+  ASSERT_EQ(static_cast<size_t>(1002), arena_->get_interned_count());
+  ASSERT_EQ(a, arena_->Intern("a"));
+  ASSERT_EQ(string("999"), *arena_->Intern("999"));
+  ASSERT_EQ(static_cast<size_t>(1002), arena_->get_interned_count());
+}
+
+static const char kRepeatedKml[] =
+  "<kml>"
+  "<Document>"
+  "<StyleMap><Pair><key>normal</key><styleUrl>#s</styleUrl></Pair></StyleMap>"
+  "<Placemark><description>d</description><styleUrl>#s</styleUrl>"
+  "<ExtendedData><Data name=\"n\"><value>1</value></Data>"
+  "<SchemaData schemaUrl=\"#t\"><SimpleData name=\"n\">1</SimpleData>"
+  "</SchemaData></ExtendedData></Placemark>"
+  "<Placemark><description>d</description><styleUrl>#s</styleUrl>"
+  "<ExtendedData><Data name=\"n\"><value>2</value></Data>"
+  "<SchemaData schemaUrl=\"#t\"><SimpleData name=\"n\">2</SimpleData>"
+  "</SchemaData></ExtendedData></Placemark>"
+  "</Document>"
+  "</kml>";
+
+// Each Placemark of kRepeatedKml.
+struct RepeatedFields {
+  RepeatedFields(const DocumentPtr& document, size_t index) {
+    placemark = AsPlacemark(document->get_feature_array_at(index));
+    const ExtendedDataPtr& extendeddata = placemark->get_extendeddata();
+    data = extendeddata->get_data_array_at(0);
+    schemadata = extendeddata->get_schemadata_array_at(0);
+    simpledata = schemadata->get_simpledata_array_at(0);
+  }
+  PlacemarkPtr placemark;
+  DataPtr data;
+  SchemaDataPtr schemadata;
+  SimpleDataPtr simpledata;
+};
+
+TEST_F(ArenaTest, TestParseInternStrings) {
+  arena_->set_intern_strings(true);
+  ParseOptions options;
+  options.arena = arena_;
+  Parser parser;
+  parser.set_options(options);
+  ElementPtr root = parser.Parse(kRepeatedKml, NULL);
+  ASSERT_TRUE(root);
+  ASSERT_EQ(SerializeRaw(ParseKml(kRepeatedKml)), SerializeRaw(root));
+  // "#s", "d", "n" and "#t".
+  ASSERT_EQ(static_cast<size_t>(4), arena_->get_interned_count());
+
+  const DocumentPtr document = AsDocument(AsKml(root)->get_feature());
+  RepeatedFields first(document, 0);
+  RepeatedFields second(document, 1);
+  const PairPtr pair = AsStyleMap(document->get_styleselector_array_at(0))->
+      get_pair_array_at(0);
+  ASSERT_EQ(&pair->get_styleurl(), &first.placemark->get_styleurl());
+  ASSERT_EQ(&first.placemark->get_styleurl(),
+            &second.placemark->get_styleurl());
+  ASSERT_EQ(&first.placemark->get_description(),
+            &second.placemark->get_description());
+  ASSERT_EQ(&first.data->get_name(), &second.data->get_name());
+  ASSERT_EQ(&first.data->get_name(), &second.simpledata->get_name());
+  ASSERT_EQ(&first.schemadata->get_schemaurl(),
+            &second.schemadata->get_schemaurl());
+
+  // A change to one Element leaves the others as they are.
+  first.placemark->styleurl().append("t");
+  second.data->set_name("m");
+  ASSERT_EQ(string("#st"), first.placemark->get_styleurl());
+  ASSERT_EQ(string("#s"), second.placemark->get_styleurl());
+  ASSERT_EQ(string("n"), first.data->get_name());
+  ASSERT_EQ(string("m"), second.data->get_name());
+  ASSERT_EQ(string("#s"), *arena_->Intern("#s"));
+
+  // The interned strings live as long as any Element.
+  options.arena = NULL;
+  parser.set_options(options);
+  root = NULL;
+  first = second;
+  arena_ = NULL;
+  ASSERT_EQ(string("#s"), first.placemark->get_styleurl());
+  ASSERT_EQ(string("n"), first.simpledata->get_name());
+}
+
+TEST_F(ArenaTest, TestParseWithoutInternStrings) {
+  ParseOptions options;
+  options.arena = arena_;
+  Parser parser;
+  parser.set_options(options);
+  ElementPtr root = parser.Parse(kRepeatedKml, NULL);
+  ASSERT_TRUE(root);
+  ASSERT_EQ(static_cast<size_t>(0), arena_->get_interned_count());
+  const DocumentPtr document = AsDocument(AsKml(root)->get_feature());
+  RepeatedFields first(document, 0);
+  RepeatedFields second(document, 1);
+  ASSERT_EQ(first.placemark->get_styleurl(),
+            second.placemark->get_styleurl());
+  ASSERT_NE(&first.placemark->get_styleurl(),
+            &second.placemark->get_styleurl());
+}
+
+TEST_F(ArenaTest, TestParseParallelInternStrings) {
+  string kml("<kml><Document>");
+  for (int i = 0; i < 1000; ++i) {
+    kml.append("<Placemark><styleUrl>#s</styleUrl>"
+               "<Point><coordinates>1,2,3</coordinates></Point></Placemark>");
+  }
+  kml.append("</Document></kml>");
+  arena_->set_intern_strings(true);
+  ParseOptions options;
+  options.arena = arena_;
+  Parser parser;
+  parser.set_options(options);
+  ElementPtr root = parser.ParseParallel(kml, 4, 4096, NULL);
+  ASSERT_TRUE(root);
+  ASSERT_EQ(SerializeRaw(ParseKml(kml)), SerializeRaw(root));
+  // Each chunk interns in an Arena of its own.
+  const DocumentPtr document = AsDocument(AsKml(root)->get_feature());
+  ASSERT_EQ(&document->get_feature_array_at(0)->get_styleurl(),
+            &document->get_feature_array_at(1)->get_styleurl());
+}
+
+}  // end namespace kmldom
@@ -26,6 +26,7 @@
 // This file contains the implementation of the abstract Container element.
 
 #include "kml/dom/container.h"
+#include <algorithm>
 #include "kml/dom/feature.h"
 #include "kml/dom/kml_cast.h"
 #include "kml/dom/kml_ptr.h"
@@ -33,7 +34,9 @@
 
 namespace kmldom {
 
-Container::Container() {}
+Container::Container()
+  : lazy_feature_count_(0) {
+}
 
 Container::~Container() {
   // feature_array_'s destructor calls the destructor of each FeaturePtr
@@ -44,6 +47,72 @@ void Container::add_feature(const FeaturePtr& feature) {
   AddComplexChild(feature, &feature_array_);
 }
 
+void Container::AddLazyFeature(
+    const LazyFeatureSourcePtr& lazy_feature_source, size_t begin,
+    size_t end) {
+  // Lazy Features always precede all others.  One which would follow a
+  // parsed Feature is parsed now instead.
+  if (feature_array_.size() != lazy_feature_ranges_.size()) {
+    if (FeaturePtr feature =
+            lazy_feature_source->ParseFeature(begin, end, this)) {
+      add_feature(feature);
+    }
+    return;
+  }
+  lazy_feature_source_ = lazy_feature_source;
+  lazy_feature_ranges_.push_back(std::make_pair(begin, end));
+  feature_array_.push_back(NULL);
+  ++lazy_feature_count_;
+}
+
+void Container::ParseLazyFeatureAt(size_t index) const {
+  if (!lazy_feature_source_ || index >= lazy_feature_ranges_.size()) {
+    return;
+  }
+  // The Feature is parsed into the otherwise const Container.
+  Container* container = const_cast<Container*>(this);
+  FeaturePtr feature = lazy_feature_source_->ParseFeature(
+      lazy_feature_ranges_[index].first, lazy_feature_ranges_[index].second,
+      container);
+  // A Feature which fails to parse stays unparsed.
+  if (feature &&
+      container->SetComplexChild(feature, &feature_array_[index])) {
+    --lazy_feature_count_;
+  }
+}
+
+void Container::ParseLazyFeatures() const {
+  for (size_t i = 0; lazy_feature_count_ > 0 &&
+                     i < lazy_feature_ranges_.size(); ++i) {
+    if (!feature_array_[i]) {
+      ParseLazyFeatureAt(i);
+    }
+  }
+}
+
+// Orders the ranges by their begin offset.
+static bool RangeBeginsBefore(const std::pair<size_t, size_t>& range,
+                              size_t begin) {
+  return range.first < begin;
+}
+
+size_t Container::FindLazyFeatureById(const string& id) const {
+  size_t begin;
+  if (lazy_feature_count_ == 0 ||
+      !lazy_feature_source_->FindFeatureById(id, &begin)) {
+    return feature_array_.size();
+  }
+  // The ranges remain in document order as Features are deleted.
+  std::vector<std::pair<size_t, size_t> >::const_iterator find =
+      std::lower_bound(lazy_feature_ranges_.begin(),
+                       lazy_feature_ranges_.end(), begin, RangeBeginsBefore);
+  if (find == lazy_feature_ranges_.end() || find->first != begin) {
+    return feature_array_.size();
+  }
+  const size_t index = find - lazy_feature_ranges_.begin();
+  return feature_array_[index] ? feature_array_.size() : index;
+}
+
 void Container::AddElement(const ElementPtr& element) {
   if (FeaturePtr feature = AsFeature(element)) {
     add_feature(feature);
@@ -55,6 +124,16 @@ void Container::AddElement(const ElementPtr& element) {
 // This exists for the benefit of Document which has special serialization
 // needs.  See document.cc.
 void Container::SerializeFeatureArray(Serializer& serializer) const {
+  // An unparsed Feature which the serializer saves as its KML stays
+  // unparsed and NULL.
+  for (size_t i = 0; lazy_feature_count_ > 0 &&
+                     i < lazy_feature_ranges_.size(); ++i) {
+    if (!feature_array_[i] &&
+        !serializer.SaveUnparsedFeature(lazy_feature_ranges_[i].second -
+                                        lazy_feature_ranges_[i].first)) {
+      ParseLazyFeatureAt(i);
+    }
+  }
   serializer.SaveElementGroupArray(feature_array_, Type_Feature);
 }
 
@@ -65,25 +144,35 @@ void Container::Serialize(Serializer& serializer) const {
 
 FeaturePtr Container::DeleteFeatureById(const string& id) {
   // TODO: push all this to Element to properly/centrally remove parent.
-  std::vector<FeaturePtr>::iterator iter = feature_array_.begin();
-  for (; iter != feature_array_.end(); ++iter) {
-    FeaturePtr feature = *iter;
-    if (feature->has_id() && id == feature->get_id()) {
+  ParseLazyFeatures();
+  // A lazy Feature which failed to parse is NULL.
+  for (size_t i = 0; i < feature_array_.size(); ++i) {
+    if (feature_array_[i] && feature_array_[i]->has_id() &&
+        id == feature_array_[i]->get_id()) {
   // TODO: if Container is in a KmlFile remove Feature from object map
-      feature_array_.erase(iter);
-      return feature;
+      return DeleteFeatureAt(i);
     }
   }
   return NULL;
 }
 
 FeaturePtr Container::DeleteFeatureAt(size_t i) {
+  if (i < lazy_feature_ranges_.size()) {
+    get_feature_array_at(i);  // The caller gets the Feature.
+    lazy_feature_ranges_.erase(lazy_feature_ranges_.begin() + i);
+  }
   return Element::DeleteFromArrayAt(&feature_array_, i);
 }
 
 void Container::AcceptChildren(VisitorDriver* driver) {
+  ParseLazyFeatures();
   Feature::AcceptChildren(driver);
-  Element::AcceptRepeated<FeaturePtr>(&feature_array_, driver);
+  // A lazy Feature which failed to parse is NULL.
+  for (size_t i = 0; i < feature_array_.size(); ++i) {
+    if (feature_array_[i]) {
+      driver->Visit(feature_array_[i]);
+    }
+  }
 }
 
 }  // end namespace kmldom
@@ -27,8 +27,10 @@
 #define KML_DOM_CONTAINER_H__
 
 #include <vector>
+#include <utility>
 #include "kml/dom/feature.h"
 #include "kml/dom/kml22.h"
+#include "kml/dom/lazy_feature_source.h"
 #include "kml/base/util.h"
 
 namespace kmldom {
@@ -52,10 +54,33 @@ class Container : public Feature {
     return feature_array_.size();
   }
 
+  // If the Features of this Container are parsed lazily (see
+  // Parser::ParseLazy) the Feature at index is parsed on first access.  NULL
+  // is returned if it fails to parse: see LazyFeatureSource::get_errors().
   const FeaturePtr& get_feature_array_at(size_t index) const {
+    if (!feature_array_[index]) {
+      ParseLazyFeatureAt(index);
+    }
     return feature_array_[index];
   }
 
+  // This returns true if any of the Features of this Container are yet to be
+  // parsed.
+  bool has_lazy_features() const {
+    return lazy_feature_source_ && lazy_feature_count_ > 0;
+  }
+
+  // This returns the index of the unparsed Feature which holds the Object with
+  // the given id.  If there is no such Feature get_feature_array_size() is
+  // returned.
+  size_t FindLazyFeatureById(const string& id) const;
+
+  // This returns the source of the Features of this Container if they were
+  // parsed lazily, else NULL.
+  const LazyFeatureSourcePtr& get_lazy_feature_source() const {
+    return lazy_feature_source_;
+  }
+
   // The following two methods delete a Feature from the Container.  If the
   // id='ed or index'ed Feature exists a pointer to it is returned and it is
   // removed from the Container.  This Feature can be used by client code as
@@ -86,7 +111,23 @@ class Container : public Feature {
   virtual void Serialize(Serializer& serializer) const;
 
  private:
-  std::vector<FeaturePtr> feature_array_;
+  friend class Parser;
+  // This appends a Feature whose KML at [begin, end) of the source is parsed
+  // on first access.  As the lazy Features precede all others one added
+  // after a parsed Feature is parsed right away.
+  void AddLazyFeature(const LazyFeatureSourcePtr& lazy_feature_source,
+                      size_t begin, size_t end);
+  // These parse the unparsed Feature at index, and all unparsed Features.
+  void ParseLazyFeatureAt(size_t index) const;
+  void ParseLazyFeatures() const;
+
+  // An unparsed Feature is NULL in feature_array_.  The lazily added
+  // Features precede all others and the range of each in the
+  // lazy_feature_source_ is at the same index in lazy_feature_ranges_.
+  mutable std::vector<FeaturePtr> feature_array_;
+  LazyFeatureSourcePtr lazy_feature_source_;
+  std::vector<std::pair<size_t, size_t> > lazy_feature_ranges_;
+  mutable size_t lazy_feature_count_;
   LIBKML_DISALLOW_EVIL_CONSTRUCTORS(Container);
 };
 
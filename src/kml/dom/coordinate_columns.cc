@@ -0,0 +1,289 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of the CoordinateColumns class.
+
+#include "kml/dom/coordinate_columns.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+using kmlbase::Vec3;
+
+namespace kmldom {
+
+const double CoordinateColumns::kFixedDegreeScale = 1e7;
+const double CoordinateColumns::kFixedMeterScale = 1e3;
+
+// The magnitude of the largest value of a COORDINATES_FIXED column.
+static const double kFixedMax = 2147483647.0;
+
+// Private.  The size in bytes of one value of a column of the given type.
+static size_t GetValueSize(CoordinatesStorage type) {
+  return type == COORDINATES_DOUBLE ? sizeof(double) : sizeof(float);
+}
+
+// Private.  The scale of a COORDINATES_FIXED column.
+static double GetFixedScale(int column) {
+  return column == 2 ? CoordinateColumns::kFixedMeterScale :
+                       CoordinateColumns::kFixedDegreeScale;
+}
+
+void CoordinateColumns::Release() {
+  // Even the last reference is released atomically as another thread may
+  // be sharing the block at the same moment.
+  if (header_ && kmlbase::AtomicAdd(&header_->ref_count, -1) == 0) {
+    free(header_);
+  }
+  header_ = NULL;
+}
+
+void CoordinateColumns::Reset(CoordinatesStorage type) {
+  Release();
+  if (type != COORDINATES_VEC3) {
+    Relayout(type, 0, 0);
+  }
+}
+
+void CoordinateColumns::Share(const CoordinateColumns& columns) {
+  if (columns.header_ == header_) {
+    return;
+  }
+  Release();
+  header_ = columns.header_;
+  if (header_) {
+    kmlbase::AtomicAdd(&header_->ref_count, 1);
+  }
+}
+
+size_t CoordinateColumns::GetBlockSize(CoordinatesStorage type,
+                                       size_t capacity, uint32_t flags) {
+  if (type == COORDINATES_VEC3) {
+    return sizeof(Header) + capacity * sizeof(Vec3);
+  }
+  const size_t column_count = (flags & kHasAltitude) ? 3 : 2;
+  size_t block_size = sizeof(Header) +
+      column_count * capacity * GetValueSize(type);
+  if (flags & kHasAltitudeMask) {
+    block_size += capacity;
+  }
+  return block_size;
+}
+
+char* CoordinateColumns::GetColumn(int column) const {
+  return reinterpret_cast<char*>(header_ + 1) +
+      column * header_->capacity * GetValueSize(header_->type);
+}
+
+double CoordinateColumns::Get(int column, size_t index) const {
+  const char* p = GetColumn(column);
+  switch (header_->type) {
+    case COORDINATES_DOUBLE:
+      return reinterpret_cast<const double*>(p)[index];
+    case COORDINATES_FLOAT:
+      return reinterpret_cast<const float*>(p)[index];
+    default:
+      return reinterpret_cast<const int32_t*>(p)[index] /
+          GetFixedScale(column);
+  }
+}
+
+void CoordinateColumns::Set(int column, size_t index, double value) {
+  char* p = GetColumn(column);
+  switch (header_->type) {
+    case COORDINATES_DOUBLE:
+      reinterpret_cast<double*>(p)[index] = value;
+      break;
+    case COORDINATES_FLOAT:
+      reinterpret_cast<float*>(p)[index] = static_cast<float>(value);
+      break;
+    default:
+      reinterpret_cast<int32_t*>(p)[index] =
+          static_cast<int32_t>(floor(value * GetFixedScale(column) + 0.5));
+      break;
+  }
+}
+
+void CoordinateColumns::Relayout(CoordinatesStorage type, size_t capacity,
+                                 uint32_t flags) {
+  const size_t column_count = (flags & kHasAltitude) ? 3 : 2;
+  CoordinateColumns columns;
+  columns.header_ = static_cast<Header*>(
+      malloc(GetBlockSize(type, capacity, flags)));
+  columns.header_->type = type;
+  columns.header_->flags = flags;
+  columns.header_->size = size();
+  columns.header_->capacity = capacity;
+  columns.header_->ref_count = 1;
+  if (header_ && type == COORDINATES_VEC3) {
+    memcpy(columns.GetRows(), GetRows(), size() * sizeof(Vec3));
+  } else if (header_) {
+    const size_t size = header_->size;
+    const size_t old_column_count = has_altitude() ? 3 : 2;
+    for (size_t column = 0; column < column_count; ++column) {
+      if (column >= old_column_count) {
+        // Tuples without an altitude have 0.
+        memset(columns.GetColumn(column), 0, size * GetValueSize(type));
+      } else if (type == header_->type) {
+        memcpy(columns.GetColumn(column), GetColumn(column),
+               size * GetValueSize(type));
+      } else {
+        for (size_t i = 0; i < size; ++i) {
+          columns.Set(column, i, Get(column, i));
+        }
+      }
+    }
+    if (flags & kHasAltitudeMask) {
+      uint8_t* mask = reinterpret_cast<uint8_t*>(
+          columns.GetColumn(column_count));
+      if (header_->flags & kHasAltitudeMask) {
+        memcpy(mask, get_altitude_mask(), size);
+      } else {
+        // Until now all or none of the tuples had an altitude.
+        memset(mask, has_altitude() ? 1 : 0, size);
+      }
+    }
+  }
+  std::swap(header_, columns.header_);
+}
+
+void CoordinateColumns::ResizeRows(size_t capacity) {
+  const size_t size = this->size();
+  header_ = static_cast<Header*>(
+      realloc(header_, GetBlockSize(COORDINATES_VEC3, capacity, 0)));
+  header_->type = COORDINATES_VEC3;
+  header_->flags = 0;
+  header_->size = size;
+  header_->capacity = capacity;
+  header_->ref_count = 1;
+}
+
+void CoordinateColumns::PushBack(const Vec3& vec3) {
+  if (get_type() == COORDINATES_VEC3) {
+    size_t capacity = header_ ? header_->capacity : 0;
+    if (size() == capacity) {
+      capacity = capacity < 2 ? capacity + 1 : 2 * capacity;
+    }
+    if (is_shared()) {
+      Relayout(COORDINATES_VEC3, capacity, 0);
+    } else if (!header_ || capacity != header_->capacity) {
+      ResizeRows(capacity);
+    }
+    GetRows()[header_->size++] = vec3;
+    return;
+  }
+  CoordinatesStorage type = header_->type;
+  if (type == COORDINATES_FIXED &&
+      !(fabs(vec3.get_longitude()) * kFixedDegreeScale <= kFixedMax &&
+        fabs(vec3.get_latitude()) * kFixedDegreeScale <= kFixedMax &&
+        fabs(vec3.get_altitude()) * kFixedMeterScale <= kFixedMax)) {
+    type = COORDINATES_DOUBLE;
+  }
+  uint32_t flags = header_->flags;
+  if (vec3.has_altitude() != has_altitude() && header_->size > 0) {
+    flags |= kHasAltitudeMask;
+  }
+  if (vec3.has_altitude()) {
+    flags |= kHasAltitude;
+  }
+  size_t capacity = header_->capacity;
+  if (header_->size == capacity) {
+    capacity = capacity < 2 ? capacity + 1 : 2 * capacity;
+  }
+  if (type != header_->type || flags != header_->flags ||
+      capacity != header_->capacity || is_shared()) {
+    Relayout(type, capacity, flags);
+  }
+  const size_t index = header_->size++;
+  Set(0, index, vec3.get_longitude());
+  Set(1, index, vec3.get_latitude());
+  if (flags & kHasAltitude) {
+    Set(2, index, vec3.get_altitude());
+  }
+  if (flags & kHasAltitudeMask) {
+    GetColumn(3)[index] = vec3.has_altitude() ? 1 : 0;
+  }
+}
+
+Vec3 CoordinateColumns::GetTuple(size_t index) const {
+  Vec3 vec3(Get(0, index), Get(1, index));
+  if (has_altitude()) {
+    const uint8_t* mask = get_altitude_mask();
+    if (!mask || mask[index]) {
+      vec3.set_altitude(Get(2, index));
+    }
+  }
+  return vec3;
+}
+
+void CoordinateColumns::Shrink() {
+  // A shared block is left as it is rather than copied.
+  if (!header_ || header_->capacity == header_->size || is_shared()) {
+    return;
+  }
+  if (header_->type != COORDINATES_VEC3) {
+    Relayout(header_->type, header_->size, header_->flags);
+  } else if (header_->size == 0) {
+    Release();
+  } else {
+    ResizeRows(header_->size);
+  }
+}
+
+size_t CoordinateColumns::GetAllocatedBytes() const {
+  return header_ ?
+      GetBlockSize(header_->type, header_->capacity, header_->flags) : 0;
+}
+
+const double* CoordinateColumns::get_double_column(int column) const {
+  if (get_type() != COORDINATES_DOUBLE || (column == 2 && !has_altitude())) {
+    return NULL;
+  }
+  return reinterpret_cast<const double*>(GetColumn(column));
+}
+
+const float* CoordinateColumns::get_float_column(int column) const {
+  if (get_type() != COORDINATES_FLOAT || (column == 2 && !has_altitude())) {
+    return NULL;
+  }
+  return reinterpret_cast<const float*>(GetColumn(column));
+}
+
+const int32_t* CoordinateColumns::get_fixed_column(int column) const {
+  if (get_type() != COORDINATES_FIXED || (column == 2 && !has_altitude())) {
+    return NULL;
+  }
+  return reinterpret_cast<const int32_t*>(GetColumn(column));
+}
+
+const uint8_t* CoordinateColumns::get_altitude_mask() const {
+  if (!header_ || !(header_->flags & kHasAltitudeMask)) {
+    return NULL;
+  }
+  return reinterpret_cast<const uint8_t*>(GetColumn(3));
+}
+
+}  // end namespace kmldom
@@ -0,0 +1,188 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of the CoordinateColumns class which
+// stores the tuples of a Coordinates either as rows of kmlbase::Vec3 or as
+// separate columns of longitudes, latitudes and altitudes.
+
+#ifndef KML_DOM_COORDINATE_COLUMNS_H__
+#define KML_DOM_COORDINATE_COLUMNS_H__
+
+#include "kml/base/referent.h"
+#include "kml/base/util.h"
+#include "kml/base/vec3.h"
+
+namespace kmldom {
+
+// This selects how a Coordinates stores its tuples.  See
+// ParseOptions::coordinates_storage and Coordinates::set_storage().
+enum CoordinatesStorage {
+  // Rows of kmlbase::Vec3 of 32 bytes per tuple.  This is the default.
+  COORDINATES_VEC3,
+  // CoordinateColumns of doubles: 16 bytes per tuple, 24 with altitude.
+  COORDINATES_DOUBLE,
+  // CoordinateColumns of floats: 8 bytes per tuple, 12 with altitude.
+  COORDINATES_FLOAT,
+  // CoordinateColumns of int32_t fixed point: longitude and latitude in
+  // units of 1e-7 degree and altitude in units of 1e-3 meter.
+  COORDINATES_FIXED
+};
+
+// CoordinateColumns hold a sequence of tuples all in one block of memory.
+// COORDINATES_VEC3 tuples are kmlbase::Vec3 rows.  The other types hold
+// contiguous columns of longitudes, latitudes and altitudes.  The altitude
+// column is present only if some tuple has an altitude.  If only some do
+// the columns also hold a mask of those which do.  The columns of
+// COORDINATES_FLOAT and COORDINATES_FIXED are quantized: a tuple read back
+// is the nearest float or fixed point value.  A COORDINATES_FIXED tuple out
+// of the range of the fixed point converts all the columns to
+// COORDINATES_DOUBLE.
+//
+// The block may be shared by several CoordinateColumns with Share().  The
+// first change to a shared block copies it (copy-on-write).
+class CoordinateColumns {
+ public:
+  // Scale factors of the COORDINATES_FIXED columns.
+  static const double kFixedDegreeScale;
+  static const double kFixedMeterScale;
+
+  CoordinateColumns()
+    : header_(NULL) {
+  }
+  ~CoordinateColumns() {
+    Release();
+  }
+
+  // This discards all tuples and sets the type of the columns.  With
+  // COORDINATES_VEC3 the block is freed.
+  void Reset(CoordinatesStorage type);
+
+  // This makes the tuples those of the given columns by sharing their
+  // block.  The count of the sharers of a block is kept atomically, so the
+  // columns of a frozen KmlFile may be shared from several threads at once.
+  void Share(const CoordinateColumns& columns);
+
+  // This returns true if the block is shared with other CoordinateColumns.
+  bool is_shared() const {
+    return header_ && kmlbase::AtomicLoad(&header_->ref_count) > 1;
+  }
+
+  CoordinatesStorage get_type() const {
+    return header_ ? header_->type : COORDINATES_VEC3;
+  }
+
+  size_t size() const {
+    return header_ ? header_->size : 0;
+  }
+
+  // This returns true if there is an altitude column.
+  bool has_altitude() const {
+    return header_ && (header_->flags & kHasAltitude);
+  }
+
+  // This appends the tuple.
+  void push_back(const kmlbase::Vec3& vec3) {
+    // A row appended to a block of its own with room for it is the common
+    // case of a parse.
+    if (header_ && header_->type == COORDINATES_VEC3 &&
+        header_->size < header_->capacity &&
+        kmlbase::AtomicLoad(&header_->ref_count) == 1) {
+      GetRows()[header_->size++] = vec3;
+    } else {
+      PushBack(vec3);
+    }
+  }
+
+  // This returns the tuple at the given index, or an empty Vec3 if the index
+  // is not below size().
+  kmlbase::Vec3 at(size_t index) const {
+    if (index >= size()) {
+      return kmlbase::Vec3();
+    }
+    if (header_->type == COORDINATES_VEC3) {
+      return GetRows()[index];
+    }
+    return GetTuple(index);
+  }
+
+  // This frees the capacity beyond size().
+  void Shrink();
+
+  // This returns the size in bytes of the block holding the tuples.
+  size_t GetAllocatedBytes() const;
+
+  // These return the longitude (0), latitude (1) or altitude (2) column if
+  // the columns are of the matching type, else NULL.  The altitude column is
+  // NULL if no tuple has an altitude.
+  const double* get_double_column(int column) const;
+  const float* get_float_column(int column) const;
+  const int32_t* get_fixed_column(int column) const;
+
+  // If only some tuples have an altitude this returns an array of one byte
+  // per tuple which is 1 for each tuple with an altitude.  The altitude of a
+  // tuple without one is 0 in the altitude column.  If all or no tuples have
+  // an altitude this returns NULL.
+  const uint8_t* get_altitude_mask() const;
+
+ private:
+  enum {
+    kHasAltitude = 1,
+    kHasAltitudeMask = 2
+  };
+  // The block starts with this Header.  Rows of capacity tuples follow, or
+  // the columns of capacity values each, then the mask of capacity bytes if
+  // there is one.
+  struct Header {
+    CoordinatesStorage type;
+    uint32_t flags;
+    size_t size;
+    size_t capacity;
+    // The number of CoordinateColumns sharing the block.
+    int ref_count;
+  };
+  static size_t GetBlockSize(CoordinatesStorage type, size_t capacity,
+                             uint32_t flags);
+  kmlbase::Vec3* GetRows() const {
+    return reinterpret_cast<kmlbase::Vec3*>(header_ + 1);
+  }
+  char* GetColumn(int column) const;
+  kmlbase::Vec3 GetTuple(size_t index) const;
+  void PushBack(const kmlbase::Vec3& vec3);
+  // This resizes the rows of a block not shared in place.
+  void ResizeRows(size_t capacity);
+  // This releases this reference to the block.
+  void Release();
+  double Get(int column, size_t index) const;
+  void Set(int column, size_t index, double value);
+  // This moves the tuples to a new block of the given layout.
+  void Relayout(CoordinatesStorage type, size_t capacity, uint32_t flags);
+
+  Header* header_;
+  LIBKML_DISALLOW_EVIL_CONSTRUCTORS(CoordinateColumns);
+};
+
+}  // end namespace kmldom
+
+#endif  // KML_DOM_COORDINATE_COLUMNS_H__
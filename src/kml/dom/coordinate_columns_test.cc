@@ -0,0 +1,209 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the unit tests for the CoordinateColumns class.
+
+#include "kml/dom/coordinate_columns.h"
+#include "gtest/gtest.h"
+
+using kmlbase::Vec3;
+
+namespace kmldom {
+
+TEST(CoordinateColumnsTest, TestDefault) {
+  CoordinateColumns columns;
+  ASSERT_EQ(COORDINATES_VEC3, columns.get_type());
+  ASSERT_EQ(static_cast<size_t>(0), columns.size());
+  ASSERT_FALSE(columns.has_altitude());
+  ASSERT_TRUE(NULL == columns.get_double_column(0));
+  ASSERT_TRUE(NULL == columns.get_altitude_mask());
+  ASSERT_EQ(static_cast<size_t>(0), columns.GetAllocatedBytes());
+  // With no block an index is out of range.
+  ASSERT_EQ(0.0, columns.at(0).get_longitude());
+  ASSERT_FALSE(columns.at(0).has_altitude());
+}
+
+TEST(CoordinateColumnsTest, TestDouble) {
+  CoordinateColumns columns;
+  columns.Reset(COORDINATES_DOUBLE);
+  ASSERT_EQ(COORDINATES_DOUBLE, columns.get_type());
+  for (int i = 0; i < 100; ++i) {
+    columns.push_back(Vec3(i + 0.1, -i - 0.2));
+  }
+  ASSERT_EQ(static_cast<size_t>(100), columns.size());
+  // No tuple has an altitude.
+  ASSERT_FALSE(columns.has_altitude());
+  ASSERT_TRUE(NULL == columns.get_double_column(2));
+  const double* longitudes = columns.get_double_column(0);
+  const double* latitudes = columns.get_double_column(1);
+  ASSERT_TRUE(longitudes);
+  ASSERT_TRUE(latitudes);
+  ASSERT_TRUE(NULL == columns.get_float_column(0));
+  ASSERT_TRUE(NULL == columns.get_fixed_column(0));
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(i + 0.1, longitudes[i]);
+    ASSERT_EQ(-i - 0.2, latitudes[i]);
+    const Vec3 vec3 = columns.at(i);
+    ASSERT_EQ(i + 0.1, vec3.get_longitude());
+    ASSERT_EQ(-i - 0.2, vec3.get_latitude());
+    ASSERT_FALSE(vec3.has_altitude());
+  }
+  columns.Shrink();
+  ASSERT_EQ(static_cast<size_t>(100), columns.size());
+  ASSERT_EQ(99.1, columns.at(99).get_longitude());
+  ASSERT_EQ(0.0, columns.at(100).get_longitude());
+  // Shrunk there are two columns of 100 doubles after the header.
+  const size_t column_bytes = 2 * 100 * sizeof(double);
+  ASSERT_LT(column_bytes, columns.GetAllocatedBytes());
+  ASSERT_GT(column_bytes + 64, columns.GetAllocatedBytes());
+  columns.Reset(COORDINATES_DOUBLE);
+  ASSERT_EQ(static_cast<size_t>(0), columns.size());
+  ASSERT_EQ(COORDINATES_DOUBLE, columns.get_type());
+}
+
+TEST(CoordinateColumnsTest, TestAltitude) {
+  CoordinateColumns columns;
+  columns.Reset(COORDINATES_DOUBLE);
+  columns.push_back(Vec3(1, 2, 3));
+  columns.push_back(Vec3(4, 5, 6));
+  ASSERT_TRUE(columns.has_altitude());
+  ASSERT_TRUE(NULL == columns.get_altitude_mask());
+  ASSERT_EQ(6.0, columns.get_double_column(2)[1]);
+
+  // A tuple without an altitude adds the mask.
+  columns.push_back(Vec3(7, 8));
+  const uint8_t* mask = columns.get_altitude_mask();
+  ASSERT_TRUE(mask);
+  ASSERT_EQ(1, mask[0]);
+  ASSERT_EQ(1, mask[1]);
+  ASSERT_EQ(0, mask[2]);
+  ASSERT_EQ(0.0, columns.get_double_column(2)[2]);
+  ASSERT_TRUE(columns.at(1).has_altitude());
+  ASSERT_FALSE(columns.at(2).has_altitude());
+  ASSERT_EQ(8.0, columns.at(2).get_latitude());
+
+  // As does a tuple with an altitude after those without.
+  columns.Reset(COORDINATES_FLOAT);
+  columns.push_back(Vec3(1, 2));
+  ASSERT_FALSE(columns.has_altitude());
+  columns.push_back(Vec3(4, 5, 6));
+  ASSERT_TRUE(columns.has_altitude());
+  mask = columns.get_altitude_mask();
+  ASSERT_TRUE(mask);
+  ASSERT_EQ(0, mask[0]);
+  ASSERT_EQ(1, mask[1]);
+  ASSERT_FALSE(columns.at(0).has_altitude());
+  ASSERT_EQ(6.0, columns.at(1).get_altitude());
+}
+
+TEST(CoordinateColumnsTest, TestFloat) {
+  CoordinateColumns columns;
+  columns.Reset(COORDINATES_FLOAT);
+  columns.push_back(Vec3(-122.0841430, 37.4219720, 100.5));
+  const float* longitudes = columns.get_float_column(0);
+  ASSERT_TRUE(longitudes);
+  ASSERT_EQ(static_cast<float>(-122.0841430), longitudes[0]);
+  ASSERT_EQ(static_cast<float>(37.4219720), columns.get_float_column(1)[0]);
+  ASSERT_EQ(100.5f, columns.get_float_column(2)[0]);
+  const Vec3 vec3 = columns.at(0);
+  ASSERT_NEAR(-122.0841430, vec3.get_longitude(), 1e-5);
+  ASSERT_NEAR(37.4219720, vec3.get_latitude(), 1e-5);
+  ASSERT_EQ(100.5, vec3.get_altitude());
+}
+
+TEST(CoordinateColumnsTest, TestFixed) {
+  CoordinateColumns columns;
+  columns.Reset(COORDINATES_FIXED);
+  columns.push_back(Vec3(-122.0841430, 37.4219720, 100.5));
+  columns.push_back(Vec3(180, -90, -0.0004));
+  const int32_t* longitudes = columns.get_fixed_column(0);
+  const int32_t* latitudes = columns.get_fixed_column(1);
+  const int32_t* altitudes = columns.get_fixed_column(2);
+  ASSERT_TRUE(longitudes);
+  ASSERT_EQ(-1220841430, longitudes[0]);
+  ASSERT_EQ(374219720, latitudes[0]);
+  ASSERT_EQ(100500, altitudes[0]);
+  ASSERT_EQ(1800000000, longitudes[1]);
+  ASSERT_EQ(-900000000, latitudes[1]);
+  ASSERT_EQ(0, altitudes[1]);
+  ASSERT_DOUBLE_EQ(-122.0841430, columns.at(0).get_longitude());
+  ASSERT_DOUBLE_EQ(37.4219720, columns.at(0).get_latitude());
+  ASSERT_DOUBLE_EQ(100.5, columns.at(0).get_altitude());
+}
+
+TEST(CoordinateColumnsTest, TestFixedOutOfRange) {
+  CoordinateColumns columns;
+  columns.Reset(COORDINATES_FIXED);
+  columns.push_back(Vec3(1.5, 2.5));
+  // A value out of the range of the fixed point converts to double.
+  columns.push_back(Vec3(1000, 2.5));
+  ASSERT_EQ(COORDINATES_DOUBLE, columns.get_type());
+  ASSERT_TRUE(NULL == columns.get_fixed_column(0));
+  ASSERT_EQ(1.5, columns.get_double_column(0)[0]);
+  ASSERT_EQ(1000.0, columns.get_double_column(0)[1]);
+  columns.push_back(Vec3(1, 2, 1e10));
+  ASSERT_EQ(1e10, columns.at(2).get_altitude());
+}
+
+TEST(CoordinateColumnsTest, TestShare) {
+  CoordinateColumns columns;
+  columns.push_back(Vec3(1, 2, 3));
+  columns.push_back(Vec3(4, 5, 6));
+  ASSERT_FALSE(columns.is_shared());
+  size_t allocated_bytes = columns.GetAllocatedBytes();
+  ASSERT_LT(static_cast<size_t>(0), allocated_bytes);
+  {
+    CoordinateColumns shared;
+    shared.Share(columns);
+    ASSERT_TRUE(columns.is_shared());
+    ASSERT_TRUE(shared.is_shared());
+    ASSERT_EQ(static_cast<size_t>(2), shared.size());
+    ASSERT_TRUE(Vec3(4, 5, 6) == shared.at(1));
+    // A change to either copies the block first.
+    shared.push_back(Vec3(7, 8, 9));
+    ASSERT_FALSE(columns.is_shared());
+    ASSERT_FALSE(shared.is_shared());
+    ASSERT_EQ(static_cast<size_t>(2), columns.size());
+    ASSERT_EQ(static_cast<size_t>(3), shared.size());
+    shared.Share(columns);
+    ASSERT_TRUE(columns.is_shared());
+  }
+  // The block is the original's alone once the other is destroyed.
+  ASSERT_FALSE(columns.is_shared());
+  ASSERT_EQ(allocated_bytes, columns.GetAllocatedBytes());
+
+  CoordinateColumns quantized;
+  quantized.Reset(COORDINATES_FLOAT);
+  quantized.push_back(Vec3(1.5, 2.5));
+  CoordinateColumns shared;
+  shared.Share(quantized);
+  ASSERT_EQ(COORDINATES_FLOAT, shared.get_type());
+  ASSERT_EQ(quantized.get_float_column(0), shared.get_float_column(0));
+  quantized.Reset(COORDINATES_VEC3);
+  ASSERT_FALSE(shared.is_shared());
+  ASSERT_EQ(1.5, shared.at(0).get_longitude());
+}
+
+}  // end namespace kmldom
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include "kml/base/attributes.h"
 #include "kml/base/string_util.h"
+#include "kml/dom/arena.h"
 #include "kml/dom/kml_cast.h"
 #include "kml/dom/serializer.h"
 #include "kml/dom/xsd.h"
@@ -39,46 +40,125 @@ using kmlbase::XmlElement;
 namespace kmldom {
 
 Element::Element()
- : type_id_(Type_Unknown) {
+ : type_id_(Type_Unknown),
+   in_arena_(false) {
 }
 
 Element::Element(KmlDomType type_id)
-  : type_id_(type_id) {
+  : type_id_(type_id),
+    in_arena_(false) {
 }
 
 Element::~Element() {
 }
 
+// The Arena is kept in front of the Element.  Each Element class derives
+// singly from Element such that an Element is at the start of its object.
+void* Element::operator new(size_t size, Arena* arena) {
+  char* p = static_cast<char*>(arena->Allocate(Arena::kAlignment + size));
+  *reinterpret_cast<Arena**>(p) = arena;
+  kmlbase::intrusive_ptr_add_ref(arena);
+  return p + Arena::kAlignment;
+}
+
+// Private.  This returns the Arena of an Element created in one.
+static Arena* GetArenaOf(const Element* element) {
+  return *reinterpret_cast<Arena* const*>(
+      reinterpret_cast<const char*>(element) - Arena::kAlignment);
+}
+
+// This is called only if the constructor of an Element created in an Arena
+// throws.
+void Element::operator delete(void* p, Arena* arena) {
+  kmlbase::intrusive_ptr_release(arena);
+}
+
+void Element::Destroy() {
+  if (!in_arena_) {
+    delete this;
+    return;
+  }
+  // The Arena may free the memory of this Element only once it is destroyed.
+  Arena* arena = GetArenaOf(this);
+  this->~Element();
+  kmlbase::intrusive_ptr_release(arena);
+}
+
+void Element::SetThreadShared() {
+  set_thread_shared();
+  if (in_arena_) {
+    GetArenaOf(this)->set_thread_shared();
+  }
+}
+
+void Element::InternString(const string& value,
+                           kmlbase::PooledString* field) const {
+  Arena* arena = in_arena_ ? GetArenaOf(this) : NULL;
+  if (arena && arena->get_intern_strings()) {
+    field->set_pooled(arena->Intern(value));
+  } else {
+    *field = value;
+  }
+}
+
+Element::Extension* Element::GetExtension() {
+  if (!extension_.get()) {
+    extension_.reset(new Extension);
+  }
+  return extension_.get();
+}
+
+void Element::swap_char_data(string* char_data) {
+  if (!extension_.get() && char_data->empty()) {
+    return;
+  }
+  Extension* extension = GetExtension();
+  extension->char_data.swap(*char_data);
+  // The Extension goes if the character data was all it held.
+  if (extension->char_data.empty() &&
+      extension->char_data.capacity() <= string().capacity() &&
+      extension->unknown_elements_array.empty() &&
+      extension->unknown_legal_elements_array.empty() &&
+      !extension->unknown_attributes.get() && !extension->xmlns.get()) {
+    extension_.reset();
+  }
+}
+
 // Anything reaching this level is an known (KML) element found in an illegal
 // position during parse. We will store it for later serialiation.
 void Element::AddElement(const ElementPtr& element) {
-  unknown_legal_elements_array_.push_back(element);
+  GetExtension()->unknown_legal_elements_array.push_back(element);
 }
 
 // Anything that reaches this level of the hierarchy is an unknown (non-KML)
 // element found during parse.
 void Element::AddUnknownElement(const string& s) {
-  unknown_elements_array_.push_back(s);
+  GetExtension()->unknown_elements_array.push_back(s);
 }
 
 // Serialize at this level is expected to handle only the unknown elements
 // we discovered during parse.
 void Element::SerializeUnknown(Serializer& serializer) const {
+  if (!extension_.get()) {
+    return;
+  }
   // First serialize the misplaced elements:
-  for (size_t i = 0; i < unknown_legal_elements_array_.size(); ++i) {
+  const std::vector<ElementPtr>& unknown_legal_elements_array =
+      extension_->unknown_legal_elements_array;
+  for (size_t i = 0; i < unknown_legal_elements_array.size(); ++i) {
     // Anything derived from Element implements a Serialize() method.
-    unknown_legal_elements_array_[i]->Serialize(serializer);
+    unknown_legal_elements_array[i]->Serialize(serializer);
   }
   // Now serialize unknown elements:
   // Announce to the Serializer that the next N SaveContent() are each
   // unparsed xml.
-  size_t unknown_size = unknown_elements_array_.size();
+  size_t unknown_size = extension_->unknown_elements_array.size();
   if (unknown_size > 0) {
     serializer.BeginElementArray(Type_Unknown, unknown_size);
     for (size_t i = 0; i < unknown_size; ++i) {
       serializer.Indent();
       // This is raw XML do not try to CDATA escape it.
-      serializer.SaveContent(unknown_elements_array_[i], false);
+      serializer.SaveContent(extension_->unknown_elements_array[i], false);
     }
     serializer.EndElementArray(Type_Unknown);
   }
@@ -90,6 +170,7 @@ void Element::AddUnknownAttributes(Attributes* attributes) {
   if (attributes) {
     // Split out any attribute of the form xmlns:PREFIX=.
     if (Attributes* xmlns = attributes->SplitByPrefix("xmlns")) {
+      boost::scoped_ptr<Attributes>& xmlns_ = GetExtension()->xmlns;
       if (xmlns_.get()) {
         xmlns_->MergeAttributes(*xmlns);
         delete xmlns;
@@ -100,6 +181,7 @@ void Element::AddUnknownAttributes(Attributes* attributes) {
     // Split out xmlns= itself.
     string xmlns;
     if (attributes->CutValue("xmlns", &xmlns)) {
+      boost::scoped_ptr<Attributes>& xmlns_ = GetExtension()->xmlns;
       if (!xmlns_.get()) {
         xmlns_.reset(new Attributes);
       }
@@ -110,7 +192,7 @@ void Element::AddUnknownAttributes(Attributes* attributes) {
     if (attributes->GetSize() == 0) {
       delete attributes;  // Nothing left so delete it.
     } else {
-      unknown_attributes_.reset(attributes);
+      GetExtension()->unknown_attributes.reset(attributes);
     }
   }
 }
@@ -124,12 +206,12 @@ void Element::ParseAttributes(Attributes* attributes) {
 
 // This is the reverse of ParseAttributes().
 void Element::SerializeAttributes(Attributes* attributes) const {
-  if (attributes) {
-    if (unknown_attributes_.get()) {
-      attributes->MergeAttributes(*unknown_attributes_);
+  if (attributes && extension_.get()) {
+    if (const Attributes* unknown_attributes = GetUnknownAttributes()) {
+      attributes->MergeAttributes(*unknown_attributes);
     }
-    if (xmlns_.get()) {
-      kmlbase::StringMapIterator iter = xmlns_->CreateIterator();
+    if (const Attributes* xmlns = GetXmlns()) {
+      kmlbase::StringMapIterator iter = xmlns->CreateIterator();
       for (; !iter.AtEnd(); iter.Advance()) {
         string key = iter.Data().first == "xmlns" ? iter.Data().first :
                           string("xmlns:") + iter.Data().first;
@@ -144,6 +226,7 @@ ElementPtr Element::GetParent() const {
 }
 
 void Element::MergeXmlns(const Attributes& xmlns) {
+  boost::scoped_ptr<Attributes>& xmlns_ = GetExtension()->xmlns;
   if (!xmlns_.get()) {
     xmlns_.reset(new Attributes);
   }
@@ -223,4 +306,13 @@ bool Field::SetString(string* val) {
   return ret;
 }
 
+bool Field::SetPooledString(kmlbase::PooledString* val) {
+  bool ret = false;
+  if (val) {
+    InternString(get_char_data(), val);
+    ret = true;
+  }
+  return ret;
+}
+
 }  // namespace kmldom
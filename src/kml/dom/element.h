@@ -40,6 +40,7 @@
 #include "kml/dom/kml22.h"
 #include "kml/dom/kml_ptr.h"
 #include "kml/dom/visitor_driver.h"
+#include "kml/base/pooled_string.h"
 #include "kml/base/util.h"
 #include "kml/base/xml_element.h"
 
@@ -49,6 +50,7 @@ class Attributes;
 
 namespace kmldom {
 
+class Arena;
 class Serializer;
 class Visitor;
 class Xsd;
@@ -68,11 +70,15 @@ class Element : public kmlbase::XmlElement {
 
   // This is the concatenation of all character data found parsing this element.
   const string& get_char_data() const {
-    return char_data_;
+    return extension_.get() ? extension_->char_data : GetEmptyString();
   }
   void set_char_data(const string& char_data) {
-    char_data_ = char_data;
+    string copy(char_data);
+    swap_char_data(&copy);
   }
+  // This exchanges the character data with the given string.  The parser
+  // uses this to hand over the character data it gathers without a copy.
+  void swap_char_data(string* char_data);
 
   // TODO: AddElement() and ParseAttributes() should really be protected.
 
@@ -115,18 +121,25 @@ class Element : public kmlbase::XmlElement {
 
   // Returns the unknown elements.
   size_t get_unknown_elements_array_size() const {
-    return unknown_elements_array_.size();
+    return extension_.get() ? extension_->unknown_elements_array.size() : 0;
   }
   const string& get_unknown_elements_array_at(size_t i) const {
-    return unknown_elements_array_[i];
+    return extension_->unknown_elements_array[i];
+  }
+
+  // This returns the size in bytes of the block holding the character data
+  // and the unknown parts of this element, or 0 if there is none.
+  size_t GetExtensionBytes() const {
+    return extension_.get() ? sizeof(Extension) : 0;
   }
 
   // Returns the unknown legal (misplaced) elements.
   size_t get_misplaced_elements_array_size() const {
-    return unknown_legal_elements_array_.size();
+    return extension_.get() ?
+        extension_->unknown_legal_elements_array.size() : 0;
   }
   const ElementPtr& get_misplaced_elements_array_at(size_t i) const {
-    return unknown_legal_elements_array_[i];
+    return extension_->unknown_legal_elements_array[i];
   }
 
   // Add the given set of attributes to the element's unknown attributes.
@@ -138,7 +151,7 @@ class Element : public kmlbase::XmlElement {
   // there are no unparsed attributes.  Ownership of the object is retained
   // by the Element class.
   const kmlbase::Attributes* GetUnknownAttributes() const {
-    return unknown_attributes_.get();
+    return extension_.get() ? extension_->unknown_attributes.get() : NULL;
   }
 
   // This is the set of xmlns:PREFIX=NAMESPACE attributes on the
@@ -147,7 +160,7 @@ class Element : public kmlbase::XmlElement {
   // of "xmlns" in the normal "unknown" attributes list.  Use
   // get_default_xmlns() to access the default namespace for an element.
   const kmlbase::Attributes* GetXmlns() const {
-    return xmlns_.get();
+    return extension_.get() ? extension_->xmlns.get() : NULL;
   }
 
   // This merges in the given set of prefix/namespace attributes into the
@@ -162,6 +175,7 @@ class Element : public kmlbase::XmlElement {
   virtual bool SetInt(int* val) { return false; }
   virtual bool SetEnum(int* val) { return false; }
   virtual bool SetString(string* val) { return false; }
+  virtual bool SetPooledString(kmlbase::PooledString* val) { return false; }
 
   // Accepts the visitor for this element (this must be overridden for each
   // element type).
@@ -175,11 +189,33 @@ class Element : public kmlbase::XmlElement {
     /* Inlinable for efficiency */
   }
 
+  // An Element is created with new unless KmlFactory creates it in an Arena.
+  // An Element in an Arena holds a reference to the Arena which is released
+  // once the Element is destroyed.
+  static void* operator new(size_t size) {
+    return ::operator new(size);
+  }
+  static void operator delete(void* p) {
+    ::operator delete(p);
+  }
+  static void* operator new(size_t size, Arena* arena);
+  static void operator delete(void* p, Arena* arena);
+  virtual void Destroy();
+
+  // This makes the reference count of this Element atomic, and also that of
+  // its Arena if it is in one.  See kmlbase::Referent::set_thread_shared()
+  // and kmlengine::KmlFile::Freeze().
+  void SetThreadShared();
+
  protected:
   // Element is an abstract base class and is never created directly.
   Element();
   Element(KmlDomType type_id);
 
+  // This sets the given field to the value.  If this Element is in an Arena
+  // which interns strings the field refers to the Arena's copy of the value.
+  void InternString(const string& value, kmlbase::PooledString* field) const;
+
   // This sets the given complex child to a field of this element.
   // The intended usage is to implement the set_child() and clear_child()
   // methods in a concrete element.
@@ -231,20 +267,34 @@ class Element : public kmlbase::XmlElement {
   }
 
  private:
+  friend class KmlFactory;
   KmlDomType type_id_;
-  string char_data_;
-  // A vector of strings to contain unknown non-KML elements discovered during
-  // parse.
-  std::vector<string> unknown_elements_array_;
-  // A vector of Element*'s to contain known KML elements found during parse
-  // to be in illegal positions, e.g. <Placemark><Document>.
-  std::vector<ElementPtr> unknown_legal_elements_array_;
-  // Unknown attributes found during parse are copied out and a pointer is
-  // stored. The object is dynamically allocated so every element is not
-  // burdened with an unnecessary Attributes object.
-  boost::scoped_ptr<kmlbase::Attributes> unknown_attributes_;
-  // Any Element may have 0 or more xmlns attributes.
-  boost::scoped_ptr<kmlbase::Attributes> xmlns_;
+  // This is set by KmlFactory for an Element created in an Arena.
+  bool in_arena_;
+  // The members below are empty for nearly every Element.  They are kept
+  // in an Extension created on first use such that each Element carries
+  // only one pointer for them all.
+  struct Extension {
+    string char_data;
+    // A vector of strings to contain unknown non-KML elements discovered
+    // during parse.
+    std::vector<string> unknown_elements_array;
+    // A vector of Element*'s to contain known KML elements found during
+    // parse to be in illegal positions, e.g. <Placemark><Document>.
+    std::vector<ElementPtr> unknown_legal_elements_array;
+    // Unknown attributes found during parse are copied out and a pointer is
+    // stored.
+    boost::scoped_ptr<kmlbase::Attributes> unknown_attributes;
+    // Any Element may have 0 or more xmlns attributes.
+    boost::scoped_ptr<kmlbase::Attributes> xmlns;
+  };
+  boost::scoped_ptr<Extension> extension_;
+  // This returns the Extension, creating it if there is none.
+  Extension* GetExtension();
+  static const string& GetEmptyString() {
+    static const string empty;
+    return empty;
+  }
   LIBKML_DISALLOW_EVIL_CONSTRUCTORS(Element);
 };
 
@@ -315,6 +365,10 @@ class Field : public Element {
   // supplied false is returned, else true is returned and the val is set.
   bool SetString(string* val);
 
+  // As SetString, but the string is interned if the Field is in an Arena
+  // which interns strings.  See Element::InternString().
+  bool SetPooledString(kmlbase::PooledString* val);
+
  private:
   const Xsd& xsd_;
   LIBKML_DISALLOW_EVIL_CONSTRUCTORS(Field);
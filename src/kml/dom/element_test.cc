@@ -30,6 +30,7 @@
 #include "gtest/gtest.h"
 #include "kml/base/attributes.h"
 #include "kml/base/xml_namespaces.h"
+#include "kml/dom.h"
 #include "kml/dom/kml_factory.h"
 #include "kml/dom/kml_funcs.h"
 #include "kml/dom/stats_serializer.h"
@@ -696,4 +697,112 @@ TEST(FieldTest, TestSerialize) {
   ASSERT_EQ(kExpectedXml, SerializeRaw(field));
 }
 
+// The Element base is added to every node of a DOM.  These sizes are those
+// of a 64-bit build with a 32 byte std::string and are the limit for each
+// concrete type such that a change growing the DOM is noticed.
+#define ASSERT_SIZE_AT_MOST(type, size) \
+  ASSERT_GE(static_cast<size_t>(size), sizeof(type)) << #type
+
+TEST(ElementSizeTest, TestSizeOf) {
+  if (sizeof(void*) != 8 || sizeof(string) != 32) {
+    return;  // The sizes below do not apply.
+  }
+  ASSERT_SIZE_AT_MOST(Element, 48);
+  ASSERT_SIZE_AT_MOST(Field, 56);
+  ASSERT_SIZE_AT_MOST(Alias, 208);
+  ASSERT_SIZE_AT_MOST(AtomAuthor, 168);
+  ASSERT_SIZE_AT_MOST(AtomCategory, 168);
+  ASSERT_SIZE_AT_MOST(AtomContent, 128);
+  ASSERT_SIZE_AT_MOST(AtomEntry, 264);
+  ASSERT_SIZE_AT_MOST(AtomFeed, 240);
+  ASSERT_SIZE_AT_MOST(AtomLink, 256);
+  ASSERT_SIZE_AT_MOST(BalloonStyle, 192);
+  ASSERT_SIZE_AT_MOST(Camera, 248);
+  ASSERT_SIZE_AT_MOST(Change, 72);
+  ASSERT_SIZE_AT_MOST(Coordinates, 64);
+  ASSERT_SIZE_AT_MOST(Create, 72);
+  ASSERT_SIZE_AT_MOST(Data, 224);
+  ASSERT_SIZE_AT_MOST(Delete, 72);
+  ASSERT_SIZE_AT_MOST(Document, 472);
+  ASSERT_SIZE_AT_MOST(ExtendedData, 96);
+  ASSERT_SIZE_AT_MOST(Folder, 424);
+  ASSERT_SIZE_AT_MOST(GroundOverlay, 432);
+  ASSERT_SIZE_AT_MOST(GxAnimatedUpdate, 144);
+  ASSERT_SIZE_AT_MOST(GxFlyTo, 152);
+  ASSERT_SIZE_AT_MOST(GxLatLonQuad, 136);
+  ASSERT_SIZE_AT_MOST(GxMultiTrack, 152);
+  ASSERT_SIZE_AT_MOST(GxPlaylist, 152);
+  ASSERT_SIZE_AT_MOST(GxSimpleArrayData, 112);
+  ASSERT_SIZE_AT_MOST(GxSimpleArrayField, 168);
+  ASSERT_SIZE_AT_MOST(GxSoundCue, 168);
+  ASSERT_SIZE_AT_MOST(GxTimeSpan, 208);
+  ASSERT_SIZE_AT_MOST(GxTimeStamp, 168);
+  ASSERT_SIZE_AT_MOST(GxTour, 368);
+  ASSERT_SIZE_AT_MOST(GxTourControl, 136);
+  ASSERT_SIZE_AT_MOST(GxTrack, 232);
+  ASSERT_SIZE_AT_MOST(GxWait, 136);
+  ASSERT_SIZE_AT_MOST(HotSpot, 96);
+  ASSERT_SIZE_AT_MOST(Icon, 312);
+  ASSERT_SIZE_AT_MOST(IconStyle, 192);
+  ASSERT_SIZE_AT_MOST(IconStyleIcon, 232);
+  ASSERT_SIZE_AT_MOST(ImagePyramid, 160);
+  ASSERT_SIZE_AT_MOST(InnerBoundaryIs, 56);
+  ASSERT_SIZE_AT_MOST(ItemIcon, 200);
+  ASSERT_SIZE_AT_MOST(Kml, 104);
+  ASSERT_SIZE_AT_MOST(LabelStyle, 160);
+  ASSERT_SIZE_AT_MOST(LatLonAltBox, 240);
+  ASSERT_SIZE_AT_MOST(LatLonBox, 208);
+  ASSERT_SIZE_AT_MOST(LineString, 160);
+  ASSERT_SIZE_AT_MOST(LineStyle, 160);
+  ASSERT_SIZE_AT_MOST(LinearRing, 160);
+  ASSERT_SIZE_AT_MOST(Link, 312);
+  ASSERT_SIZE_AT_MOST(LinkSnippet, 96);
+  ASSERT_SIZE_AT_MOST(ListStyle, 176);
+  ASSERT_SIZE_AT_MOST(Location, 176);
+  ASSERT_SIZE_AT_MOST(Lod, 192);
+  ASSERT_SIZE_AT_MOST(LookAt, 248);
+  ASSERT_SIZE_AT_MOST(Metadata, 48);
+  ASSERT_SIZE_AT_MOST(Model, 184);
+  ASSERT_SIZE_AT_MOST(MultiGeometry, 152);
+  ASSERT_SIZE_AT_MOST(NetworkLink, 368);
+  ASSERT_SIZE_AT_MOST(NetworkLinkControl, 304);
+  ASSERT_SIZE_AT_MOST(Orientation, 176);
+  ASSERT_SIZE_AT_MOST(OuterBoundaryIs, 56);
+  ASSERT_SIZE_AT_MOST(OverlayXY, 96);
+  ASSERT_SIZE_AT_MOST(Pair, 160);
+  ASSERT_SIZE_AT_MOST(PhotoOverlay, 432);
+  ASSERT_SIZE_AT_MOST(Placemark, 368);
+  ASSERT_SIZE_AT_MOST(Point, 152);
+  ASSERT_SIZE_AT_MOST(PolyStyle, 144);
+  ASSERT_SIZE_AT_MOST(Polygon, 176);
+  ASSERT_SIZE_AT_MOST(Region, 144);
+  ASSERT_SIZE_AT_MOST(ResourceMap, 152);
+  ASSERT_SIZE_AT_MOST(RotationXY, 96);
+  ASSERT_SIZE_AT_MOST(Scale, 176);
+  ASSERT_SIZE_AT_MOST(Schema, 216);
+  ASSERT_SIZE_AT_MOST(SchemaData, 192);
+  ASSERT_SIZE_AT_MOST(ScreenOverlay, 432);
+  ASSERT_SIZE_AT_MOST(ScreenXY, 96);
+  ASSERT_SIZE_AT_MOST(SimpleData, 104);
+  ASSERT_SIZE_AT_MOST(SimpleField, 168);
+  ASSERT_SIZE_AT_MOST(Size, 96);
+  ASSERT_SIZE_AT_MOST(Snippet, 96);
+  ASSERT_SIZE_AT_MOST(Style, 176);
+  ASSERT_SIZE_AT_MOST(StyleMap, 152);
+  ASSERT_SIZE_AT_MOST(TimeSpan, 208);
+  ASSERT_SIZE_AT_MOST(TimeStamp, 168);
+  ASSERT_SIZE_AT_MOST(Update, 112);
+  ASSERT_SIZE_AT_MOST(Url, 312);
+  ASSERT_SIZE_AT_MOST(ViewVolume, 208);
+  ASSERT_SIZE_AT_MOST(XalAddressDetails, 56);
+  ASSERT_SIZE_AT_MOST(XalAdministrativeArea, 104);
+  ASSERT_SIZE_AT_MOST(XalCountry, 96);
+  ASSERT_SIZE_AT_MOST(XalLocality, 104);
+  ASSERT_SIZE_AT_MOST(XalPostalCode, 88);
+  ASSERT_SIZE_AT_MOST(XalSubAdministrativeArea, 96);
+  ASSERT_SIZE_AT_MOST(XalThoroughfare, 128);
+}
+
+#undef ASSERT_SIZE_AT_MOST
+
 }  // end namespace kmldom
@@ -53,14 +53,18 @@ void SimpleData::ParseAttributes(Attributes* attributes) {
   if (!attributes) {
     return;
   }
-  has_name_ = attributes->CutValue(kSimpleDataName, &name_);
+  string name;
+  has_name_ = attributes->CutValue(kSimpleDataName, &name);
+  if (has_name_) {
+    InternString(name, &name_);
+  }
   AddUnknownAttributes(attributes);
 }
 
 void SimpleData::SerializeAttributes(Attributes* attributes) const {
   Element::SerializeAttributes(attributes);
   if (has_name_) {
-    attributes->SetValue(kSimpleDataName, name_);
+    attributes->SetValue(kSimpleDataName, get_name());
   }
 }
 
@@ -152,14 +156,18 @@ void SchemaData::ParseAttributes(Attributes* attributes) {
   if (!attributes) {
     return;
   }
-  has_schemaurl_ = attributes->CutValue(kSchemaUrl, &schemaurl_);
+  string schemaurl;
+  has_schemaurl_ = attributes->CutValue(kSchemaUrl, &schemaurl);
+  if (has_schemaurl_) {
+    InternString(schemaurl, &schemaurl_);
+  }
   Object::ParseAttributes(attributes);
 }
 
 void SchemaData::SerializeAttributes(Attributes* attributes) const {
   Object::SerializeAttributes(attributes);
   if (has_schemaurl_) {
-    attributes->SetValue(kSchemaUrl, schemaurl_);
+    attributes->SetValue(kSchemaUrl, get_schemaurl());
   }
 }
 
@@ -213,14 +221,18 @@ void Data::ParseAttributes(Attributes* attributes) {
   if (!attributes) {
     return;
   }
-  has_name_ = attributes->CutValue(kDataName, &name_);
+  string name;
+  has_name_ = attributes->CutValue(kDataName, &name);
+  if (has_name_) {
+    InternString(name, &name_);
+  }
   Object::ParseAttributes(attributes);
 }
 
 void Data::SerializeAttributes(Attributes* attributes) const {
   Object::SerializeAttributes(attributes);
   if (has_name_) {
-    attributes->SetValue(kDataName, name_);
+    attributes->SetValue(kDataName, get_name());
   }
 }
 
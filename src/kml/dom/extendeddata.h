@@ -51,7 +51,7 @@ class SimpleData : public BasicElement<Type_SimpleData> {
   virtual ~SimpleData();
 
   // name=
-  const string& get_name() const { return name_; }
+  const string& get_name() const { return name_.get(); }
   bool has_name() const { return has_name_; }
   void set_name(const string& value) {
     name_ = value;
@@ -86,7 +86,7 @@ class SimpleData : public BasicElement<Type_SimpleData> {
   friend class Serializer;
   virtual void Serialize(Serializer& serializer) const;
   virtual void SerializeAttributes(kmlbase::Attributes* attributes) const;
-  string name_;
+  kmlbase::PooledString name_;
   bool has_name_;
   string text_;
   bool has_text_;
@@ -152,7 +152,7 @@ class SchemaData : public Object {
   static KmlDomType ElementType() { return Type_SchemaData; }
 
   // schemaUrl=
-  const string& get_schemaurl() const { return schemaurl_; }
+  const string& get_schemaurl() const { return schemaurl_.get(); }
   bool has_schemaurl() const { return has_schemaurl_; }
   void set_schemaurl(const string& value) {
     schemaurl_ = value;
@@ -203,7 +203,7 @@ class SchemaData : public Object {
   friend class Serializer;
   virtual void Serialize(Serializer& serializer) const;
   virtual void SerializeAttributes(kmlbase::Attributes* attributes) const;
-  string schemaurl_;
+  kmlbase::PooledString schemaurl_;
   bool has_schemaurl_;
   std::vector<SimpleDataPtr> simpledata_array_;
   std::vector<GxSimpleArrayDataPtr> gx_simplearraydata_array_;
@@ -221,7 +221,7 @@ class Data : public Object {
   static KmlDomType ElementType() { return Type_Data; }
 
   // name=
-  const string& get_name() const { return name_; }
+  const string& get_name() const { return name_.get(); }
   bool has_name() const { return has_name_; }
   void set_name(const string& value) {
     name_ = value;
@@ -269,7 +269,7 @@ class Data : public Object {
   friend class Serializer;
   virtual void Serialize(Serializer& serializer) const;
   virtual void SerializeAttributes(kmlbase::Attributes* attributes) const;
-  string name_;
+  kmlbase::PooledString name_;
   bool has_name_;
   string displayname_;
   bool has_displayname_;
@@ -104,10 +104,10 @@ void Feature::AddElement(const ElementPtr& element) {
 #endif
       break;
     case Type_description:
-      has_description_ = element->SetString(&description_);
+      has_description_ = element->SetPooledString(&description_);
       break;
     case Type_styleUrl:
-      has_styleurl_ = element->SetString(&styleurl_);
+      has_styleurl_ = element->SetPooledString(&styleurl_);
       break;
     case Type_Region:
       set_region(AsRegion(element));
@@ -158,7 +158,7 @@ void Feature::SerializeBeforeStyleSelector(Serializer& serializer) const {
     serializer.SaveElement(get_snippet());
   }
   if (has_description()) {
-    serializer.SaveFieldById(Type_description, description_);
+    serializer.SaveFieldById(Type_description, get_description());
   }
   if (has_abstractview()) {
     serializer.SaveElementGroup(get_abstractview(), Type_AbstractView);
@@ -167,7 +167,7 @@ void Feature::SerializeBeforeStyleSelector(Serializer& serializer) const {
     serializer.SaveElementGroup(get_timeprimitive(), Type_TimePrimitive);
   }
   if (has_styleurl()) {
-    serializer.SaveFieldById(Type_styleUrl, styleurl_);
+    serializer.SaveFieldById(Type_styleUrl, get_styleurl());
   }
 }
 
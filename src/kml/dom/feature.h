@@ -159,7 +159,7 @@ class Feature : public Object {
   }
 
   // <description>
-  const string& get_description() const { return description_; }
+  const string& get_description() const { return description_.get(); }
   bool has_description() const { return has_description_; }
   void set_description(const string& value) {
     description_ = value;
@@ -191,8 +191,8 @@ class Feature : public Object {
   }
 
   // <styleUrl>
-  const string& get_styleurl() const { return styleurl_; }
-  string& styleurl() { return styleurl_; }
+  const string& get_styleurl() const { return styleurl_.get(); }
+  string& styleurl() { return *styleurl_.mutable_get(); }
   bool has_styleurl() const { return has_styleurl_; }
   void set_styleurl(const string& value) {
     styleurl_ = value;
@@ -274,11 +274,11 @@ class Feature : public Object {
   string phonenumber_;
   bool has_phonenumber_;
   SnippetPtr snippet_;
-  string description_;
+  kmlbase::PooledString description_;
   bool has_description_;
   AbstractViewPtr abstractview_;
   TimePrimitivePtr timeprimitive_;
-  string styleurl_;
+  kmlbase::PooledString styleurl_;
   bool has_styleurl_;
   StyleSelectorPtr styleselector_;
   RegionPtr region_;
@@ -0,0 +1,321 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of the internal SplitAtFeatures
+// and FindIds functions.
+
+#include "kml/dom/feature_splitter.h"
+#include <string.h>
+#include "kml/dom/kml22.h"
+#include "kml/dom/xsd.h"
+
+namespace kmldom {
+
+static bool IsXmlSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool HasPrefix(const char* begin, const char* end, const char* prefix) {
+  const size_t prefix_len = strlen(prefix);
+  return static_cast<size_t>(end - begin) >= prefix_len &&
+         memcmp(begin, prefix, prefix_len) == 0;
+}
+
+// Returns the first occurrence of s in [begin, end) or NULL if there is none.
+static const char* FindString(const char* begin, const char* end,
+                              const char* s) {
+  const size_t s_len = strlen(s);
+  while (static_cast<size_t>(end - begin) >= s_len) {
+    const char* found = static_cast<const char*>(
+        memchr(begin, s[0], end - begin - s_len + 1));
+    if (!found) {
+      return NULL;
+    }
+    if (memcmp(found, s, s_len) == 0) {
+      return found;
+    }
+    begin = found + 1;
+  }
+  return NULL;
+}
+
+// Returns the '>' which closes the tag starting at tag, skipping over quoted
+// attribute values, or NULL if the tag is not closed.
+static const char* FindTagEnd(const char* tag, const char* end) {
+  for (const char* p = tag; p < end; ++p) {
+    if (*p == '"' || *p == '\'') {
+      p = static_cast<const char*>(memchr(p + 1, *p, end - p - 1));
+      if (!p) {
+        return NULL;
+      }
+    } else if (*p == '>') {
+      return p;
+    }
+  }
+  return NULL;
+}
+
+static bool IsContainerName(const char* name, size_t name_len) {
+  const int type_id = Xsd::GetSchema()->ElementId(name, name_len);
+  return type_id == Type_Document || type_id == Type_Folder;
+}
+
+static bool IsFeatureName(const char* name, size_t name_len) {
+  switch (Xsd::GetSchema()->ElementId(name, name_len)) {
+    case Type_Document:
+    case Type_Folder:
+    case Type_GroundOverlay:
+    case Type_GxTour:
+    case Type_NetworkLink:
+    case Type_PhotoOverlay:
+    case Type_Placemark:
+    case Type_ScreenOverlay:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Adds the child of the Container at [begin, end) of data to the chunks.  A
+// Feature extends the open chunk or starts a new one.  Any other child
+// closes the open chunk.
+static void AddContainerChild(size_t begin, size_t end, bool is_feature,
+                              size_t chunk_size, bool* chunk_open,
+                              FeatureSplit* feature_split) {
+  if (!is_feature) {
+    *chunk_open = false;
+    return;
+  }
+  std::vector<std::pair<size_t, size_t> >& chunks = feature_split->chunks;
+  if (*chunk_open) {
+    chunks.back().second = end;
+  } else {
+    chunks.push_back(std::make_pair(begin, end));
+    *chunk_open = true;
+  }
+  if (chunks.back().second - chunks.back().first >= chunk_size) {
+    *chunk_open = false;
+  }
+}
+
+bool SplitAtFeatures(const char* data, size_t size, size_t chunk_size,
+                     FeatureSplit* feature_split) {
+  const char* end = data + size;
+  const char* p = data;
+  // The scan looks at bytes and so only supports encodings in which markup
+  // is ASCII.  A UTF-16 document starts with a byte order mark or has a NUL
+  // within its first few bytes.
+  if (HasPrefix(p, end, "\xEF\xBB\xBF")) {
+    p += 3;
+  }
+  if (p == end || (*p != '<' && !IsXmlSpace(*p)) ||
+      memchr(p, '\0', end - p < 4 ? end - p : 4)) {
+    return false;
+  }
+  const char* const first_markup = p;
+
+  feature_split->prefix.clear();
+  feature_split->suffix.clear();
+  feature_split->prefix_depth = 0;
+  feature_split->chunks.clear();
+
+  string root_name;
+  string container_name;
+  size_t depth = 0;
+  // The depth of the children of the Container, or 0 until it is found.
+  size_t child_depth = 0;
+  bool container_closed = false;
+  const char* child_begin = NULL;
+  bool child_is_feature = false;
+  bool chunk_open = false;
+
+  while (!container_closed &&
+         (p = static_cast<const char*>(memchr(p, '<', end - p)))) {
+    const char* tag = p;
+    if (HasPrefix(tag, end, "<?")) {
+      const char* pi_end = FindString(tag + 2, end, "?>");
+      if (!pi_end) {
+        return false;
+      }
+      if (tag == first_markup && HasPrefix(tag, end, "<?xml") &&
+          IsXmlSpace(tag[5])) {
+        // The XML declaration names the encoding which each chunk needs.
+        feature_split->prefix.assign(tag, pi_end + 2);
+      }
+      p = pi_end + 2;
+      continue;
+    }
+    if (HasPrefix(tag, end, "<!--")) {
+      const char* comment_end = FindString(tag + 4, end, "-->");
+      if (!comment_end) {
+        return false;
+      }
+      p = comment_end + 3;
+      continue;
+    }
+    if (HasPrefix(tag, end, "<![CDATA[")) {
+      const char* cdata_end = FindString(tag + 9, end, "]]>");
+      if (!cdata_end) {
+        return false;
+      }
+      p = cdata_end + 3;
+      continue;
+    }
+    if (HasPrefix(tag, end, "<!")) {
+      // A DOCTYPE may declare entities which the chunks would not see.
+      return false;
+    }
+    const char* tag_end = FindTagEnd(tag, end);
+    if (!tag_end) {
+      return false;
+    }
+    p = tag_end + 1;
+
+    if (tag[1] == '/') {
+      if (depth == 0) {
+        return false;
+      }
+      --depth;
+      if (child_depth != 0 && depth == child_depth) {
+        AddContainerChild(child_begin - data, p - data, child_is_feature,
+                          chunk_size, &chunk_open, feature_split);
+      } else if (child_depth != 0 && depth + 1 == child_depth) {
+        container_closed = true;
+      }
+      continue;
+    }
+
+    const char* name = tag + 1;
+    const char* name_end = name;
+    while (name_end < tag_end && !IsXmlSpace(*name_end) && *name_end != '/' &&
+           *name_end != '>') {
+      ++name_end;
+    }
+    const size_t name_len = name_end - name;
+    const bool is_empty = tag_end[-1] == '/';
+    if (name_len == 6 && memcmp(name, "Schema", 6) == 0 &&
+        FindString(name_end, tag_end, "parent")) {
+      return false;
+    }
+
+    if (depth == 0) {
+      if (!root_name.empty() || is_empty) {
+        return false;
+      }
+      root_name.assign(name, name_len);
+      feature_split->prefix.append(tag, p);
+      feature_split->prefix_depth = 1;
+      if (IsContainerName(name, name_len)) {
+        container_name = root_name;
+        child_depth = 1;
+      } else if (root_name != "kml") {
+        return false;
+      }
+    } else if (depth == 1 && child_depth == 0 && !is_empty &&
+               IsContainerName(name, name_len)) {
+      container_name.assign(name, name_len);
+      feature_split->prefix.append(tag, p);
+      feature_split->prefix_depth = 2;
+      child_depth = 2;
+    } else if (child_depth != 0 && depth == child_depth) {
+      child_begin = tag;
+      child_is_feature = IsFeatureName(name, name_len);
+      if (is_empty) {
+        AddContainerChild(child_begin - data, p - data, child_is_feature,
+                          chunk_size, &chunk_open, feature_split);
+      }
+    }
+    if (!is_empty) {
+      ++depth;
+    }
+  }
+
+  if (!container_closed || feature_split->chunks.empty()) {
+    return false;
+  }
+  feature_split->suffix = "</" + container_name + ">";
+  if (feature_split->prefix_depth == 2) {
+    feature_split->suffix.append("</" + root_name + ">");
+  }
+  return true;
+}
+
+void FindIds(const char* data, size_t size, std::vector<string>* ids) {
+  const char* end = data + size;
+  const char* p = data;
+  while ((p = static_cast<const char*>(memchr(p, '<', end - p)))) {
+    const char* tag = p;
+    const char* skip_to = NULL;
+    if (HasPrefix(tag, end, "<?")) {
+      skip_to = FindString(tag + 2, end, "?>");
+    } else if (HasPrefix(tag, end, "<!--")) {
+      skip_to = FindString(tag + 4, end, "-->");
+    } else if (HasPrefix(tag, end, "<![CDATA[")) {
+      skip_to = FindString(tag + 9, end, "]]>");
+    } else {
+      skip_to = FindTagEnd(tag, end);
+    }
+    if (!skip_to) {
+      return;
+    }
+    p = skip_to + 1;
+    if (tag[1] == '/' || tag[1] == '?' || tag[1] == '!') {
+      continue;
+    }
+    // Step over the element name to each attribute of the start tag.
+    const char* a = tag + 1;
+    while (a < skip_to && !IsXmlSpace(*a) && *a != '/') {
+      ++a;
+    }
+    while (a < skip_to) {
+      while (a < skip_to && (IsXmlSpace(*a) || *a == '/')) {
+        ++a;
+      }
+      const char* name = a;
+      while (a < skip_to && *a != '=' && !IsXmlSpace(*a)) {
+        ++a;
+      }
+      const char* name_end = a;
+      while (a < skip_to && (IsXmlSpace(*a) || *a == '=')) {
+        ++a;
+      }
+      if (a == skip_to || (*a != '"' && *a != '\'')) {
+        break;
+      }
+      const char* value = a + 1;
+      const char* value_end =
+          static_cast<const char*>(memchr(value, *a, skip_to - value));
+      if (!value_end) {
+        break;
+      }
+      if (name_end - name == 2 && name[0] == 'i' && name[1] == 'd') {
+        ids->push_back(string(value, value_end));
+      }
+      a = value_end + 1;
+    }
+  }
+}
+
+}  // end namespace kmldom
@@ -0,0 +1,79 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of the internal SplitAtFeatures
+// function which Parser::ParseParallel and Parser::ParseLazy use to divide a
+// KML document into pieces which can be parsed independently.
+
+#ifndef KML_DOM_FEATURE_SPLITTER_H__
+#define KML_DOM_FEATURE_SPLITTER_H__
+
+#include <utility>
+#include <vector>
+#include "kml/base/util.h"
+
+namespace kmldom {
+
+// This describes a KML document divided at the boundaries between the
+// Features of its top-level Container: the root <Document> or <Folder>, or
+// else the first such child of the root <kml>.  Each chunk is a run of
+// sibling Features (and whatever whitespace and comments lie between them)
+// which parses as a well-formed document when placed between prefix and
+// suffix.
+struct FeatureSplit {
+  // The XML declaration, if any, followed by the start tags of the root
+  // element and of the Container (just the one tag if the Container is the
+  // root).
+  string prefix;
+  // The end tags which close the elements opened in prefix.
+  string suffix;
+  // The number of elements opened by prefix: 1 or 2.
+  size_t prefix_depth;
+  // The byte range [first, second) of each chunk in document order.
+  std::vector<std::pair<size_t, size_t> > chunks;
+};
+
+// This scans the size bytes of XML at data for the Features of its
+// top-level Container and groups consecutive Features into chunks of at
+// least chunk_size bytes.  A chunk never spans a non-Feature sibling.  The
+// scan skips comments, CDATA sections, processing instructions and quoted
+// attribute values and tracks nesting depth only; it does not check that
+// the XML is well-formed, which is left to the parse of each piece.  This
+// returns false if no Features were found or if the document cannot safely
+// be divided: it is not in an ASCII compatible encoding, it has a DOCTYPE
+// (which may declare entities), or it uses the old KML 2.0/2.1 style of
+// <Schema parent="Placemark"> (see kml_handler.h) whose effect crosses
+// chunks.
+bool SplitAtFeatures(const char* data, size_t size, size_t chunk_size,
+                     FeatureSplit* feature_split);
+
+// This appends to ids the value of each id attribute of the start tags in
+// the size bytes of XML at data, skipping comments, CDATA sections and
+// processing instructions.  Entity references in the values are left as is.
+void FindIds(const char* data, size_t size, std::vector<string>* ids);
+
+}  // end namespace kmldom
+
+#endif  // KML_DOM_FEATURE_SPLITTER_H__
@@ -0,0 +1,161 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the unit tests for the internal SplitAtFeatures
+// function.
+
+#include "kml/dom/feature_splitter.h"
+#include "gtest/gtest.h"
+
+namespace kmldom {
+
+class FeatureSplitterTest : public testing::Test {
+ protected:
+  bool Split(const string& kml, size_t chunk_size) {
+    return SplitAtFeatures(kml.data(), kml.size(), chunk_size,
+                           &feature_split_);
+  }
+
+  string GetChunk(const string& kml, size_t i) {
+    const std::pair<size_t, size_t>& chunk = feature_split_.chunks[i];
+    return kml.substr(chunk.first, chunk.second - chunk.first);
+  }
+
+  FeatureSplit feature_split_;
+};
+
+TEST_F(FeatureSplitterTest, TestSplitKmlDocument) {
+  const string kKml(
+      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+      "<!-- <Document> -->\n"
+      "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n"
+      "<NetworkLinkControl><Update><Create><Folder targetId=\"f\">"
+      "<Placemark/></Folder></Create></Update></NetworkLinkControl>\n"
+      "<Document id=\"d\">\n"
+      "<name>d</name>\n"
+      "<Style id=\"s\"/>\n"
+      "<Placemark><name>a</name></Placemark>\n"
+      "<!-- </Document> <Placemark> -->\n"
+      "<Placemark><description><![CDATA[</Placemark>]]></description>"
+      "</Placemark>\n"
+      "<Folder><Placemark/><Folder/></Folder>"
+      "<Schema name=\"x\"/>"
+      "<Placemark name='>'/>\n"
+      "</Document>\n"
+      "</kml>\n");
+  // A chunk_size of 0 puts each Feature in a chunk of its own.
+  ASSERT_TRUE(Split(kKml, 0));
+  ASSERT_EQ(string("<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+                   "<kml xmlns=\"http://www.opengis.net/kml/2.2\">"
+                   "<Document id=\"d\">"),
+            feature_split_.prefix);
+  ASSERT_EQ(string("</Document></kml>"), feature_split_.suffix);
+  ASSERT_EQ(static_cast<size_t>(2), feature_split_.prefix_depth);
+  ASSERT_EQ(static_cast<size_t>(4), feature_split_.chunks.size());
+  ASSERT_EQ(string("<Placemark><name>a</name></Placemark>"),
+            GetChunk(kKml, 0));
+  ASSERT_EQ(string("<Placemark><description><![CDATA[</Placemark>]]>"
+                   "</description></Placemark>"),
+            GetChunk(kKml, 1));
+  ASSERT_EQ(string("<Folder><Placemark/><Folder/></Folder>"),
+            GetChunk(kKml, 2));
+  ASSERT_EQ(string("<Placemark name='>'/>"), GetChunk(kKml, 3));
+
+  // A larger chunk_size groups consecutive Features, but a chunk ends at a
+  // non-Feature.
+  ASSERT_TRUE(Split(kKml, 1000));
+  ASSERT_EQ(static_cast<size_t>(2), feature_split_.chunks.size());
+  ASSERT_EQ(string("<Placemark><name>a</name></Placemark>\n"
+                   "<!-- </Document> <Placemark> -->\n"
+                   "<Placemark><description><![CDATA[</Placemark>]]>"
+                   "</description></Placemark>\n"
+                   "<Folder><Placemark/><Folder/></Folder>"),
+            GetChunk(kKml, 0));
+  ASSERT_EQ(string("<Placemark name='>'/>"), GetChunk(kKml, 1));
+}
+
+TEST_F(FeatureSplitterTest, TestSplitRootFolder) {
+  const string kKml(
+      "\xEF\xBB\xBF<Folder><Placemark/><GroundOverlay/><ScreenOverlay/>"
+      "<PhotoOverlay/><NetworkLink/><gx:Tour/><Document/><Folder/>"
+      "<Placemark/></Folder>");
+  ASSERT_TRUE(Split(kKml, 20));
+  ASSERT_EQ(string("<Folder>"), feature_split_.prefix);
+  ASSERT_EQ(string("</Folder>"), feature_split_.suffix);
+  ASSERT_EQ(static_cast<size_t>(1), feature_split_.prefix_depth);
+  ASSERT_EQ(static_cast<size_t>(5), feature_split_.chunks.size());
+  ASSERT_EQ(string("<Placemark/><GroundOverlay/>"), GetChunk(kKml, 0));
+  ASSERT_EQ(string("<ScreenOverlay/><PhotoOverlay/>"), GetChunk(kKml, 1));
+  ASSERT_EQ(string("<NetworkLink/><gx:Tour/>"), GetChunk(kKml, 2));
+  ASSERT_EQ(string("<Document/><Folder/>"), GetChunk(kKml, 3));
+  ASSERT_EQ(string("<Placemark/>"), GetChunk(kKml, 4));
+}
+
+TEST_F(FeatureSplitterTest, TestNoSplit) {
+  // No Container.
+  ASSERT_FALSE(Split("<kml><Placemark/></kml>", 0));
+  ASSERT_FALSE(Split("<Placemark><name>a</name></Placemark>", 0));
+  // No Features.
+  ASSERT_FALSE(Split("<kml><Document><Style/></Document></kml>", 0));
+  ASSERT_FALSE(Split("<kml><Document/></kml>", 0));
+  // Not KML.
+  ASSERT_FALSE(Split("<foo><Document><Placemark/></Document></foo>", 0));
+  ASSERT_FALSE(Split("", 0));
+  ASSERT_FALSE(Split("junk", 0));
+  // A DOCTYPE may declare entities.
+  ASSERT_FALSE(Split("<!DOCTYPE kml [<!ENTITY e \"x\">]>"
+                     "<kml><Document><Placemark/></Document></kml>", 0));
+  // Old style <Schema> usage.
+  ASSERT_FALSE(Split("<kml><Document>"
+                     "<Schema parent=\"Placemark\" name=\"S\"/>"
+                     "<Placemark/><S/></Document></kml>", 0));
+  // UTF-16.
+  ASSERT_FALSE(Split(string("\xFF\xFE<\0k\0", 6), 0));
+  ASSERT_FALSE(Split(string("<\0k\0m\0l\0", 8), 0));
+  // Truncated or unterminated markup.
+  ASSERT_FALSE(Split("<kml><Document><Placemark/>", 0));
+  ASSERT_FALSE(Split("<kml><Document><Placemark/><!-- </Document></kml>",
+                     0));
+  ASSERT_FALSE(Split("<kml><Document><Placemark/><![CDATA[ </Document></kml>",
+                     0));
+  ASSERT_FALSE(Split("<kml><Document><Placemark name=\"/></Document></kml>",
+                     0));
+}
+
+TEST(FindIdsTest, TestFindIds) {
+  const string kKml(
+      "<Placemark id=\"p\"><name>id=\"x\"</name>"
+      "<!-- <Point id=\"c\"/> --><![CDATA[<Point id=\"d\"/>]]>"
+      "<Point targetId=\"t\" id = 'q'/>"
+      "<Style id=\"a>b\"/><?pi id=\"e\"?></Placemark>");
+  std::vector<string> ids;
+  FindIds(kKml.data(), kKml.size(), &ids);
+  ASSERT_EQ(static_cast<size_t>(3), ids.size());
+  ASSERT_EQ(string("p"), ids[0]);
+  ASSERT_EQ(string("q"), ids[1]);
+  ASSERT_EQ(string("a>b"), ids[2]);
+}
+
+}  // end namespace kmldom
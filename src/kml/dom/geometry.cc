@@ -28,9 +28,9 @@
 // outerBoundaryIs, innerBoundaryIs and Polygon.
 
 #include "kml/dom/geometry.h"
-#include <ctype.h>
-#include <stdlib.h>
+#include <string.h>
 #include "kml/base/attributes.h"
+#include "kml/base/string_util.h"
 #include "kml/base/xml_namespaces.h"
 #include "kml/dom/element.h"
 #include "kml/dom/kml22.h"
@@ -43,7 +43,9 @@ using kmlbase::Vec3;
 
 namespace kmldom {
 
-Coordinates::Coordinates() {
+Coordinates::Coordinates()
+  : is_deferred_(false),
+    is_unedited_(false) {
   set_xmlns(kmlbase::XMLNS_KML22);
 }
 
@@ -81,6 +83,20 @@ bool Coordinates::ParseVec3(const char* cstr, char** nextp, Vec3* vec) {
   if (!cstr || !vec) {  // Not much to do w/o input or output.
     return false;
   }
+  const char* next = cstr;
+  const bool done = ParseVec3(cstr, cstr + strlen(cstr), &next, vec);
+  if (nextp) {
+    *nextp = const_cast<char*>(next);
+  }
+  return done;
+}
+
+// This is the workhorse of ParseVec3 above.  end must point to the NUL
+// terminating the string starting at cstr.  Knowing the end lets the scans
+// for separators and whitespace below use memchr and FindNonWhitespace
+// rather than a byte at a time loop.
+bool Coordinates::ParseVec3(const char* cstr, const char* end,
+                            const char** nextp, Vec3* vec) {
   bool done = false;
   char* endp = const_cast<char*>(cstr);
 
@@ -92,56 +108,44 @@ bool Coordinates::ParseVec3(const char* cstr, char** nextp, Vec3* vec) {
     ++endp;
   }
 
-  // Longitude first.  strtod() eats leading whitespace.
-  vec->set(0, strtod(endp, &endp));
-  if (endp) {
-
-    // Latitude next.
-    while (isspace(*endp) || *endp != ',') {
-      // We check here to make sure the parse is sane. If we've been passed
-      // an invalid coordinate string, this loop will reach the null
-      // terminator. If we see it, we set the nextp pointer to the end and
-      // return which will let Coordinates::Parse know that it's finished.
-      if (*endp == '\0') {
-        *nextp = endp;
-        return done;
-      }
-      // Eat whitespace between double and comma.
-      ++endp;
-    }
-    vec->set(1, strtod(endp+1, &endp));
-    done = true;  // Need at least lon,lat to be valid.
+  // Longitude first.  ParseDouble() eats leading whitespace.
+  vec->set(0, kmlbase::ParseDouble(endp, &endp));
 
-    // If no altitude set to 0
-    while (isspace(*endp)) {  // Eat whitespace between double and comma.
-      ++endp;
-    }
-    if (*endp == ',') {
-      // Note that this sets altitude only if an altitude is supplied.
-      vec->set(2, strtod(endp+1, &endp));
-    }
+  // Latitude next.  Anything between the longitude and the next comma is
+  // discarded.  If there is no comma we've been passed an invalid coordinate
+  // string: set nextp to the end which lets Coordinates::Parse know that
+  // it's finished.
+  const char* comma = static_cast<const char*>(memchr(endp, ',', end - endp));
+  if (!comma) {
+    *nextp = end;
+    return done;
   }
-  if (nextp) {
-    while (isspace(*endp)) {  // Eat the remaining whitespace before return.
-      ++endp;
-    }
-    *nextp = endp;
+  vec->set(1, kmlbase::ParseDouble(comma + 1, &endp));
+  done = true;  // Need at least lon,lat to be valid.
+
+  // If no altitude set to 0
+  endp = const_cast<char*>(kmlbase::FindNonWhitespace(endp, end));
+  if (*endp == ',') {
+    // Note that this sets altitude only if an altitude is supplied.
+    vec->set(2, kmlbase::ParseDouble(endp + 1, &endp));
   }
+  // Eat the remaining whitespace before return.
+  *nextp = kmlbase::FindNonWhitespace(endp, end);
   return done;
 }
 
 // The char_data is everything between <coordinates> elements including
 // leading and trailing whitespace.
 void Coordinates::Parse(const string& char_data) {
-  const char* cstr = char_data.c_str();
-  const char* endp = cstr + char_data.size();
-  char* next = const_cast<char*>(cstr);
-  while (next != endp) {
+  const char* next = char_data.c_str();
+  const char* end = next + char_data.size();
+  while (next != end) {
     Vec3 vec;
-    if (ParseVec3(next, &next, &vec)) {
-      coordinates_array_.push_back(vec);
+    if (ParseVec3(next, end, &next, &vec)) {
+      Append(vec);
     }
   }
+  columns_.Shrink();
 }
 
 // Coordinates essentially parses itself.
@@ -149,12 +153,70 @@ void Coordinates::AddElement(const ElementPtr& element) {
   Parse(get_char_data());
 }
 
+void Coordinates::DeferParse() {
+  columns_.Reset(columns_.get_type());
+  is_deferred_ = true;
+  is_unedited_ = true;
+}
+
+void Coordinates::Decode() const {
+  is_deferred_ = false;
+  const_cast<Coordinates*>(this)->Parse(get_char_data());
+}
+
+void Coordinates::ReleaseCharData() {
+  string char_data;
+  swap_char_data(&char_data);
+}
+
+void Coordinates::ShareTuples(const Coordinates& coordinates) {
+  columns_.Share(coordinates.columns_);
+  is_deferred_ = coordinates.is_deferred_;
+  is_unedited_ = coordinates.is_unedited_;
+  // The character data is kept only for as long as it is to be serialized.
+  string char_data;
+  if (is_unedited_) {
+    char_data = coordinates.get_char_data();
+  }
+  swap_char_data(&char_data);
+}
+
+void Coordinates::set_storage(CoordinatesStorage storage) {
+  if (storage == columns_.get_type()) {
+    return;
+  }
+  if (is_deferred_) {
+    // The tuples are decoded to the new storage.
+    columns_.Reset(storage);
+    return;
+  }
+  std::vector<Vec3> vec3s;
+  vec3s.reserve(columns_.size());
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    vec3s.push_back(columns_.at(i));
+  }
+  columns_.Reset(storage);
+  for (size_t i = 0; i < vec3s.size(); ++i) {
+    Append(vec3s[i]);
+  }
+  columns_.Shrink();
+}
+
 void Coordinates::Serialize(Serializer& serializer) const {
   Attributes dummy;
   serializer.BeginById(Type(), dummy);
-  serializer.BeginElementArray(Type(), coordinates_array_.size());
-  for (size_t i = 0; i < coordinates_array_.size(); ++i) {
-    serializer.SaveVec3(coordinates_array_[i]);
+  // The character data of unedited tuples is saved as parsed if the
+  // serializer can.
+  if (is_unedited_ && serializer.SaveCoordinatesText(get_char_data())) {
+    serializer.End();
+    return;
+  }
+  if (is_deferred_) {
+    Decode();
+  }
+  serializer.BeginElementArray(Type(), columns_.size());
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    serializer.SaveVec3(columns_.at(i));
   }
   serializer.EndElementArray(Type_coordinates);
   serializer.End();
@@ -524,14 +586,24 @@ void GxTrack::Parse(const string& char_data, std::vector<Vec3>* out) {
   if (!out) {
     return;
   }
-  // TODO: this is a little heavy. Optimization along the lines of
-  // Coordinates::Parse may be required.
-  std::vector<string> s;
-  kmlbase::SplitStringUsing(char_data, " ", &s);
+  // The fields are split on single spaces in place.  Each field is parsed
+  // as strtod() would parse it on its own: a field of only whitespace (or
+  // none at all, as between two adjacent spaces) is 0, and altitude is set
+  // if there is a third field whatever its content.
+  const char* field = char_data.c_str();
+  const char* end = field + char_data.size();
   kmlbase::Vec3 vec;
-  for (size_t i = 0; i < s.size(); i++) {
-    vec.set(i, strtod(s[i].c_str(), NULL));
-    if (i > 2) break;
+  for (int i = 0; ; ++i) {
+    const char* field_end =
+        static_cast<const char*>(memchr(field, ' ', end - field));
+    if (!field_end) {
+      field_end = end;
+    }
+    const char* number = kmlbase::FindNonWhitespace(field, field_end);
+    vec.set(i, number == field_end ?
+                   0.0 : kmlbase::ParseDouble(number, NULL));
+    if (i > 2 || field_end == end) break;
+    field = field_end + 1;
   }
   out->push_back(vec);
 }
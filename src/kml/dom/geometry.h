@@ -75,6 +75,7 @@
 #include <vector>
 #include "kml/base/util.h"
 #include "kml/base/vec3.h"
+#include "kml/dom/coordinate_columns.h"
 #include "kml/dom/extendeddata.h"
 #include "kml/dom/kml22.h"
 #include "kml/dom/kml_ptr.h"
@@ -88,39 +89,98 @@ class Visitor;
 class VisitorDriver;
 
 // <coordinates>
+// If parsed with ParseOptions::defer_coordinates the tuples are decoded from
+// the character data on first access, and until the tuples are changed the
+// character data is serialized as parsed.  The tuples are stored as selected
+// by set_storage() or ParseOptions::coordinates_storage.
 class Coordinates : public BasicElement<Type_coordinates> {
  public:
   virtual ~Coordinates();
 
   // The main KML-specific API
   void add_latlngalt(double latitude, double longitude, double altitude) {
-    coordinates_array_.push_back(kmlbase::Vec3(longitude, latitude, altitude));
+    Edit();
+    Append(kmlbase::Vec3(longitude, latitude, altitude));
   }
 
   void add_latlng(double latitude, double longitude) {
-    coordinates_array_.push_back(kmlbase::Vec3(longitude, latitude));
+    Edit();
+    Append(kmlbase::Vec3(longitude, latitude));
   }
 
   void add_vec3(const kmlbase::Vec3& vec3) {
-    coordinates_array_.push_back(vec3);
+    Edit();
+    Append(vec3);
   }
 
   size_t get_coordinates_array_size() const {
-    return coordinates_array_.size();
+    if (is_deferred_) {
+      Decode();
+    }
+    return columns_.size();
   }
 
+  // An index out of range returns an empty Vec3.
   const kmlbase::Vec3 get_coordinates_array_at(size_t index) const {
-    return coordinates_array_[index];
+    if (is_deferred_) {
+      Decode();
+    }
+    return columns_.at(index);
+  }
+
+  // This selects how the tuples are stored.  Any tuples are converted, and
+  // with COORDINATES_FLOAT or COORDINATES_FIXED they are quantized.
+  void set_storage(CoordinatesStorage storage);
+  CoordinatesStorage get_storage() const {
+    return columns_.get_type();
+  }
+
+  // The columns of the tuples for a storage other than COORDINATES_VEC3.
+  // Their spans let a loop over the tuples run over contiguous arrays.
+  const CoordinateColumns& get_coordinate_columns() const {
+    if (is_deferred_) {
+      Decode();
+    }
+    return columns_;
   }
 
   // Internal methods used in parser.  Public for unittest purposes.
   // See .cc for more details.
   void Parse(const string& char_data);
   static bool ParseVec3(const char* coords, char** nextp, kmlbase::Vec3* vec);
+  static bool ParseVec3(const char* coords, const char* end,
+                        const char** nextp, kmlbase::Vec3* vec);
 
-  // This clears the internal coordinates array.
+  // This clears the internal coordinates array.  Any character data the
+  // tuples were parsed from is released.
   void Clear() {
-    coordinates_array_.clear();
+    columns_.Reset(columns_.get_type());
+    is_deferred_ = false;
+    is_unedited_ = false;
+    ReleaseCharData();
+  }
+
+  // This returns true if the tuples are yet to be decoded from the
+  // character data.
+  bool is_deferred() const {
+    return is_deferred_;
+  }
+
+  // This returns the size in bytes of the storage of the tuples.  Tuples
+  // yet to be decoded take none.
+  size_t GetAllocatedBytes() const {
+    return columns_.GetAllocatedBytes();
+  }
+
+  // This gives this Coordinates the tuples of the given one.  The storage
+  // of the tuples is shared rather than copied until either Coordinates
+  // changes its tuples.  Deferred character data is copied undecoded.
+  void ShareTuples(const Coordinates& coordinates);
+
+  // This returns true if the storage of the tuples is shared with another
+  // Coordinates.
+  bool is_shared() const {
+    return columns_.is_shared();
   }
 
   // Visitor API methods, see visitor.h.
@@ -131,10 +191,35 @@ class Coordinates : public BasicElement<Type_coordinates> {
   Coordinates();
   friend class KmlHandler;
   virtual void AddElement(const ElementPtr& element);
+  // KmlHandler calls this in place of AddElement() to defer the decoding of
+  // the character data.
+  void DeferParse();
+  // This decodes the character data to the tuples.
+  void Decode() const;
+  // This prepares the tuples for a change.  The character data they were
+  // decoded from is released as it is no longer serialized.
+  void Edit() {
+    if (is_deferred_) {
+      Decode();
+    }
+    is_unedited_ = false;
+    if (!get_char_data().empty()) {
+      ReleaseCharData();
+    }
+  }
+  void ReleaseCharData();
+  void Append(const kmlbase::Vec3& vec3) {
+    columns_.push_back(vec3);
+  }
   friend class Serializer;
   virtual void Serialize(Serializer& serializer) const;
 
-  std::vector<kmlbase::Vec3> coordinates_array_;
+  // The tuples, possibly shared with a clone.  See ShareTuples().
+  mutable CoordinateColumns columns_;
+  // True until Decode() is called on deferred character data.
+  mutable bool is_deferred_;
+  // True if the deferred character data is unchanged by any edit.
+  bool is_unedited_;
   LIBKML_DISALLOW_EVIL_CONSTRUCTORS(Coordinates);
 };
 
@@ -28,17 +28,148 @@
 // MultiGeometry.
 
 #include "kml/dom/geometry.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "kml/base/file.h"
+#include "kml/base/string_util.h"
 #include "kml/dom/kml_cast.h"
 #include "kml/dom/kml_factory.h"
 #include "kml/dom/kml_ptr.h"
 #include "kml/dom/kml_funcs.h"
+#include "kml/dom/parser.h"
 #include "kml/dom/serializer.h"
 #include "gtest/gtest.h"
 
+#ifndef DATADIR
+#error *** DATADIR must be defined! ***
+#endif
+
 using kmlbase::Vec3;
 
 namespace kmldom {
 
+// This is the strtod()-based coordinate tuple parser which Coordinates used
+// before it had its own tokenizer.  It is kept verbatim as the reference for
+// the differential tests below.
+static bool LegacyParseVec3(const char* cstr, char** nextp, Vec3* vec) {
+  bool done = false;
+  char* endp = const_cast<char*>(cstr);
+  if (*endp == ',') {
+    ++endp;
+  }
+  vec->set(0, strtod(endp, &endp));
+  if (endp) {
+    while (isspace(*endp) || *endp != ',') {
+      if (*endp == '\0') {
+        *nextp = endp;
+        return done;
+      }
+      ++endp;
+    }
+    vec->set(1, strtod(endp+1, &endp));
+    done = true;
+    while (isspace(*endp)) {
+      ++endp;
+    }
+    if (*endp == ',') {
+      vec->set(2, strtod(endp+1, &endp));
+    }
+  }
+  if (nextp) {
+    while (isspace(*endp)) {
+      ++endp;
+    }
+    *nextp = endp;
+  }
+  return done;
+}
+
+static void LegacyParseCoordinates(const string& char_data,
+                                   std::vector<Vec3>* out) {
+  const char* cstr = char_data.c_str();
+  const char* endp = cstr + char_data.size();
+  char* next = const_cast<char*>(cstr);
+  while (next != endp) {
+    Vec3 vec;
+    if (LegacyParseVec3(next, &next, &vec)) {
+      out->push_back(vec);
+    }
+  }
+}
+
+// The SplitStringUsing() and strtod() based parse GxTrack used for gx:coord
+// and gx:angles.
+static Vec3 LegacyParseGxTrackVec3(const string& char_data) {
+  std::vector<string> s;
+  kmlbase::SplitStringUsing(char_data, " ", &s);
+  Vec3 vec;
+  for (size_t i = 0; i < s.size(); i++) {
+    vec.set(i, strtod(s[i].c_str(), NULL));
+    if (i > 2) break;
+  }
+  return vec;
+}
+
+// Doubles are compared bit for bit: the new parse must round exactly as
+// strtod() does and must agree on the sign of zero.
+static bool SameDouble(double a, double b) {
+  return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static bool SameVec3(const Vec3& a, const Vec3& b) {
+  return SameDouble(a.get_longitude(), b.get_longitude()) &&
+         SameDouble(a.get_latitude(), b.get_latitude()) &&
+         SameDouble(a.get_altitude(), b.get_altitude()) &&
+         a.has_altitude() == b.has_altitude();
+}
+
+// This returns the content of every <tag>...</tag> in the given testdata
+// file.
+static void ReadTestDataElements(const char* file, const string& tag,
+                                 std::vector<string>* content) {
+  const string path(kmlbase::File::JoinPaths(DATADIR, file));
+  string data;
+  ASSERT_TRUE(kmlbase::File::ReadFileToString(path, &data)) << path;
+  const string begin_tag("<" + tag + ">");
+  const string end_tag("</" + tag + ">");
+  size_t begin = 0;
+  while ((begin = data.find(begin_tag, begin)) != string::npos) {
+    begin += begin_tag.size();
+    const size_t end = data.find(end_tag, begin);
+    ASSERT_NE(string::npos, end);
+    content->push_back(data.substr(begin, end - begin));
+    begin = end;
+  }
+}
+
+// A deterministic stream of strings drawn from an alphabet heavy in the
+// characters which matter to coordinate parsing.
+class FuzzedStrings {
+ public:
+  FuzzedStrings() : state_(12345) {}
+  string Next() {
+    static const char kAlphabet[] =
+        "0123456789012345678901234567890123456789"
+        "..........,,,,,,,,,,--++    \t\n\r\v\f*;xXeEinfa";
+    const size_t length = NextRandom() % 48;
+    string s;
+    for (size_t i = 0; i < length; ++i) {
+      s.push_back(kAlphabet[NextRandom() % (sizeof(kAlphabet) - 1)]);
+    }
+    return s;
+  }
+
+ private:
+  unsigned int NextRandom() {
+    state_ = state_ * 1103515245 + 12345;
+    return (state_ >> 16) & 0x7fff;
+  }
+  unsigned int state_;
+};
+
+static const int kFuzzIterations = 200000;
+
 // Test Coordinates.
 class CoordinatesTest : public testing::Test {
  protected:
@@ -275,6 +406,94 @@ TEST_F(CoordinatesTest, TestParseBadSeparator) {
                    coordinates_->get_coordinates_array_at(0).get_altitude());
 }
 
+// Parse the given coordinates with both Coordinates::Parse and the legacy
+// parser and verify they agree exactly.
+static void CheckCoordinatesParse(const string& char_data) {
+  std::vector<Vec3> expected;
+  LegacyParseCoordinates(char_data, &expected);
+  CoordinatesPtr coordinates = KmlFactory::GetFactory()->CreateCoordinates();
+  coordinates->Parse(char_data);
+  ASSERT_EQ(expected.size(), coordinates->get_coordinates_array_size())
+      << "[" << char_data << "]";
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_TRUE(SameVec3(expected[i],
+                         coordinates->get_coordinates_array_at(i)))
+        << "[" << char_data << "] tuple " << i;
+  }
+
+  // ParseVec3 must also agree on where each tuple ends.
+  const char* cstr = char_data.c_str();
+  char* legacy_next = const_cast<char*>(cstr);
+  char* next = legacy_next;
+  while (*legacy_next) {
+    Vec3 legacy_vec;
+    Vec3 vec;
+    ASSERT_EQ(LegacyParseVec3(legacy_next, &legacy_next, &legacy_vec),
+              Coordinates::ParseVec3(next, &next, &vec));
+    ASSERT_EQ(legacy_next, next) << "[" << char_data << "]";
+    ASSERT_TRUE(SameVec3(legacy_vec, vec)) << "[" << char_data << "]";
+  }
+}
+
+TEST_F(CoordinatesTest, TestParseMatchesLegacyOnEdgeCases) {
+  const char* kCases[] = {
+    "", " ", ",", ",,", ",,,,", "1", "1,", ",1", "1,2", "1,2,", "1,2,3,",
+    "1,2,3,4", "1,2,3,4,5", "1,2,3,4,5,6,7", " 1 , 2 , 3 ", "1 2 3",
+    "1.1*2.2,3.3", "130.999*66.56083,75", "1,,2", "1,2,,3", ",,1,2",
+    "1,2 3,4 5", "1,2\t\t3,4\n", "\n\t1.1, 2.2\t\t4.4, 5.5\n",
+    "-122.0822035425683,37.42228990140251,0",
+    "-122.0822035425683,37.42228990140251,0 -122.1,37.4,17.5",
+    "1e3,2E-3,3e+2", "1.e1,.5,-.5", "0x1p3,0x10,0X1P-2", "inf,-inf,nan",
+    "infinity,nan(123),INF", "+1,+2,+3", "-0,-0.0,-.0", "1.,2.,3.",
+    "0.000000000000000000000001,1e-400,1e400",
+    "123456789012345,1234567890123456,12345678901234567890",
+    "0.1234567890123456789,000000000000000000001.5,1.50000000000000000",
+    "9007199254740993,4.9406564584124654e-324,1.7976931348623157e308",
+    "1-2,3+4,5.6.7", "abc,def,ghi", "1,abc 2,3", "  \v\f1,2",
+  };
+  for (size_t i = 0; i < sizeof(kCases)/sizeof(kCases[0]); ++i) {
+    CheckCoordinatesParse(kCases[i]);
+  }
+}
+
+TEST_F(CoordinatesTest, TestParseMatchesLegacyOnTestData) {
+  const char* kFiles[] = {
+    "kml/all-altitudemodes.kml", "kml/badcoords.kml",
+    "kml/gnis-ak-first-101.kml", "kml/kmlsamples.kml",
+    "kml/outline_space.kml", "kmz/camels.kml", "update/california.kml",
+    "gx/all-gx.kml",
+  };
+  size_t count = 0;
+  for (size_t i = 0; i < sizeof(kFiles)/sizeof(kFiles[0]); ++i) {
+    std::vector<string> content;
+    ReadTestDataElements(kFiles[i], "coordinates", &content);
+    for (size_t j = 0; j < content.size(); ++j) {
+      CheckCoordinatesParse(content[j]);
+    }
+    count += content.size();
+  }
+  ASSERT_LT(static_cast<size_t>(100), count);
+}
+
+TEST_F(CoordinatesTest, TestParseMatchesLegacyOnFuzzedStrings) {
+  FuzzedStrings fuzzed_strings;
+  for (int i = 0; i < kFuzzIterations; ++i) {
+    CheckCoordinatesParse(fuzzed_strings.Next());
+  }
+}
+
+TEST_F(CoordinatesTest, TestParseVec3WithEnd) {
+  const string kLine("  1.5,2.5,3.5\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t4,5");
+  const char* next = kLine.c_str();
+  const char* end = next + kLine.size();
+  Vec3 vec;
+  ASSERT_TRUE(Coordinates::ParseVec3(next, end, &next, &vec));
+  ASSERT_TRUE(Vec3(1.5, 2.5, 3.5) == vec);
+  ASSERT_EQ('4', *next);
+  ASSERT_TRUE(Coordinates::ParseVec3(next, end, &next, &vec));
+  ASSERT_EQ(end, next);
+}
+
 TEST_F(CoordinatesTest, TestClear) {
   // Clearing nothing results in nothing.
   coordinates_->Clear();
@@ -407,6 +626,165 @@ TEST_F(CoordinatesTest, TestCommaSeparators) {
                    coordinates_->get_coordinates_array_at(2).get_altitude());
 }
 
+// This parses the given <coordinates> with ParseOptions::defer_coordinates.
+static CoordinatesPtr ParseDeferredCoordinates(const string& kml) {
+  ParseOptions options;
+  options.defer_coordinates = true;
+  Parser parser;
+  parser.set_options(options);
+  return AsCoordinates(parser.Parse(kml, NULL));
+}
+
+TEST_F(CoordinatesTest, TestDeferredParse) {
+  const string kKml("<coordinates>\n  1.5,2,3 4,5\t6,7,8\n</coordinates>");
+  coordinates_ = ParseDeferredCoordinates(kKml);
+  ASSERT_TRUE(coordinates_);
+  ASSERT_TRUE(coordinates_->is_deferred());
+  // Unaccessed tuples serialize as parsed.
+  ASSERT_EQ(kKml, SerializeRaw(coordinates_));
+
+  // Access decodes the tuples as Parse() does.
+  ASSERT_EQ(static_cast<size_t>(3), coordinates_->get_coordinates_array_size());
+  ASSERT_FALSE(coordinates_->is_deferred());
+  ASSERT_EQ(Vec3(1.5, 2, 3), coordinates_->get_coordinates_array_at(0));
+  ASSERT_EQ(Vec3(4, 5, 0), coordinates_->get_coordinates_array_at(1));
+  ASSERT_EQ(Vec3(6, 7, 8), coordinates_->get_coordinates_array_at(2));
+  // Unedited tuples still serialize as parsed.
+  ASSERT_EQ(kKml, SerializeRaw(coordinates_));
+
+  // Any edit serializes as the tuples.
+  coordinates_->add_latlng(10, 9);
+  // The character data is released with the first edit.
+  ASSERT_TRUE(coordinates_->get_char_data().empty());
+  ASSERT_EQ(static_cast<size_t>(4), coordinates_->get_coordinates_array_size());
+  ASSERT_EQ(string("<coordinates>1.5,2,3\n4,5,0\n6,7,8\n9,10,0\n"
+                   "</coordinates>"),
+            SerializeRaw(coordinates_));
+
+  // An edit decodes deferred tuples first.
+  coordinates_ = ParseDeferredCoordinates(kKml);
+  coordinates_->add_vec3(Vec3(9, 10));
+  ASSERT_FALSE(coordinates_->is_deferred());
+  ASSERT_EQ(static_cast<size_t>(4), coordinates_->get_coordinates_array_size());
+  ASSERT_EQ(Vec3(1.5, 2, 3), coordinates_->get_coordinates_array_at(0));
+  coordinates_ = ParseDeferredCoordinates(kKml);
+  coordinates_->Clear();
+  ASSERT_TRUE(coordinates_->get_char_data().empty());
+  ASSERT_EQ(static_cast<size_t>(0), coordinates_->get_coordinates_array_size());
+  ASSERT_EQ(string("<coordinates/>"), SerializeRaw(coordinates_));
+
+  // A serializer which takes the tuples gets them decoded.
+  coordinates_ = ParseDeferredCoordinates(kKml);
+  Vec3Vector vec3_vector;
+  MockCoordinatesSerializer mock(&vec3_vector);
+  mock.SaveElement(coordinates_);
+  ASSERT_EQ(static_cast<size_t>(3), vec3_vector.size());
+  ASSERT_EQ(Vec3(6, 7, 8), vec3_vector[2]);
+}
+
+TEST_F(CoordinatesTest, TestDeferredParseTestData) {
+  // A document with geometry serializes the same whether or not its
+  // coordinates were decoded.
+  string kml;
+  ASSERT_TRUE(kmlbase::File::ReadFileToString(
+      string(DATADIR) + "/kml/kmlsamples.kml", &kml));
+  ElementPtr root = Parse(kml, NULL);
+  ParseOptions options;
+  options.defer_coordinates = true;
+  Parser parser;
+  parser.set_options(options);
+  ElementPtr deferred_root = parser.Parse(kml, NULL);
+  ASSERT_TRUE(deferred_root);
+  ASSERT_NE(SerializePretty(root), SerializePretty(deferred_root));
+  ElementPtr reparsed_root = Parse(SerializePretty(deferred_root), NULL);
+  ASSERT_EQ(SerializePretty(root), SerializePretty(reparsed_root));
+}
+
+TEST_F(CoordinatesTest, TestSetStorage) {
+  coordinates_->add_latlngalt(2.5, 1.5, 3.5);
+  coordinates_->add_latlng(5, 4);
+  ASSERT_EQ(COORDINATES_VEC3, coordinates_->get_storage());
+  ASSERT_TRUE(NULL ==
+              coordinates_->get_coordinate_columns().get_double_column(0));
+  const string kSerialized(SerializeRaw(coordinates_));
+
+  // The tuples move to the columns.
+  coordinates_->set_storage(COORDINATES_DOUBLE);
+  ASSERT_EQ(COORDINATES_DOUBLE, coordinates_->get_storage());
+  ASSERT_EQ(static_cast<size_t>(2), coordinates_->get_coordinates_array_size());
+  ASSERT_EQ(Vec3(1.5, 2.5, 3.5), coordinates_->get_coordinates_array_at(0));
+  ASSERT_FALSE(coordinates_->get_coordinates_array_at(1).has_altitude());
+  const CoordinateColumns& columns = coordinates_->get_coordinate_columns();
+  ASSERT_EQ(4.0, columns.get_double_column(0)[1]);
+  ASSERT_EQ(5.0, columns.get_double_column(1)[1]);
+  ASSERT_EQ(kSerialized, SerializeRaw(coordinates_));
+
+  // Edits go to the columns.
+  coordinates_->add_vec3(Vec3(7, 8, 9));
+  ASSERT_EQ(static_cast<size_t>(3), columns.size());
+  ASSERT_EQ(9.0, columns.get_double_column(2)[2]);
+
+  // And back.
+  coordinates_->set_storage(COORDINATES_VEC3);
+  ASSERT_EQ(static_cast<size_t>(3), coordinates_->get_coordinates_array_size());
+  ASSERT_EQ(Vec3(7, 8, 9), coordinates_->get_coordinates_array_at(2));
+  coordinates_->Clear();
+  ASSERT_EQ(static_cast<size_t>(0), coordinates_->get_coordinates_array_size());
+}
+
+// This parses the kml with the given ParseOptions::coordinates_storage.
+static ElementPtr ParseWithStorage(const string& kml,
+                                   CoordinatesStorage storage,
+                                   bool defer_coordinates) {
+  ParseOptions options;
+  options.coordinates_storage = storage;
+  options.defer_coordinates = defer_coordinates;
+  Parser parser;
+  parser.set_options(options);
+  return parser.Parse(kml, NULL);
+}
+
+TEST_F(CoordinatesTest, TestParseWithStorage) {
+  const string kKml("<coordinates>1.5,2,3 4,5\t6,7,8</coordinates>");
+  coordinates_ = AsCoordinates(
+      ParseWithStorage(kKml, COORDINATES_FLOAT, false));
+  ASSERT_TRUE(coordinates_);
+  ASSERT_EQ(COORDINATES_FLOAT, coordinates_->get_storage());
+  const float* altitudes =
+      coordinates_->get_coordinate_columns().get_float_column(2);
+  ASSERT_TRUE(altitudes);
+  ASSERT_EQ(8.0f, altitudes[2]);
+  ASSERT_EQ(Vec3(4, 5), coordinates_->get_coordinates_array_at(1));
+
+  // Deferred tuples are decoded to the columns.
+  coordinates_ = AsCoordinates(
+      ParseWithStorage(kKml, COORDINATES_FIXED, true));
+  ASSERT_TRUE(coordinates_->is_deferred());
+  ASSERT_EQ(kKml, SerializeRaw(coordinates_));
+  const int32_t* longitudes =
+      coordinates_->get_coordinate_columns().get_fixed_column(0);
+  ASSERT_FALSE(coordinates_->is_deferred());
+  ASSERT_TRUE(longitudes);
+  ASSERT_EQ(15000000, longitudes[0]);
+  ASSERT_EQ(Vec3(6, 7, 8), coordinates_->get_coordinates_array_at(2));
+}
+
+TEST_F(CoordinatesTest, TestParseWithStorageTestData) {
+  string kml;
+  ASSERT_TRUE(kmlbase::File::ReadFileToString(
+      string(DATADIR) + "/kml/kmlsamples.kml", &kml));
+  // Columns of doubles lose nothing.
+  const string kSerialized(SerializePretty(Parse(kml, NULL)));
+  ASSERT_EQ(kSerialized, SerializePretty(
+      ParseWithStorage(kml, COORDINATES_DOUBLE, false)));
+  // Quantized tuples differ but quantize no further when parsed again.
+  const string kFixed(SerializePretty(
+      ParseWithStorage(kml, COORDINATES_FIXED, false)));
+  ASSERT_NE(kSerialized, kFixed);
+  ASSERT_EQ(kFixed, SerializePretty(
+      ParseWithStorage(kFixed, COORDINATES_FIXED, false)));
+}
+
 // Test Point.
 class PointTest : public testing::Test {
  protected:
@@ -1148,6 +1526,37 @@ TEST_F(GxTrackTest, TestParse) {
   ASSERT_TRUE(gx_track->has_extendeddata());
 }
 
+static void CheckGxTrackParse(const string& char_data) {
+  GxTrackPtr gx_track = KmlFactory::GetFactory()->CreateGxTrack();
+  std::vector<Vec3> vec3s;
+  gx_track->Parse(char_data, &vec3s);
+  ASSERT_EQ(static_cast<size_t>(1), vec3s.size());
+  ASSERT_TRUE(SameVec3(LegacyParseGxTrackVec3(char_data), vec3s[0]))
+      << "[" << char_data << "]";
+}
+
+TEST_F(GxTrackTest, TestParseMatchesLegacy) {
+  const char* kCases[] = {
+    "", " ", "  ", "1", "1 ", " 1", "1 2", "1  2", "1 2 ", "1 2 3",
+    "1 2 3 4 5", "-122.1 37.2 100.3       ", "\t-122.1\n37.2 \t100.3",
+    "1,2,3", "1e2 2E-2 0x10", "inf nan -inf", "  \t  ", "a b c",
+    "-0 -0.0 +0", "1234567890123456789 0.12345678901234567890 1",
+  };
+  for (size_t i = 0; i < sizeof(kCases)/sizeof(kCases[0]); ++i) {
+    CheckGxTrackParse(kCases[i]);
+  }
+  std::vector<string> content;
+  ReadTestDataElements("gx/all-gx.kml", "gx:coord", &content);
+  ASSERT_FALSE(content.empty());
+  for (size_t i = 0; i < content.size(); ++i) {
+    CheckGxTrackParse(content[i]);
+  }
+  FuzzedStrings fuzzed_strings;
+  for (int i = 0; i < kFuzzIterations; ++i) {
+    CheckGxTrackParse(fuzzed_strings.Next());
+  }
+}
+
 TEST_F(GxTrackTest, TestSerialize) {
   gx_track_->set_altitudemode(ALTITUDEMODE_RELATIVETOGROUND);
   ASSERT_TRUE(gx_track_->has_altitudemode());
@@ -0,0 +1,185 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of the IncrementalParser class.
+
+#include "kml/dom/incremental_parser.h"
+#include "kml/base/expat_parser.h"
+#include "kml/dom/kml_handler.h"
+
+namespace kmldom {
+
+// The most bytes handed to expat in one XML_Parse() call.  As in
+// ExpatParser::ParseBytes() this bounds expat's own buffer.
+static const size_t kFeedWindowSize = 1024 * 1024;
+
+IncrementalParser::IncrementalParser()
+  : finish_pending_(false),
+    final_parsed_(false),
+    in_parse_(false),
+    suspended_(false),
+    paused_(false),
+    failed_(false),
+    finished_(false) {
+}
+
+IncrementalParser::~IncrementalParser() {
+}
+
+void IncrementalParser::AddObserver(ParserObserver* parser_observer) {
+  if (parser_observer) {
+    observers_.push_back(parser_observer);
+  }
+}
+
+bool IncrementalParser::Feed(const char* data, size_t size) {
+  if (failed_ || finished_ || finish_pending_) {
+    return false;
+  }
+  if (paused_) {
+    pending_.append(data, size);
+    return true;
+  }
+  Start();
+  ParseBytes(data, size, false);
+  return !failed_;
+}
+
+bool IncrementalParser::Finish() {
+  if (failed_ || finished_) {
+    return finished_;
+  }
+  finish_pending_ = true;
+  if (paused_) {
+    return true;
+  }
+  Start();
+  ParseBytes(NULL, 0, true);
+  return !failed_;
+}
+
+void IncrementalParser::Pause() {
+  if (failed_ || finished_) {
+    return;
+  }
+  paused_ = true;
+  if (in_parse_) {
+    expat_parser_->Suspend();
+  }
+}
+
+bool IncrementalParser::Resume() {
+  if (failed_ || !paused_) {
+    return !failed_;
+  }
+  paused_ = false;
+  if (suspended_) {
+    in_parse_ = true;
+    const XML_Status status = expat_parser_->Resume(&errors_);
+    in_parse_ = false;
+    if (!HandleStatus(status)) {
+      return !failed_;
+    }
+  }
+  if (!pending_.empty()) {
+    string pending;
+    pending.swap(pending_);
+    Start();
+    if (!ParseBytes(pending.data(), pending.size(), false)) {
+      return !failed_;
+    }
+  }
+  if (finish_pending_ && !final_parsed_) {
+    Start();
+    ParseBytes(NULL, 0, true);
+  }
+  return !failed_;
+}
+
+// Private.
+void IncrementalParser::Start() {
+  if (!kml_handler_.get()) {
+    kml_handler_.reset(new KmlHandler(observers_, options_));
+    expat_parser_.reset(new kmlbase::ExpatParser(kml_handler_.get(), false));
+  }
+}
+
+// Private.  This hands the bytes to expat a window at a time.  If a
+// ParserObserver pauses the parse the bytes expat has not been handed are
+// held in pending_.  This returns false if the parse fails or is paused.
+bool IncrementalParser::ParseBytes(const char* data, size_t size,
+                                   bool is_final) {
+  final_parsed_ = is_final;
+  do {
+    const size_t window = size < kFeedWindowSize ? size : kFeedWindowSize;
+    in_parse_ = true;
+    const XML_Status status = expat_parser_->ParseChunk(
+        data, window, is_final && window == size, &errors_);
+    in_parse_ = false;
+    data += window;
+    size -= window;
+    if (!HandleStatus(status)) {
+      if (!failed_) {
+        pending_.append(data, size);
+      }
+      return false;
+    }
+  } while (size > 0);
+  return true;
+}
+
+// Private.  This returns true if expat has parsed all it was given.
+bool IncrementalParser::HandleStatus(int status) {
+  switch (status) {
+    case XML_STATUS_OK:
+      suspended_ = false;
+      if (final_parsed_) {
+        root_ = kml_handler_->PopRoot();
+        finished_ = true;
+      }
+      return true;
+    case XML_STATUS_SUSPENDED:
+      // KmlHandler also suspends expat to terminate the parse.
+      if (kml_handler_->is_stopped()) {
+        Fail("Invalid root element");
+        return false;
+      }
+      suspended_ = true;
+      return false;
+    default:
+      Fail(errors_);
+      return false;
+  }
+}
+
+// Private.
+void IncrementalParser::Fail(const string& errors) {
+  errors_ = errors;
+  failed_ = true;
+  paused_ = false;
+  pending_.clear();
+}
+
+}  // end namespace kmldom
@@ -0,0 +1,166 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of the IncrementalParser class.
+
+#ifndef KML_DOM_INCREMENTAL_PARSER_H__
+#define KML_DOM_INCREMENTAL_PARSER_H__
+
+#include "boost/scoped_ptr.hpp"
+#include "kml/dom/kml_ptr.h"
+#include "kml/dom/parse_options.h"
+#include "kml/dom/parser_observer.h"
+#include "kml/base/util.h"
+
+namespace kmlbase {
+class ExpatParser;
+}
+
+namespace kmldom {
+
+class KmlHandler;
+
+// The IncrementalParser parses KML as it arrives, such as from a socket or a
+// pipe, without the whole document in memory as one string.  Each Feed()
+// parses the bytes given so far and the ParserObservers see each Element as
+// it is completed, well before the end of the document.  A ParserObserver
+// can Pause() the parse from within any of its callbacks and the parse then
+// stops once the callback returns, keeping its place in the input.  Any
+// bytes fed while paused are held until Resume().  This permits an
+// application to bound the work done per Feed() or to hand off each
+// Feature as it is parsed.  The Elements built are as from Parser::Parse().
+//
+// Intended usage:
+//   IncrementalParser parser;
+//   parser.AddObserver(...);
+//   while (... the next size bytes of the document are in buf ...) {
+//     if (!parser.Feed(buf, size)) {
+//       break;
+//     }
+//     while (parser.is_paused()) {
+//       ... take the Elements handed off by the observer ...
+//       parser.Resume();
+//     }
+//   }
+//   if (parser.Finish()) {
+//     ElementPtr root = parser.get_root();
+//   } else {
+//     ... parser.get_errors() ...
+//   }
+class IncrementalParser {
+ public:
+  IncrementalParser();
+  ~IncrementalParser();
+
+  // This registers the given ParserObserver-based class as in
+  // Parser::AddObserver().  Observers must be added before the first Feed().
+  void AddObserver(ParserObserver* parser_observer);
+
+  // The ParseOptions apply to the parse started by the first Feed().
+  void set_options(const ParseOptions& options) {
+    options_ = options;
+  }
+  const ParseOptions& get_options() const {
+    return options_;
+  }
+
+  // This parses the next size bytes of the document.  The bytes need not end
+  // on any boundary of the XML.  This returns false if the XML so far is
+  // malformed, the root is not KML or a ParserObserver terminated the parse,
+  // or if Finish() has been called.  Once this returns false the parse is
+  // over and get_errors() has a diagnostic.
+  bool Feed(const char* data, size_t size);
+  bool Feed(const string& data) {
+    return Feed(data.data(), data.size());
+  }
+
+  // This marks the end of the document and completes the parse.  This
+  // returns false if the document is malformed or incomplete.  If the parse
+  // is paused the parse completes once it is resumed.
+  bool Finish();
+
+  // This pauses the parse.  If called from a ParserObserver callback the
+  // parse stops once the callback returns.  Otherwise any subsequent Feed()
+  // only holds its bytes.
+  void Pause();
+
+  // This resumes a paused parse, parsing any bytes held while paused and
+  // completing the parse if Finish() was called.  This returns false if the
+  // parse fails.  The parse may be paused again by a ParserObserver before
+  // this returns.
+  bool Resume();
+
+  bool is_paused() const {
+    return paused_;
+  }
+
+  // This returns true once the parse has completed without error.
+  bool is_finished() const {
+    return finished_;
+  }
+
+  // This returns true once the parse has failed.
+  bool has_failed() const {
+    return failed_;
+  }
+
+  // This is the root element once the parse has completed and NULL until
+  // then.
+  const ElementPtr& get_root() const {
+    return root_;
+  }
+
+  // This is a human readable diagnostic once the parse has failed.
+  const string& get_errors() const {
+    return errors_;
+  }
+
+ private:
+  void Start();
+  bool ParseBytes(const char* data, size_t size, bool is_final);
+  bool HandleStatus(int status);
+  void Fail(const string& errors);
+
+  parser_observer_vector_t observers_;
+  ParseOptions options_;
+  boost::scoped_ptr<KmlHandler> kml_handler_;
+  boost::scoped_ptr<kmlbase::ExpatParser> expat_parser_;
+  // The bytes fed while paused which expat has not yet seen.
+  string pending_;
+  bool finish_pending_;
+  bool final_parsed_;
+  bool in_parse_;
+  bool suspended_;
+  bool paused_;
+  bool failed_;
+  bool finished_;
+  string errors_;
+  ElementPtr root_;
+  LIBKML_DISALLOW_EVIL_CONSTRUCTORS(IncrementalParser);
+};
+
+}  // end namespace kmldom
+
+#endif  // KML_DOM_INCREMENTAL_PARSER_H__
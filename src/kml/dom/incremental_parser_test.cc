@@ -0,0 +1,257 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the unit tests for the IncrementalParser class.
+
+#include "kml/dom/incremental_parser.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "kml/base/file.h"
+#include "kml/dom/kml_cast.h"
+#include "kml/dom/kml_funcs.h"
+#include "kml/dom/placemark.h"
+#include "gtest/gtest.h"
+
+#ifndef DATADIR
+#error DATADIR must be defined!
+#endif
+
+namespace kmldom {
+
+static const char kDocument[] =
+  "<kml>"
+  "<Document>"
+  "<Placemark id=\"a\"><name>a</name></Placemark>"
+  "<Placemark id=\"b\"><name>b</name></Placemark>"
+  "<Placemark id=\"c\"><name>c</name></Placemark>"
+  "</Document>"
+  "</kml>";
+
+// This observer collects the id of each Placemark as it is completed.  It
+// pauses the given parser at each Placemark if pause is true and terminates
+// the parse at the Placemark with the id stop_id if not empty.
+class PlacemarkObserver : public ParserObserver {
+ public:
+  PlacemarkObserver(IncrementalParser* parser, bool pause,
+                    const string& stop_id)
+    : parser_(parser),
+      pause_(pause),
+      stop_id_(stop_id) {
+  }
+
+  virtual bool EndElement(const ElementPtr& parent, const ElementPtr& child) {
+    if (const PlacemarkPtr placemark = AsPlacemark(child)) {
+      ids_.push_back(placemark->get_id());
+      if (pause_) {
+        parser_->Pause();
+      }
+    }
+    return true;
+  }
+
+  virtual bool AddChild(const ElementPtr& parent, const ElementPtr& child) {
+    return stop_id_.empty() || !AsPlacemark(child) ||
+           AsPlacemark(child)->get_id() != stop_id_;
+  }
+
+  const std::vector<string>& get_ids() const {
+    return ids_;
+  }
+
+ private:
+  IncrementalParser* parser_;
+  const bool pause_;
+  const string stop_id_;
+  std::vector<string> ids_;
+};
+
+class IncrementalParserTest : public testing::Test {
+ protected:
+  // This feeds the kml to the parser chunk_size bytes at a time.
+  static bool FeedInChunks(const string& kml, size_t chunk_size,
+                           IncrementalParser* parser) {
+    for (size_t offset = 0; offset < kml.size(); offset += chunk_size) {
+      const size_t size = std::min(chunk_size, kml.size() - offset);
+      if (!parser->Feed(kml.data() + offset, size)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+TEST_F(IncrementalParserTest, TestDefault) {
+  IncrementalParser parser;
+  ASSERT_FALSE(parser.is_paused());
+  ASSERT_FALSE(parser.is_finished());
+  ASSERT_FALSE(parser.has_failed());
+  ASSERT_FALSE(parser.get_root());
+  ASSERT_TRUE(parser.get_errors().empty());
+  ASSERT_FALSE(parser.get_options().defer_coordinates);
+}
+
+TEST_F(IncrementalParserTest, TestChunks) {
+  const size_t kChunkSizes[] = { 1, 7, 4096 };
+  for (size_t i = 0; i < sizeof(kChunkSizes) / sizeof(kChunkSizes[0]); ++i) {
+    IncrementalParser parser;
+    ASSERT_TRUE(FeedInChunks(kDocument, kChunkSizes[i], &parser));
+    ASSERT_FALSE(parser.is_finished());
+    ASSERT_TRUE(parser.Finish());
+    ASSERT_TRUE(parser.is_finished());
+    ASSERT_TRUE(parser.get_errors().empty());
+    ASSERT_EQ(SerializePretty(Parse(kDocument, NULL)),
+              SerializePretty(parser.get_root()));
+    // Nothing more is accepted once finished.
+    ASSERT_FALSE(parser.Feed("<kml/>"));
+    ASSERT_TRUE(parser.Finish());
+  }
+}
+
+// Verify that the observers see each Placemark as soon as its end tag is fed.
+TEST_F(IncrementalParserTest, TestObserversBeforeFinish) {
+  IncrementalParser parser;
+  PlacemarkObserver observer(&parser, false, "");
+  parser.AddObserver(&observer);
+  const string kml(kDocument);
+  const size_t end_of_a = kml.find("</Placemark>") + strlen("</Placemark>");
+  ASSERT_TRUE(parser.Feed(kml.data(), end_of_a));
+  ASSERT_EQ(static_cast<size_t>(1), observer.get_ids().size());
+  ASSERT_EQ(string("a"), observer.get_ids()[0]);
+  ASSERT_TRUE(parser.Feed(kml.substr(end_of_a)));
+  ASSERT_EQ(static_cast<size_t>(3), observer.get_ids().size());
+  ASSERT_FALSE(parser.get_root());
+  ASSERT_TRUE(parser.Finish());
+  ASSERT_TRUE(parser.get_root());
+}
+
+// Verify that an observer can pause the parse at each Placemark.
+TEST_F(IncrementalParserTest, TestPause) {
+  IncrementalParser parser;
+  PlacemarkObserver observer(&parser, true, "");
+  parser.AddObserver(&observer);
+  // The whole document in one Feed() stops at the first Placemark.
+  ASSERT_TRUE(parser.Feed(kDocument));
+  ASSERT_TRUE(parser.is_paused());
+  ASSERT_EQ(static_cast<size_t>(1), observer.get_ids().size());
+  // Bytes fed and a Finish() while paused are held until resumed.
+  ASSERT_TRUE(parser.Feed("<!-- more -->"));
+  ASSERT_TRUE(parser.Finish());
+  ASSERT_FALSE(parser.is_finished());
+  ASSERT_TRUE(parser.Resume());
+  ASSERT_TRUE(parser.is_paused());
+  ASSERT_EQ(static_cast<size_t>(2), observer.get_ids().size());
+  ASSERT_TRUE(parser.Resume());
+  ASSERT_TRUE(parser.is_paused());
+  ASSERT_EQ(static_cast<size_t>(3), observer.get_ids().size());
+  ASSERT_FALSE(parser.is_finished());
+  ASSERT_TRUE(parser.Resume());
+  ASSERT_FALSE(parser.is_paused());
+  ASSERT_TRUE(parser.is_finished());
+  ASSERT_EQ(SerializePretty(Parse(kDocument, NULL)),
+            SerializePretty(parser.get_root()));
+  // Resume() when not paused does nothing.
+  ASSERT_TRUE(parser.Resume());
+}
+
+// Verify that Pause() outside of a parse holds the bytes fed.
+TEST_F(IncrementalParserTest, TestPauseBetweenFeeds) {
+  IncrementalParser parser;
+  PlacemarkObserver observer(&parser, false, "");
+  parser.AddObserver(&observer);
+  parser.Pause();
+  ASSERT_TRUE(parser.Feed(kDocument));
+  ASSERT_TRUE(observer.get_ids().empty());
+  ASSERT_TRUE(parser.Resume());
+  ASSERT_EQ(static_cast<size_t>(3), observer.get_ids().size());
+  ASSERT_TRUE(parser.Finish());
+  ASSERT_TRUE(parser.get_root());
+}
+
+TEST_F(IncrementalParserTest, TestErrors) {
+  // Malformed XML.
+  IncrementalParser malformed;
+  ASSERT_TRUE(malformed.Feed("<kml><Placemark>"));
+  ASSERT_FALSE(malformed.Feed("</kml>"));
+  ASSERT_TRUE(malformed.has_failed());
+  ASSERT_FALSE(malformed.get_errors().empty());
+  ASSERT_FALSE(malformed.Feed("<kml/>"));
+  ASSERT_FALSE(malformed.Finish());
+  ASSERT_FALSE(malformed.get_root());
+
+  // An incomplete document fails only at Finish().
+  IncrementalParser incomplete;
+  ASSERT_TRUE(incomplete.Feed("<kml><Placemark>"));
+  ASSERT_FALSE(incomplete.Finish());
+  ASSERT_FALSE(incomplete.get_errors().empty());
+  ASSERT_FALSE(incomplete.get_root());
+
+  // Nothing at all.
+  IncrementalParser empty;
+  ASSERT_FALSE(empty.Finish());
+  ASSERT_FALSE(empty.get_errors().empty());
+
+  // The root is not KML.
+  IncrementalParser not_kml;
+  ASSERT_FALSE(not_kml.Feed("<html>"));
+  ASSERT_EQ(string("Invalid root element"), not_kml.get_errors());
+
+  // An observer terminates the parse.
+  IncrementalParser stopped;
+  PlacemarkObserver observer(&stopped, false, "b");
+  stopped.AddObserver(&observer);
+  ASSERT_FALSE(stopped.Feed(kDocument));
+  ASSERT_EQ(static_cast<size_t>(2), observer.get_ids().size());
+  ASSERT_EQ(string("Invalid root element"), stopped.get_errors());
+  ASSERT_FALSE(stopped.Finish());
+}
+
+TEST_F(IncrementalParserTest, TestTestData) {
+  const char* kFiles[] = {
+    "/kml/kmlsamples.kml",
+    "/kml/gnis-ak-first-101.kml",
+    "/kml/old_schema_example.kml",
+    "/kml/schemadata.kml"
+  };
+  for (size_t i = 0; i < sizeof(kFiles) / sizeof(kFiles[0]); ++i) {
+    string kml;
+    ASSERT_TRUE(kmlbase::File::ReadFileToString(string(DATADIR) + kFiles[i],
+                                                &kml));
+    const ElementPtr root = Parse(kml, NULL);
+    ASSERT_TRUE(root);
+    IncrementalParser parser;
+    PlacemarkObserver observer(&parser, true, "");
+    parser.AddObserver(&observer);
+    ASSERT_TRUE(FeedInChunks(kml, 1000, &parser));
+    ASSERT_TRUE(parser.Finish());
+    while (parser.is_paused()) {
+      ASSERT_TRUE(parser.Resume());
+    }
+    ASSERT_TRUE(parser.is_finished());
+    ASSERT_EQ(SerializePretty(root), SerializePretty(parser.get_root()));
+  }
+}
+
+}  // end namespace kmldom
@@ -322,4 +322,53 @@ static XsdSimpleTypeEnum kKml22Enums[] = {
   { Type_GxPlayMode, kGxPlayModeEnums }
 };
 
+// These are the defaults in the KML 2.2 XSD of those simple elements which
+// mean the same wherever they appear.  The fields of the SubStyles are left
+// out: there a field at its default value overrides that of a shared style
+// it is merged with.  Likewise <heading>, <tilt> and <scale>, which also
+// appear in <IconStyle>.
+static XsdElementDefault kKml22Defaults[] = {
+  { Type_altitude, "0" },
+  { Type_altitudeMode, "clampToGround" },
+  { Type_drawOrder, "0" },
+  { Type_extrude, "0" },
+  { Type_flyToView, "0" },
+  { Type_maxAltitude, "0" },
+  { Type_maxFadeExtent, "0" },
+  { Type_maxLodPixels, "-1" },
+  { Type_minAltitude, "0" },
+  { Type_minFadeExtent, "0" },
+  { Type_minLodPixels, "0" },
+  { Type_open, "0" },
+  { Type_refreshInterval, "4" },
+  { Type_refreshMode, "onChange" },
+  { Type_refreshVisibility, "0" },
+  { Type_rotation, "0" },
+  { Type_shape, "rectangle" },
+  { Type_tessellate, "0" },
+  { Type_viewBoundScale, "1" },
+  { Type_viewRefreshMode, "never" },
+  { Type_viewRefreshTime, "4" },
+  { Type_visibility, "1" }
+};
+
+// These are the simple elements whose value an Element holds as a string.
+// Those of all other simple elements are held as a number, a bool, a color
+// or an enumeration.
+static int kKml22StringElements[] = {
+  Type_address, Type_begin, Type_cookie, Type_description, Type_displayName,
+  Type_end, Type_expires, Type_href, Type_httpQuery, Type_linkDescription,
+  Type_linkName, Type_message, Type_name, Type_phoneNumber, Type_sourceHref,
+  Type_styleUrl, Type_targetHref, Type_text, Type_value, Type_viewFormat,
+  Type_when,
+  Type_atomEmail, Type_atomId, Type_atomLabel, Type_atomName,
+  Type_atomScheme, Type_atomSummary, Type_atomTerm, Type_atomTitle,
+  Type_atomUpdated, Type_atomUri,
+  Type_xalAdministrativeAreaName, Type_xalCountryNameCode,
+  Type_xalLocalityName, Type_xalPostalCodeNumber,
+  Type_xalSubAdministrativeAreaName, Type_xalThoroughfareName,
+  Type_xalThoroughfareNumber,
+  Type_GxValue
+};
+
 }  // namespace kmldom
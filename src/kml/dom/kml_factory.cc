@@ -24,6 +24,7 @@
 // ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "kml/dom/kml_factory.h"
+#include "kml/dom/arena.h"
 #include "kml/dom/kml22.h"
 #include "kml/dom/kml_ptr.h"
 #include "kml/dom/kmldom.h"
@@ -42,112 +43,152 @@ KmlFactory* KmlFactory::GetFactory() {
 }
 
 ElementPtr KmlFactory::CreateElementById(KmlDomType id) const {
-  switch (id) {
-  case Type_Alias: return CreateAlias();
-  case Type_AtomAuthor: return CreateAtomAuthor();
-  case Type_AtomCategory: return CreateAtomCategory();
-  case Type_AtomContent: return CreateAtomContent();
-  case Type_AtomEntry: return CreateAtomEntry();
-  case Type_AtomFeed: return CreateAtomFeed();
-  case Type_AtomLink: return CreateAtomLink();
-  case Type_BalloonStyle: return CreateBalloonStyle();
-  case Type_Camera: return CreateCamera();
-  case Type_Change: return CreateChange();
-  case Type_Create: return CreateCreate();
-  case Type_Data: return CreateData();
-  case Type_Delete: return CreateDelete();
-  case Type_Document: return CreateDocument();
-  case Type_ExtendedData: return CreateExtendedData();
-  case Type_Folder: return CreateFolder();
-  case Type_GroundOverlay: return CreateGroundOverlay();
-  case Type_Icon: return CreateIcon();
-  case Type_IconStyle: return CreateIconStyle();
-  case Type_IconStyleIcon: return CreateIconStyleIcon();
-  case Type_ImagePyramid: return CreateImagePyramid();
-  case Type_ItemIcon: return CreateItemIcon();
-  case Type_LabelStyle: return CreateLabelStyle();
-  case Type_LatLonBox: return CreateLatLonBox();
-  case Type_LatLonAltBox: return CreateLatLonAltBox();
-  case Type_LinearRing: return CreateLinearRing();
-  case Type_LineString: return CreateLineString();
-  case Type_LineStyle: return CreateLineStyle();
-  case Type_Link: return CreateLink();
-  case Type_ListStyle: return CreateListStyle();
-  case Type_Location: return CreateLocation();
-  case Type_Lod: return CreateLod();
-  case Type_LookAt: return CreateLookAt();
-  case Type_Metadata: return CreateMetadata();
-  case Type_Model: return CreateModel();
-  case Type_MultiGeometry: return CreateMultiGeometry();
-  case Type_NetworkLink: return CreateNetworkLink();
-  case Type_NetworkLinkControl: return CreateNetworkLinkControl();
-  case Type_Orientation: return CreateOrientation();
-  case Type_Pair: return CreatePair();
-  case Type_PhotoOverlay: return CreatePhotoOverlay();
-  case Type_Placemark: return CreatePlacemark();
-  case Type_PolyStyle: return CreatePolyStyle();
-  case Type_Point: return CreatePoint();
-  case Type_Polygon: return CreatePolygon();
-  case Type_Region: return CreateRegion();
-  case Type_ResourceMap: return CreateResourceMap();
-  case Type_Scale: return CreateScale();
-  case Type_Schema: return CreateSchema();
-  case Type_SchemaData: return CreateSchemaData();
-  case Type_ScreenOverlay: return CreateScreenOverlay();
-  case Type_SimpleData: return CreateSimpleData();
-  case Type_SimpleField: return CreateSimpleField();
-  case Type_Snippet: return CreateSnippet();
-  case Type_Style: return CreateStyle();
-  case Type_StyleMap: return CreateStyleMap();
-  case Type_TimeSpan: return CreateTimeSpan();
-  case Type_TimeStamp: return CreateTimeStamp();
-  case Type_ViewVolume: return CreateViewVolume();
-  case Type_Update: return CreateUpdate();
-  case Type_Url: return CreateUrl();
-  case Type_coordinates: return CreateCoordinates();
-  case Type_hotSpot: return CreateHotSpot();
-  case Type_innerBoundaryIs: return CreateInnerBoundaryIs();
-  case Type_kml: return CreateKml();
-  case Type_linkSnippet: return CreateLinkSnippet();
-  case Type_overlayXY: return CreateOverlayXY();
-  case Type_outerBoundaryIs: return CreateOuterBoundaryIs();
-  case Type_rotationXY: return CreateRotationXY();
-  case Type_screenXY: return CreateScreenXY();
-  case Type_size: return CreateSize();
-  case Type_XalAddressDetails: return CreateXalAddressDetails();
-  case Type_XalAdministrativeArea: return CreateXalAdministrativeArea();
-  case Type_XalCountry: return CreateXalCountry();
-  case Type_XalLocality: return CreateXalLocality();
-  case Type_XalPostalCode: return CreateXalPostalCode();
-  case Type_XalSubAdministrativeArea: return CreateXalSubAdministrativeArea();
-  case Type_XalThoroughfare: return CreateXalThoroughfare();
-
-  case Type_GxAnimatedUpdate: return CreateGxAnimatedUpdate();
-  case Type_GxFlyTo: return CreateGxFlyTo();
-  case Type_GxLatLonQuad: return CreateGxLatLonQuad();
-  case Type_GxMultiTrack: return CreateGxMultiTrack();
-  case Type_GxPlaylist: return CreateGxPlaylist();
-  case Type_GxSimpleArrayData: return CreateGxSimpleArrayData();
-  case Type_GxSimpleArrayField: return CreateGxSimpleArrayField();
-  case Type_GxSoundCue: return CreateGxSoundCue();
-  case Type_GxTimeSpan: return CreateGxTimeSpan();
-  case Type_GxTimeStamp: return CreateGxTimeStamp();
-  case Type_GxTour: return CreateGxTour();
-  case Type_GxTourControl: return CreateGxTourControl();
-  case Type_GxTrack: return CreateGxTrack();
-  case Type_GxWait: return CreateGxWait();
+  return CreateElementById(id, NULL);
+}
 
+// Private.
+template <class T>
+T* KmlFactory::New(Arena* arena) {
+  if (!arena) {
+    return new T();
+  }
+  T* element = new (arena) T();
+  element->in_arena_ = true;
+  return element;
+}
+
+// Private.  This is the one list of the complex elements the factory
+// creates, each given to ELEMENT as its type id and its class.
+#define KMLDOM_COMPLEX_ELEMENTS(ELEMENT) \
+  ELEMENT(Type_Alias, Alias)                                       \
+  ELEMENT(Type_AtomAuthor, AtomAuthor)                             \
+  ELEMENT(Type_AtomCategory, AtomCategory)                         \
+  ELEMENT(Type_AtomContent, AtomContent)                           \
+  ELEMENT(Type_AtomEntry, AtomEntry)                               \
+  ELEMENT(Type_AtomFeed, AtomFeed)                                 \
+  ELEMENT(Type_AtomLink, AtomLink)                                 \
+  ELEMENT(Type_BalloonStyle, BalloonStyle)                         \
+  ELEMENT(Type_Camera, Camera)                                     \
+  ELEMENT(Type_Change, Change)                                     \
+  ELEMENT(Type_Create, Create)                                     \
+  ELEMENT(Type_Data, Data)                                         \
+  ELEMENT(Type_Delete, Delete)                                     \
+  ELEMENT(Type_Document, Document)                                 \
+  ELEMENT(Type_ExtendedData, ExtendedData)                         \
+  ELEMENT(Type_Folder, Folder)                                     \
+  ELEMENT(Type_GroundOverlay, GroundOverlay)                       \
+  ELEMENT(Type_Icon, Icon)                                         \
+  ELEMENT(Type_IconStyle, IconStyle)                               \
+  ELEMENT(Type_IconStyleIcon, IconStyleIcon)                       \
+  ELEMENT(Type_ImagePyramid, ImagePyramid)                         \
+  ELEMENT(Type_ItemIcon, ItemIcon)                                 \
+  ELEMENT(Type_LabelStyle, LabelStyle)                             \
+  ELEMENT(Type_LatLonBox, LatLonBox)                               \
+  ELEMENT(Type_LatLonAltBox, LatLonAltBox)                         \
+  ELEMENT(Type_LinearRing, LinearRing)                             \
+  ELEMENT(Type_LineString, LineString)                             \
+  ELEMENT(Type_LineStyle, LineStyle)                               \
+  ELEMENT(Type_Link, Link)                                         \
+  ELEMENT(Type_ListStyle, ListStyle)                               \
+  ELEMENT(Type_Location, Location)                                 \
+  ELEMENT(Type_Lod, Lod)                                           \
+  ELEMENT(Type_LookAt, LookAt)                                     \
+  ELEMENT(Type_Metadata, Metadata)                                 \
+  ELEMENT(Type_Model, Model)                                       \
+  ELEMENT(Type_MultiGeometry, MultiGeometry)                       \
+  ELEMENT(Type_NetworkLink, NetworkLink)                           \
+  ELEMENT(Type_NetworkLinkControl, NetworkLinkControl)             \
+  ELEMENT(Type_Orientation, Orientation)                           \
+  ELEMENT(Type_Pair, Pair)                                         \
+  ELEMENT(Type_PhotoOverlay, PhotoOverlay)                         \
+  ELEMENT(Type_Placemark, Placemark)                               \
+  ELEMENT(Type_PolyStyle, PolyStyle)                               \
+  ELEMENT(Type_Point, Point)                                       \
+  ELEMENT(Type_Polygon, Polygon)                                   \
+  ELEMENT(Type_Region, Region)                                     \
+  ELEMENT(Type_ResourceMap, ResourceMap)                           \
+  ELEMENT(Type_Scale, Scale)                                       \
+  ELEMENT(Type_Schema, Schema)                                     \
+  ELEMENT(Type_SchemaData, SchemaData)                             \
+  ELEMENT(Type_ScreenOverlay, ScreenOverlay)                       \
+  ELEMENT(Type_SimpleData, SimpleData)                             \
+  ELEMENT(Type_SimpleField, SimpleField)                           \
+  ELEMENT(Type_Snippet, Snippet)                                   \
+  ELEMENT(Type_Style, Style)                                       \
+  ELEMENT(Type_StyleMap, StyleMap)                                 \
+  ELEMENT(Type_TimeSpan, TimeSpan)                                 \
+  ELEMENT(Type_TimeStamp, TimeStamp)                               \
+  ELEMENT(Type_ViewVolume, ViewVolume)                             \
+  ELEMENT(Type_Update, Update)                                     \
+  ELEMENT(Type_Url, Url)                                           \
+  ELEMENT(Type_coordinates, Coordinates)                           \
+  ELEMENT(Type_hotSpot, HotSpot)                                   \
+  ELEMENT(Type_innerBoundaryIs, InnerBoundaryIs)                   \
+  ELEMENT(Type_kml, Kml)                                           \
+  ELEMENT(Type_linkSnippet, LinkSnippet)                           \
+  ELEMENT(Type_overlayXY, OverlayXY)                               \
+  ELEMENT(Type_outerBoundaryIs, OuterBoundaryIs)                   \
+  ELEMENT(Type_rotationXY, RotationXY)                             \
+  ELEMENT(Type_screenXY, ScreenXY)                                 \
+  ELEMENT(Type_size, Size)                                         \
+  ELEMENT(Type_XalAddressDetails, XalAddressDetails)               \
+  ELEMENT(Type_XalAdministrativeArea, XalAdministrativeArea)       \
+  ELEMENT(Type_XalCountry, XalCountry)                             \
+  ELEMENT(Type_XalLocality, XalLocality)                           \
+  ELEMENT(Type_XalPostalCode, XalPostalCode)                       \
+  ELEMENT(Type_XalSubAdministrativeArea, XalSubAdministrativeArea) \
+  ELEMENT(Type_XalThoroughfare, XalThoroughfare)                   \
+  ELEMENT(Type_GxAnimatedUpdate, GxAnimatedUpdate)                 \
+  ELEMENT(Type_GxFlyTo, GxFlyTo)                                   \
+  ELEMENT(Type_GxLatLonQuad, GxLatLonQuad)                         \
+  ELEMENT(Type_GxMultiTrack, GxMultiTrack)                         \
+  ELEMENT(Type_GxPlaylist, GxPlaylist)                             \
+  ELEMENT(Type_GxSimpleArrayData, GxSimpleArrayData)               \
+  ELEMENT(Type_GxSimpleArrayField, GxSimpleArrayField)             \
+  ELEMENT(Type_GxSoundCue, GxSoundCue)                             \
+  ELEMENT(Type_GxTimeSpan, GxTimeSpan)                             \
+  ELEMENT(Type_GxTimeStamp, GxTimeStamp)                           \
+  ELEMENT(Type_GxTour, GxTour)                                     \
+  ELEMENT(Type_GxTourControl, GxTourControl)                       \
+  ELEMENT(Type_GxTrack, GxTrack)                                   \
+  ELEMENT(Type_GxWait, GxWait)
+
+ElementPtr KmlFactory::CreateElementById(KmlDomType id, Arena* arena) const {
+#define KMLDOM_NEW_ELEMENT(type_id, T) case type_id: return New<T>(arena);
+  switch (id) {
+  KMLDOM_COMPLEX_ELEMENTS(KMLDOM_NEW_ELEMENT)
   default: return NULL;
   }
+#undef KMLDOM_NEW_ELEMENT
+}
+
+size_t KmlFactory::GetElementSize(KmlDomType id) const {
+#define KMLDOM_ELEMENT_SIZE(type_id, T) case type_id: return sizeof(T);
+  switch (id) {
+  KMLDOM_COMPLEX_ELEMENTS(KMLDOM_ELEMENT_SIZE)
+  default: return sizeof(Field);
+  }
+#undef KMLDOM_ELEMENT_SIZE
 }
 
+#undef KMLDOM_COMPLEX_ELEMENTS
+
 ElementPtr KmlFactory::CreateElementFromName(const string& element_name) const {
   return CreateElementById(
       static_cast<KmlDomType>(Xsd::GetSchema()->ElementId(element_name)));
 }
 
 Field* KmlFactory::CreateFieldById(KmlDomType type_id) const {
-  return new Field(type_id);
+  return CreateFieldById(type_id, NULL);
+}
+
+Field* KmlFactory::CreateFieldById(KmlDomType type_id, Arena* arena) const {
+  if (!arena) {
+    return new Field(type_id);
+  }
+  Field* field = new (arena) Field(type_id);
+  field->in_arena_ = true;
+  return field;
 }
 
 Alias* KmlFactory::CreateAlias() const {
@@ -32,6 +32,8 @@
 
 namespace kmldom {
 
+class Arena;
+
 // A singleton factory class.
 class KmlFactory {
  public:
@@ -42,6 +44,15 @@ class KmlFactory {
   ElementPtr CreateElementFromName(const string& element_name) const;
   Field* CreateFieldById(KmlDomType type_id) const;
 
+  // As above, but the element is allocated in the given Arena if it is not
+  // NULL.  See ParseOptions::arena.
+  ElementPtr CreateElementById(KmlDomType id, Arena* arena) const;
+  Field* CreateFieldById(KmlDomType type_id, Arena* arena) const;
+
+  // This returns the size of the object CreateElementById() creates for the
+  // given type, or else that of the Field CreateFieldById() creates.
+  size_t GetElementSize(KmlDomType id) const;
+
   // Factory functions to create all KML complex elements.
   Alias* CreateAlias() const;
   AtomAuthor* CreateAtomAuthor() const;
@@ -140,6 +151,9 @@ class KmlFactory {
 
  private:
   KmlFactory() {};  // Singleton class, use GetFactory().
+  // This creates an element of type T in the Arena if it is not NULL.
+  template <class T>
+  static T* New(Arena* arena);
   static KmlFactory* factory_;
   LIBKML_DISALLOW_EVIL_CONSTRUCTORS(KmlFactory);
 };
@@ -326,4 +326,13 @@ TEST(KmlFactoryTest, TestCreateElementFromName) {
   ASSERT_TRUE(kmldom::AsGxTour(kf->CreateElementFromName("gx:Tour")));
 }
 
+TEST(KmlFactoryTest, TestGetElementSize) {
+  KmlFactory* kf = KmlFactory::GetFactory();
+  ASSERT_EQ(sizeof(Placemark), kf->GetElementSize(Type_Placemark));
+  ASSERT_EQ(sizeof(Coordinates), kf->GetElementSize(Type_coordinates));
+  ASSERT_EQ(sizeof(IconStyleIcon), kf->GetElementSize(Type_IconStyleIcon));
+  ASSERT_EQ(sizeof(GxWait), kf->GetElementSize(Type_GxWait));
+  ASSERT_EQ(sizeof(Field), kf->GetElementSize(Type_name));
+}
+
 }  // end namespace kmldom
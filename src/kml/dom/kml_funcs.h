@@ -40,6 +40,13 @@ namespace kmldom {
 // readable error string is stored to errors if such is supplied.
 ElementPtr Parse(const string& xml, string* errors);
 
+// As Parse(), but a document whose top-level <Document> or <Folder> holds
+// many Features is divided between those Features and the pieces are parsed
+// concurrently on up to thread_count threads.  A thread_count of 0 uses one
+// thread per processor.  The result is the same as that of Parse().
+ElementPtr ParseParallel(const string& xml, size_t thread_count,
+                         string* errors);
+
 // As Parse(), but invokes the underlying XML parser's namespace-aware mode.
 ElementPtr ParseNS(const string& xml, string* errors);
 
@@ -58,11 +65,43 @@ ElementPtr ParseKml(const string& xml);
 // each level of XML depth.
 string SerializePretty(const ElementPtr& root);
 
+// As SerializePretty(), but the Features of the top-level Container, the
+// root <Document> or <Folder>, or else that of the root <kml>, are
+// serialized concurrently on up to thread_count threads.  A thread_count of
+// 0 uses one thread per processor.  The result is the same as that of
+// SerializePretty().  See XmlSerializer::set_thread_count().
+string SerializePrettyParallel(const ElementPtr& root, size_t thread_count);
+
 // This function is the public API for generating "raw" XML for the KML
 // hierarchy rooted at the given Element.  "raw" is no indentation white space
 // and no newlines.
 string SerializeRaw(const ElementPtr& root);
 
+// These are the options to SerializeCompact().
+struct CompactOptions {
+  CompactOptions()
+    : coordinate_precision(-1),
+      strip_defaults(false) {
+  }
+
+  // If 0 or more each coordinate of each tuple of <coordinates> is rounded
+  // to this many decimal places, up to 15.  6 places is about 0.1 m.  By
+  // default each coordinate is written in full.
+  int coordinate_precision;
+
+  // If true a field set to its default value, such as <extrude>0</extrude>
+  // or <visibility>1</visibility>, is left out.  The fields of the styles
+  // are kept as they may override those of a shared style, as are those
+  // within an <Update> where each is a change.
+  bool strip_defaults;
+};
+
+// This function is the public API for generating the smallest XML for the
+// KML hierarchy rooted at the given Element.  This is "raw" XML whose
+// <coordinates> tuples are separated by single spaces and leave out an
+// altitude which was not set, as configured by the given options.
+string SerializeCompact(const ElementPtr& root, const CompactOptions& options);
+
 // This function is the public API for emitting the XML of an element
 // hierarchy.  The comments for SerializePretty() vs SerializeRaw() describe
 // the behavior of the "pretty" flag.  If root or xml are null this method
@@ -35,6 +35,7 @@
 #include "kml/dom/kml_handler.h"
 #include "boost/scoped_ptr.hpp"
 #include "kml/base/attributes.h"
+#include "kml/base/string_util.h"
 #include "kml/dom/element.h"
 #include "kml/dom/kml_cast.h"
 #include "kml/dom/kml_factory.h"
@@ -55,13 +56,38 @@ kMaxNestingDepth = LIBKML_MAX_NESTING_DEPTH;
 
 namespace kmldom {
 
+// The states of each entry of KmlHandler::type_filter_.
+enum {
+  kFilterUndecided,
+  kFilterIn,
+  kFilterOut
+};
+
 KmlHandler::KmlHandler(parser_observer_vector_t& observers)
   : kml_factory_(*KmlFactory::GetFactory()),
     skip_depth_(0),
     in_description_(0),
     nesting_depth_(0),
     in_old_schema_placemark_(false),
+    stopped_(false),
+    filter_depth_(0),
+    observers_(observers) {
+}
+
+KmlHandler::KmlHandler(parser_observer_vector_t& observers,
+                       const ParseOptions& parse_options)
+  : kml_factory_(*KmlFactory::GetFactory()),
+    parse_options_(parse_options),
+    skip_depth_(0),
+    in_description_(0),
+    nesting_depth_(0),
+    in_old_schema_placemark_(false),
+    stopped_(false),
+    filter_depth_(0),
     observers_(observers) {
+  if (parse_options_.has_type_filter()) {
+    type_filter_.resize(Type_Invalid, kFilterUndecided);
+  }
 }
 
 KmlHandler::~KmlHandler() {
@@ -73,7 +99,12 @@ void KmlHandler::StartElement(const string& name,
                               const StringVector& attrs) {
   // Check that we're not nested beyond the max permissible depth.
   if (++nesting_depth_ > kMaxNestingDepth) {
-    XML_StopParser(get_parser(), XML_TRUE);
+    StopParser();
+    return;
+  }
+  if (filter_depth_ > 0) {
+    // We're inside an element filtered out by the ParseOptions.
+    ++filter_depth_;
     return;
   }
   // 3 possibilities:
@@ -115,8 +146,7 @@ void KmlHandler::StartElement(const string& name,
 
   // Push a string onto the stack we'll use to manage the gathering of
   // character data.
-  string element_char_data;
-  char_data_.push(element_char_data);
+  char_data_.push();
 
   ElementPtr element;
 
@@ -129,26 +159,33 @@ void KmlHandler::StartElement(const string& name,
     type_id = Type_Placemark;
   }
 
+  // Icon as a child of IconStyle is really IconStyleIcon.  This is settled
+  // first such that the type filter sees the type which is created.
+  if (type_id == Type_Icon && !stack_.empty() &&
+      stack_.top()->Type() == Type_IconStyle) {
+    type_id = Type_IconStyleIcon;
+  }
+
+  // An element whose type is known to be filtered out by the ParseOptions is
+  // skipped without creating anything.
+  if (!type_filter_.empty() && !stack_.empty() &&
+      type_filter_[type_id] == kFilterOut) {
+    char_data_.pop();
+    filter_depth_ = 1;
+    return;
+  }
+
   XsdType xsd_type = Xsd::GetSchema()->ElementType(type_id);
+  Arena* arena = parse_options_.arena.get();
   if ((xsd_type == XSD_COMPLEX_TYPE) &&
-      (element = kml_factory_.CreateElementById(type_id))) {
-
-    // Icon as a child of IconStyle is really IconStyleIcon
-    if (element->Type() == Type_Icon) {
-      // If there is a parent and it is IconStyle...
-      if (!stack_.empty() && stack_.top()->Type() == Type_IconStyle) {
-        // ... delete the Icon and create an IconStyleIcon instead.
-        element = kml_factory_.CreateElementById(Type_IconStyleIcon);
-      }
-    }
-
+      (element = kml_factory_.CreateElementById(type_id, arena))) {
     // We parse attributes only if StartElement received any.
     if (!attrs.empty()) {
       // Element::ParseAttributes takes ownership of the created Attributes.
       element->ParseAttributes(Attributes::Create(attrs));
     }
   } else if (xsd_type == XSD_SIMPLE_TYPE) {
-    element = kml_factory_.CreateFieldById(type_id);
+    element = GetField(type_id);
   } else if (xsd_type == XSD_UNKNOWN && !old_schema_name_.empty()) {
     // We might be parsing one of the children of the old schema usage.
     in_old_schema_placemark_ = ParseOldSchemaChild(name, simplefield_name_vec_,
@@ -158,12 +195,19 @@ void KmlHandler::StartElement(const string& name,
     }
   }
 
+  if (!type_filter_.empty() && !stack_.empty() &&
+      IsFilteredOut(element ? element->Type() : Type_Unknown, element)) {
+    char_data_.pop();
+    filter_depth_ = 1;
+    return;
+  }
+
   if (!element) {
     if (stack_.empty()) {
       // Root element is not known.  XML_TRUE causes XML_Parse() to return
       // XML_STATUS_SUSPENDED.  Returning XML_FALSE _can_ result in
       // XML_Parse() returning XML_STATUS_OK.
-      XML_StopParser(get_parser(), XML_TRUE);
+      StopParser();
       return;
     }
     // The transition point from known to unknown KML. We treat everything
@@ -189,7 +233,7 @@ void KmlHandler::StartElement(const string& name,
   // Call the NewElement() method of each ParserObserver.  The whole parse
   // terminates if and when any observer's NewElement() returns false.
   if (!CallNewElementObservers(observers_, element)) {
-    XML_StopParser(get_parser(), XML_TRUE);
+    StopParser();
   }
 }
 
@@ -204,8 +248,27 @@ bool KmlHandler::CallNewElementObservers(
   return true;
 }
 
+// Returns true if an element of the given type makes use of its character
+// data: each simple element and the complex elements which parse their
+// character data.
+static bool UsesCharData(KmlDomType type_id) {
+  switch (type_id) {
+    case Type_coordinates:
+    case Type_Snippet:
+    case Type_linkSnippet:
+    case Type_SimpleData:
+      return true;
+    default:
+      return Xsd::GetSchema()->ElementType(type_id) == XSD_SIMPLE_TYPE;
+  }
+}
+
 void KmlHandler::EndElement(const string& name) {
   --nesting_depth_;
+  if (filter_depth_ > 0) {
+    --filter_depth_;
+    return;
+  }
   // See the comment towards the end of StartElement about handling "raw" HTML
   // inside <description> elements. Here we are checking to see if (1) we're
   // inside a closing </description> element and (2) if we're at the end of any
@@ -251,17 +314,37 @@ void KmlHandler::EndElement(const string& name) {
   // The top of the stack is the begin of the element ending here.
   ElementPtr child = stack_.top();
 
-  string child_char_data_ = char_data_.top();
+  // The character data is handed over rather than copied.  For a reused
+  // Field this hands back the storage of the previous character data.  Most
+  // complex elements have no use for their character data which is usually
+  // just the whitespace between their children, and that is dropped.
+  string& child_char_data = char_data_.top();
+  if (parse_options_.keep_whitespace_char_data ||
+      UsesCharData(child->Type()) ||
+      kmlbase::SkipLeadingWhitespaceString(child_char_data) !=
+          child_char_data.size()) {
+    child->swap_char_data(&child_char_data);
+  }
   char_data_.pop();
 
-  child->set_char_data(child_char_data_);
-
-  if (child->Type() == Type_coordinates ||
-      child->Type() == Type_Snippet ||
-      child->Type() == Type_linkSnippet ||
-      child->Type() == Type_SimpleData) {
+  if (child->Type() == Type_coordinates &&
+      parse_options_.coordinates_storage != COORDINATES_VEC3) {
+    AsCoordinates(child)->set_storage(parse_options_.coordinates_storage);
+  }
+  if (child->Type() == Type_coordinates &&
+      parse_options_.defer_coordinates) {
+    // The Coordinates decodes its character data when first accessed.
+    AsCoordinates(child)->DeferParse();
+  } else if (child->Type() == Type_coordinates ||
+             child->Type() == Type_Snippet ||
+             child->Type() == Type_linkSnippet ||
+             child->Type() == Type_SimpleData) {
     // These are effectively complex elements, but with character data.
     child->AddElement(child);  // "Parse yourself"
+    // Having parsed it the element has no further use for its character
+    // data.  Taking it back lets the element drop its Extension.
+    child->swap_char_data(&child_char_data);
+    child_char_data.clear();
   }
 
   // Check if we're parsing old-style Schema KML. If we are, and if this
@@ -292,11 +375,21 @@ void KmlHandler::EndElement(const string& name) {
       stack_.top()->AddElement(child);
     }
     if (!CallAddChildObservers(observers_, stack_.top(), child)) {
-      XML_StopParser(get_parser(), XML_TRUE);
+      StopParser();
     }
   }
 }
 
+// static
+unsigned int KmlHandler::GetMaxNestingDepth() {
+  return kMaxNestingDepth;
+}
+
+void KmlHandler::StopParser() {
+  stopped_ = true;
+  XML_StopParser(get_parser(), XML_TRUE);
+}
+
 bool KmlHandler::CallEndElementObservers(
     const parser_observer_vector_t& observers, const ElementPtr& parent,
     const ElementPtr& child) {
@@ -328,7 +421,77 @@ bool KmlHandler::CallAddChildObservers(
 // <Placemark><Point><coordinates/></Point></Placemark>
 // <X><Point>foo<coordinates/>bar</Point></P> remains as-is.
 void KmlHandler::CharData(const string& s) {
-  char_data_.top().append(s);
+  if (filter_depth_ == 0) {
+    char_data_.top().append(s);
+  }
+}
+
+void KmlHandler::StartElementRaw(const char* name, size_t name_len,
+                                 const kmlbase::ExpatAttributeView& atts) {
+  name_buf_.assign(name, name_len);
+  // Resize rather than clear such that the strings in atts_buf_ keep their
+  // storage for the next element with attributes.
+  atts_buf_.resize(atts.size() * 2);
+  for (size_t i = 0; i < atts.size(); ++i) {
+    atts_buf_[i * 2].assign(atts.name(i));
+    atts_buf_[i * 2 + 1].assign(atts.value(i));
+  }
+  KmlHandler::StartElement(name_buf_, atts_buf_);
+}
+
+void KmlHandler::EndElementRaw(const char* name, size_t name_len) {
+  name_buf_.assign(name, name_len);
+  KmlHandler::EndElement(name_buf_);
+}
+
+void KmlHandler::CharDataRaw(const char* s, size_t len) {
+  if (filter_depth_ == 0) {
+    char_data_.top().append(s, len);
+  }
+}
+
+// Returns true if the element matches any of the given types.
+static bool MatchesAnyType(const std::set<KmlDomType>& types,
+                           KmlDomType type_id, const ElementPtr& element) {
+  std::set<KmlDomType>::const_iterator iter = types.begin();
+  for (; iter != types.end(); ++iter) {
+    if (*iter == type_id || (element && element->IsA(*iter))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Private.
+bool KmlHandler::IsFilteredOut(KmlDomType type_id, const ElementPtr& element) {
+  char& decision = type_filter_[type_id];
+  if (decision == kFilterUndecided) {
+    const bool filtered_out =
+        MatchesAnyType(parse_options_.exclude_types, type_id, element) ||
+        (!parse_options_.include_types.empty() &&
+         !MatchesAnyType(parse_options_.include_types, type_id, element));
+    decision = filtered_out ? kFilterOut : kFilterIn;
+  }
+  return decision == kFilterOut;
+}
+
+// Private.  A simple element is parsed into a Field whose character data its
+// parent converts in AddElement() and a Field is normally discarded once it
+// is added.  Rather than create a Field for each simple element the Field of
+// each type is reused unless it is still held: a parent keeps a misplaced
+// Field and a ParserObserver can keep any Element.  A Field which gathered
+// unknown or misplaced children is not reused either.
+FieldPtr KmlHandler::GetField(KmlDomType type_id) {
+  if (fields_.empty()) {
+    fields_.resize(Type_Invalid);
+  }
+  FieldPtr& field = fields_[type_id];
+  if (!field || field->get_ref_count() != 1 ||
+      field->get_unknown_elements_array_size() != 0 ||
+      field->get_misplaced_elements_array_size() != 0) {
+    field = kml_factory_.CreateFieldById(type_id, parse_options_.arena.get());
+  }
+  return field;
 }
 
 // As with STL pop() methods this is (potentially) destructive.  If the
@@ -75,20 +75,57 @@
 #define KML_DOM_KML_HANDLER_H__
 
 #include <stack>
+#include <vector>
 #include "kml/base/expat_handler.h"
 #include "kml/dom/element.h"
 #include "kml/dom/kml_ptr.h"
+#include "kml/dom/parse_options.h"
 #include "kml/dom/parser_observer.h"
 
 namespace kmldom {
 
 class KmlFactory;
 
+// This is a stack of the strings gathering the character data of each open
+// element.  A string popped keeps its storage for the next string pushed at
+// the same depth such that once grown gathering character data does not
+// allocate.
+class CharDataStack {
+ public:
+  CharDataStack()
+    : size_(0) {
+  }
+
+  // This pushes an empty string.
+  void push() {
+    if (size_ == strings_.size()) {
+      strings_.push_back(string());
+    } else {
+      strings_[size_].clear();
+    }
+    ++size_;
+  }
+
+  void pop() {
+    --size_;
+  }
+
+  string& top() {
+    return strings_[size_ - 1];
+  }
+
+ private:
+  std::vector<string> strings_;
+  size_t size_;
+};
+
 // This class implements the expat handlers for parsing KML.  This class is
 // handed to expat in the ExpatParser() function.
 class KmlHandler : public kmlbase::ExpatHandler {
 public:
   KmlHandler(parser_observer_vector_t& observers);
+  KmlHandler(parser_observer_vector_t& observers,
+             const ParseOptions& parse_options);
   ~KmlHandler();
 
   // ExpatHandler methods
@@ -97,17 +134,43 @@ public:
   virtual void EndElement(const string& name);
   virtual void CharData(const string& s);
 
+  // ExpatRawHandler methods.  ExpatParser drives these directly.  The name
+  // and attributes are gathered into scratch buffers reused across events
+  // and character data is appended in place such that a parse does not
+  // allocate a string per expat event.
+  virtual void StartElementRaw(const char* name, size_t name_len,
+                               const kmlbase::ExpatAttributeView& atts);
+  virtual void EndElementRaw(const char* name, size_t name_len);
+  virtual void CharDataRaw(const char* s, size_t len);
+
   // This destructively removes the Element on the top of the stack and
   // transfers ownership of it to the caller.  The intention is to use this
   // after a successful parse.
   ElementPtr PopRoot();
 
+  // This returns the deepest nesting of elements the handler permits.
+  static unsigned int GetMaxNestingDepth();
+
+  // This returns true if the handler has stopped the parse: the root is not
+  // KML, the nesting is too deep, or a ParserObserver terminated the parse.
+  bool is_stopped() const {
+    return stopped_;
+  }
+
 private:
   const KmlFactory& kml_factory_;
+  const ParseOptions parse_options_;
   std::stack<ElementPtr> stack_;
   // Char data is managed as a stack to allow for gathering all character data
   // inside unknown elements.
-  std::stack<string> char_data_;
+  CharDataStack char_data_;
+  // The Field of each simple element type reused from one simple element to
+  // the next.  See GetField().
+  std::vector<FieldPtr> fields_;
+  // Scratch buffers for the ExpatRawHandler methods.  These retain their
+  // capacity across events.
+  string name_buf_;
+  kmlbase::StringVector atts_buf_;
   // Helpers for handling unknown elements:
   void InsertUnknownStartElement(const string& name,
                                  const kmlbase::StringVector& atts);
@@ -122,6 +185,23 @@ private:
   string old_schema_name_;
   kmlbase::StringVector simplefield_name_vec_;
   std::vector<SimpleDataPtr> simpledata_vec_;
+  bool stopped_;
+  // The type filter of the ParseOptions decided for each KmlDomType, and the
+  // depth within an element skipped by it.  See IsFilteredOut().
+  std::vector<char> type_filter_;
+  unsigned int filter_depth_;
+
+  // This returns true if an element of the given type is filtered out by the
+  // ParseOptions.  The element is NULL for an element not in the KML schema.
+  // The decision for each type is made once.
+  bool IsFilteredOut(KmlDomType type_id, const ElementPtr& element);
+
+  // This returns a Field for a simple element of the given type.  The Field
+  // of the previous element of this type is reused if nothing else holds it.
+  FieldPtr GetField(KmlDomType type_id);
+
+  // This stops the parse at the end of the current expat callback.
+  void StopParser();
 
   // This calls the NewElement() method of each ParserObserver.  If any
   // ParserObserver::NewElement() returns false this immediately returns false.
@@ -40,6 +40,11 @@ KmlHandlerNS::KmlHandlerNS(parser_observer_vector_t& observers)
   : KmlHandler(observers) {
 }
 
+KmlHandlerNS::KmlHandlerNS(parser_observer_vector_t& observers,
+                           const ParseOptions& parse_options)
+  : KmlHandler(observers, parse_options) {
+}
+
 KmlHandlerNS::~KmlHandlerNS() {
 }
 
@@ -58,6 +63,28 @@ void KmlHandlerNS::EndElement(const string& name) {
   KmlHandler::EndElement(name.substr(token));
 }
 
+// Returns the offset of the local name following the last separator in the
+// given expat namespace-qualified name, or 0 if there is no separator.
+static size_t FindLocalName(const char* name, size_t name_len) {
+  for (size_t i = name_len; i > 0; --i) {
+    if (name[i - 1] == kXmlnsSeparator) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+void KmlHandlerNS::StartElementRaw(const char* name, size_t name_len,
+                                   const kmlbase::ExpatAttributeView& atts) {
+  size_t token = FindLocalName(name, name_len);
+  KmlHandler::StartElementRaw(name + token, name_len - token, atts);
+}
+
+void KmlHandlerNS::EndElementRaw(const char* name, size_t name_len) {
+  size_t token = FindLocalName(name, name_len);
+  KmlHandler::EndElementRaw(name + token, name_len - token);
+}
+
 void KmlHandlerNS::CharData(const string& s) {
   KmlHandler::CharData(s);
 }
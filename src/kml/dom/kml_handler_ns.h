@@ -46,6 +46,8 @@ class KmlFactory;
 class KmlHandlerNS : public KmlHandler {
  public:
   KmlHandlerNS(parser_observer_vector_t& observers);
+  KmlHandlerNS(parser_observer_vector_t& observers,
+               const ParseOptions& parse_options);
   ~KmlHandlerNS();
 
   // ExpatHandler methods.
@@ -57,6 +59,12 @@ class KmlHandlerNS : public KmlHandler {
                               const string &uri);
   virtual void EndNamespace(const string &prefix);
 
+  // ExpatRawHandler methods.  These strip the namespace from the name in
+  // place and hand the local name to KmlHandler.
+  virtual void StartElementRaw(const char* name, size_t name_len,
+                               const kmlbase::ExpatAttributeView& atts);
+  virtual void EndElementRaw(const char* name, size_t name_len);
+
  private:
   // TODO: A map of namespace URIs to their prefixes found during the parse.
   LIBKML_DISALLOW_EVIL_CONSTRUCTORS(KmlHandlerNS);
@@ -27,7 +27,10 @@
 
 #include "kml/dom/kml_handler.h"
 #include <stdlib.h>  // For calloc() and free().
+#include <map>
+#include <new>
 #include "boost/scoped_ptr.hpp"
+#include "kml/base/expat_parser.h"
 #include "kml/base/file.h"
 #include "kml/dom/element.h"
 #include "kml/dom/kml_cast.h"
@@ -47,6 +50,20 @@
 #error *** DATADIR must be defined! ***
 #endif
 
+// Every allocation made with operator new in this test is counted such that
+// a test can check how many a parse makes.  The memory is from malloc() as
+// that of the default operator new such that the default operator delete
+// frees it.
+static size_t g_allocation_count = 0;
+
+void* operator new(size_t size) throw(std::bad_alloc) {
+  ++g_allocation_count;
+  if (void* p = malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
 namespace kmldom {
 
 typedef std::vector<ElementPtr> element_vector_t;
@@ -756,4 +773,298 @@ TEST_F(KmlHandlerTest, TestOldSchemaHandling) {
   ASSERT_EQ(kOldStyleSchemaChildCharData, simpledata->get_text());
 }
 
+// This observer counts the Elements of each type.
+class TypeCounter : public ParserObserver {
+ public:
+  virtual bool NewElement(const ElementPtr& element) {
+    ++counts_[element->Type()];
+    return true;
+  }
+  int get_count(KmlDomType type_id) {
+    return counts_[type_id];
+  }
+ private:
+  std::map<KmlDomType, int> counts_;
+};
+
+static const char kTypeFilterKml[] =
+  "<kml>"
+  "<Document>"
+  "<Style id=\"s\"><IconStyle><scale>2</scale></IconStyle></Style>"
+  "<Placemark>"
+  "<name>a</name>"
+  "<description><h1>HTML</h1> and <b>more</b></description>"
+  "<ExtendedData><Data name=\"d\"><value>1</value></Data></ExtendedData>"
+  "<Point><coordinates>1,2</coordinates></Point>"
+  "<unknown><name>not KML</name></unknown>"
+  "</Placemark>"
+  "<Folder><name>f</name><Placemark><name>b</name></Placemark></Folder>"
+  "</Document>"
+  "</kml>";
+
+TEST_F(KmlHandlerTest, TestExcludeTypes) {
+  ParseOptions options;
+  options.exclude_types.insert(Type_description);
+  options.exclude_types.insert(Type_ExtendedData);
+  // The abstract type matches the Style.
+  options.exclude_types.insert(Type_StyleSelector);
+  options.exclude_types.insert(Type_Unknown);
+  TypeCounter type_counter;
+  observers_.push_back(&type_counter);
+  KmlHandler kml_handler(observers_, options);
+  ASSERT_TRUE(kmlbase::ExpatParser::ParseString(kTypeFilterKml, &kml_handler,
+                                                NULL, false));
+  const ElementPtr root = kml_handler.PopRoot();
+  ASSERT_TRUE(root);
+  const DocumentPtr document = AsDocument(AsKml(root)->get_feature());
+  ASSERT_EQ(static_cast<size_t>(0), document->get_styleselector_array_size());
+  ASSERT_EQ(static_cast<size_t>(2), document->get_feature_array_size());
+  const PlacemarkPtr placemark = AsPlacemark(document->get_feature_array_at(0));
+  ASSERT_EQ(string("a"), placemark->get_name());
+  ASSERT_FALSE(placemark->has_description());
+  ASSERT_FALSE(placemark->has_extendeddata());
+  ASSERT_TRUE(placemark->has_geometry());
+  ASSERT_EQ(static_cast<size_t>(0),
+            placemark->get_unknown_elements_array_size());
+  // Nothing of the skipped subtrees was seen by the observer.
+  ASSERT_EQ(0, type_counter.get_count(Type_Style));
+  ASSERT_EQ(0, type_counter.get_count(Type_IconStyle));
+  ASSERT_EQ(0, type_counter.get_count(Type_Data));
+  ASSERT_EQ(0, type_counter.get_count(Type_description));
+  ASSERT_EQ(3, type_counter.get_count(Type_name));
+  ASSERT_EQ(2, type_counter.get_count(Type_Placemark));
+}
+
+TEST_F(KmlHandlerTest, TestIncludeTypes) {
+  ParseOptions options;
+  options.include_types.insert(Type_Container);
+  options.include_types.insert(Type_Placemark);
+  options.include_types.insert(Type_Geometry);
+  options.include_types.insert(Type_coordinates);
+  KmlHandler kml_handler(observers_, options);
+  ASSERT_TRUE(kmlbase::ExpatParser::ParseString(kTypeFilterKml, &kml_handler,
+                                                NULL, false));
+  const ElementPtr root = kml_handler.PopRoot();
+  ASSERT_TRUE(root);
+  const DocumentPtr document = AsDocument(AsKml(root)->get_feature());
+  ASSERT_TRUE(document);
+  ASSERT_EQ(static_cast<size_t>(0), document->get_styleselector_array_size());
+  ASSERT_EQ(static_cast<size_t>(2), document->get_feature_array_size());
+  const PlacemarkPtr placemark = AsPlacemark(document->get_feature_array_at(0));
+  ASSERT_FALSE(placemark->has_name());
+  ASSERT_FALSE(placemark->has_description());
+  ASSERT_FALSE(placemark->has_extendeddata());
+  ASSERT_EQ(static_cast<size_t>(0),
+            placemark->get_unknown_elements_array_size());
+  const PointPtr point = AsPoint(placemark->get_geometry());
+  ASSERT_TRUE(point);
+  ASSERT_EQ(static_cast<size_t>(1),
+            point->get_coordinates()->get_coordinates_array_size());
+  const FolderPtr folder = AsFolder(document->get_feature_array_at(1));
+  ASSERT_TRUE(folder);
+  ASSERT_FALSE(folder->has_name());
+  ASSERT_EQ(static_cast<size_t>(1), folder->get_feature_array_size());
+
+  // An exclusion wins over an inclusion.
+  options.exclude_types.insert(Type_Folder);
+  KmlHandler exclude_folder(observers_, options);
+  ASSERT_TRUE(kmlbase::ExpatParser::ParseString(kTypeFilterKml,
+                                                &exclude_folder, NULL, false));
+  ASSERT_EQ(static_cast<size_t>(1),
+            AsDocument(AsKml(exclude_folder.PopRoot())->get_feature())
+                ->get_feature_array_size());
+}
+
+// Verify that the <Icon> of an <IconStyle> is filtered as the
+// IconStyleIcon it is.
+TEST_F(KmlHandlerTest, TestTypeFilterIconStyleIcon) {
+  const string kKml(
+    "<Document>"
+    "<Style><IconStyle><Icon><href>a.png</href></Icon></IconStyle></Style>"
+    "<GroundOverlay><Icon><href>b.png</href></Icon></GroundOverlay>"
+    "</Document>");
+  ParseOptions options;
+  options.exclude_types.insert(Type_Icon);
+  KmlHandler kml_handler(observers_, options);
+  ASSERT_TRUE(kmlbase::ExpatParser::ParseString(kKml, &kml_handler, NULL,
+                                                false));
+  const DocumentPtr document = AsDocument(kml_handler.PopRoot());
+  ASSERT_TRUE(document);
+  const StylePtr style = AsStyle(document->get_styleselector_array_at(0));
+  ASSERT_TRUE(style->get_iconstyle()->has_icon());
+  ASSERT_EQ(string("a.png"), style->get_iconstyle()->get_icon()->get_href());
+  const GroundOverlayPtr groundoverlay =
+      AsGroundOverlay(document->get_feature_array_at(0));
+  ASSERT_FALSE(groundoverlay->has_icon());
+}
+
+// Verify that the root element is never filtered out.
+TEST_F(KmlHandlerTest, TestTypeFilterRoot) {
+  ParseOptions options;
+  options.exclude_types.insert(Type_kml);
+  options.exclude_types.insert(Type_Feature);
+  KmlHandler kml_handler(observers_, options);
+  ASSERT_TRUE(kmlbase::ExpatParser::ParseString(kTypeFilterKml, &kml_handler,
+                                                NULL, false));
+  const KmlPtr kml = AsKml(kml_handler.PopRoot());
+  ASSERT_TRUE(kml);
+  ASSERT_FALSE(kml->has_feature());
+}
+
+// Verify a type filter on a large set of test data.
+TEST_F(KmlHandlerTest, TestTypeFilterTestData) {
+  string kml;
+  ASSERT_TRUE(kmlbase::File::ReadFileToString(
+      kmlbase::File::JoinPaths(DATADIR, kmlbase::File::JoinPaths(
+          "kml", "kmlsamples.kml")), &kml));
+  TypeCounter full_count;
+  Parser full_parser;
+  full_parser.AddObserver(&full_count);
+  ASSERT_TRUE(full_parser.Parse(kml, NULL));
+
+  ParseOptions options;
+  options.exclude_types.insert(Type_description);
+  options.exclude_types.insert(Type_StyleSelector);
+  options.exclude_types.insert(Type_AbstractView);
+  Parser parser;
+  parser.set_options(options);
+  const ElementPtr root = parser.Parse(kml, NULL);
+  ASSERT_TRUE(root);
+  // Parse the result again to count what is left.
+  TypeCounter count;
+  Parser reparser;
+  reparser.AddObserver(&count);
+  ASSERT_TRUE(reparser.Parse(SerializePretty(root), NULL));
+  ASSERT_LT(0, full_count.get_count(Type_description));
+  ASSERT_EQ(0, count.get_count(Type_description));
+  ASSERT_LT(0, full_count.get_count(Type_Style));
+  ASSERT_EQ(0, count.get_count(Type_Style));
+  ASSERT_EQ(0, count.get_count(Type_LookAt));
+  ASSERT_LT(0, count.get_count(Type_Placemark));
+  ASSERT_EQ(full_count.get_count(Type_Placemark),
+            count.get_count(Type_Placemark));
+  ASSERT_EQ(full_count.get_count(Type_coordinates),
+            count.get_count(Type_coordinates));
+}
+
+// This observer counts the Elements.  Unlike TypeCounter it does not
+// allocate.
+class ElementCounter : public ParserObserver {
+ public:
+  ElementCounter()
+    : count_(0) {
+  }
+  virtual bool NewElement(const ElementPtr& element) {
+    ++count_;
+    return true;
+  }
+  size_t get_count() const {
+    return count_;
+  }
+ private:
+  size_t count_;
+};
+
+// Returns the number of allocations made by a KmlHandler parse of the kml.
+static size_t CountParseAllocations(const string& kml) {
+  parser_observer_vector_t observers;
+  KmlHandler kml_handler(observers);
+  const size_t before = g_allocation_count;
+  if (!kmlbase::ExpatParser::ParseString(kml, &kml_handler, NULL, false)) {
+    return 0;
+  }
+  return g_allocation_count - before;
+}
+
+TEST_F(KmlHandlerTest, TestParseAllocations) {
+  string kml;
+  ASSERT_TRUE(kmlbase::File::ReadFileToString(
+      kmlbase::File::JoinPaths(DATADIR, kmlbase::File::JoinPaths(
+          "kml", "kmlsamples.kml")), &kml));
+  ElementCounter element_counter;
+  Parser parser;
+  parser.AddObserver(&element_counter);
+  ASSERT_TRUE(parser.Parse(kml, NULL));
+  ASSERT_EQ(static_cast<size_t>(489), element_counter.get_count());
+  // Each complex element is allocated along with its attributes and the
+  // arrays of its children, but a simple element allocates at most for the
+  // value its parent keeps.  When each simple element had a Field of its own
+  // this parse made 2395 allocations.
+  const size_t allocations = CountParseAllocations(kml);
+  ASSERT_LT(static_cast<size_t>(0), allocations);
+  ASSERT_GT(3 * element_counter.get_count(), allocations);
+}
+
+// Verify that the number of simple elements does not add to the allocations.
+TEST_F(KmlHandlerTest, TestSimpleElementAllocations) {
+  const string kFields(
+      "<name>a name longer than any short string</name>"
+      "<visibility>1</visibility>"
+      "<styleUrl>#a-style-url-longer-than-a-short-string</styleUrl>");
+  string few("<Placemark>");
+  for (size_t i = 0; i < 10; ++i) {
+    few.append(kFields);
+  }
+  few.append("</Placemark>");
+  string many("<Placemark>");
+  for (size_t i = 0; i < 1000; ++i) {
+    many.append(kFields);
+  }
+  many.append("</Placemark>");
+  const size_t few_allocations = CountParseAllocations(few);
+  ASSERT_LT(static_cast<size_t>(0), few_allocations);
+  ASSERT_EQ(few_allocations, CountParseAllocations(many));
+}
+
+static const char kIndentedKml[] =
+  "<kml>\n"
+  "  <Placemark>\n"
+  "    <name>a</name>\n"
+  "    <Snippet>  a snippet  </Snippet>\n"
+  "    <Point>\n"
+  "      <coordinates>\n"
+  "        1,2,3\n"
+  "      </coordinates>\n"
+  "    </Point>\n"
+  "    mixed content\n"
+  "  </Placemark>\n"
+  "</kml>";
+
+// Verify that by default a complex element keeps no whitespace character data.
+TEST_F(KmlHandlerTest, TestWhitespaceCharDataIsDropped) {
+  KmlHandler kml_handler(observers_);
+  ASSERT_TRUE(kmlbase::ExpatParser::ParseString(kIndentedKml, &kml_handler,
+                                                NULL, false));
+  const KmlPtr kml = AsKml(kml_handler.PopRoot());
+  ASSERT_TRUE(kml);
+  ASSERT_TRUE(kml->get_char_data().empty());
+  const PlacemarkPtr placemark = AsPlacemark(kml->get_feature());
+  ASSERT_TRUE(placemark);
+  // Character data other than whitespace is kept.
+  ASSERT_NE(string::npos, placemark->get_char_data().find("mixed content"));
+  ASSERT_EQ(string("a"), placemark->get_name());
+  ASSERT_EQ(string("  a snippet  "), placemark->get_snippet()->get_text());
+  const PointPtr point = AsPoint(placemark->get_geometry());
+  ASSERT_TRUE(point);
+  ASSERT_TRUE(point->get_char_data().empty());
+  const CoordinatesPtr coordinates = point->get_coordinates();
+  ASSERT_EQ(static_cast<size_t>(1), coordinates->get_coordinates_array_size());
+  ASSERT_EQ(3.0, coordinates->get_coordinates_array_at(0).get_altitude());
+}
+
+TEST_F(KmlHandlerTest, TestKeepWhitespaceCharData) {
+  ParseOptions options;
+  options.keep_whitespace_char_data = true;
+  KmlHandler kml_handler(observers_, options);
+  ASSERT_TRUE(kmlbase::ExpatParser::ParseString(kIndentedKml, &kml_handler,
+                                                NULL, false));
+  const KmlPtr kml = AsKml(kml_handler.PopRoot());
+  ASSERT_TRUE(kml);
+  ASSERT_EQ(string("\n  \n"), kml->get_char_data());
+  const PointPtr point =
+      AsPoint(AsPlacemark(kml->get_feature())->get_geometry());
+  ASSERT_TRUE(point);
+  ASSERT_EQ(string("\n      \n    "), point->get_char_data());
+}
+
 }  // end namespace kmldom
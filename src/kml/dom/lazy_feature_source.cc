@@ -0,0 +1,69 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of the LazyFeatureSource class.
+
+#include "kml/dom/lazy_feature_source.h"
+#include "kml/dom/container.h"
+#include "kml/dom/parser.h"
+
+namespace kmldom {
+
+LazyFeatureSource::LazyFeatureSource(const string& kml, const string& prefix,
+                                     const string& suffix,
+                                     size_t prefix_depth,
+                                     const parser_observer_vector_t& observers,
+                                     const ParseOptions& options)
+  : kml_(kml),
+    prefix_(prefix),
+    suffix_(suffix),
+    prefix_depth_(prefix_depth),
+    observers_(observers),
+    options_(options) {
+}
+
+bool LazyFeatureSource::FindFeatureById(const string& id,
+                                        size_t* begin) const {
+  std::map<string, size_t>::const_iterator find = id_index_.find(id);
+  if (find == id_index_.end()) {
+    return false;
+  }
+  if (begin) {
+    *begin = find->second;
+  }
+  return true;
+}
+
+FeaturePtr LazyFeatureSource::ParseFeature(
+    size_t begin, size_t end, const ContainerPtr& container) const {
+  Parser parser;
+  parser.set_options(options_);
+  for (size_t i = 0; i < observers_.size(); ++i) {
+    parser.AddObserver(observers_[i]);
+  }
+  return parser.ParseLazyFeature(*this, begin, end, container);
+}
+
+}  // end namespace kmldom
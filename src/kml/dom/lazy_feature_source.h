@@ -0,0 +1,105 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of the LazyFeatureSource class which
+// holds the KML of the Features a Container parses on first access.  See
+// Parser::ParseLazy.
+
+#ifndef KML_DOM_LAZY_FEATURE_SOURCE_H__
+#define KML_DOM_LAZY_FEATURE_SOURCE_H__
+
+#include <map>
+#include "boost/intrusive_ptr.hpp"
+#include "kml/base/referent.h"
+#include "kml/base/util.h"
+#include "kml/dom/kml_ptr.h"
+#include "kml/dom/parse_options.h"
+#include "kml/dom/parser_observer.h"
+
+namespace kmldom {
+
+// A LazyFeatureSource is shared by the Features of the top-level Container
+// of a document parsed with Parser::ParseLazy.  It retains the text of the
+// whole document and an index of the ids found in the unparsed Features.
+class LazyFeatureSource : public kmlbase::Referent {
+ public:
+  // This looks up the id in the index of the ids in the unparsed Features.
+  // If found the offset of the Feature's KML in the document is saved to
+  // begin and true is returned.  Where an id appears in more than one
+  // Feature the last one wins.
+  bool FindFeatureById(const string& id, size_t* begin) const;
+
+  // The ParserObservers given to Parser::ParseLazy are called for the
+  // Elements of each Feature as it is parsed.  This stops that, for use when
+  // the observers cease to exist before the Elements do.
+  void ClearObservers() {
+    observers_.clear();
+  }
+
+  // This returns the errors of the parses of the Features so far, one per
+  // line, or an empty string if there were none.  A Feature fails to parse
+  // if an observer terminates its parse, which leaves the rest of the
+  // Feature unparsed.
+  const string& get_errors() const {
+    return errors_;
+  }
+
+ private:
+  friend class Container;
+  friend class Parser;
+  LazyFeatureSource(const string& kml, const string& prefix,
+                    const string& suffix, size_t prefix_depth,
+                    const parser_observer_vector_t& observers,
+                    const ParseOptions& options);
+
+  // This parses the Feature whose KML is at [begin, end) of the document for
+  // the given Container and calls the observers for its Elements.  NULL is
+  // returned if the KML proves to be malformed.  The Feature is parsed with
+  // the ParseOptions given to Parser::ParseLazy.
+  FeaturePtr ParseFeature(size_t begin, size_t end,
+                          const ContainerPtr& container) const;
+
+  // This appends a line to the errors.
+  void AddError(const string& error) const {
+    errors_.append(error);
+    errors_.push_back('\n');
+  }
+
+  const string kml_;
+  const string prefix_;
+  const string suffix_;
+  const size_t prefix_depth_;
+  parser_observer_vector_t observers_;
+  const ParseOptions options_;
+  std::map<string, size_t> id_index_;
+  mutable string errors_;
+  LIBKML_DISALLOW_EVIL_CONSTRUCTORS(LazyFeatureSource);
+};
+
+typedef boost::intrusive_ptr<LazyFeatureSource> LazyFeatureSourcePtr;
+
+}  // end namespace kmldom
+
+#endif  // KML_DOM_LAZY_FEATURE_SOURCE_H__
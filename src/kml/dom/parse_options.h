@@ -0,0 +1,101 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of the ParseOptions struct which
+// selects how the Parser builds the DOM.
+
+#ifndef KML_DOM_PARSE_OPTIONS_H__
+#define KML_DOM_PARSE_OPTIONS_H__
+
+#include <set>
+#include "kml/dom/arena.h"
+#include "kml/dom/coordinate_columns.h"
+#include "kml/dom/kml22.h"
+
+namespace kmldom {
+
+// The default ParseOptions build the DOM just as a Parser always has.  See
+// Parser::set_options().
+struct ParseOptions {
+  ParseOptions()
+    : defer_coordinates(false),
+      coordinates_storage(COORDINATES_VEC3),
+      keep_whitespace_char_data(false) {
+  }
+
+  // If true the tuples of each <coordinates> are decoded from its character
+  // data only when they are first accessed, and a <coordinates> whose tuples
+  // are not changed is serialized as its character data as parsed.  See
+  // Coordinates.
+  bool defer_coordinates;
+
+  // This selects how each Coordinates stores its tuples.  The default is a
+  // std::vector of kmlbase::Vec3.  The other choices store the tuples as
+  // CoordinateColumns, optionally quantized to float or fixed point.  See
+  // coordinate_columns.h.
+  CoordinatesStorage coordinates_storage;
+
+  // By default a complex Element whose character data is only whitespace,
+  // such as the indentation between the children of a <Placemark>, does not
+  // keep it.  Only the simple elements and the complex elements parsed from
+  // their character data (<coordinates>, <Snippet>, <linkSnippet> and
+  // <SimpleData>) keep all their character data.  If true every Element
+  // keeps its character data as get_char_data().
+  bool keep_whitespace_char_data;
+
+  // These filter the Elements built by element type.  An Element is
+  // filtered out if it is of a type in exclude_types or if include_types is
+  // not empty and it is of no type in include_types.  A type matches as in
+  // Element::IsA() such that Type_Feature matches every Feature, and
+  // Type_Unknown matches each element not in the KML schema which is
+  // otherwise kept as a string in its parent.  An Element filtered out is
+  // skipped along with everything within it: no Element is created, no
+  // character data is kept and no ParserObserver sees any of it.  The root
+  // element is never filtered out.  Note that with include_types each
+  // Element is built only if its parent is, hence to keep the names and
+  // geometry of Placemarks in Folders include Type_Container,
+  // Type_Placemark, Type_name, Type_Geometry, Type_coordinates and so on.
+  std::set<KmlDomType> include_types;
+  std::set<KmlDomType> exclude_types;
+
+  // If set the Elements built are allocated in this Arena rather than each
+  // with new.  Each Element holds a reference to the Arena such that the
+  // Arena is freed in one go once the last of its Elements is destroyed.
+  // The memory of an Element discarded during the parse is not reused.
+  // Strings and arrays within the Elements are not in the Arena, but an
+  // Arena may intern the values most often repeated: see
+  // Arena::set_intern_strings().  A KmlFile keeps its ParseOptions and thus
+  // the Arena.  Parser::ParseParallel gives each of its threads an Arena of
+  // its own which interns strings if this one does.
+  ArenaPtr arena;
+
+  bool has_type_filter() const {
+    return !include_types.empty() || !exclude_types.empty();
+  }
+};
+
+}  // end namespace kmldom
+
+#endif  // KML_DOM_PARSE_OPTIONS_H__
@@ -33,12 +33,19 @@
 #include "kml/base/attributes.h"
 #include "kml/base/expat_parser.h"
 #include "kml/base/expat_handler_ns.h"
+#include "kml/base/thread.h"
 #include "kml/base/xmlns.h"
+#include "kml/dom/container.h"
 #include "kml/dom/element.h"
+#include "kml/dom/feature_splitter.h"
+#include "kml/dom/kml_cast.h"
+#include "kml/dom/kml_factory.h"
 #include "kml/dom/kml_handler.h"
 #include "kml/dom/kml_handler_ns.h"
+#include "kml/dom/lazy_feature_source.h"
 #include "kml/dom/parser.h"
 #include "kml/dom/parser_observer.h"
+#include "kml/dom/xsd.h"
 
 namespace kmldom {
 
@@ -51,7 +58,7 @@ void Parser::AddObserver(ParserObserver* parser_observer) {
 // This is the internal API to the parser.  TODO: determine how/if to make
 // public and SWIG.
 ElementPtr Parser::Parse(const string& kml, string* errors) {
-  KmlHandler kml_handler(observers_);
+  KmlHandler kml_handler(observers_, options_);
   kmlbase::ExpatParser parser(&kml_handler, false);
   if (kmlbase::ExpatParser::ParseString(kml, &kml_handler, errors, false)) {
     return kml_handler.PopRoot();
@@ -59,11 +66,411 @@ ElementPtr Parser::Parse(const string& kml, string* errors) {
   return NULL;
 }
 
+ElementPtr Parser::ParseMappedFile(kmlbase::MappedFile* mapped_file,
+                                   string* errors) {
+  KmlHandler kml_handler(observers_, options_);
+  if (kmlbase::ExpatParser::ParseMappedFile(mapped_file, &kml_handler, errors,
+                                            false)) {
+    return kml_handler.PopRoot();
+  }
+  return NULL;
+}
+
+// A chunk is parsed by ParseParallel no smaller than this.
+static const size_t kMinParallelChunkSize = 64 * 1024;
+
+// The ParserObserver events issued by a KmlHandler.  ParseParallel records
+// these when it has observers and replays them once all chunks are parsed.
+struct ParseEvent {
+  enum Kind {
+    NEW_ELEMENT,  // NewElement(child)
+    END_ELEMENT,  // EndElement(parent, child) then AddChild(parent, child)
+    SPLICE        // The next chunk's Features go to the Container child.
+  };
+  ParseEvent(Kind kind_, const ElementPtr& parent_, const ElementPtr& child_)
+    : kind(kind_), parent(parent_), child(child_) {
+  }
+  Kind kind;
+  ElementPtr parent;
+  ElementPtr child;
+};
+typedef std::vector<ParseEvent> parse_event_vector_t;
+
+// ParseParallel gives this as the only ParserObserver to the KmlHandler of
+// each piece of the document it parses.  The first wrapper_depth Elements
+// are those of the prefix of a chunk.  The children of the innermost of
+// these are the Features of the chunk which are collected rather than added
+// to it.  When recording no child is added to its parent at all: the events
+// are recorded to be replayed.  The Features are recorded as children of a
+// NULL parent which stands for the Container they are spliced into.
+class ParsePieceObserver : public ParserObserver {
+ public:
+  ParsePieceObserver(size_t wrapper_depth, bool recording)
+    : wrapper_depth_(wrapper_depth),
+      recording_(recording) {
+  }
+
+  virtual bool NewElement(const ElementPtr& element) {
+    if (recording_ && open_.size() >= wrapper_depth_) {
+      events_.push_back(ParseEvent(ParseEvent::NEW_ELEMENT, NULL, element));
+    }
+    open_.push_back(element);
+    return true;
+  }
+
+  virtual bool EndElement(const ElementPtr& parent, const ElementPtr& child) {
+    open_.pop_back();
+    if (open_.size() < wrapper_depth_) {
+      return false;  // The end of an element of the prefix.
+    }
+    const bool is_feature = open_.size() == wrapper_depth_;
+    if (is_feature) {
+      features_.push_back(child);
+    }
+    if (recording_) {
+      events_.push_back(ParseEvent(ParseEvent::END_ELEMENT,
+                                   is_feature ? NULL : parent, child));
+      return false;
+    }
+    return !is_feature;
+  }
+
+  // This marks the point at which the Features of the next chunk belong to
+  // the innermost open Element which is returned.  This is NULL if no
+  // Element is open.
+  ElementPtr Splice() {
+    ElementPtr container = open_.empty() ? NULL : open_.back();
+    if (recording_) {
+      events_.push_back(ParseEvent(ParseEvent::SPLICE, NULL, container));
+    }
+    return container;
+  }
+
+  const std::vector<ElementPtr>& get_features() const {
+    return features_;
+  }
+  const parse_event_vector_t& get_events() const {
+    return events_;
+  }
+
+ private:
+  const size_t wrapper_depth_;
+  const bool recording_;
+  std::vector<ElementPtr> open_;
+  std::vector<ElementPtr> features_;
+  parse_event_vector_t events_;
+};
+
+// This is one chunk of a ParseParallel.  Run() parses the chunk placed
+// between the prefix and suffix of the FeatureSplit.
+class ParseChunkRunnable : public kmlbase::Runnable {
+ public:
+  ParseChunkRunnable(const string& kml, const FeatureSplit& feature_split,
+                     size_t chunk_index, bool recording,
+                     const ParseOptions& options)
+    : kml_(kml),
+      feature_split_(feature_split),
+      chunk_index_(chunk_index),
+      observer_(feature_split.prefix_depth, recording),
+      options_(options),
+      status_(false) {
+    // An Arena is not thread-safe.
+    if (options_.arena) {
+      const bool intern_strings = options_.arena->get_intern_strings();
+      options_.arena = new Arena;
+      options_.arena->set_intern_strings(intern_strings);
+    }
+  }
+
+  virtual void Run() {
+    const std::pair<size_t, size_t>& chunk =
+        feature_split_.chunks[chunk_index_];
+    string xml(feature_split_.prefix);
+    xml.append(kml_, chunk.first, chunk.second - chunk.first);
+    xml.append(feature_split_.suffix);
+    parser_observer_vector_t observers(1, &observer_);
+    KmlHandler kml_handler(observers, options_);
+    status_ = kmlbase::ExpatParser::ParseString(xml, &kml_handler, NULL,
+                                                false);
+  }
+
+  bool get_status() const {
+    return status_;
+  }
+  const ParsePieceObserver& get_observer() const {
+    return observer_;
+  }
+
+ private:
+  const string& kml_;
+  const FeatureSplit& feature_split_;
+  const size_t chunk_index_;
+  ParsePieceObserver observer_;
+  ParseOptions options_;
+  bool status_;
+};
+
+// This replays the recorded events to the observers and adds each child to
+// its parent unless an observer's EndElement() returns false.  The events of
+// each chunk are replayed at its SPLICE event with the Container standing
+// in for their NULL parent.  The children of the NULL parent are added to
+// the Container only if add_to_container.  This returns false if an
+// observer terminates the parse.
+static bool ReplayParseEvents(
+    const parse_event_vector_t& events, const ElementPtr& container,
+    bool add_to_container,
+    const std::vector<ParseChunkRunnable*>& chunk_runnables,
+    size_t* next_chunk, const parser_observer_vector_t& observers) {
+  for (size_t i = 0; i < events.size(); ++i) {
+    const ParseEvent& event = events[i];
+    if (event.kind == ParseEvent::SPLICE) {
+      const ParseChunkRunnable* chunk_runnable =
+          chunk_runnables[(*next_chunk)++];
+      if (!ReplayParseEvents(chunk_runnable->get_observer().get_events(),
+                             event.child, true, chunk_runnables, next_chunk,
+                             observers)) {
+        return false;
+      }
+    } else if (event.kind == ParseEvent::NEW_ELEMENT) {
+      for (size_t j = 0; j < observers.size(); ++j) {
+        if (!observers[j]->NewElement(event.child)) {
+          return false;
+        }
+      }
+    } else {
+      const ElementPtr& parent = event.parent ? event.parent : container;
+      size_t j = 0;
+      while (j < observers.size() &&
+             observers[j]->EndElement(parent, event.child)) {
+        ++j;
+      }
+      if (j == observers.size() && (event.parent || add_to_container)) {
+        parent->AddElement(event.child);
+      }
+      for (j = 0; j < observers.size(); ++j) {
+        if (!observers[j]->AddChild(parent, event.child)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+ElementPtr Parser::ParseParallel(const string& kml, size_t thread_count,
+                                 size_t chunk_size, string* errors) {
+  if (thread_count == 0) {
+    thread_count = kmlbase::GetProcessorCount();
+  }
+  if (chunk_size == 0) {
+    // A few chunks per thread evens out the threads' work.
+    chunk_size = kml.size() / (thread_count * 4);
+    if (chunk_size < kMinParallelChunkSize) {
+      chunk_size = kMinParallelChunkSize;
+    }
+  }
+  FeatureSplit feature_split;
+  if (thread_count < 2 ||
+      !SplitAtFeatures(kml.data(), kml.size(), chunk_size, &feature_split)) {
+    return Parse(kml, errors);
+  }
+
+  // The schema and factory singletons must exist before the threads use
+  // them.
+  Xsd::GetSchema();
+  KmlFactory::GetFactory();
+
+  const bool recording = !observers_.empty();
+  std::vector<ParseChunkRunnable*> chunk_runnables;
+  std::vector<kmlbase::Runnable*> runnables;
+  for (size_t i = 0; i < feature_split.chunks.size(); ++i) {
+    chunk_runnables.push_back(
+        new ParseChunkRunnable(kml, feature_split, i, recording, options_));
+    runnables.push_back(chunk_runnables.back());
+  }
+  kmlbase::RunInParallel(runnables, thread_count);
+  bool status = true;
+  for (size_t i = 0; i < chunk_runnables.size(); ++i) {
+    status = status && chunk_runnables[i]->get_status();
+  }
+
+  // Parse the rest of the document on this thread splicing in the Features
+  // of each chunk where it was cut out.
+  ParsePieceObserver observer(0, recording);
+  parser_observer_vector_t observers(1, &observer);
+  KmlHandler kml_handler(observers, options_);
+  kmlbase::ExpatParser parser(&kml_handler, false);
+  size_t offset = 0;
+  for (size_t i = 0; status && i < feature_split.chunks.size(); ++i) {
+    const std::pair<size_t, size_t>& chunk = feature_split.chunks[i];
+    status = parser.ParseBuffer(kml.substr(offset, chunk.first - offset),
+                                NULL, false);
+    ElementPtr container = status ? observer.Splice() : NULL;
+    status = container && container->IsA(Type_Container);
+    if (status && !recording) {
+      const std::vector<ElementPtr>& features =
+          chunk_runnables[i]->get_observer().get_features();
+      for (size_t j = 0; j < features.size(); ++j) {
+        container->AddElement(features[j]);
+      }
+    }
+    offset = chunk.second;
+  }
+  status = status && parser.ParseBuffer(kml.substr(offset), NULL, true);
+
+  ElementPtr root;
+  if (status) {
+    root = kml_handler.PopRoot();
+    size_t next_chunk = 0;
+    if (recording && !ReplayParseEvents(observer.get_events(), NULL, true,
+                                        chunk_runnables, &next_chunk,
+                                        observers_)) {
+      root = NULL;
+      if (errors) {
+        // As reported by Parse() when an observer terminates the parse.
+        *errors = "Invalid root element";
+      }
+    }
+  }
+  for (size_t i = 0; i < chunk_runnables.size(); ++i) {
+    delete chunk_runnables[i];
+  }
+  // Errors are reported as by Parse() which has not yet called any
+  // observer.
+  return status ? root : Parse(kml, errors);
+}
+
+// This handler builds nothing.  A parse with it succeeds only if the
+// document is well-formed and nests no deeper than a KmlHandler permits.
+class WellFormedHandler : public kmlbase::ExpatRawHandler {
+ public:
+  WellFormedHandler()
+    : depth_(0) {
+  }
+
+  virtual void StartElementRaw(const char* name, size_t name_len,
+                               const kmlbase::ExpatAttributeView& atts) {
+    if (++depth_ > KmlHandler::GetMaxNestingDepth()) {
+      XML_StopParser(get_parser(), XML_TRUE);
+    }
+  }
+  virtual void EndElementRaw(const char* name, size_t name_len) {
+    --depth_;
+  }
+  virtual void CharDataRaw(const char* s, size_t len) {}
+
+ private:
+  unsigned int depth_;
+};
+
+ElementPtr Parser::ParseLazy(const string& kml, string* errors) {
+  // Each Feature of the top-level Container is its own chunk.
+  // A Feature filtered out by the ParseOptions is not known to be until it
+  // is parsed so a filtered parse is not deferred.
+  FeatureSplit feature_split;
+  if (options_.has_type_filter() ||
+      !SplitAtFeatures(kml.data(), kml.size(), 0, &feature_split)) {
+    return Parse(kml, errors);
+  }
+  // A Feature which Parse() would reject must not be found malformed only
+  // when it is accessed, so the whole document is checked up front.  This
+  // tokenizes the document without building anything.
+  WellFormedHandler well_formed_handler;
+  if (!kmlbase::ExpatParser::ParseString(kml, &well_formed_handler, NULL,
+                                         false)) {
+    return Parse(kml, errors);
+  }
+  LazyFeatureSourcePtr lazy_feature_source =
+      new LazyFeatureSource(kml, feature_split.prefix, feature_split.suffix,
+                            feature_split.prefix_depth, observers_,
+                            options_);
+  std::vector<string> ids;
+  for (size_t i = 0; i < feature_split.chunks.size(); ++i) {
+    const std::pair<size_t, size_t>& chunk = feature_split.chunks[i];
+    ids.clear();
+    FindIds(kml.data() + chunk.first, chunk.second - chunk.first, &ids);
+    for (size_t j = 0; j < ids.size(); ++j) {
+      lazy_feature_source->id_index_[ids[j]] = chunk.first;
+    }
+  }
+
+  // Parse the rest of the document leaving a lazy Feature in the Container
+  // where each was cut out.  The observers see only the Elements parsed.
+  ParsePieceObserver observer(0, false);
+  parser_observer_vector_t observers(1, &observer);
+  observers.insert(observers.end(), observers_.begin(), observers_.end());
+  KmlHandler kml_handler(observers, options_);
+  kmlbase::ExpatParser parser(&kml_handler, false);
+  bool status = true;
+  size_t offset = 0;
+  for (size_t i = 0; status && i < feature_split.chunks.size(); ++i) {
+    const std::pair<size_t, size_t>& chunk = feature_split.chunks[i];
+    status = parser.ParseBuffer(kml.substr(offset, chunk.first - offset),
+                                NULL, false);
+    ContainerPtr container = status ? AsContainer(observer.Splice()) : NULL;
+    status = container != NULL;
+    if (status) {
+      container->AddLazyFeature(lazy_feature_source, chunk.first,
+                                chunk.second);
+    }
+    offset = chunk.second;
+  }
+  if (status && parser.ParseBuffer(kml.substr(offset), NULL, true)) {
+    return kml_handler.PopRoot();
+  }
+  // The document was cut up so the errors are found by parsing it whole.
+  // The observers have already seen the start of the document.
+  if (Parser().Parse(kml, errors) && errors) {
+    // The parse was terminated by an observer.
+    *errors = "Invalid root element";
+  }
+  return NULL;
+}
+
+FeaturePtr Parser::ParseLazyFeature(
+    const LazyFeatureSource& lazy_feature_source, size_t begin, size_t end,
+    const ContainerPtr& container) {
+  string xml(lazy_feature_source.prefix_);
+  xml.append(lazy_feature_source.kml_, begin, end - begin);
+  xml.append(lazy_feature_source.suffix_);
+  const bool recording = !observers_.empty();
+  ParsePieceObserver observer(lazy_feature_source.prefix_depth_, recording);
+  parser_observer_vector_t observers(1, &observer);
+  KmlHandler kml_handler(observers, options_);
+  string errors;
+  FeaturePtr feature;
+  if (kmlbase::ExpatParser::ParseString(xml, &kml_handler, &errors, false) &&
+      observer.get_features().size() == 1) {
+    feature = AsFeature(observer.get_features()[0]);
+  }
+  std::stringstream where;
+  where << "Feature at byte " << begin << ": ";
+  if (!feature) {
+    // ParseLazy() checked the document so this is not expected.  The Feature
+    // is left unparsed rather than replaced.
+    lazy_feature_source.AddError(where.str() +
+                                 (errors.empty() ? "not parsed" : errors));
+    return NULL;
+  }
+  if (recording) {
+    // The Feature itself is left to the caller to add to the Container.
+    // The parse of the document is long over so an observer which
+    // terminates it leaves the rest of the Feature unparsed and an error.
+    size_t next_chunk = 0;
+    if (!ReplayParseEvents(observer.get_events(), container, false,
+                           std::vector<ParseChunkRunnable*>(), &next_chunk,
+                           observers_)) {
+      lazy_feature_source.AddError(
+          where.str() + "parse terminated by an observer");
+    }
+  }
+  return feature;
+}
 
 // As Parser::Parse(), but invokes the underlying XML parser's namespace-aware
 // mode.
 ElementPtr Parser::ParseNS(const string& kml, string* errors) {
-  KmlHandlerNS kml_handler(observers_);
+  KmlHandlerNS kml_handler(observers_, options_);
   if (kmlbase::ExpatParser::ParseString(kml, &kml_handler, errors, true)) {
     return kml_handler.PopRoot();
   }
@@ -75,7 +482,7 @@ ElementPtr Parser::ParseNS(const string& kml, string* errors) {
 ElementPtr Parser::ParseAtom(const string& atom, string* errors) {
   // Create a garden variety KML parser with "short-hand" namespace prefixes
   // for Atom.
-  KmlHandler kml_handler(observers_);
+  KmlHandler kml_handler(observers_, options_);
   kmlbase::Attributes attributes;
   // Create a namespace aware expat handler which converts the Atom namespace
   // elements to the "short-hand" namespace prefixing used in KmlHandler.
@@ -103,6 +510,12 @@ ElementPtr Parse(const string& kml, string* errors) {
   return parser.Parse(kml, errors);
 }
 
+ElementPtr ParseParallel(const string& kml, size_t thread_count,
+                         string* errors) {
+  Parser parser;
+  return parser.ParseParallel(kml, thread_count, 0, errors);
+}
+
 // As Parse(), but invokes the underlying XML parser's namespace-aware mode.
 ElementPtr ParseNS(const string& kml, string* errors) {
   Parser parser;
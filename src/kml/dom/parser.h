@@ -30,11 +30,18 @@
 
 #include <vector>
 #include "kml/dom/kml_ptr.h"
+#include "kml/dom/parse_options.h"
 #include "kml/dom/parser_observer.h"
 #include "kml/base/util.h"
 
+namespace kmlbase {
+class MappedFile;
+}
+
 namespace kmldom {
 
+class LazyFeatureSource;
+
 // The internal Parser class implements the public Parse API.
 // CDATA tags are dropped (by expat) upon parse and internally we carry
 // around the resultant representation. There are thus no methods within
@@ -59,7 +66,51 @@ class Parser {
   // element is returned.  Note that any ParseObserver can terminate the parse.
   ElementPtr Parse(const string& kml, string *errors);
 
+  // As Parse(), but parses the contents of the given mapped file without
+  // copying them.  The pages of the mapping are released as the parse
+  // passes them such that the file does not add to the peak memory use.
+  ElementPtr ParseMappedFile(kmlbase::MappedFile* mapped_file,
+                             string *errors);
+
+  // As Parse(), but parses the Features of a large top-level <Document> or
+  // <Folder> on up to thread_count threads (0 for one per processor).  The
+  // document is divided between Features into chunks of about chunk_size
+  // bytes (0 for a size suited to thread_count) and each chunk is parsed by
+  // its own KmlHandler.  The Features are then added to the Container in
+  // document order such that the result is as from Parse().  Documents
+  // which cannot be divided (see feature_splitter.h) and documents with
+  // errors are handed to Parse().
+  // If there are observers the parse of each chunk records its events and
+  // defers adding children.  The events are replayed to the observers on
+  // the calling thread in document order once all chunks are parsed, and
+  // each child is added unless an observer's EndElement() returns false,
+  // just as in Parse().  The one difference is that all Elements are built
+  // before the first observer is called.
+  ElementPtr ParseParallel(const string& kml, size_t thread_count,
+                           size_t chunk_size, string* errors);
+
+  // As Parse(), but defers the parse of each Feature of a large top-level
+  // <Document> or <Folder> until it is first accessed.  The Container keeps
+  // the byte range of each Feature in a LazyFeatureSource which retains the
+  // document, and an index of the ids within each Feature is built by a
+  // light scan of its start tags.  A Feature is parsed when it is fetched
+  // from the Container with get_feature_array_at() (see
+  // Container::FindLazyFeatureById()) and all are parsed when the Container
+  // is serialized or visited.  The observers see the Elements of each
+  // Feature as it is parsed which may be well after this returns, and so
+  // they must outlive the Elements or be removed with
+  // LazyFeatureSource::ClearObservers().  An observer's EndElement() can
+  // veto a child within a Feature as in Parse(), but not the Feature itself,
+  // and an observer which terminates the parse of a Feature leaves the rest
+  // of that Feature unparsed and an error in
+  // LazyFeatureSource::get_errors().  The whole document is checked to be
+  // well-formed up front such that a document Parse() rejects is rejected.
+  // Documents which cannot be divided (see feature_splitter.h) and parses
+  // with a type filter (see ParseOptions) are handed to Parse().
+  ElementPtr ParseLazy(const string& kml, string* errors);
+
   // As Parse(), but invokes the underlying XML parser's namespace-aware mode.
+  // The ParseOptions apply here and to ParseAtom() as they do to Parse().
   ElementPtr ParseNS(const string& kml, string *errors);
 
   // As Parse(), but invokes the underlying XML parser's namespace-aware mode
@@ -69,8 +120,27 @@ class Parser {
   // This method registers the given ParserObserver-based class.  Each
   // NewElement() and AddChild() method is called in the order added.
   void AddObserver(ParserObserver* parser_observer);
+
+  // The ParseOptions apply to each subsequent Parse(), ParseMappedFile(),
+  // ParseParallel() and ParseLazy().
+  void set_options(const ParseOptions& options) {
+    options_ = options;
+  }
+  const ParseOptions& get_options() const {
+    return options_;
+  }
+
  private:
+  friend class LazyFeatureSource;
+  // This parses the Feature at [begin, end) of the document of the
+  // LazyFeatureSource.  The observers are called for the Elements of the
+  // Feature as children of the given Container.
+  FeaturePtr ParseLazyFeature(const LazyFeatureSource& lazy_feature_source,
+                              size_t begin, size_t end,
+                              const ContainerPtr& container);
+
   parser_observer_vector_t observers_;
+  ParseOptions options_;
   LIBKML_DISALLOW_EVIL_CONSTRUCTORS(Parser);
 };
 
@@ -28,6 +28,7 @@
 #ifndef KML_DOM_PARSER_OBSERVER_H__
 #define KML_DOM_PARSER_OBSERVER_H__
 
+#include <vector>
 #include "kml/dom/kml_ptr.h"
 
 namespace kmldom {
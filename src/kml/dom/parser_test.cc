@@ -27,11 +27,22 @@
 // various internals of the KmlHandler class.
 
 #include "kml/dom/kml_funcs.h"
+#include <sstream>
+#include "kml/base/file.h"
+#include "kml/base/string_util.h"
 #include "kml/dom/element.h"
+#include "kml/dom/feature_splitter.h"
 #include "kml/dom/kml.h"
 #include "kml/dom/kml_cast.h"
+#include "kml/dom/kml_factory.h"
+#include "kml/dom/lazy_feature_source.h"
+#include "kml/dom/parser.h"
 #include "gtest/gtest.h"
 
+#ifndef DATADIR
+#error DATADIR must be defined!
+#endif
+
 namespace kmldom {
 
 // Verify proper behavior for good KML.  The XML is valid and all elements
@@ -175,6 +186,29 @@ TEST(ParserTest, TestBasicParseAtom) {
   ASSERT_EQ(kmlbase::XMLNS_ATOM, root->get_xmlns());
 }
 
+// Verify that ParseNS() and ParseAtom() follow the ParseOptions.
+TEST(ParserTest, TestParseNSAndAtomOptions) {
+  ParseOptions options;
+  options.exclude_types.insert(Type_name);
+  Parser parser;
+  parser.set_options(options);
+  const PlacemarkPtr placemark = AsPlacemark(parser.ParseNS(
+      "<Placemark xmlns='http://www.opengis.net/kml/2.2'>"
+      "<name>a</name><description>b</description></Placemark>", NULL));
+  ASSERT_TRUE(placemark);
+  ASSERT_FALSE(placemark->has_name());
+  ASSERT_TRUE(placemark->has_description());
+
+  options.exclude_types.insert(Type_AtomLink);
+  parser.set_options(options);
+  const AtomFeedPtr feed = AsAtomFeed(parser.ParseAtom(
+      "<feed xmlns='http://www.w3.org/2005/Atom'>"
+      "<link href='a.kml'/><title>t</title></feed>", NULL));
+  ASSERT_TRUE(feed);
+  ASSERT_EQ(static_cast<size_t>(0), feed->get_link_array_size());
+  ASSERT_TRUE(feed->has_title());
+}
+
 TEST(ParserTest, TestBasicParseAtomWithKml) {
   ElementPtr root = ParseAtom(
     "<atom:content xmlns:atom='http://www.w3.org/2005/Atom'>"
@@ -191,4 +225,329 @@ TEST(ParserTest, TestBasicParseAtomWithKml) {
   ASSERT_EQ(string("pm0"), placemark->get_id());
 }
 
+// This ParserObserver logs every call and vetoes the adding of the Placemark
+// named by veto_name_.  It terminates the parse at the Placemark named by
+// stop_name_.
+class LoggingObserver : public ParserObserver {
+ public:
+  LoggingObserver(const string& veto_name, const string& stop_name)
+    : veto_name_(veto_name),
+      stop_name_(stop_name) {
+  }
+
+  virtual bool NewElement(const ElementPtr& element) {
+    log_.append("new " + GetElementName(element) + "\n");
+    return true;
+  }
+
+  virtual bool EndElement(const ElementPtr& parent, const ElementPtr& child) {
+    log_.append("end " + Describe(parent) + " " + Describe(child) + "\n");
+    PlacemarkPtr placemark = AsPlacemark(child);
+    return !placemark || placemark->get_name() != veto_name_;
+  }
+
+  virtual bool AddChild(const ElementPtr& parent, const ElementPtr& child) {
+    log_.append("add " + Describe(parent) + " " + Describe(child) + "\n");
+    PlacemarkPtr placemark = AsPlacemark(child);
+    return !placemark || placemark->get_name() != stop_name_;
+  }
+
+  const string& get_log() const {
+    return log_;
+  }
+
+ private:
+  static string Describe(const ElementPtr& element) {
+    FeaturePtr feature = AsFeature(element);
+    return GetElementName(element) +
+        (feature ? "[" + feature->get_name() + "]" : "");
+  }
+
+  const string veto_name_;
+  const string stop_name_;
+  string log_;
+};
+
+class ParseParallelTest : public testing::Test {
+ protected:
+  // Returns a Document of count Placemarks named "0", "1", etc with a
+  // Style after each 10th.
+  static string CreateFlatKml(size_t count) {
+    string kml("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+               "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n"
+               "<Document><name>flat</name>\n");
+    for (size_t i = 0; i < count; ++i) {
+      kml.append("  <Placemark id=\"p" + kmlbase::ToString(i) + "\"><name>" +
+                 kmlbase::ToString(i) + "</name><Point><coordinates>" +
+                 kmlbase::ToString(i) + ",1</coordinates></Point>"
+                 "<description><![CDATA[<b>" + kmlbase::ToString(i) +
+                 "</b>]]></description></Placemark>\n");
+      if (i % 10 == 9) {
+        kml.append("  <Style id=\"s" + kmlbase::ToString(i) + "\"/>\n");
+      }
+    }
+    kml.append("</Document>\n</kml>\n");
+    return kml;
+  }
+
+  // Verifies that ParseParallel of the kml in chunks of chunk_size produces
+  // the same DOM, observer calls and errors as Parse.
+  static void VerifyParseParallel(const string& kml, size_t chunk_size,
+                                  const string& veto_name,
+                                  const string& stop_name) {
+    LoggingObserver observer(veto_name, stop_name);
+    Parser parser;
+    parser.AddObserver(&observer);
+    string errors;
+    ElementPtr root = parser.Parse(kml, &errors);
+
+    LoggingObserver parallel_observer(veto_name, stop_name);
+    Parser parallel_parser;
+    parallel_parser.AddObserver(&parallel_observer);
+    string parallel_errors;
+    ElementPtr parallel_root = parallel_parser.ParseParallel(
+        kml, 4, chunk_size, &parallel_errors);
+
+    ASSERT_EQ(errors, parallel_errors);
+    ASSERT_EQ(observer.get_log(), parallel_observer.get_log());
+    ASSERT_EQ(root.get() == NULL, parallel_root.get() == NULL);
+    if (root) {
+      ASSERT_EQ(SerializePretty(root), SerializePretty(parallel_root));
+    }
+
+    // And without observers.
+    errors.clear();
+    parallel_errors.clear();
+    parallel_root = ParseParallel(kml, 4, &parallel_errors);
+    ElementPtr plain_root = Parse(kml, &errors);
+    ASSERT_EQ(errors, parallel_errors);
+    ASSERT_EQ(plain_root.get() == NULL, parallel_root.get() == NULL);
+    if (plain_root) {
+      ASSERT_EQ(SerializePretty(plain_root), SerializePretty(parallel_root));
+    }
+    Parser unobserved_parser;
+    parallel_root = unobserved_parser.ParseParallel(kml, 4, chunk_size,
+                                                    &parallel_errors);
+    ASSERT_EQ(plain_root.get() == NULL, parallel_root.get() == NULL);
+    if (plain_root) {
+      ASSERT_EQ(SerializePretty(plain_root), SerializePretty(parallel_root));
+    }
+  }
+};
+
+TEST_F(ParseParallelTest, TestFlatDocument) {
+  const string kKml = CreateFlatKml(1000);
+  FeatureSplit feature_split;
+  ASSERT_TRUE(SplitAtFeatures(kKml.data(), kKml.size(), 1000,
+                              &feature_split));
+  ASSERT_LT(static_cast<size_t>(50), feature_split.chunks.size());
+
+  Parser parser;
+  ElementPtr root = parser.ParseParallel(kKml, 4, 1000, NULL);
+  DocumentPtr document = AsDocument(AsKml(root)->get_feature());
+  ASSERT_EQ(static_cast<size_t>(1000), document->get_feature_array_size());
+  ASSERT_EQ(static_cast<size_t>(100),
+            document->get_styleselector_array_size());
+  for (size_t i = 0; i < 1000; ++i) {
+    FeaturePtr feature = document->get_feature_array_at(i);
+    ASSERT_EQ(kmlbase::ToString(i), feature->get_name());
+    ASSERT_EQ(document, feature->GetParent());
+  }
+
+  VerifyParseParallel(kKml, 1, "", "");
+  VerifyParseParallel(kKml, 1000, "", "");
+  VerifyParseParallel(kKml, 1000, "500", "");
+}
+
+TEST_F(ParseParallelTest, TestObserverStop) {
+  const string kKml = CreateFlatKml(100);
+  VerifyParseParallel(kKml, 100, "", "50");
+  VerifyParseParallel(kKml, 100, "", "99");
+}
+
+TEST_F(ParseParallelTest, TestErrors) {
+  string kml = CreateFlatKml(100);
+  // Break the well-formedness in the middle of the Placemarks and in the
+  // rest of the document.
+  kml.replace(kml.find("<name>50</name>"), 15, "<name>50</nam>");
+  VerifyParseParallel(kml, 100, "", "");
+  kml = CreateFlatKml(100);
+  kml.replace(kml.find("<Style id=\"s49\"/>"), 16, "<Style id=\"s49\">");
+  VerifyParseParallel(kml, 100, "", "");
+  VerifyParseParallel("<kml><Document><Placemark></Document></kml>", 1, "",
+                      "");
+}
+
+TEST_F(ParseParallelTest, TestTestData) {
+  const char* kFiles[] = {
+    "/kml/kmlsamples.kml",
+    "/kml/gnis-ak-first-101.kml",
+    "/kml/101_nested_folders.kml",
+    "/kml/all-unknown-input.kml",
+    "/kml/old_schema_example.kml",
+    "/kml/photooverlay-zermatt.kml",
+    "/kml/schemadata.kml"
+  };
+  for (size_t i = 0; i < sizeof(kFiles) / sizeof(kFiles[0]); ++i) {
+    string kml;
+    ASSERT_TRUE(kmlbase::File::ReadFileToString(string(DATADIR) + kFiles[i],
+                                                &kml));
+    VerifyParseParallel(kml, 1, "", "");
+    VerifyParseParallel(kml, 4096, "", "");
+  }
+}
+
+class ParseLazyTest : public ParseParallelTest {
+ protected:
+  // Verifies that ParseLazy of the kml produces the same DOM and errors as
+  // Parse once all Features are parsed.
+  static void VerifyParseLazy(const string& kml) {
+    string errors;
+    ElementPtr root = Parse(kml, &errors);
+    string lazy_errors;
+    Parser parser;
+    ElementPtr lazy_root = parser.ParseLazy(kml, &lazy_errors);
+    ASSERT_EQ(errors, lazy_errors);
+    ASSERT_EQ(root.get() == NULL, lazy_root.get() == NULL);
+    if (root) {
+      ASSERT_EQ(SerializePretty(root), SerializePretty(lazy_root));
+    }
+  }
+};
+
+TEST_F(ParseLazyTest, TestFlatDocument) {
+  const string kKml = CreateFlatKml(100);
+  Parser parser;
+  ElementPtr root = parser.ParseLazy(kKml, NULL);
+  DocumentPtr document = AsDocument(AsKml(root)->get_feature());
+  ASSERT_TRUE(document->has_lazy_features());
+  ASSERT_EQ(static_cast<size_t>(100), document->get_feature_array_size());
+  ASSERT_EQ(static_cast<size_t>(10),
+            document->get_styleselector_array_size());
+
+  // Only the Features asked for are parsed.
+  ASSERT_EQ(static_cast<size_t>(7), document->FindLazyFeatureById("p7"));
+  FeaturePtr feature = document->get_feature_array_at(50);
+  ASSERT_EQ(string("50"), feature->get_name());
+  ASSERT_EQ(string("p50"), feature->get_id());
+  ASSERT_EQ(document, feature->GetParent());
+  ASSERT_EQ(feature, document->get_feature_array_at(50));
+  ASSERT_EQ(static_cast<size_t>(100), document->FindLazyFeatureById("p50"));
+  ASSERT_EQ(static_cast<size_t>(100), document->FindLazyFeatureById("s9"));
+  ASSERT_EQ(static_cast<size_t>(100), document->FindLazyFeatureById("nope"));
+  ASSERT_TRUE(document->has_lazy_features());
+
+  // Deleting keeps the rest in place.
+  feature = document->DeleteFeatureAt(7);
+  ASSERT_EQ(string("7"), feature->get_name());
+  ASSERT_EQ(static_cast<size_t>(99), document->get_feature_array_size());
+  ASSERT_EQ(static_cast<size_t>(8), document->FindLazyFeatureById("p9"));
+  ASSERT_EQ(string("8"), document->get_feature_array_at(7)->get_name());
+  ASSERT_EQ(string("p50"), document->DeleteFeatureById("p50")->get_id());
+  ASSERT_FALSE(document->has_lazy_features());
+  ASSERT_EQ(static_cast<size_t>(98), document->get_feature_array_size());
+
+  // A Feature added goes after the lazy ones.
+  document->add_feature(KmlFactory::GetFactory()->CreatePlacemark());
+  ASSERT_EQ(static_cast<size_t>(99), document->get_feature_array_size());
+
+  VerifyParseLazy(kKml);
+}
+
+TEST_F(ParseLazyTest, TestObservers) {
+  const string kKml = CreateFlatKml(100);
+  LoggingObserver observer("", "");
+  Parser parser;
+  parser.AddObserver(&observer);
+  ElementPtr root = parser.ParseLazy(kKml, NULL);
+  DocumentPtr document = AsDocument(AsKml(root)->get_feature());
+  ASSERT_EQ(string::npos, observer.get_log().find("Placemark"));
+  document->get_feature_array_at(3);
+  ASSERT_NE(string::npos,
+            observer.get_log().find("new Placemark\n"));
+  ASSERT_NE(string::npos,
+            observer.get_log().find("add Document[flat] Placemark[3]\n"));
+  ASSERT_EQ(string::npos, observer.get_log().find("Placemark[4]"));
+
+  // The observers may be removed before they go.
+  document->get_lazy_feature_source()->ClearObservers();
+  const string log = observer.get_log();
+  document->get_feature_array_at(4);
+  ASSERT_EQ(log, observer.get_log());
+}
+
+TEST_F(ParseLazyTest, TestErrors) {
+  string kml = CreateFlatKml(100);
+  // A malformed Feature is found at once as by Parse().
+  kml.replace(kml.find("<name>50</name>"), 15, "<name>50</nam>");
+  VerifyParseLazy(kml);
+  Parser parser;
+  ASSERT_FALSE(parser.ParseLazy(kml, NULL));
+
+  // As are errors in the rest of the document.
+  kml = CreateFlatKml(100);
+  kml.replace(kml.find("<Style id=\"s49\"/>"), 16, "<Style id=\"s49\">");
+  VerifyParseLazy(kml);
+  VerifyParseLazy("<kml><Document><Placemark/></Folder></kml>");
+
+  // As is a Feature nested too deeply.
+  ASSERT_TRUE(kmlbase::File::ReadFileToString(
+      string(DATADIR) + "/kml/101_nested_folders.kml", &kml));
+  ASSERT_FALSE(Parse(kml, NULL));
+  VerifyParseLazy(kml);
+  ASSERT_FALSE(parser.ParseLazy(kml, NULL));
+}
+
+TEST_F(ParseLazyTest, TestObserverTerminates) {
+  const string kKml(
+      "<kml><Document>"
+      "<Folder><Placemark><name>a</name></Placemark>"
+      "<Placemark><name>stop</name></Placemark>"
+      "<Placemark><name>c</name></Placemark></Folder>"
+      "<Folder><Placemark><name>d</name></Placemark></Folder>"
+      "</Document></kml>");
+  LoggingObserver observer("", "stop");
+  Parser parser;
+  parser.AddObserver(&observer);
+  ElementPtr root = parser.ParseLazy(kKml, NULL);
+  ASSERT_TRUE(root);
+  DocumentPtr document = AsDocument(AsKml(root)->get_feature());
+  const LazyFeatureSourcePtr& source = document->get_lazy_feature_source();
+  ASSERT_TRUE(source);
+  ASSERT_TRUE(source->get_errors().empty());
+
+  // The observer terminates the parse of the first Folder which keeps the
+  // Features up to the one it stopped at.  The error says which.
+  FolderPtr folder = AsFolder(document->get_feature_array_at(0));
+  ASSERT_TRUE(folder);
+  ASSERT_EQ(static_cast<size_t>(2), folder->get_feature_array_size());
+  std::stringstream error;
+  error << "Feature at byte " << kKml.find("<Folder>")
+        << ": parse terminated by an observer\n";
+  ASSERT_EQ(error.str(), source->get_errors());
+
+  // Other Features parse as before.
+  folder = AsFolder(document->get_feature_array_at(1));
+  ASSERT_TRUE(folder);
+  ASSERT_EQ(static_cast<size_t>(1), folder->get_feature_array_size());
+  ASSERT_EQ(error.str(), source->get_errors());
+}
+
+TEST_F(ParseLazyTest, TestTestData) {
+  const char* kFiles[] = {
+    "/kml/kmlsamples.kml",
+    "/kml/gnis-ak-first-101.kml",
+    "/kml/all-unknown-input.kml",
+    "/kml/old_schema_example.kml",
+    "/kml/photooverlay-zermatt.kml",
+    "/kml/schemadata.kml"
+  };
+  for (size_t i = 0; i < sizeof(kFiles) / sizeof(kFiles[0]); ++i) {
+    string kml;
+    ASSERT_TRUE(kmlbase::File::ReadFileToString(string(DATADIR) + kFiles[i],
+                                                &kml));
+    VerifyParseLazy(kml);
+  }
+}
+
 }  // end namespace kmldom
@@ -72,7 +72,7 @@ const string Serializer::MaybeQuoteString(const string& value) {
 // For example, type_id=Type_altitudeMode, enum_value=ALTITUDEMODE_ABSOLUTE.
 // If enum_value is not valid for the given type_id nothing is emitted.
 void Serializer::SaveEnum(int type_id, int enum_value) {
-  string enum_string = xsd_.EnumValue(type_id, enum_value);
+  const string& enum_string = xsd_.EnumValue(type_id, enum_value);
   if (!enum_string.empty()) {
     SaveFieldById(type_id, enum_string);
   }
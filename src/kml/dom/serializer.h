@@ -83,6 +83,21 @@ class Serializer {
   // Save a lon,lat,alt tuple as appears within <coordinates>.
   virtual void SaveVec3(const kmlbase::Vec3& vec3);
 
+  // Save the character data of a <coordinates> whose tuples are unchanged
+  // since it was parsed.  A serializer which returns false here is given
+  // each tuple with SaveVec3() instead, as is the default.
+  virtual bool SaveCoordinatesText(const string& char_data) {
+    return false;
+  }
+
+  // Save a Feature of a Container parsed with Parser::ParseLazy which is
+  // yet to be parsed given the size of its KML in the document.  A
+  // serializer which returns false here is given the parsed Feature instead,
+  // as is the default.
+  virtual bool SaveUnparsedFeature(size_t kml_size) {
+    return false;
+  }
+
   // Save a Vec3 with a specified delimiter and with an optional newline char.
   virtual void SaveSimpleVec3(int type_id, const kmlbase::Vec3& vec3,
                               const string& delimiter);
@@ -106,6 +121,11 @@ class Serializer {
     SaveStringFieldById(type_id, kmlbase::ToString(value));
   }
 
+  // A string value is saved as is, without a copy through ToString().
+  void SaveFieldById(int type_id, const string& value) {
+    SaveStringFieldById(type_id, value);
+  }
+
   // Notify the serializer that an array of the given type of element is being
   // saved.  SaveElement will now be called N times (N == element_count).
   virtual void BeginElementArray(int type_id, size_t element_count) {}
@@ -67,7 +67,7 @@ class Pair : public Object {
 
   // <styleUrl>
   const string& get_styleurl() const {
-    return styleurl_;
+    return styleurl_.get();
   }
   bool has_styleurl() const {
     return has_styleurl_;
@@ -104,7 +104,7 @@ class Pair : public Object {
   virtual void Serialize(Serializer& serializer) const;
   int key_;
   bool has_key_;
-  string styleurl_;
+  kmlbase::PooledString styleurl_;
   bool has_styleurl_;
   StyleSelectorPtr styleselector_;
   LIBKML_DISALLOW_EVIL_CONSTRUCTORS(Pair);
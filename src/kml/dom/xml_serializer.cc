@@ -54,6 +54,20 @@ string SerializePretty(const ElementPtr& root) {
   return xml;
 }
 
+// This function is in the public API for converting the given Element
+// hierarchy to "pretty" xml on several threads.
+string SerializePrettyParallel(const ElementPtr& root, size_t thread_count) {
+  if (!root) {
+    return string("");
+  }
+  string xml;
+  StringAdapter string_adapter(&xml);
+  XmlSerializer<StringAdapter> serializer("\n", "  ", &string_adapter);
+  serializer.set_thread_count(thread_count);
+  root->Serialize(serializer);
+  return xml;
+}
+
 // This function is in the public API for converting the given Element
 // hierarchy to xml with no additional whitespace for newlines or
 // indentation.
@@ -68,6 +82,22 @@ string SerializeRaw(const ElementPtr& root) {
   return xml;
 }
 
+// This function is in the public API for converting the given Element
+// hierarchy to the most compact xml.
+string SerializeCompact(const ElementPtr& root, const CompactOptions& options) {
+  if (!root) {
+    return string("");
+  }
+  string xml;
+  StringAdapter string_adapter(&xml);
+  XmlSerializer<StringAdapter> serializer("", "", &string_adapter);
+  serializer.set_compact_coordinates(true);
+  serializer.set_coordinate_precision(options.coordinate_precision);
+  serializer.set_strip_defaults(options.strip_defaults);
+  root->Serialize(serializer);
+  return xml;
+}
+
 string GetElementName(const ElementPtr& element) {
   return element ?  Xsd::GetSchema()->ElementName(element->Type()) : string("");
 }
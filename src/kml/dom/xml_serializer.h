@@ -30,10 +30,14 @@
 #ifndef KML_DOM_XML_SERIALIZER_H__
 #define KML_DOM_XML_SERIALIZER_H__
 
+#include <string.h>
+#include <algorithm>
 #include <ostream>
 #include <stack>
 #include <vector>
 #include "kml/base/attributes.h"
+#include "kml/base/number_format.h"
+#include "kml/base/thread.h"
 #include "kml/base/vec3.h"
 #include "kml/dom/serializer.h"
 #include "kml/dom/xsd.h"
@@ -67,6 +71,15 @@ class StringAdapter {
 //   void put(char c);
 // };
 // C++ std::ostream matches T
+//
+// The XmlSerializer gathers its output in a buffer of its own and hands it
+// to the T in blocks of up to kBufferSize bytes.  The buffer is flushed
+// whenever the serialization of a root element is complete, and on
+// destruction.  Serializing an element allocates nothing beyond what the
+// element itself does to build its Attributes.
+//
+// With set_thread_count() the Features of the top-level Container of a root
+// element are serialized concurrently.  See there.
 template<class T>
 class XmlSerializer : public Serializer {
  public:
@@ -89,22 +102,85 @@ class XmlSerializer : public Serializer {
     : newline_(newline),
       indent_(indent),
       output_(output),
-      start_pending_(false) {
+      start_pending_(false),
+      coordinate_precision_(-1),
+      compact_coordinates_(false),
+      strip_defaults_(false),
+      update_depth_(0),
+      tuple_written_(false),
+      thread_count_(1),
+      depth_(0),
+      root_type_id_(Type_Unknown),
+      collecting_features_(false),
+      buffer_size_(0) {
+  }
+
+  virtual ~XmlSerializer() {
+    Flush();
+  }
+
+  // By default each coordinate is written as the shortest text which reads
+  // back as the same double.  This instead rounds each coordinate of each
+  // tuple of <coordinates> to the given number of decimal places, 0 to 15.
+  // A negative number restores the default.
+  void set_coordinate_precision(int decimal_places) {
+    coordinate_precision_ = decimal_places;
+  }
+
+  // If true the tuples of <coordinates> are separated by one space rather
+  // than a line break, and a tuple without altitude is written as lon,lat.
+  void set_compact_coordinates(bool compact_coordinates) {
+    compact_coordinates_ = compact_coordinates;
+  }
+
+  // If true a field set to its default value in the KML schema is left out.
+  // See Xsd::IsElementDefault() for which fields have one.  Fields within an
+  // <Update> are always written as there a default value is a change.
+  void set_strip_defaults(bool strip_defaults) {
+    strip_defaults_ = strip_defaults;
   }
 
-  virtual ~XmlSerializer() {}
+  // If 2 or more the Features of the top-level Container of each root element
+  // serialized, the root itself if a <Document> or <Folder> or else the
+  // <Document> or <Folder> of a root <kml>, are serialized concurrently on
+  // up to this many threads, one of which is the calling thread.  Runs of
+  // consecutive Features are serialized to separate buffers which are
+  // written out in order such that the output is the same as with one
+  // thread.  A Container of fewer than kMinParallelFeatures Features is
+  // serialized on the calling thread.  The Elements must not be changed
+  // meanwhile, and no Element may be shared between two Features.  A
+  // thread_count of 0 uses one thread per processor.
+  void set_thread_count(size_t thread_count) {
+    thread_count_ = thread_count ? thread_count : kmlbase::GetProcessorCount();
+  }
+
+  // See set_thread_count().
+  static const size_t kMinParallelFeatures = 16;
 
   // Emit the start tag of the given element: <Placemark id="pm123">.
   virtual void BeginById(int type_id, const kmlbase::Attributes& attributes) {
-    // Here we just record the element we're starting and its attributes if
-    // it has any.  The "<TAGNAME [name="VAL" ...]..." are not emmited until
-    // it is known if this is a nil element or not.
+    // The "<TAGNAME [name="VAL" ...]" is emitted here, but whether it is
+    // closed with ">" or "/>" is not known until it is known if this is a
+    // nil element or not.
     EmitStart(false);
     Indent();
+    if (tag_stack_.empty()) {
+      root_type_id_ = type_id;
+    }
     tag_stack_.push(type_id);  // So we know what tag to use in End().
+    if (type_id == Type_Update) {
+      ++update_depth_;
+    }
+    Write(xsd_.ElementStartTag(type_id));
     if (attributes.GetSize() > 0) {
-      // TODO: Attributes::SerializeToBase would be handy.
-      attributes.Serialize(&serialized_attributes_);
+      kmlbase::StringMapIterator iter = attributes.CreateIterator();
+      for (; !iter.AtEnd(); iter.Advance()) {
+        Put(' ');
+        Write(iter.Data().first);
+        Write("=\"", 2);
+        Write(iter.Data().second);
+        Put('"');
+      }
     }
     start_pending_ = true;
   }
@@ -112,38 +188,41 @@ class XmlSerializer : public Serializer {
   // Emit the end tag of the given element: </Placemark>.
   virtual void End() {
     int type_id = tag_stack_.top();
+    if (type_id == Type_Update) {
+      --update_depth_;
+    }
     // TODO: make this less fiddly
     if (EmitStart(true)) {
       tag_stack_.pop();
     } else {
       tag_stack_.pop();
       Indent();
-      output_->write("</", 2);
-      const string& tag_name = xsd_.ElementName(type_id);
-      output_->write(tag_name.data(), tag_name.size());
-      output_->put('>');
+      Write(xsd_.ElementEndTag(type_id));
       Newline();
     }
+    tuple_written_ = false;
+    MaybeFlush();
   }
 
   // Emit the XML for the field of the given type with the given content
   // as its character data.  If value is empty a nil element is emitted.
   virtual void SaveStringFieldById(int type_id, string value) {
+    if (strip_defaults_ && update_depth_ == 0 &&
+        xsd_.IsElementDefault(type_id, value)) {
+      return;
+    }
     EmitStart(false);
     Indent();
-    const string& tag_name = xsd_.ElementName(type_id);
-    output_->put('<');
-    output_->write(tag_name.data(), tag_name.size());
+    Write(xsd_.ElementStartTag(type_id));
     if (value.empty()) {  // Special case to emit <TAGNAME/>
-      output_->put('/');
+      Write("/>", 2);
     } else {  // <TAGNAME>VALUE</TAGNAME>
-      output_->put('>');
+      Put('>');
       WriteQuoted(value);
-      output_->write("</", 2);
-      output_->write(tag_name.data(), tag_name.size());
+      Write(xsd_.ElementEndTag(type_id));
     }
-    output_->put('>');
     Newline();
+    MaybeFlush();
   }
 
   // Save out character data.
@@ -152,33 +231,50 @@ class XmlSerializer : public Serializer {
     if (maybe_quote) {
       WriteQuoted(content);
     } else {
-      output_->write(content.data(), content.size());
+      Write(content);
     }
+    MaybeFlush();
   }
 
   // Save a lon,lat,alt tuple as appears within <coordinates>.
   virtual void SaveVec3(const kmlbase::Vec3& vec3) {
     EmitStart(false);
+    if (compact_coordinates_) {
+      SaveCompactVec3(vec3);
+      return;
+    }
     Indent();
-    string val = kmlbase::ToString(vec3.get_longitude());
-    output_->write(val.data(), val.size());
-    output_->put(',');
-    val = kmlbase::ToString(vec3.get_latitude());
-    output_->write(val.data(), val.size());
+    // The tuple is formatted straight into the buffer.
+    Reserve(3 * kmlbase::kMaxDoubleLength + 2);
+    char* buf = buffer_ + buffer_size_;
+    char* end = buf + FormatCoordinate(vec3.get_longitude(), buf);
+    *end++ = ',';
+    end += FormatCoordinate(vec3.get_latitude(), end);
     // Ideally, we'd only emit if vec3.has_altitude(), but lots of test cases
     // expect lon,lat,0
-    output_->put(',');
-    val = kmlbase::ToString(vec3.get_altitude());
-    output_->write(val.data(), val.size());
+    *end++ = ',';
+    end += FormatCoordinate(vec3.get_altitude(), end);
+    buffer_size_ += end - buf;
     // In libkml 1.2 a "\n" was baked into Serializer::SaveVec3.  We emit an
     // explicit "\n" for compatibility instead of calling Newline() because
     // Newline() could be an empty string which would effectively concatenate
     // coordinates items in SerializeRaw.
     if (newline_.empty()) {
-      output_->write("\n", 1);
+      Put('\n');
     } else {
       Newline();
     }
+    MaybeFlush();
+  }
+
+  // Save the character data of unchanged <coordinates> as is, unless the
+  // tuples are to be written otherwise than as parsed.
+  virtual bool SaveCoordinatesText(const string& char_data) {
+    if (compact_coordinates_ || coordinate_precision_ >= 0) {
+      return false;
+    }
+    SaveContent(char_data, true);
+    return true;
   }
 
   // Save a Color32 value as its AABBGGRR representation.
@@ -187,46 +283,226 @@ class XmlSerializer : public Serializer {
     SaveFieldById(type_id, color.to_string_abgr());
   }
 
+  // The Features of the top-level Container are gathered here to be
+  // serialized concurrently.  See set_thread_count().
+  virtual void BeginElementGroupArray(int group_id, size_t element_count) {
+    collecting_features_ = thread_count_ > 1 && group_id == Type_Feature &&
+        element_count >= kMinParallelFeatures && depth_ == 0 &&
+        (tag_stack_.size() == 1 ||
+         (tag_stack_.size() == 2 && root_type_id_ == Type_kml));
+    if (collecting_features_) {
+      parallel_features_.reserve(element_count);
+    }
+  }
+
+  virtual void SaveElementGroup(const ElementPtr& element, int group_id) {
+    if (collecting_features_) {
+      parallel_features_.push_back(element);
+    } else {
+      Serializer::SaveElementGroup(element, group_id);
+    }
+  }
+
+  virtual void EndElementGroupArray(int group_id) {
+    if (collecting_features_) {
+      collecting_features_ = false;
+      SaveParallelFeatures();
+      parallel_features_.clear();
+    }
+  }
+
   // Emit one level of indentation.
   virtual void Indent() {
     if (!indent_.empty()) {
-      size_t depth = tag_stack_.size();
+      size_t depth = depth_ + tag_stack_.size();
       while (depth--) {
-        output_->write(indent_.data(), indent_.size());
+        Write(indent_);
       }
     }
   }
 
+  // This hands everything buffered to the output.
+  void Flush() {
+    if (buffer_size_) {
+      output_->write(buffer_, buffer_size_);
+      buffer_size_ = 0;
+    }
+  }
+
  private:
+  // The size of the buffer the output is gathered in.
+  static const size_t kBufferSize = 8192;
+
+  // This makes room for size bytes in the buffer.  The size must not exceed
+  // kBufferSize.
+  void Reserve(size_t size) {
+    if (buffer_size_ + size > kBufferSize) {
+      Flush();
+    }
+  }
+
+  void Write(const char* s, size_t n) {
+    if (buffer_size_ + n > kBufferSize) {
+      Flush();
+      if (n > kBufferSize) {
+        output_->write(s, n);
+        return;
+      }
+    }
+    memcpy(buffer_ + buffer_size_, s, n);
+    buffer_size_ += n;
+  }
+
+  void Write(const string& s) {
+    Write(s.data(), s.size());
+  }
+
+  void Put(char c) {
+    Reserve(1);
+    buffer_[buffer_size_++] = c;
+  }
+
+  // The output is flushed at the end of each root element.
+  void MaybeFlush() {
+    if (tag_stack_.empty()) {
+      Flush();
+    }
+  }
+
   // Emit a line break.
   void Newline() {
     if (!newline_.empty()) {
-      output_->write(newline_.data(), newline_.size());
+      Write(newline_);
     }
   }
 
-  // Emit quoted. See Serializer::MaybeQuoteString().
+  // Format one coordinate of a tuple.  See set_coordinate_precision().
+  size_t FormatCoordinate(double value, char* buf) const {
+    if (coordinate_precision_ < 0) {
+      return kmlbase::FormatDouble(value, buf);
+    }
+    return kmlbase::FormatDoubleFixed(value, coordinate_precision_, buf);
+  }
+
+  // The XmlSerializer of another output shares the settings of this one.
+  template<class U> friend class XmlSerializer;
+
+  // This serializes a run of the Features gathered by SaveElementGroup() to
+  // a string with the settings of the given XmlSerializer.
+  class FeatureRunnable : public kmlbase::Runnable {
+   public:
+    FeatureRunnable(const XmlSerializer& parent, size_t begin, size_t end)
+      : parent_(parent), begin_(begin), end_(end) {
+    }
+
+    virtual void Run() {
+      StringAdapter string_adapter(&xml_);
+      boost::scoped_ptr<XmlSerializer<StringAdapter> > serializer(
+          new XmlSerializer<StringAdapter>(parent_.newline_.c_str(),
+                                           parent_.indent_.c_str(),
+                                           &string_adapter));
+      serializer->CopySettings(parent_);
+      for (size_t i = begin_; i < end_; ++i) {
+        serializer->SaveElementGroup(parent_.parallel_features_[i],
+                                     Type_Feature);
+      }
+      serializer->Flush();
+    }
+
+    const string& xml() const {
+      return xml_;
+    }
+
+   private:
+    const XmlSerializer& parent_;
+    const size_t begin_;
+    const size_t end_;
+    string xml_;
+  };
+
+  // This takes the settings of the given XmlSerializer, and its depth for
+  // the indentation of each element serialized.
+  template<class U>
+  void CopySettings(const XmlSerializer<U>& other) {
+    coordinate_precision_ = other.coordinate_precision_;
+    compact_coordinates_ = other.compact_coordinates_;
+    strip_defaults_ = other.strip_defaults_;
+    update_depth_ = other.update_depth_;
+    depth_ = other.depth_ + other.tag_stack_.size();
+  }
+
+  // This serializes the Features gathered by SaveElementGroup() on up to
+  // thread_count_ threads.  A few runs of Features per thread even out the
+  // threads' work.  The runs are serialized in batches such that only so
+  // much of the output is held at once.
+  void SaveParallelFeatures() {
+    static const size_t kMaxRunFeatures = 1024;
+    const size_t count = parallel_features_.size();
+    const size_t batch_runs = thread_count_ * 4;
+    size_t run_features = count / batch_runs;
+    if (run_features == 0) {
+      run_features = 1;
+    } else if (run_features > kMaxRunFeatures) {
+      run_features = kMaxRunFeatures;
+    }
+    EmitStart(false);
+    for (size_t begin = 0; begin < count;) {
+      std::vector<kmlbase::Runnable*> runnables;
+      for (; begin < count && runnables.size() < batch_runs;
+           begin += run_features) {
+        const size_t end = std::min(begin + run_features, count);
+        runnables.push_back(new FeatureRunnable(*this, begin, end));
+      }
+      kmlbase::RunInParallel(runnables, thread_count_);
+      for (size_t i = 0; i < runnables.size(); ++i) {
+        Write(static_cast<FeatureRunnable*>(runnables[i])->xml());
+        delete runnables[i];
+      }
+    }
+  }
+
+  // Save a tuple as lon,lat[,alt] after a space if it is not the first.
+  void SaveCompactVec3(const kmlbase::Vec3& vec3) {
+    Reserve(3 * kmlbase::kMaxDoubleLength + 3);
+    char* buf = buffer_ + buffer_size_;
+    char* end = buf;
+    if (tuple_written_) {
+      *end++ = ' ';
+    }
+    end += FormatCoordinate(vec3.get_longitude(), end);
+    *end++ = ',';
+    end += FormatCoordinate(vec3.get_latitude(), end);
+    if (vec3.has_altitude()) {
+      *end++ = ',';
+      end += FormatCoordinate(vec3.get_altitude(), end);
+    }
+    buffer_size_ += end - buf;
+    tuple_written_ = true;
+  }
+
+  // Emit quoted. See Serializer::MaybeQuoteString().  The common cases are
+  // written here without a copy of the value.
   void WriteQuoted(const string& value) {
-    string quoted = MaybeQuoteString(value);
-    output_->write(quoted.data(), quoted.size());
+    if (value.find("<![CDATA[") != string::npos) {
+      Write(MaybeQuoteString(value));
+    } else if (value.find_first_of("&'<>\"") != string::npos) {
+      Write("<![CDATA[", 9);
+      Write(value);
+      Write("]]>", 3);
+    } else {
+      Write(value);
+    }
   }
 
+  // This closes the start tag written by BeginById().
   bool EmitStart(bool is_nil) {
     if (!start_pending_) {
       return false;
     }
-    output_->put('<');
-    const string& tag_name = xsd_.ElementName(tag_stack_.top());
-    output_->write(tag_name.data(), tag_name.size());
-    if (!serialized_attributes_.empty()) {
-      output_->write(serialized_attributes_.data(),
-                     serialized_attributes_.size());
-      serialized_attributes_.clear();
-    }
     if (is_nil) {
-      output_->write("/>", 2);
+      Write("/>", 2);
     } else {
-      output_->put('>');
+      Put('>');
     }
     Newline();
     start_pending_ = false;
@@ -238,7 +514,21 @@ class XmlSerializer : public Serializer {
   T* output_;
   std::stack<int> tag_stack_;
   bool start_pending_;
-  string serialized_attributes_;
+  int coordinate_precision_;
+  bool compact_coordinates_;
+  bool strip_defaults_;
+  // The number of open <Update> elements.
+  size_t update_depth_;
+  // True once a tuple of the current <coordinates> is written compactly.
+  bool tuple_written_;
+  size_t thread_count_;
+  // The depth of the element which this serializes within, if any.
+  size_t depth_;
+  int root_type_id_;
+  bool collecting_features_;
+  std::vector<ElementPtr> parallel_features_;
+  size_t buffer_size_;
+  char buffer_[kBufferSize];
 };
 
 }  // end namespace kmldom
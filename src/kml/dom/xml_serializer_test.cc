@@ -184,9 +184,29 @@ TEST_F(XmlSerializerTest, TestPrecision) {
   expected = "1.1";
   ASSERT_EQ(expected, ToString(b));
   double c = 1.2345678901234567890;
-  // Will round down to 15 decimals of precision:
-  expected = "1.23456789012346";
+  // Will keep as many digits as read back as the same double:
+  expected = "1.2345678901234567";
   ASSERT_EQ(expected, ToString(c));
+  double d = 0.1 + 0.2;
+  expected = "0.30000000000000004";
+  ASSERT_EQ(expected, ToString(d));
+}
+
+TEST_F(XmlSerializerTest, TestSaveVec3) {
+  xml_serializer_->SaveVec3(kmlbase::Vec3(-122.0841430, 37.4219720, 0.1 + 0.2));
+  ASSERT_EQ(string("-122.084143,37.421972,0.30000000000000004\n"), output_);
+}
+
+TEST_F(XmlSerializerTest, TestSetCoordinatePrecision) {
+  xml_serializer_->set_coordinate_precision(5);
+  xml_serializer_->SaveVec3(kmlbase::Vec3(-122.0841430, 37.4219720, 0.1 + 0.2));
+  xml_serializer_->set_coordinate_precision(0);
+  xml_serializer_->SaveVec3(kmlbase::Vec3(-122.0841430, 37.4219720));
+  xml_serializer_->set_coordinate_precision(-1);
+  xml_serializer_->SaveVec3(kmlbase::Vec3(-122.0841430, 37.4219720));
+  ASSERT_EQ(string("-122.08414,37.42197,0.3\n"
+                   "-122,37,0\n"
+                   "-122.084143,37.421972,0\n"), output_);
 }
 
 // Tests the internal Indent() method.
@@ -276,6 +296,135 @@ TEST_F(XmlSerializerTest, SerializeRawCoordinates) {
   ASSERT_EQ(want, SerializeRaw(placemark_));
 }
 
+// SerializeCompact() separates the tuples of <coordinates> by spaces and
+// writes no altitude which was not set.
+TEST_F(XmlSerializerTest, TestSerializeCompact) {
+  placemark_ = AsPlacemark(ParseKml(
+      "<Placemark>\n"
+      "  <name>a &amp; b</name>\n"
+      "  <Style><IconStyle><scale>1</scale></IconStyle></Style>\n"
+      "  <LineString>\n"
+      "    <extrude>0</extrude>\n"
+      "    <tessellate>1</tessellate>\n"
+      "    <altitudeMode>clampToGround</altitudeMode>\n"
+      "    <coordinates>1.23456789,3.4,5.6 9.8,-7.6</coordinates>\n"
+      "  </LineString>\n"
+      "</Placemark>"));
+  ASSERT_TRUE(placemark_);
+  CompactOptions options;
+  ASSERT_EQ(string(
+      "<Placemark>"
+      "<name><![CDATA[a & b]]></name>"
+      "<Style><IconStyle><scale>1</scale></IconStyle></Style>"
+      "<LineString>"
+      "<extrude>0</extrude>"
+      "<tessellate>1</tessellate>"
+      "<altitudeMode>clampToGround</altitudeMode>"
+      "<coordinates>1.23456789,3.4,5.6 9.8,-7.6</coordinates>"
+      "</LineString>"
+      "</Placemark>"), SerializeCompact(placemark_, options));
+
+  // The fields of the styles are kept at their defaults.
+  options.coordinate_precision = 2;
+  options.strip_defaults = true;
+  ASSERT_EQ(string(
+      "<Placemark>"
+      "<name><![CDATA[a & b]]></name>"
+      "<Style><IconStyle><scale>1</scale></IconStyle></Style>"
+      "<LineString>"
+      "<tessellate>1</tessellate>"
+      "<coordinates>1.23,3.4,5.6 9.8,-7.6</coordinates>"
+      "</LineString>"
+      "</Placemark>"), SerializeCompact(placemark_, options));
+
+  // An element left with nothing in it is closed in its start tag.
+  PointPtr point = KmlFactory::GetFactory()->CreatePoint();
+  point->set_extrude(false);
+  ASSERT_EQ(string("<Point><extrude>0</extrude></Point>"),
+            SerializeCompact(point, CompactOptions()));
+  ASSERT_EQ(string("<Point/>"), SerializeCompact(point, options));
+  ASSERT_EQ(string(""), SerializeCompact(NULL, options));
+
+  // Within an <Update> a field at its default value is a change and is kept.
+  const string kUpdate(
+      "<kml>"
+      "<NetworkLinkControl><Update><targetHref>a.kml</targetHref>"
+      "<Change><Placemark targetId=\"p\"><visibility>1</visibility>"
+      "</Placemark></Change>"
+      "<Create><Folder targetId=\"f\"><Placemark><open>0</open></Placemark>"
+      "</Folder></Create>"
+      "</Update></NetworkLinkControl>"
+      "<Document><open>0</open><visibility>1</visibility></Document>"
+      "</kml>");
+  ElementPtr kml = ParseKml(kUpdate);
+  ASSERT_TRUE(kml);
+  ASSERT_EQ(string(
+      "<kml>"
+      "<NetworkLinkControl><Update><targetHref>a.kml</targetHref>"
+      "<Change><Placemark targetId=\"p\"><visibility>1</visibility>"
+      "</Placemark></Change>"
+      "<Create><Folder targetId=\"f\"><Placemark><open>0</open></Placemark>"
+      "</Folder></Create>"
+      "</Update></NetworkLinkControl>"
+      "<Document/>"
+      "</kml>"), SerializeCompact(kml, options));
+}
+
+// SerializePrettyParallel() writes the same as SerializePretty().
+TEST_F(XmlSerializerTest, TestSerializePrettyParallel) {
+  KmlFactory* factory = KmlFactory::GetFactory();
+  FolderPtr folder = factory->CreateFolder();
+  folder->set_name("folder");
+  for (int i = 0; i < 100; ++i) {
+    PlacemarkPtr placemark = factory->CreatePlacemark();
+    placemark->set_id("p" + ToString(i));
+    placemark->set_name(i % 2 ? "a & b" : "name");
+    PointPtr point = factory->CreatePoint();
+    CoordinatesPtr coordinates = factory->CreateCoordinates();
+    coordinates->add_latlng(i * 0.1, 1.0 / (i + 1));
+    point->set_coordinates(coordinates);
+    placemark->set_geometry(point);
+    if (i % 10 == 0) {
+      FolderPtr nested = factory->CreateFolder();
+      nested->add_feature(placemark);
+      folder->add_feature(nested);
+    } else {
+      folder->add_feature(placemark);
+    }
+  }
+  DocumentPtr document = factory->CreateDocument();
+  document->add_styleselector(factory->CreateStyle());
+  document->add_feature(folder);
+  for (int i = 0; i < 20; ++i) {
+    document->add_feature(factory->CreatePlacemark());
+  }
+  document->add_schema(factory->CreateSchema());
+  KmlPtr kml = factory->CreateKml();
+  kml->set_feature(document);
+
+  // The Features of the <Document> of the <kml> are run in parallel, as are
+  // those of a root <Folder>.
+  const string expected = SerializePretty(kml);
+  ASSERT_EQ(expected, SerializePrettyParallel(kml, 4));
+  ASSERT_EQ(expected, SerializePrettyParallel(kml, 0));
+  ASSERT_EQ(SerializePretty(folder), SerializePrettyParallel(folder, 3));
+  ASSERT_EQ(SerializePretty(placemark_),
+            SerializePrettyParallel(placemark_, 2));
+  ASSERT_EQ(string(""), SerializePrettyParallel(NULL, 2));
+
+  // The other settings of the XmlSerializer apply to each thread.
+  xml_serializer_->set_coordinate_precision(2);
+  xml_serializer_->set_compact_coordinates(true);
+  xml_serializer_->SaveElement(kml);
+  xml_serializer_->Flush();
+  const string expected_compact = output_;
+  output_.clear();
+  xml_serializer_->set_thread_count(4);
+  xml_serializer_->SaveElement(kml);
+  xml_serializer_->Flush();
+  ASSERT_EQ(expected_compact, output_);
+}
+
 TEST_F(XmlSerializerTest, BasicSerializePrettyToOstream) {
   kmldom::CoordinatesPtr coordinates =
       kmldom::KmlFactory::GetFactory()->CreateCoordinates();
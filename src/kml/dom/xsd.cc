@@ -26,6 +26,8 @@
 // This file implements the internal Xsd class specifically for KML 2.2.
 
 #include "kml/dom/xsd.h"
+#include <string.h>  // For strlen(), strncmp().
+#include <algorithm>
 #include "kml/dom/kml22.h"
 #include "kml/dom/kml22.cc"
 
@@ -40,35 +42,196 @@ Xsd* Xsd::GetSchema() {
   return schema_;
 }
 
-Xsd::Xsd() {
-  for (int i = 0; i < Type_Invalid; ++i) {
-    tag_to_id[kKml22Elements[i].element_name_] = i;
+// The element names are hashed with 32-bit FNV-1a.  The basis is a
+// parameter so that another may be tried in the unlikely event that two
+// names hash to the same value.
+static const unsigned int kFnvBasis = 2166136261u;
+static const unsigned int kFnvPrime = 16777619u;
+
+static unsigned int HashName(const char* name, size_t name_len,
+                             unsigned int basis) {
+  unsigned int hash = basis;
+  for (size_t i = 0; i < name_len; ++i) {
+    hash ^= static_cast<unsigned char>(name[i]);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+// This is the murmur3 finalizer.  It scatters a name's hash differently for
+// each seed.
+static unsigned int MixHash(unsigned int hash, unsigned int seed) {
+  hash ^= seed * 0x9e3779b9u;
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+static size_t NextPowerOfTwo(size_t n) {
+  size_t power = 1;
+  while (power < n) {
+    power <<= 1;
+  }
+  return power;
+}
+
+Xsd::Xsd()
+  : element_names_(Type_Invalid),
+    element_start_tags_(Type_Invalid),
+    element_end_tags_(Type_Invalid),
+    element_defaults_(Type_Invalid),
+    string_elements_(Type_Invalid),
+    name_hash_basis_(kFnvBasis),
+    enum_values_(Type_Invalid) {
+  for (int i = 1; i < Type_Invalid; ++i) {
+    element_names_[i] = kKml22Elements[i].element_name_;
+  }
+  // This is the other side of the wart found in KmlHandler::StartElement.
+  // TODO: factor this and kKml22 out of Xsd.
+  element_names_[Type_IconStyleIcon] = "Icon";
+  for (int i = 1; i < Type_Invalid; ++i) {
+    element_start_tags_[i] = "<" + element_names_[i];
+    element_end_tags_[i] = "</" + element_names_[i] + ">";
+  }
+  const size_t default_count =
+      sizeof(kKml22Defaults)/sizeof(XsdElementDefault);
+  for (size_t i = 0; i < default_count; ++i) {
+    element_defaults_[kKml22Defaults[i].type_id] = kKml22Defaults[i].value;
+  }
+  const size_t string_count =
+      sizeof(kKml22StringElements)/sizeof(kKml22StringElements[0]);
+  for (size_t i = 0; i < string_count; ++i) {
+    string_elements_[kKml22StringElements[i]] = true;
+  }
+  while (!BuildNameHash(name_hash_basis_)) {
+    ++name_hash_basis_;
+  }
+  const size_t size = sizeof(kKml22Enums)/sizeof(XsdSimpleTypeEnum);
+  for (size_t i = 0; i < size; ++i) {
+    kmlbase::StringVector& values = enum_values_[kKml22Enums[i].type_id];
+    for (const char** enum_value_item = kKml22Enums[i].enum_value_list;
+         *enum_value_item;
+         ++enum_value_item) {
+      values.push_back(*enum_value_item);
+    }
+  }
+}
+
+// This is "hash and displace": names are grouped into buckets by their hash,
+// then the buckets with the most names are placed first, each with the first
+// seed which sends all of its names to free slots.
+bool Xsd::BuildNameHash(unsigned int basis) {
+  // Names are hashed as written in kKml22Elements, not as ElementName()
+  // returns them: ElementId("IconStyleIcon") is Type_IconStyleIcon.
+  std::vector<int> ids;
+  std::vector<unsigned int> hashes;
+  for (int i = 1; i < Type_Invalid; ++i) {
+    const char* name = kKml22Elements[i].element_name_;
+    ids.push_back(i);
+    hashes.push_back(HashName(name, strlen(name), basis));
+  }
+  // Two names with the same hash could never be separated by any seed.
+  std::vector<unsigned int> sorted_hashes(hashes);
+  std::sort(sorted_hashes.begin(), sorted_hashes.end());
+  if (std::adjacent_find(sorted_hashes.begin(), sorted_hashes.end()) !=
+      sorted_hashes.end()) {
+    return false;
+  }
+
+  const size_t bucket_count = NextPowerOfTwo(ids.size() / 2);
+  const size_t slot_count = NextPowerOfTwo(ids.size() * 2);
+  std::vector<std::vector<size_t> > buckets(bucket_count);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    buckets[hashes[i] & (bucket_count - 1)].push_back(i);
+  }
+  std::vector<std::pair<size_t, size_t> > bucket_order;
+  for (size_t b = 0; b < bucket_count; ++b) {
+    bucket_order.push_back(std::make_pair(buckets[b].size(), b));
+  }
+  std::sort(bucket_order.rbegin(), bucket_order.rend());
+
+  name_seeds_.assign(bucket_count, 0);
+  name_slots_.assign(slot_count, Type_Unknown);
+  const unsigned int kMaxSeed = 1 << 16;
+  for (size_t o = 0; o < bucket_order.size(); ++o) {
+    const std::vector<size_t>& bucket = buckets[bucket_order[o].second];
+    if (bucket.empty()) {
+      break;
+    }
+    unsigned int seed = 0;
+    std::vector<size_t> slots;
+    for (; seed < kMaxSeed; ++seed) {
+      slots.clear();
+      for (size_t k = 0; k < bucket.size(); ++k) {
+        size_t slot = MixHash(hashes[bucket[k]], seed) & (slot_count - 1);
+        if (name_slots_[slot] != Type_Unknown ||
+            std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+          break;
+        }
+        slots.push_back(slot);
+      }
+      if (slots.size() == bucket.size()) {
+        break;
+      }
+    }
+    if (seed == kMaxSeed) {
+      return false;
+    }
+    name_seeds_[bucket_order[o].second] = seed;
+    for (size_t k = 0; k < bucket.size(); ++k) {
+      name_slots_[slots[k]] = ids[bucket[k]];
+    }
   }
+  return true;
+}
+
+size_t Xsd::FindNameSlot(const char* name, size_t name_len) const {
+  unsigned int hash = HashName(name, name_len, name_hash_basis_);
+  unsigned int seed = name_seeds_[hash & (name_seeds_.size() - 1)];
+  return MixHash(hash, seed) & (name_slots_.size() - 1);
 }
 
-int Xsd::ElementId(const string& element_name) const {
-  tag_id_map_t::const_iterator iter = tag_to_id.find(element_name);
-  if (iter == tag_to_id.end()) {
-    return Type_Unknown;
+int Xsd::ElementId(const char* element_name, size_t name_len) const {
+  int id = name_slots_[FindNameSlot(element_name, name_len)];
+  // Any name hashes to some slot: verify this is the name found there.
+  if (id != Type_Unknown) {
+    const char* name = kKml22Elements[id].element_name_;
+    if (strncmp(name, element_name, name_len) == 0 &&
+        name[name_len] == '\0') {
+      return id;
+    }
   }
-  return iter->second;
+  return Type_Unknown;
 }
 
 static bool is_valid(int id) {
   return id > Type_Unknown && id < Type_Invalid;
 }
 
-string Xsd::ElementName(int id) const {
+static const string kEmptyString;
+
+const string& Xsd::ElementName(int id) const {
   if (!is_valid(id)) {
-    return string();
+    return kEmptyString;
   }
-  // This is the other side of the wart found in KmlHandler::StartElement.
-  // TODO: factor this and kKml22 out of Xsd.
-  if (id == Type_IconStyleIcon) {
-    return "Icon";
+  return element_names_[id];
+}
+
+const string& Xsd::ElementStartTag(int id) const {
+  if (!is_valid(id)) {
+    return kEmptyString;
   }
-  XsdElement element = kKml22Elements[id];
-  return element.element_name_;
+  return element_start_tags_[id];
+}
+
+const string& Xsd::ElementEndTag(int id) const {
+  if (!is_valid(id)) {
+    return kEmptyString;
+  }
+  return element_end_tags_[id];
 }
 
 XsdType Xsd::ElementType(int id) const {
@@ -79,18 +242,13 @@ XsdType Xsd::ElementType(int id) const {
   return element.xsd_type_;
 }
 
-int Xsd::EnumId(int type_id, string enum_value) const {
-  const int size = sizeof(kKml22Enums)/sizeof(XsdSimpleTypeEnum);
-  for (int i = 0; i < size; ++i) {
-    XsdSimpleTypeEnum* simple = kKml22Enums + i;
-    if (simple->type_id == type_id) {
-      for (const char** enum_value_item = simple->enum_value_list;
-           *enum_value_item;
-           ++enum_value_item) {
-        if (*enum_value_item == enum_value) {
-          // enum id is simple offset into enum_value_list;
-          return static_cast<int>(enum_value_item - simple->enum_value_list);
-        }
+int Xsd::EnumId(int type_id, const string& enum_value) const {
+  if (is_valid(type_id)) {
+    const kmlbase::StringVector& values = enum_values_[type_id];
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (values[i] == enum_value) {
+        // enum id is simple offset into enum_value_list;
+        return static_cast<int>(i);
       }
     }
   }
@@ -101,17 +259,15 @@ int Xsd::EnumId(int type_id, string enum_value) const {
   return -1;
 }
 
-string Xsd::EnumValue(int type_id, int enum_id) const {
-  if (enum_id < 0) {
-    return string();
+const string& Xsd::EnumValue(int type_id, int enum_id) const {
+  if (enum_id < 0 || !is_valid(type_id)) {
+    return kEmptyString;
   }
-  for (XsdSimpleTypeEnum* simple = kKml22Enums; simple; ++simple) {
-    if (simple->type_id == type_id) {
-      return simple->enum_value_list[enum_id];
-    }
+  const kmlbase::StringVector& values = enum_values_[type_id];
+  if (static_cast<size_t>(enum_id) >= values.size()) {
+    return kEmptyString;
   }
-  return string();
+  return values[enum_id];
 }
 
-
 }  // end namespace kmldom
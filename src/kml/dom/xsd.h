@@ -31,7 +31,8 @@
 #ifndef KML_XSD_XSD_H__
 #define KML_XSD_XSD_H__
 
-#include <map>
+#include <vector>
+#include "kml/base/string_util.h"
 #include "kml/base/util.h"
 
 namespace kmldom {
@@ -74,31 +75,89 @@ struct XsdSimpleTypeEnum {
   const char** enum_value_list;  // Value of value attribute.
 };
 
-typedef std::map<string,int> tag_id_map_t;
+// This represents the default value of a simple element, as in:
+//  <element name="extrude" type="boolean" default="0"/>
+// The value is written as the serializer writes it.
+struct XsdElementDefault {
+  int type_id;
+  const char* value;
+};
 
 // This a 0.1 C++ version of the information in the KML XSD.
 // At present it is just the list of elements.  Each element has a name,
 // libkml-specific id, and type info (simple vs complex).
+// Name to id lookup uses a minimal perfect hash over the element names which
+// is built once when the schema singleton is created.  Id to name and the
+// enumeration lookups are array indexed.  No lookup allocates.
 class Xsd {
  public:
   static Xsd* GetSchema();
 
   // Essentially the API to the global <element>'s
-  int ElementId(const string& name) const;
+  int ElementId(const string& name) const {
+    return ElementId(name.data(), name.size());
+  }
+  int ElementId(const char* name, size_t name_len) const;
   XsdType ElementType(int id) const;
-  string ElementName(int id) const;
+  // This returns a reference to the schema's own copy of the name.  An
+  // empty string is returned for an invalid id.
+  const string& ElementName(int id) const;
+  // These return the start tag without its closing ">", "<Placemark", and
+  // the end tag, "</Placemark>", of the element.  An empty string is
+  // returned for an invalid id.
+  const string& ElementStartTag(int id) const;
+  const string& ElementEndTag(int id) const;
+
+  // Returns true if the given value is the default of the given element.
+  // Only those elements whose default holds wherever they appear have one.
+  bool IsElementDefault(int id, const string& value) const {
+    return id > 0 && id < static_cast<int>(element_defaults_.size()) &&
+        element_defaults_[id] && value == element_defaults_[id];
+  }
+
+  // Returns true if an Element holds the value of the given simple element
+  // as a string, as for <name>, and false if it is held as a number, a bool,
+  // a color or an enumeration, as for <altitude>.
+  bool IsStringElement(int id) const {
+    return id > 0 && id < static_cast<int>(string_elements_.size()) &&
+        string_elements_[id];
+  }
 
   // Return the id of the given enum string for the given enum element.
-  int EnumId(int type_id, string enum_value) const;
+  int EnumId(int type_id, const string& enum_value) const;
   // Return the enum string for the given enum id for the given enum element.
-  string EnumValue(int type_id, int enum_id) const;
+  // An empty string is returned if either id is invalid.
+  const string& EnumValue(int type_id, int enum_id) const;
 
  private:
   Xsd();
   static Xsd* schema_;
 
-  tag_id_map_t tag_to_id;
-  std::map<int,XsdElement> id_to_string;
+  // Builds the perfect hash over the element names.  Returns false if the
+  // given hash basis does not separate all names.
+  bool BuildNameHash(unsigned int basis);
+  // Returns the slot in name_slots_ for the given name.
+  size_t FindNameSlot(const char* name, size_t name_len) const;
+
+  // The name of each element indexed by element id.
+  std::vector<string> element_names_;
+  // The start and end tags of each element indexed by element id.
+  std::vector<string> element_start_tags_;
+  std::vector<string> element_end_tags_;
+  // The default value of each element indexed by element id, or NULL.
+  std::vector<const char*> element_defaults_;
+  // Whether the value of each element is held as a string, indexed by
+  // element id.
+  std::vector<bool> string_elements_;
+  // The name hash is two level.  The first level hash of a name selects a
+  // seed in name_seeds_.  The name's hash mixed with that seed selects its
+  // slot in name_slots_ which holds the element id (or Type_Unknown).
+  unsigned int name_hash_basis_;
+  std::vector<unsigned int> name_seeds_;
+  std::vector<int> name_slots_;
+  // The values of each enumerated element indexed by element id.  This is
+  // empty for elements which are not enumerations.
+  std::vector<kmlbase::StringVector> enum_values_;
 };
 
 }  // end namespace kmldom
@@ -98,6 +98,76 @@ TEST_F(XsdTest, TestGoodElement) {
             Xsd::GetSchema()->ElementName(Type_GxPlayMode));
 }
 
+// Verify that every element name maps back to its own id.
+TEST_F(XsdTest, TestAllElementNames) {
+  const Xsd* xsd = Xsd::GetSchema();
+  for (int id = Type_Unknown + 1; id < Type_Invalid; ++id) {
+    const string& name = xsd->ElementName(id);
+    ASSERT_FALSE(name.empty());
+    if (id == Type_IconStyleIcon) {
+      // <Icon> in <IconStyle> is special-cased in KmlHandler.
+      ASSERT_EQ(static_cast<int>(Type_Icon), xsd->ElementId(name));
+      continue;
+    }
+    ASSERT_EQ(id, xsd->ElementId(name)) << name;
+    ASSERT_EQ(id, xsd->ElementId(name.data(), name.size())) << name;
+  }
+  // The reserved name in the slot for Type_Unknown is not an element name.
+  ASSERT_EQ(static_cast<int>(Type_Unknown), xsd->ElementId("<Unknown>"));
+}
+
+// Verify the start and end tags of each element.
+TEST_F(XsdTest, TestElementTags) {
+  const Xsd* xsd = Xsd::GetSchema();
+  ASSERT_EQ(string("<Placemark"), xsd->ElementStartTag(Type_Placemark));
+  ASSERT_EQ(string("</Placemark>"), xsd->ElementEndTag(Type_Placemark));
+  ASSERT_EQ(string("<Icon"), xsd->ElementStartTag(Type_IconStyleIcon));
+  ASSERT_EQ(string("</gx:Tour>"), xsd->ElementEndTag(Type_GxTour));
+  ASSERT_EQ(string(""), xsd->ElementStartTag(0));
+  ASSERT_EQ(string(""), xsd->ElementEndTag(Type_Invalid + 1));
+}
+
+// Verify the default values of elements.
+TEST_F(XsdTest, TestElementDefaults) {
+  const Xsd* xsd = Xsd::GetSchema();
+  ASSERT_TRUE(xsd->IsElementDefault(Type_extrude, "0"));
+  ASSERT_FALSE(xsd->IsElementDefault(Type_extrude, "1"));
+  ASSERT_TRUE(xsd->IsElementDefault(Type_altitudeMode, "clampToGround"));
+  ASSERT_TRUE(xsd->IsElementDefault(Type_maxLodPixels, "-1"));
+  ASSERT_FALSE(xsd->IsElementDefault(Type_name, ""));
+  ASSERT_FALSE(xsd->IsElementDefault(Type_scale, "1"));
+  ASSERT_FALSE(xsd->IsElementDefault(0, "0"));
+  ASSERT_FALSE(xsd->IsElementDefault(Type_Invalid + 1, "0"));
+}
+
+// Verify which elements hold their value as a string.
+TEST_F(XsdTest, TestStringElements) {
+  const Xsd* xsd = Xsd::GetSchema();
+  ASSERT_TRUE(xsd->IsStringElement(Type_name));
+  ASSERT_TRUE(xsd->IsStringElement(Type_when));
+  ASSERT_TRUE(xsd->IsStringElement(Type_GxValue));
+  ASSERT_FALSE(xsd->IsStringElement(Type_altitude));
+  ASSERT_FALSE(xsd->IsStringElement(Type_visibility));
+  ASSERT_FALSE(xsd->IsStringElement(Type_altitudeMode));
+  ASSERT_FALSE(xsd->IsStringElement(Type_color));
+  ASSERT_FALSE(xsd->IsStringElement(Type_Placemark));
+  ASSERT_FALSE(xsd->IsStringElement(0));
+  ASSERT_FALSE(xsd->IsStringElement(Type_Invalid + 1));
+}
+
+// Verify that names which are a prefix, extension or near miss of a known
+// name are not found.
+TEST_F(XsdTest, TestNearMissElement) {
+  const Xsd* xsd = Xsd::GetSchema();
+  ASSERT_EQ(static_cast<int>(Type_Unknown), xsd->ElementId("Placemar"));
+  ASSERT_EQ(static_cast<int>(Type_Unknown), xsd->ElementId("Placemarks"));
+  ASSERT_EQ(static_cast<int>(Type_Unknown), xsd->ElementId("placemark"));
+  ASSERT_EQ(static_cast<int>(Type_Unknown), xsd->ElementId("gx:"));
+  // The length is respected for names which are not NUL terminated.
+  ASSERT_EQ(static_cast<int>(Type_Point), xsd->ElementId("Pointless", 5));
+  ASSERT_EQ(static_cast<int>(Type_Unknown), xsd->ElementId("Point", 4));
+}
+
 // Verify that ElementId(), ElementType() and ElementName() are well
 // behaved given bad values.
 TEST_F(XsdTest, TestBadElement) {
@@ -136,6 +206,24 @@ TEST_F(XsdTest, TestBadEnumValue) {
   ASSERT_EQ(string(), Xsd::GetSchema()->EnumValue(0, -1));
 }
 
+// Verify EnumId() and EnumValue() for every value of a multi-valued enum.
+TEST_F(XsdTest, TestAllEnumValues) {
+  const Xsd* xsd = Xsd::GetSchema();
+  const char* kStates[] = {
+    "open", "closed", "error", "fetching0", "fetching1", "fetching2"
+  };
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_EQ(i, xsd->EnumId(Type_state, kStates[i]));
+    ASSERT_EQ(string(kStates[i]), xsd->EnumValue(Type_state, i));
+  }
+  // Out of range enum ids and non-enum elements have no value.
+  ASSERT_EQ(string(), xsd->EnumValue(Type_state, 6));
+  ASSERT_EQ(string(), xsd->EnumValue(Type_name, 0));
+  ASSERT_EQ(string(), xsd->EnumValue(Type_Invalid, 0));
+  ASSERT_EQ(-1, xsd->EnumId(Type_name, "open"));
+  ASSERT_EQ(-1, xsd->EnumId(Type_Invalid, "open"));
+}
+
 // Verify that EnumId() is well behaved for an enum value known to be ugly.
 TEST_F(XsdTest, TestUglyEnum) {
   ASSERT_EQ(-1, Xsd::GetSchema()->EnumId(Type_state, ""));
@@ -30,6 +30,7 @@
 #define KML_ENGINE_H__
 
 #include "kml/engine/bbox.h"
+#include "kml/engine/binary_snapshot.h"
 #include "kml/engine/clone.h"
 #include "kml/engine/engine_types.h"
 #include "kml/engine/entity_mapper.h"
@@ -42,12 +43,14 @@
 #include "kml/engine/href.h"
 #include "kml/engine/id_mapper.h"
 #include "kml/engine/kml_cache.h"
+#include "kml/engine/kml_feature_reader.h"
 #include "kml/engine/kml_file.h"
 #include "kml/engine/kml_stream.h"
 #include "kml/engine/kml_uri.h"
 #include "kml/engine/kmz_file.h"
 #include "kml/engine/link_util.h"
 #include "kml/engine/location_util.h"
+#include "kml/engine/memory_usage.h"
 #include "kml/engine/merge.h"
 #include "kml/engine/object_id_parser_observer.h"
 #include "kml/engine/shared_style_parser_observer.h"
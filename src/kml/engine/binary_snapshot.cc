@@ -0,0 +1,661 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of the SaveBinary() and LoadBinary()
+// functions.
+//
+// A snapshot is a header followed by the records of the Serializer calls
+// made by the Element hierarchy, each a one byte tag and its operands.
+// Integers are unsigned LEB128 varints, signed ones zigzag encoded.  A string
+// operand is a varint n: 0 is followed by the length and bytes of a string
+// not seen before, n > 0 is the n-th string which was.  Only strings up to
+// kMaxTableString bytes go in the table such that long unique strings cost
+// no lookup.
+
+#include "kml/engine/binary_snapshot.h"
+#include <string.h>
+#include <deque>
+#include <map>
+#include <vector>
+#include "boost/scoped_ptr.hpp"
+#include "kml/base/attributes.h"
+#include "kml/base/color32.h"
+#include "kml/base/vec3.h"
+#include "kml/dom/serializer.h"
+#include "kml/dom/xsd.h"
+#include "kml/engine/clone_internal.h"
+
+using kmlbase::Attributes;
+using kmlbase::Vec3;
+using kmldom::ElementPtr;
+using kmldom::KmlDomType;
+
+namespace kmlengine {
+
+// Private.  The header of a snapshot is the magic, the version and the
+// fingerprint of the schema, see GetSchemaFingerprint().
+static const char kMagic[] = "KMLB";
+static const size_t kMagicSize = 4;
+static const unsigned char kVersion = 1;
+static const size_t kHeaderSize = kMagicSize + 1 + 4;
+
+// Private.  The maximum nesting depth of the complex elements of a snapshot
+// LoadBinary() permits, as in the parser.  Override it with a
+// -DLIBKML_MAX_NESTING_DEPTH preprocessor instruction.
+#ifdef LIBKML_MAX_NESTING_DEPTH
+static const size_t kMaxNestingDepth = LIBKML_MAX_NESTING_DEPTH;
+#else
+static const size_t kMaxNestingDepth = 100;
+#endif
+
+// Private.  The tags of the records.
+enum RecordTag {
+  kBeginTag = 1,  // type id, attribute count, name and value strings
+  kEndTag,        // none
+  kFieldTag,      // type id, value string
+  kContentTag,    // string
+  kUnknownTag,    // string: the XML of an unknown element
+  kColorTag,      // type id, 4 bytes of AABBGGRR little endian
+  kTuplesTag      // see SaveTuples()
+};
+
+// Private.  The encodings of the tuples of a <coordinates>.
+enum TuplesEncoding {
+  kRawDoubles = 0,  // 8 bytes each, little endian
+  kDeltaVarints     // zigzag varint deltas in units of kDeltaScale
+};
+static const double kDeltaScale = 1e7;
+// A value this large or larger is written as a double.
+static const double kMaxDeltaValue = 1e8;
+// The bound of each value in units of kDeltaScale.
+static const double kMaxDeltaUnits = kMaxDeltaValue * kDeltaScale;
+
+// Private.  Which tuples of a <coordinates> have an altitude.
+enum AltitudePresence {
+  kNoAltitudes = 0,
+  kAllAltitudes,
+  kSomeAltitudes  // followed by a bitmap, one bit per tuple
+};
+
+// Private.
+static const size_t kMaxTableString = 64;
+
+// Private.  A snapshot to an ostream is written in blocks of this size.
+static const size_t kStreamBlockSize = 64 * 1024;
+
+// Private.  This returns the FNV-1a hash of the name and XsdType of each
+// KmlDomType id.  A snapshot records the ids of this build's schema so a
+// build whose ids differ in any way rejects it.
+static uint32_t ComputeSchemaFingerprint() {
+  const kmldom::Xsd* xsd = kmldom::Xsd::GetSchema();
+  uint32_t hash = 2166136261u;
+  for (int id = 0; id <= kmldom::Type_Invalid; ++id) {
+    string entry(xsd->ElementName(id));
+    entry.push_back('\0');
+    entry.push_back(static_cast<char>(xsd->ElementType(id)));
+    for (size_t i = 0; i < entry.size(); ++i) {
+      hash = (hash ^ static_cast<unsigned char>(entry[i])) * 16777619u;
+    }
+  }
+  return hash;
+}
+
+// Private.
+static uint32_t GetSchemaFingerprint() {
+  static const uint32_t fingerprint = ComputeSchemaFingerprint();
+  return fingerprint;
+}
+
+// Private.  This returns true if the value is an exact multiple of
+// 1 / kDeltaScale, bit for bit, and puts that multiple in units.
+static bool ToDeltaUnits(double value, int64_t* units) {
+  if (!(value > -kMaxDeltaValue && value < kMaxDeltaValue)) {
+    return false;  // Too large, infinite or NaN.
+  }
+  const double scaled = value * kDeltaScale;
+  const int64_t rounded =
+      static_cast<int64_t>(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+  // The quotient of two exact doubles is correctly rounded.  This is what
+  // LoadBinary() computes.  -0 does not survive, as intended.
+  const double back = static_cast<double>(rounded) / kDeltaScale;
+  if (memcmp(&back, &value, sizeof(double)) != 0) {
+    return false;
+  }
+  *units = rounded;
+  return true;
+}
+
+// Private.  This returns the i-th coordinate of the tuple.
+static double GetCoordinate(const Vec3& vec3, int i) {
+  return i == 0 ? vec3.get_longitude() :
+         i == 1 ? vec3.get_latitude() : vec3.get_altitude();
+}
+
+// This Serializer writes the records of each call made to it.
+class BinarySerializer : public kmldom::Serializer {
+ public:
+  BinarySerializer(string* output, std::ostream* stream)
+    : output_(output),
+      stream_(stream),
+      in_unknown_(false),
+      in_coordinates_(false) {
+    output_->append(kMagic, kMagicSize);
+    output_->push_back(static_cast<char>(kVersion));
+    const uint32_t fingerprint = GetSchemaFingerprint();
+    for (int i = 0; i < 4; ++i) {
+      output_->push_back(static_cast<char>((fingerprint >> (8 * i)) & 0xff));
+    }
+  }
+
+  virtual void BeginById(int type_id, const Attributes& attributes) {
+    PutTag(kBeginTag);
+    PutVarint(type_id);
+    PutVarint(attributes.GetSize());
+    kmlbase::StringMapIterator iter = attributes.CreateIterator();
+    for (; !iter.AtEnd(); iter.Advance()) {
+      PutString(iter.Data().first);
+      PutString(iter.Data().second);
+    }
+  }
+
+  virtual void End() {
+    PutTag(kEndTag);
+    MaybeFlush();
+  }
+
+  virtual void SaveStringFieldById(int type_id, string value) {
+    PutTag(kFieldTag);
+    PutVarint(type_id);
+    PutString(value);
+  }
+
+  virtual void SaveContent(const string& content, bool maybe_quote) {
+    PutTag(in_unknown_ ? kUnknownTag : kContentTag);
+    PutString(content);
+  }
+
+  virtual void SaveColor(int type_id, const kmlbase::Color32& color) {
+    PutTag(kColorTag);
+    PutVarint(type_id);
+    const uint32_t abgr = color.get_color_abgr();
+    for (int i = 0; i < 4; ++i) {
+      output_->push_back(static_cast<char>((abgr >> (8 * i)) & 0xff));
+    }
+  }
+
+  virtual void BeginElementArray(int type_id, size_t element_count) {
+    if (type_id == kmldom::Type_Unknown) {
+      in_unknown_ = true;
+    } else if (type_id == kmldom::Type_coordinates) {
+      in_coordinates_ = true;
+      tuples_.clear();
+      tuples_.reserve(element_count);
+    }
+  }
+
+  virtual void EndElementArray(int type_id) {
+    if (type_id == kmldom::Type_Unknown) {
+      in_unknown_ = false;
+    } else if (type_id == kmldom::Type_coordinates) {
+      in_coordinates_ = false;
+      SaveTuples();
+    }
+  }
+
+  virtual void SaveVec3(const Vec3& vec3) {
+    if (in_coordinates_) {
+      tuples_.push_back(vec3);
+    }
+  }
+
+  // This hands anything not yet written to the stream.
+  void Flush() {
+    if (stream_ && !output_->empty()) {
+      stream_->write(output_->data(), output_->size());
+      output_->clear();
+    }
+  }
+
+ private:
+  void MaybeFlush() {
+    if (output_->size() >= kStreamBlockSize) {
+      Flush();
+    }
+  }
+
+  void PutTag(RecordTag tag) {
+    output_->push_back(static_cast<char>(tag));
+  }
+
+  void PutVarint(uint64_t value) {
+    while (value >= 0x80) {
+      output_->push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    output_->push_back(static_cast<char>(value));
+  }
+
+  void PutSignedVarint(int64_t value) {
+    PutVarint((static_cast<uint64_t>(value) << 1) ^
+              static_cast<uint64_t>(value >> 63));
+  }
+
+  void PutDouble(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; ++i) {
+      output_->push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+    }
+  }
+
+  void PutString(const string& value) {
+    if (value.size() <= kMaxTableString) {
+      std::map<string, size_t>::const_iterator find = string_table_.find(value);
+      if (find != string_table_.end()) {
+        PutVarint(find->second);
+        return;
+      }
+      const size_t index = string_table_.size() + 1;
+      string_table_[value] = index;
+    }
+    PutVarint(0);
+    PutVarint(value.size());
+    output_->append(value);
+  }
+
+  // The tuples are written as their count, their AltitudePresence and their
+  // TuplesEncoding.  Deltas are taken of each of the three coordinates from
+  // the same coordinate of the previous tuple which has one.  The first is
+  // taken from 0.
+  void SaveTuples() {
+    PutTag(kTuplesTag);
+    PutVarint(tuples_.size());
+    size_t altitude_count = 0;
+    bool deltas = true;
+    int64_t units;
+    for (size_t i = 0; i < tuples_.size(); ++i) {
+      const Vec3& vec3 = tuples_[i];
+      deltas = deltas && ToDeltaUnits(vec3.get_longitude(), &units) &&
+          ToDeltaUnits(vec3.get_latitude(), &units);
+      if (vec3.has_altitude()) {
+        ++altitude_count;
+        deltas = deltas && ToDeltaUnits(vec3.get_altitude(), &units);
+      }
+    }
+    if (altitude_count == 0) {
+      output_->push_back(static_cast<char>(kNoAltitudes));
+    } else if (altitude_count == tuples_.size()) {
+      output_->push_back(static_cast<char>(kAllAltitudes));
+    } else {
+      output_->push_back(static_cast<char>(kSomeAltitudes));
+      for (size_t i = 0; i < tuples_.size(); i += 8) {
+        unsigned char bits = 0;
+        for (size_t j = i; j < i + 8 && j < tuples_.size(); ++j) {
+          if (tuples_[j].has_altitude()) {
+            bits |= static_cast<unsigned char>(1 << (j - i));
+          }
+        }
+        output_->push_back(static_cast<char>(bits));
+      }
+    }
+    output_->push_back(static_cast<char>(deltas ? kDeltaVarints :
+                                                  kRawDoubles));
+    int64_t previous[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < tuples_.size(); ++i) {
+      const Vec3& vec3 = tuples_[i];
+      const int coordinate_count = vec3.has_altitude() ? 3 : 2;
+      for (int c = 0; c < coordinate_count; ++c) {
+        if (deltas) {
+          ToDeltaUnits(GetCoordinate(vec3, c), &units);
+          PutSignedVarint(units - previous[c]);
+          previous[c] = units;
+        } else {
+          PutDouble(GetCoordinate(vec3, c));
+        }
+      }
+    }
+  }
+
+  string* output_;
+  std::ostream* stream_;
+  bool in_unknown_;
+  bool in_coordinates_;
+  std::vector<Vec3> tuples_;
+  std::map<string, size_t> string_table_;
+};
+
+bool SaveBinary(const ElementPtr& element, string* output) {
+  if (!element || !output) {
+    return false;
+  }
+  BinarySerializer serializer(output, NULL);
+  serializer.SaveElement(element);
+  return true;
+}
+
+bool SaveBinary(const ElementPtr& element, std::ostream* output) {
+  if (!element || !output) {
+    return false;
+  }
+  string buffer;
+  BinarySerializer serializer(&buffer, output);
+  serializer.SaveElement(element);
+  serializer.Flush();
+  return output->good();
+}
+
+// This reads the records of a snapshot and replays each as the call to the
+// ElementReplicator which Clone() would have made.  Each read checks that it
+// stays within the data.
+class BinaryLoader {
+ public:
+  BinaryLoader(const char* data, size_t size)
+    : data_(reinterpret_cast<const unsigned char*>(data)),
+      end_(data_ + size),
+      creatable_(kmldom::Type_Invalid, kUnchecked) {
+  }
+
+  ElementPtr Load() {
+    if (end_ - data_ < static_cast<ptrdiff_t>(kHeaderSize) ||
+        memcmp(data_, kMagic, kMagicSize) != 0 ||
+        data_[kMagicSize] != kVersion) {
+      return NULL;
+    }
+    uint32_t fingerprint = 0;
+    for (int i = 0; i < 4; ++i) {
+      fingerprint |= static_cast<uint32_t>(data_[kMagicSize + 1 + i]) <<
+          (8 * i);
+    }
+    if (fingerprint != GetSchemaFingerprint()) {
+      return NULL;
+    }
+    data_ += kHeaderSize;
+    do {
+      if (data_ == end_ || !LoadRecord()) {
+        return NULL;
+      }
+    } while (!open_types_.empty());
+    // A snapshot is one root element.
+    return data_ == end_ ? replicator_.root() : NULL;
+  }
+
+ private:
+  enum Creatable {
+    kUnchecked,
+    kYes,
+    kNo
+  };
+
+  // This reads the record at data_ and replays it within the innermost of
+  // the open elements.
+  bool LoadRecord() {
+    const unsigned char tag = *data_++;
+    uint64_t type_id = 0;
+    const string* value;
+    if (tag != kBeginTag && open_types_.empty()) {
+      return false;  // Only an element may be at the root.
+    }
+    switch (tag) {
+      case kBeginTag:
+        // Deeper nesting is rejected as in the parser.
+        return open_types_.size() < kMaxNestingDepth && LoadBegin();
+      case kEndTag:
+        replicator_.End();
+        open_types_.pop_back();
+        return true;
+      case kFieldTag:
+        if (!GetTypeId(kmldom::XSD_SIMPLE_TYPE, &type_id) ||
+            !GetString(&value)) {
+          return false;
+        }
+        replicator_.SaveStringFieldById(static_cast<int>(type_id), *value);
+        return true;
+      case kContentTag:
+        // The writer saves the content only of those elements which parse
+        // it.  Any other element would be made a child of itself.
+        if (!ElementReplicator::ParsesCharData(open_types_.back()) ||
+            !GetString(&value)) {
+          return false;
+        }
+        replicator_.SaveContent(*value, false);
+        return true;
+      case kUnknownTag:
+        if (!GetString(&value)) {
+          return false;
+        }
+        replicator_.BeginElementArray(kmldom::Type_Unknown, 1);
+        replicator_.SaveContent(*value, false);
+        replicator_.EndElementArray(kmldom::Type_Unknown);
+        return true;
+      case kColorTag:
+        return LoadColor();
+      case kTuplesTag:
+        return open_types_.back() == kmldom::Type_coordinates &&
+            LoadTuples();
+      default:
+        return false;
+    }
+  }
+
+  bool LoadBegin() {
+    uint64_t type_id;
+    uint64_t attribute_count;
+    if (!GetTypeId(kmldom::XSD_COMPLEX_TYPE, &type_id) ||
+        !IsCreatable(static_cast<int>(type_id)) ||
+        !GetVarint(&attribute_count) ||
+        attribute_count > static_cast<uint64_t>(end_ - data_)) {
+      return false;
+    }
+    kmlbase::StringVector attributes;
+    attributes.reserve(attribute_count * 2);
+    for (uint64_t i = 0; i < attribute_count * 2; ++i) {
+      const string* value;
+      if (!GetString(&value)) {
+        return false;
+      }
+      attributes.push_back(*value);
+    }
+    boost::scoped_ptr<Attributes> parsed(Attributes::Create(attributes));
+    replicator_.BeginById(static_cast<int>(type_id), *parsed);
+    open_types_.push_back(static_cast<int>(type_id));
+    return true;
+  }
+
+  bool LoadColor() {
+    uint64_t type_id;
+    if (!GetTypeId(kmldom::XSD_SIMPLE_TYPE, &type_id) || end_ - data_ < 4) {
+      return false;
+    }
+    uint32_t abgr = 0;
+    for (int i = 0; i < 4; ++i) {
+      abgr |= static_cast<uint32_t>(*data_++) << (8 * i);
+    }
+    replicator_.SaveColor(static_cast<int>(type_id), kmlbase::Color32(abgr));
+    return true;
+  }
+
+  bool LoadTuples() {
+    uint64_t count;
+    // Each tuple takes at least 2 bytes.
+    if (!GetVarint(&count) || count > static_cast<uint64_t>(end_ - data_) ||
+        end_ - data_ < 2) {
+      return false;
+    }
+    const unsigned char presence = *data_++;
+    const unsigned char* bitmap = data_;
+    if (presence == kSomeAltitudes) {
+      const size_t bitmap_size = static_cast<size_t>((count + 7) / 8);
+      if (static_cast<size_t>(end_ - data_) < bitmap_size + 1) {
+        return false;
+      }
+      data_ += bitmap_size;
+    } else if (presence != kNoAltitudes && presence != kAllAltitudes) {
+      return false;
+    }
+    const unsigned char encoding = *data_++;
+    if (encoding != kRawDoubles && encoding != kDeltaVarints) {
+      return false;
+    }
+    int64_t previous[3] = { 0, 0, 0 };
+    for (uint64_t i = 0; i < count; ++i) {
+      const bool has_altitude = presence == kAllAltitudes ||
+          (presence == kSomeAltitudes && (bitmap[i / 8] >> (i % 8)) & 1);
+      double coordinates[3];
+      for (int c = 0; c < (has_altitude ? 3 : 2); ++c) {
+        if (encoding == kRawDoubles) {
+          if (!GetDouble(&coordinates[c])) {
+            return false;
+          }
+        } else {
+          int64_t delta;
+          // Each value the writer puts in units is below kMaxDeltaValue,
+          // so a larger delta or sum is corrupt.  This also keeps the sum
+          // from overflowing.
+          if (!GetSignedVarint(&delta) ||
+              !(static_cast<double>(delta) > -2 * kMaxDeltaUnits &&
+                static_cast<double>(delta) < 2 * kMaxDeltaUnits)) {
+            return false;
+          }
+          previous[c] += delta;
+          if (!(static_cast<double>(previous[c]) > -kMaxDeltaUnits &&
+                static_cast<double>(previous[c]) < kMaxDeltaUnits)) {
+            return false;
+          }
+          coordinates[c] = static_cast<double>(previous[c]) / kDeltaScale;
+        }
+      }
+      replicator_.SaveVec3(has_altitude ?
+          Vec3(coordinates[0], coordinates[1], coordinates[2]) :
+          Vec3(coordinates[0], coordinates[1]));
+    }
+    return true;
+  }
+
+  // Only the complex elements the KmlFactory creates may be begun.
+  bool IsCreatable(int type_id) {
+    if (creatable_[type_id] == kUnchecked) {
+      creatable_[type_id] = kmldom::KmlFactory::GetFactory()->
+          CreateElementById(static_cast<KmlDomType>(type_id)) ? kYes : kNo;
+    }
+    return creatable_[type_id] == kYes;
+  }
+
+  bool GetVarint(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && data_ != end_; shift += 7) {
+      const unsigned char byte = *data_++;
+      *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool GetSignedVarint(int64_t* value) {
+    uint64_t zigzag;
+    if (!GetVarint(&zigzag)) {
+      return false;
+    }
+    *value = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(
+        zigzag & 1);
+    return true;
+  }
+
+  // A field may only be of a simple type and an element of a complex type.
+  // The DOM casts by type id such that a field of the id of a complex
+  // element would be taken for one.
+  bool GetTypeId(kmldom::XsdType xsd_type, uint64_t* type_id) {
+    return GetVarint(type_id) && *type_id > kmldom::Type_Unknown &&
+        *type_id < kmldom::Type_Invalid &&
+        kmldom::Xsd::GetSchema()->ElementType(static_cast<int>(*type_id)) ==
+            xsd_type;
+  }
+
+  bool GetDouble(double* value) {
+    if (end_ - data_ < 8) {
+      return false;
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) {
+      bits |= static_cast<uint64_t>(*data_++) << (8 * i);
+    }
+    memcpy(value, &bits, sizeof(bits));
+    return true;
+  }
+
+  // This points value at the string read, which lives as long as this.
+  bool GetString(const string** value) {
+    uint64_t index;
+    if (!GetVarint(&index)) {
+      return false;
+    }
+    if (index > 0) {
+      if (index > string_table_.size()) {
+        return false;
+      }
+      *value = &string_table_[index - 1];
+      return true;
+    }
+    uint64_t size;
+    if (!GetVarint(&size) || size > static_cast<uint64_t>(end_ - data_)) {
+      return false;
+    }
+    const char* bytes = reinterpret_cast<const char*>(data_);
+    data_ += size;
+    if (size <= kMaxTableString) {
+      string_table_.push_back(string(bytes, size));
+      *value = &string_table_.back();
+    } else {
+      long_string_.assign(bytes, size);
+      *value = &long_string_;
+    }
+    return true;
+  }
+
+  const unsigned char* data_;
+  const unsigned char* const end_;
+  // The table is a deque as its strings must not move.
+  std::deque<string> string_table_;
+  string long_string_;
+  std::vector<Creatable> creatable_;
+  // The type ids of the elements begun and not yet ended, outermost first.
+  std::vector<int> open_types_;
+  ElementReplicator replicator_;
+};
+
+ElementPtr LoadBinary(const char* data, size_t size) {
+  if (!data) {
+    return NULL;
+  }
+  BinaryLoader binary_loader(data, size);
+  return binary_loader.Load();
+}
+
+ElementPtr LoadBinary(const string& data) {
+  return LoadBinary(data.data(), data.size());
+}
+
+}  // end namespace kmlengine
@@ -0,0 +1,65 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of the SaveBinary() and LoadBinary()
+// functions which write and read a binary snapshot of an Element hierarchy.
+
+#ifndef KML_ENGINE_BINARY_SNAPSHOT_H__
+#define KML_ENGINE_BINARY_SNAPSHOT_H__
+
+#include <ostream>
+#include "kml/dom.h"
+
+namespace kmlengine {
+
+// A binary snapshot holds everything the XML serialization of the Element
+// hierarchy would: each element by its KmlDomType id, each field as its
+// character data, the attributes of each element including xmlns, and the
+// unknown and misplaced elements.  Each distinct string is written once and
+// referred to by number thereafter.  The tuples of <coordinates> are written
+// as doubles, or as varint deltas in units of 1e-7 degrees where that reads
+// back exactly.  LoadBinary() builds the hierarchy without any XML parse
+// such that SerializePretty() of the result is the same as of the original.
+// The format is for a cache: the header holds a fingerprint of the names of
+// the KmlDomType ids of this build such that a build whose ids differ
+// rejects the snapshot.
+
+// This appends the snapshot of the given Element hierarchy to the output.
+// Returns false if element or output is NULL.
+bool SaveBinary(const kmldom::ElementPtr& element, string* output);
+
+// This does as above except to an ostream.  The snapshot is written in
+// blocks such that no copy of the whole snapshot is held in memory.
+bool SaveBinary(const kmldom::ElementPtr& element, std::ostream* output);
+
+// This builds the Element hierarchy from the given snapshot.  NULL is
+// returned if the data is not a whole snapshot written by SaveBinary(), or
+// if its elements nest deeper than the parser permits.
+kmldom::ElementPtr LoadBinary(const char* data, size_t size);
+kmldom::ElementPtr LoadBinary(const string& data);
+
+}  // end namespace kmlengine
+
+#endif  // KML_ENGINE_BINARY_SNAPSHOT_H__
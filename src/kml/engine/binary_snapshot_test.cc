@@ -0,0 +1,448 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the unit tests for the SaveBinary() and LoadBinary()
+// functions.
+
+#include "kml/engine/binary_snapshot.h"
+#include <sstream>
+#include "kml/base/file.h"
+#include "kml/dom.h"
+#include "kml/engine/find.h"
+#include "gtest/gtest.h"
+
+// The following define is a convenience for testing inside Google.
+#ifdef GOOGLE_INTERNAL
+#include "kml/base/google_internal_test.h"
+#endif
+
+#ifndef DATADIR
+#error *** DATADIR must be defined! ***
+#endif
+
+using kmlbase::File;
+using kmlbase::Vec3;
+using kmldom::CoordinatesPtr;
+using kmldom::ElementPtr;
+using kmldom::KmlFactory;
+using kmldom::PlacemarkPtr;
+
+namespace kmlengine {
+
+// A hierarchy with each kind of record of a snapshot.
+static const char kKml[] =
+    "<kml xmlns=\"http://www.opengis.net/kml/2.2\""
+    " xmlns:gx=\"http://www.google.com/kml/ext/2.2\""
+    " xmlns:foo=\"http://example.com/foo\">"
+    "<Document id=\"d\" foo:bar=\"baz\">"
+    "<name>a &lt;name&gt;</name>"
+    "<foo:unknown a=\"b\"><c>d</c></foo:unknown>"
+    "<Style id=\"s\"><LineStyle><color>ff00ff00</color>"
+    "<width>2.5</width></LineStyle></Style>"
+    "<Placemark targetId=\"t\">"
+    "<description><![CDATA[<b>bold</b>]]></description>"
+    "<styleUrl>#s</styleUrl><Point><coordinates>1,2,3</coordinates></Point>"
+    "<Unknown/>"
+    "</Placemark>"
+    "<Placemark><styleUrl>#s</styleUrl><gx:Track><when>2010-05-28</when>"
+    "<gx:coord>1 2 3</gx:coord></gx:Track></Placemark>"
+    "<Placemark><Snippet maxLines=\"1\"/><ExtendedData><SchemaData>"
+    "<SimpleData name=\"n\"></SimpleData></SchemaData></ExtendedData>"
+    "<LineString><coordinates>1.5,2 3,-4,5.25</coordinates></LineString>"
+    "</Placemark>"
+    "</Document></kml>";
+
+class BinarySnapshotTest : public testing::Test {
+ protected:
+  // This returns the XML of the element after a round trip through a
+  // snapshot, or "" if the snapshot does not load.
+  static string RoundTrip(const ElementPtr& element) {
+    string snapshot;
+    EXPECT_TRUE(SaveBinary(element, &snapshot));
+    ElementPtr loaded = LoadBinary(snapshot);
+    return loaded ? kmldom::SerializePretty(loaded) : "";
+  }
+
+  // A <coordinates> loaded from a snapshot is saved from its tuples rather
+  // than as the character data it was parsed from.  This does the same to
+  // each <coordinates> of a parsed hierarchy.
+  static void EditCoordinates(const ElementPtr& root) {
+    ElementVector coordinates_vector;
+    GetElementsById(root, kmldom::Type_coordinates, &coordinates_vector);
+    for (size_t i = 0; i < coordinates_vector.size(); ++i) {
+      CoordinatesPtr coordinates = kmldom::AsCoordinates(coordinates_vector[i]);
+      std::vector<Vec3> tuples;
+      for (size_t j = 0; j < coordinates->get_coordinates_array_size(); ++j) {
+        tuples.push_back(coordinates->get_coordinates_array_at(j));
+      }
+      coordinates->Clear();
+      for (size_t j = 0; j < tuples.size(); ++j) {
+        coordinates->add_vec3(tuples[j]);
+      }
+    }
+  }
+
+  // These append the records of a snapshot as SaveBinary() writes them.
+  static void AppendVarint(uint64_t value, string* snapshot) {
+    for (; value >= 0x80; value >>= 7) {
+      snapshot->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    }
+    snapshot->push_back(static_cast<char>(value));
+  }
+
+  static void AppendBegin(int type_id, string* snapshot) {
+    snapshot->push_back(1);
+    AppendVarint(type_id, snapshot);
+    AppendVarint(0, snapshot);  // No attributes.
+  }
+
+  static void AppendEnd(string* snapshot) {
+    snapshot->push_back(2);
+  }
+
+  static void AppendField(int type_id, const string& value,
+                          string* snapshot) {
+    snapshot->push_back(3);
+    AppendVarint(type_id, snapshot);
+    AppendVarint(0, snapshot);  // A new string.
+    AppendVarint(value.size(), snapshot);
+    snapshot->append(value);
+  }
+
+  static void AppendContent(const string& value, string* snapshot) {
+    snapshot->push_back(4);
+    AppendVarint(0, snapshot);  // A new string.
+    AppendVarint(value.size(), snapshot);
+    snapshot->append(value);
+  }
+
+  static void AppendColor(int type_id, string* snapshot) {
+    snapshot->push_back(6);
+    AppendVarint(type_id, snapshot);
+    snapshot->append(4, '\xff');
+  }
+
+  // This appends tuples of a longitude and latitude as deltas in units of
+  // 1e-7, each zigzag encoded.
+  static void AppendDeltaTuples(const std::vector<int64_t>& deltas,
+                                string* snapshot) {
+    snapshot->push_back(7);
+    AppendVarint(deltas.size() / 2, snapshot);
+    snapshot->push_back(0);  // No altitudes.
+    snapshot->push_back(1);  // Deltas.
+    for (size_t i = 0; i < deltas.size(); ++i) {
+      const uint64_t delta = static_cast<uint64_t>(deltas[i]);
+      AppendVarint(deltas[i] < 0 ? ~(delta << 1) : delta << 1, snapshot);
+    }
+  }
+
+  // This returns the header of a snapshot.
+  static string GetHeader() {
+    string snapshot;
+    EXPECT_TRUE(SaveBinary(KmlFactory::GetFactory()->CreatePoint(),
+                           &snapshot));
+    string empty_point;
+    AppendBegin(kmldom::Type_Point, &empty_point);
+    AppendEnd(&empty_point);
+    EXPECT_EQ(empty_point,
+              snapshot.substr(snapshot.size() - empty_point.size()));
+    return snapshot.substr(0, snapshot.size() - empty_point.size());
+  }
+
+  static CoordinatesPtr LoadCoordinates(const CoordinatesPtr& coordinates) {
+    string snapshot;
+    EXPECT_TRUE(SaveBinary(coordinates, &snapshot));
+    return kmldom::AsCoordinates(LoadBinary(snapshot));
+  }
+};
+
+TEST_F(BinarySnapshotTest, TestNull) {
+  string snapshot;
+  ASSERT_FALSE(SaveBinary(NULL, &snapshot));
+  ASSERT_TRUE(snapshot.empty());
+  ASSERT_FALSE(SaveBinary(KmlFactory::GetFactory()->CreatePlacemark(),
+                          static_cast<string*>(NULL)));
+  ASSERT_FALSE(LoadBinary(NULL, 0));
+  ASSERT_FALSE(LoadBinary(""));
+}
+
+// Verify that each of the fields, attributes and unknown elements of a
+// hierarchy survives the round trip.
+TEST_F(BinarySnapshotTest, TestRoundTripXml) {
+  ElementPtr root = kmldom::Parse(kKml, NULL);
+  ASSERT_TRUE(root);
+  EditCoordinates(root);
+  const string xml = kmldom::SerializePretty(root);
+  ASSERT_EQ(xml, RoundTrip(root));
+  // The snapshot of the loaded hierarchy is the snapshot it was loaded from.
+  string snapshot;
+  ASSERT_TRUE(SaveBinary(root, &snapshot));
+  string reloaded;
+  ASSERT_TRUE(SaveBinary(LoadBinary(snapshot), &reloaded));
+  ASSERT_EQ(snapshot, reloaded);
+}
+
+// Verify the round trip of each KML file of the test data.
+TEST_F(BinarySnapshotTest, TestRoundTripTestData) {
+  const char* kFiles[] = {
+    "/kml/all-arrays.kml",
+    "/kml/all-unknown-attrs-input.kml",
+    "/kml/all-unknown-input.kml",
+    "/kml/gnis-ak-first-101.kml",
+    "/kml/kmlsamples.kml",
+    "/kml/model-macky.kml",
+    "/kml/schemadata.kml",
+  };
+  for (size_t i = 0; i < sizeof(kFiles) / sizeof(kFiles[0]); ++i) {
+    string kml;
+    ASSERT_TRUE(File::ReadFileToString(string(DATADIR) + kFiles[i], &kml));
+    ElementPtr root = kmldom::Parse(kml, NULL);
+    ASSERT_TRUE(root) << kFiles[i];
+    EditCoordinates(root);
+    ASSERT_EQ(kmldom::SerializePretty(root), RoundTrip(root)) << kFiles[i];
+  }
+}
+
+// Verify that the tuples of a <coordinates> load as saved whether or not
+// they are written as deltas.
+TEST_F(BinarySnapshotTest, TestCoordinates) {
+  KmlFactory* factory = KmlFactory::GetFactory();
+  CoordinatesPtr coordinates = factory->CreateCoordinates();
+  coordinates->add_latlngalt(37.4219999, -122.0840575, 10);
+  coordinates->add_latlng(-37.5, 122.25);
+  coordinates->add_latlngalt(0, 0, -0.001);
+  string delta_snapshot;
+  ASSERT_TRUE(SaveBinary(coordinates, &delta_snapshot));
+  CoordinatesPtr loaded = LoadCoordinates(coordinates);
+  ASSERT_TRUE(loaded);
+  ASSERT_EQ(static_cast<size_t>(3), loaded->get_coordinates_array_size());
+  for (size_t i = 0; i < 3; ++i) {
+    const Vec3 expected = coordinates->get_coordinates_array_at(i);
+    const Vec3 actual = loaded->get_coordinates_array_at(i);
+    ASSERT_TRUE(expected == actual);
+    ASSERT_EQ(expected.has_altitude(), actual.has_altitude());
+  }
+
+  // A value with more than 7 decimal places is written as a double.
+  coordinates->add_latlng(1.0 / 3, 2.0 / 3);
+  string raw_snapshot;
+  ASSERT_TRUE(SaveBinary(coordinates, &raw_snapshot));
+  ASSERT_LT(delta_snapshot.size() + 2 * sizeof(double),
+            raw_snapshot.size());
+  loaded = LoadCoordinates(coordinates);
+  ASSERT_TRUE(loaded);
+  ASSERT_EQ(static_cast<size_t>(4), loaded->get_coordinates_array_size());
+  ASSERT_EQ(1.0 / 3, loaded->get_coordinates_array_at(3).get_latitude());
+  ASSERT_EQ(2.0 / 3, loaded->get_coordinates_array_at(3).get_longitude());
+  ASSERT_FALSE(loaded->get_coordinates_array_at(3).has_altitude());
+  ASSERT_TRUE(loaded->get_coordinates_array_at(0).has_altitude());
+}
+
+// Verify that a string seen before is written as its number.
+TEST_F(BinarySnapshotTest, TestStringTable) {
+  KmlFactory* factory = KmlFactory::GetFactory();
+  kmldom::FolderPtr folder = factory->CreateFolder();
+  string one_placemark;
+  for (int i = 0; i < 100; ++i) {
+    PlacemarkPtr placemark = factory->CreatePlacemark();
+    placemark->set_styleurl("#a-shared-style");
+    folder->add_feature(placemark);
+    if (i == 0) {
+      ASSERT_TRUE(SaveBinary(folder, &one_placemark));
+    }
+  }
+  string snapshot;
+  ASSERT_TRUE(SaveBinary(folder, &snapshot));
+  // Each further <Placemark> takes a begin, a field and an end of a few
+  // bytes each.
+  ASSERT_GT(one_placemark.size() + 99 * 10, snapshot.size());
+  ASSERT_EQ(kmldom::SerializePretty(folder), RoundTrip(folder));
+}
+
+// Verify that the snapshot written to an ostream is that of a string.
+TEST_F(BinarySnapshotTest, TestSaveToStream) {
+  string kml;
+  ASSERT_TRUE(File::ReadFileToString(
+      string(DATADIR) + "/kml/gnis-ak-first-101.kml", &kml));
+  ElementPtr root = kmldom::Parse(kml, NULL);
+  ASSERT_TRUE(root);
+  string snapshot;
+  ASSERT_TRUE(SaveBinary(root, &snapshot));
+  std::ostringstream stream;
+  ASSERT_TRUE(SaveBinary(root, &stream));
+  ASSERT_EQ(snapshot, stream.str());
+}
+
+// Verify that anything but a whole snapshot fails to load.
+TEST_F(BinarySnapshotTest, TestBadSnapshot) {
+  string snapshot;
+  ASSERT_TRUE(SaveBinary(kmldom::Parse(kKml, NULL), &snapshot));
+  ASSERT_TRUE(LoadBinary(snapshot));
+  // Each truncation fails.
+  for (size_t size = 0; size < snapshot.size(); ++size) {
+    ASSERT_FALSE(LoadBinary(snapshot.data(), size)) << size;
+  }
+  // Trailing data fails.
+  ASSERT_FALSE(LoadBinary(snapshot + snapshot));
+  // A different version fails.
+  string other_version(snapshot);
+  other_version[4] = 2;
+  ASSERT_FALSE(LoadBinary(other_version));
+  // Each change of a byte either fails or loads something.
+  for (size_t i = 0; i < snapshot.size(); ++i) {
+    string corrupt(snapshot);
+    corrupt[i] = static_cast<char>(corrupt[i] ^ 0x5a);
+    LoadBinary(corrupt);
+  }
+  // Only an element may be at the root.
+  kmldom::ElementPtr name =
+      KmlFactory::GetFactory()->CreateFieldById(kmldom::Type_name);
+  name->set_char_data("name");
+  string field_snapshot;
+  ASSERT_TRUE(SaveBinary(name, &field_snapshot));
+  ASSERT_FALSE(LoadBinary(field_snapshot));
+  // A snapshot of a build with other type ids fails.
+  string other_schema(snapshot);
+  other_schema[5] = static_cast<char>(other_schema[5] ^ 1);
+  ASSERT_FALSE(LoadBinary(other_schema));
+}
+
+// Verify that a field may only have the id of a simple element, and an
+// element only that of a complex one.
+TEST_F(BinarySnapshotTest, TestTypeConfusion) {
+  const string header = GetHeader();
+  string snapshot(header);
+  AppendBegin(kmldom::Type_Point, &snapshot);
+  AppendField(kmldom::Type_altitudeMode, "absolute", &snapshot);
+  AppendColor(kmldom::Type_color, &snapshot);
+  AppendEnd(&snapshot);
+  ASSERT_TRUE(LoadBinary(snapshot));
+
+  // A field of the id of <coordinates> in a <Point>.
+  snapshot = header;
+  AppendBegin(kmldom::Type_Point, &snapshot);
+  AppendField(kmldom::Type_coordinates, "1,2,3", &snapshot);
+  AppendEnd(&snapshot);
+  ASSERT_FALSE(LoadBinary(snapshot));
+
+  // A color of the id of <LineStyle> in a <Style>.
+  snapshot = header;
+  AppendBegin(kmldom::Type_Style, &snapshot);
+  AppendColor(kmldom::Type_LineStyle, &snapshot);
+  AppendEnd(&snapshot);
+  ASSERT_FALSE(LoadBinary(snapshot));
+
+  // An element of the id of <name> in a <Placemark>.
+  snapshot = header;
+  AppendBegin(kmldom::Type_Placemark, &snapshot);
+  AppendBegin(kmldom::Type_name, &snapshot);
+  AppendEnd(&snapshot);
+  AppendEnd(&snapshot);
+  ASSERT_FALSE(LoadBinary(snapshot));
+}
+
+// Verify that elements may nest no deeper than the parser permits.
+TEST_F(BinarySnapshotTest, TestNestingDepth) {
+  const size_t kMaxNestingDepth = 100;
+  string nested(GetHeader());
+  for (size_t i = 0; i < kMaxNestingDepth; ++i) {
+    AppendBegin(kmldom::Type_Folder, &nested);
+  }
+  string too_deep(nested);
+  AppendBegin(kmldom::Type_Folder, &too_deep);
+  for (size_t i = 0; i < kMaxNestingDepth; ++i) {
+    AppendEnd(&nested);
+    AppendEnd(&too_deep);
+  }
+  AppendEnd(&too_deep);
+  ASSERT_TRUE(LoadBinary(nested));
+  ASSERT_FALSE(LoadBinary(too_deep));
+}
+
+// Verify that character data is accepted only in those elements which parse
+// it.  Any other element would be made a child of itself.
+TEST_F(BinarySnapshotTest, TestContent) {
+  const string header = GetHeader();
+  string snapshot(header);
+  AppendBegin(kmldom::Type_Snippet, &snapshot);
+  AppendContent("snippet", &snapshot);
+  AppendEnd(&snapshot);
+  kmldom::SnippetPtr snippet = kmldom::AsSnippet(LoadBinary(snapshot));
+  ASSERT_TRUE(snippet);
+  ASSERT_EQ(string("snippet"), snippet->get_text());
+
+  snapshot = header;
+  AppendBegin(kmldom::Type_Placemark, &snapshot);
+  AppendContent("x", &snapshot);
+  AppendEnd(&snapshot);
+  ASSERT_FALSE(LoadBinary(snapshot));
+
+  // Nor may tuples be saved outside a <coordinates>.
+  std::vector<int64_t> deltas;
+  deltas.push_back(10);
+  deltas.push_back(20);
+  snapshot = header;
+  AppendBegin(kmldom::Type_Point, &snapshot);
+  AppendDeltaTuples(deltas, &snapshot);
+  AppendEnd(&snapshot);
+  ASSERT_FALSE(LoadBinary(snapshot));
+}
+
+// Verify that deltas which sum beyond the values the writer saves as deltas
+// are rejected rather than overflowing.
+TEST_F(BinarySnapshotTest, TestDeltaRange) {
+  const string header = GetHeader();
+  const int64_t kLargeDelta = 600000000000000LL;  // 6e7 degrees
+  std::vector<int64_t> deltas;
+  deltas.push_back(kLargeDelta);
+  deltas.push_back(-kLargeDelta);
+  string snapshot(header);
+  AppendBegin(kmldom::Type_coordinates, &snapshot);
+  AppendDeltaTuples(deltas, &snapshot);
+  AppendEnd(&snapshot);
+  CoordinatesPtr coordinates = kmldom::AsCoordinates(LoadBinary(snapshot));
+  ASSERT_TRUE(coordinates);
+  ASSERT_EQ(6e7, coordinates->get_coordinates_array_at(0).get_longitude());
+  ASSERT_EQ(-6e7, coordinates->get_coordinates_array_at(0).get_latitude());
+
+  // The second longitude is 1.2e8.
+  deltas.push_back(kLargeDelta);
+  deltas.push_back(0);
+  snapshot = header;
+  AppendBegin(kmldom::Type_coordinates, &snapshot);
+  AppendDeltaTuples(deltas, &snapshot);
+  AppendEnd(&snapshot);
+  ASSERT_FALSE(LoadBinary(snapshot));
+
+  // The largest delta would overflow the sum.
+  deltas[2] = 0x7fffffffffffffffLL;
+  snapshot = header;
+  AppendBegin(kmldom::Type_coordinates, &snapshot);
+  AppendDeltaTuples(deltas, &snapshot);
+  AppendEnd(&snapshot);
+  ASSERT_FALSE(LoadBinary(snapshot));
+}
+
+}  // end namespace kmlengine
@@ -33,7 +33,9 @@
 namespace kmlengine {
 
 // This returns a "deep" clone of the given element.  All child elements and
-// fields are copied.
+// fields are copied.  The tuples of each <coordinates> are the exception:
+// the clone shares their storage with the original until either changes
+// them, at which point that one makes its own copy.
 kmldom::ElementPtr Clone(const kmldom::ElementPtr& element);
 
 }  // end namespace kmlengine
@@ -0,0 +1,203 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of the internal ElementReplicator
+// class.  Do not use this class in application code.  See clone.h for the
+// public function.
+
+#ifndef KML_ENGINE_CLONE_INTERNAL_H__
+#define KML_ENGINE_CLONE_INTERNAL_H__
+
+#include <stack>
+#include "kml/base/attributes.h"
+#include "kml/dom.h"
+#include "kml/dom/serializer.h"
+
+namespace kmlengine {
+
+// The ElementReplicator is a Serializer used by the Clone() function to walk
+// the entire hierarchy of the target element.  Each field and child element
+// of each element is "serialized" to a new parallel instance using the same
+// methods used in the parser.  This technique essentially mates the output
+// of the serializer to the input of the parser.
+class ElementReplicator : public kmldom::Serializer {
+ public:
+  ElementReplicator()
+    : has_char_data_(false),
+      serializing_unknown_(false) {
+  }
+
+  virtual ~ElementReplicator() {}
+
+  // The clone of a <coordinates> shares the storage of the tuples with the
+  // original until either changes them rather than saving each tuple.
+  virtual void SaveElement(const kmldom::ElementPtr& element) {
+    if (kmldom::CoordinatesPtr coordinates = kmldom::AsCoordinates(element)) {
+      kmldom::CoordinatesPtr clone =
+          kmldom::KmlFactory::GetFactory()->CreateCoordinates();
+      clone->ShareTuples(*coordinates);
+      if (clone_stack_.empty()) {
+        clone_stack_.push(clone);
+      } else {
+        clone_stack_.top()->AddElement(clone);
+      }
+      return;
+    }
+    Serializer::SaveElement(element);
+  }
+
+  // Serializer::BeginById() is called at the start of a complex element.
+  virtual void BeginById(int type_id,
+                         const kmlbase::Attributes& attributes) {
+    kmldom::KmlDomType id = static_cast<kmldom::KmlDomType>(type_id);
+    kmldom::ElementPtr clone =
+        kmldom::KmlFactory::GetFactory()->CreateElementById(id);
+    clone->ParseAttributes(attributes.Clone());
+    clone_stack_.push(clone);
+  }
+
+  // Serializer::End() is called at the end of a complex element.
+  virtual void End() {
+    // BeginById() always puts something on the stack so this is always safe.
+    kmldom::ElementPtr child = clone_stack_.top();
+    // This mimics the part of KmlHandler::EndElement() which special cases
+    // those complex elements which have character data.
+    // TODO: refactor the special-casing in KmlHandler::EndElement() such that
+    // it can be used from here.  Using child->AddElement(child) is dangerous.
+    // Empty character data is saved too: <SimpleData></SimpleData> has text.
+    if (has_char_data_) {
+      // NOTE: This very much expects this to mean "parse yourself".  Were
+      // this to fall through to Element::AddChild() the element would be a
+      // child of itself in its misplaced elements array, so any other
+      // element's character data is dropped.
+      // TODO: see above TODO
+      if (ParsesCharData(child->Type())) {
+        child->set_char_data(char_data_);
+        child->AddElement(child);
+      }
+      char_data_.clear();
+      has_char_data_ = false;
+    }
+    // Two or more items on the stack implies the top is a child to be added
+    // to the parent above it on the stack.
+    if (clone_stack_.size() > 1) {
+      // Pop off the child.
+      clone_stack_.pop();
+      // Parent is now the top item.
+      clone_stack_.top()->AddElement(child);
+    }
+  }
+
+  // Serializer::SaveStringFieldById() is called for each field.
+  virtual void SaveStringFieldById(int type_id, string value) {
+    kmldom::KmlDomType id = static_cast<kmldom::KmlDomType>(type_id);
+    kmldom::ElementPtr clone =
+        kmldom::KmlFactory::GetFactory()->CreateFieldById(id);
+    clone->set_char_data(value);
+    clone_stack_.top()->AddElement(clone);
+  }
+
+  // Detects if we're serializing the unknown elements array.  We don't use
+  // element_count here and instead rely on EndElementArray() to indicate the
+  // end of the array.  Begin/End are always paired and never nested.
+  virtual void BeginElementArray(int type_id, size_t element_count) {
+    if (type_id == kmldom::Type_Unknown) {
+      serializing_unknown_ = true;
+    }
+  }
+
+  // This is called after the last element of the given array.  This brackets
+  // the BeginElementArray() above.
+  virtual void EndElementArray(int type_id) {
+    if (type_id == kmldom::Type_Unknown) {
+      serializing_unknown_ = false;
+    }
+  }
+
+  // Serializer::SaveContent() is called for arbitrary character data.
+  virtual void SaveContent(const string& content, bool maybe_quote) {
+    // If this is an item in the unknown elements array do _not_ add it to
+    // this element's raw char_data, add it correctly to the unknown element
+    // array directly.
+    if (serializing_unknown_) {
+      if (clone_stack_.size() > 0) {
+        clone_stack_.top()->AddUnknownElement(content);
+      }
+    } else {
+      char_data_.append(content);
+      has_char_data_ = true;
+    }
+  }
+
+  // Serializer::SaveVec3() is called to save each <coordinates> tuple.
+  virtual void SaveVec3(const kmlbase::Vec3& vec3) {
+    if (kmldom::CoordinatesPtr coordinates =
+            kmldom::AsCoordinates(clone_stack_.top())) {
+      coordinates->add_vec3(vec3);
+    }  // else something is very wrong.
+  }
+
+  // Serializer::SaveColor() is called to save all Color32 values.
+  virtual void SaveColor(int type_id, const kmlbase::Color32& color) {
+    SaveFieldById(type_id, color.to_string_abgr());
+  }
+
+  // Returns true if End() parses the character data of an element of the
+  // given type.  These are the complex elements whose character data
+  // KmlHandler::EndElement() parses.
+  static bool ParsesCharData(int type_id) {
+    switch (type_id) {
+      case kmldom::Type_coordinates:
+      case kmldom::Type_Snippet:
+      case kmldom::Type_linkSnippet:
+      case kmldom::Type_SimpleData:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  // Return the top of the stack which holds the root element.
+  kmldom::ElementPtr root() {
+    if (clone_stack_.empty()) {
+      return NULL;
+    }
+    return clone_stack_.top();
+  }
+
+ private:
+  // This stack operates akin to the stack in the parser.
+  std::stack<kmldom::ElementPtr> clone_stack_;
+  string char_data_;
+  // True if SaveContent() was called since the last End().
+  bool has_char_data_;
+  // This flag indicates that we're serializing an array of unknown elements.
+  // See BeginElementArray(), EndElementArray(), and SaveContent() above.
+  bool serializing_unknown_;
+};
+
+}  // end namespace kmlengine
+
+#endif  // KML_ENGINE_CLONE_INTERNAL_H__
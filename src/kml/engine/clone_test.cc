@@ -273,4 +273,99 @@ TEST_F(CloneTest, TestCloneWithFullyUnknownChild) {
   ASSERT_FALSE(kmldom::SerializePretty(clone).empty());
 }
 
+TEST_F(CloneTest, TestCloneSharesCoordinates) {
+  PlacemarkPtr placemark = kmldom::AsPlacemark(kmldom::Parse(
+      "<Placemark><LineString><coordinates>1,2,3 4,5,6</coordinates>"
+      "</LineString></Placemark>", NULL));
+  ASSERT_TRUE(placemark);
+  CoordinatesPtr coordinates =
+      kmldom::AsLineString(placemark->get_geometry())->get_coordinates();
+  ASSERT_FALSE(coordinates->is_shared());
+
+  PlacemarkPtr clone = kmldom::AsPlacemark(Clone(placemark));
+  ASSERT_TRUE(clone);
+  CoordinatesPtr clone_coordinates =
+      kmldom::AsLineString(clone->get_geometry())->get_coordinates();
+  ASSERT_NE(coordinates, clone_coordinates);
+  ASSERT_TRUE(coordinates->is_shared());
+  ASSERT_TRUE(clone_coordinates->is_shared());
+  ASSERT_EQ(static_cast<size_t>(2),
+            clone_coordinates->get_coordinates_array_size());
+  ASSERT_EQ(kmldom::SerializePretty(placemark),
+            kmldom::SerializePretty(clone));
+
+  // Changing the clone's tuples copies them and leaves the original as is.
+  clone_coordinates->add_vec3(Vec3(7, 8, 9));
+  ASSERT_FALSE(coordinates->is_shared());
+  ASSERT_FALSE(clone_coordinates->is_shared());
+  ASSERT_EQ(static_cast<size_t>(2), coordinates->get_coordinates_array_size());
+  ASSERT_EQ(static_cast<size_t>(3),
+            clone_coordinates->get_coordinates_array_size());
+  ASSERT_EQ(4.0, coordinates->get_coordinates_array_at(1).get_longitude());
+  ASSERT_EQ(7.0,
+            clone_coordinates->get_coordinates_array_at(2).get_longitude());
+
+  // Clearing the original leaves a second clone unchanged.
+  CoordinatesPtr second = kmldom::AsCoordinates(Clone(coordinates));
+  ASSERT_TRUE(second->is_shared());
+  coordinates->Clear();
+  ASSERT_FALSE(second->is_shared());
+  ASSERT_EQ(static_cast<size_t>(0), coordinates->get_coordinates_array_size());
+  ASSERT_EQ(static_cast<size_t>(2), second->get_coordinates_array_size());
+}
+
+TEST_F(CloneTest, TestCloneDeferredCoordinates) {
+  const string kKml("<coordinates>\n  1.5,2,3 4,5\t6,7,8\n</coordinates>");
+  kmldom::ParseOptions options;
+  options.defer_coordinates = true;
+  kmldom::Parser parser;
+  parser.set_options(options);
+  CoordinatesPtr coordinates = kmldom::AsCoordinates(parser.Parse(kKml, NULL));
+  ASSERT_TRUE(coordinates);
+  ASSERT_TRUE(coordinates->is_deferred());
+
+  CoordinatesPtr clone = kmldom::AsCoordinates(Clone(coordinates));
+  ASSERT_TRUE(clone);
+  ASSERT_TRUE(clone->is_deferred());
+  ASSERT_TRUE(coordinates->is_deferred());
+  ASSERT_EQ(kmldom::SerializePretty(coordinates),
+            kmldom::SerializePretty(clone));
+  ASSERT_EQ(static_cast<size_t>(3), clone->get_coordinates_array_size());
+  ASSERT_EQ(6.0, clone->get_coordinates_array_at(2).get_longitude());
+  ASSERT_TRUE(coordinates->is_deferred());
+}
+
+TEST_F(CloneTest, TestCloneCoordinateColumns) {
+  CoordinatesPtr coordinates = coordinates_;
+  coordinates->set_storage(kmldom::COORDINATES_FLOAT);
+  coordinates->add_latlngalt(1, 2, 3);
+  coordinates->add_latlngalt(4, 5, 6);
+
+  CoordinatesPtr clone = kmldom::AsCoordinates(Clone(coordinates));
+  ASSERT_TRUE(clone);
+  ASSERT_EQ(kmldom::COORDINATES_FLOAT, clone->get_storage());
+  ASSERT_TRUE(clone->is_shared());
+  ASSERT_TRUE(coordinates->get_coordinates_array_at(1) ==
+              clone->get_coordinates_array_at(1));
+
+  coordinates->add_latlngalt(7, 8, 9);
+  ASSERT_FALSE(clone->is_shared());
+  ASSERT_EQ(kmldom::COORDINATES_FLOAT, coordinates->get_storage());
+  ASSERT_EQ(static_cast<size_t>(3), coordinates->get_coordinates_array_size());
+  ASSERT_EQ(static_cast<size_t>(2), clone->get_coordinates_array_size());
+}
+
+// Verify that empty text is cloned as text.
+TEST_F(CloneTest, TestCloneEmptySimpleData) {
+  kmldom::SimpleDataPtr simpledata =
+      KmlFactory::GetFactory()->CreateSimpleData();
+  simpledata->set_text("");
+  kmldom::SimpleDataPtr clone = kmldom::AsSimpleData(Clone(simpledata));
+  ASSERT_TRUE(clone);
+  ASSERT_TRUE(clone->has_text());
+  ASSERT_EQ(string(""), clone->get_text());
+  ASSERT_FALSE(kmldom::AsSimpleData(Clone(
+      KmlFactory::GetFactory()->CreateSimpleData()))->has_text());
+}
+
 }  // end namespace kmlengine
@@ -0,0 +1,176 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of the KmlFeatureReader class.
+
+#include "kml/engine/kml_feature_reader.h"
+#include "kml/base/expat_parser.h"
+#include "kml/dom/kml_handler.h"
+#include "kml/engine/schema_parser_observer.h"
+#include "kml/engine/shared_style_parser_observer.h"
+
+using kmldom::ContainerPtr;
+using kmldom::ElementPtr;
+using kmldom::FeaturePtr;
+
+namespace kmlengine {
+
+// static
+KmlFeatureReader* KmlFeatureReader::CreateFromIstream(std::istream* input) {
+  if (!input) {
+    return NULL;
+  }
+  return new KmlFeatureReader(input);
+}
+
+// static
+KmlFeatureReader* KmlFeatureReader::CreateFromFile(const string& filename,
+                                                   string* errors) {
+  std::ifstream* file =
+      new std::ifstream(filename.c_str(),
+                        std::ios_base::in|std::ios_base::binary);
+  if (!file->is_open() || !file->good()) {
+    delete file;
+    if (errors) {
+      *errors = "open failed: " + filename;
+    }
+    return NULL;
+  }
+  KmlFeatureReader* reader = new KmlFeatureReader(file);
+  reader->file_.reset(file);
+  return reader;
+}
+
+KmlFeatureReader::KmlFeatureReader(std::istream* input)
+  : input_(input),
+    shared_style_parser_observer_(
+        new SharedStyleParserObserver(&shared_style_map_, false)),
+    schema_parser_observer_(new SchemaParserObserver(&schema_name_map_)),
+    done_(false),
+    update_depth_(0) {
+  observers_.push_back(this);
+  observers_.push_back(shared_style_parser_observer_.get());
+  observers_.push_back(schema_parser_observer_.get());
+  kml_handler_.reset(new kmldom::KmlHandler(observers_));
+  expat_parser_.reset(new kmlbase::ExpatParser(kml_handler_.get(), false));
+}
+
+KmlFeatureReader::~KmlFeatureReader() {}
+
+bool KmlFeatureReader::Next() {
+  feature_ = NULL;
+  container_path_.clear();
+  // Features completed in the block with a parse error are still returned.
+  while (queue_.empty() && ParseNextBlock()) {
+  }
+  if (queue_.empty()) {
+    return false;
+  }
+  feature_ = queue_.front().feature;
+  container_path_.swap(queue_.front().container_path);
+  queue_.pop_front();
+  return true;
+}
+
+bool KmlFeatureReader::ParseNextBlock() {
+  if (done_) {
+    return false;
+  }
+  const int kBufSize = 4096;
+  void* buf = expat_parser_->GetInternalBuffer(kBufSize);
+  if (!buf) {
+    errors_ = "memory error";
+    done_ = true;
+    return false;
+  }
+  std::streamsize read_size = 0;
+  if (input_->good()) {
+    read_size = input_->read(static_cast<char*>(buf), kBufSize).gcount();
+  }
+  // Guard negative read sizes for MSVC 2010.
+  if (read_size < 0) {
+    read_size = 0;
+  }
+  const bool is_final = !input_->good();
+  if (!expat_parser_->ParseInternalBuffer(static_cast<size_t>(read_size),
+                                          &errors_, is_final)) {
+    if (errors_.empty()) {
+      errors_ = "parse error";
+    }
+    done_ = true;
+    return false;
+  }
+  if (is_final) {
+    done_ = true;
+    // A Feature which is the root element has no parent to hold it back
+    // from so it is returned here.
+    const ElementPtr root = kml_handler_->PopRoot();
+    if (FeaturePtr feature = kmldom::AsFeature(root)) {
+      if (!kmldom::AsContainer(root)) {
+        QueuedFeature queued_feature;
+        queued_feature.feature = feature;
+        queue_.push_back(queued_feature);
+      }
+    }
+  }
+  return true;
+}
+
+bool KmlFeatureReader::NewElement(const ElementPtr& element) {
+  if (element->Type() == kmldom::Type_Update) {
+    ++update_depth_;
+  } else if (update_depth_ == 0) {
+    if (ContainerPtr container = kmldom::AsContainer(element)) {
+      open_containers_.push_back(container);
+    }
+  }
+  return true;
+}
+
+bool KmlFeatureReader::EndElement(const ElementPtr& parent,
+                                  const ElementPtr& child) {
+  if (child->Type() == kmldom::Type_Update) {
+    --update_depth_;
+    return true;
+  }
+  if (update_depth_ > 0) {
+    return true;
+  }
+  if (kmldom::AsContainer(child)) {
+    // Everything within was already returned or held by the maps.
+    open_containers_.pop_back();
+    return false;
+  }
+  if (FeaturePtr feature = kmldom::AsFeature(child)) {
+    QueuedFeature queued_feature;
+    queued_feature.feature = feature;
+    queued_feature.container_path = open_containers_;
+    queue_.push_back(queued_feature);
+    return false;
+  }
+  return true;
+}
+
+}  // end namespace kmlengine
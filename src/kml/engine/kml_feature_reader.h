@@ -0,0 +1,167 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of the KmlFeatureReader class.
+
+#ifndef KML_ENGINE_KML_FEATURE_READER_H__
+#define KML_ENGINE_KML_FEATURE_READER_H__
+
+#include <deque>
+#include <fstream>
+#include <istream>
+#include <vector>
+#include "boost/scoped_ptr.hpp"
+#include "kml/dom.h"
+#include "kml/dom/parser_observer.h"
+#include "kml/base/util.h"
+#include "kml/engine/engine_types.h"
+
+namespace kmlbase {
+class ExpatParser;
+}
+
+namespace kmldom {
+class KmlHandler;
+}
+
+namespace kmlengine {
+
+// The Containers enclosing a Feature, outermost first.
+typedef std::vector<kmldom::ContainerPtr> ContainerPath;
+
+// This class reads the Features of a KML file one at a time such that a
+// file of any size can be processed in memory proportional to its largest
+// Feature.  Each non-Container Feature (Placemark, NetworkLink, the
+// Overlays, gx:Tour) is returned fully formed along with the Document and
+// Folder elements enclosing it.  Once the reader moves past a Feature the
+// reader no longer holds it.  The enclosing Containers hold only their
+// simple fields and non-Feature children (shared styles, Schemas, etc).
+// The shared styles and Schemas of all Documents seen so far are also
+// gathered into maps just as KmlFile does.  Features within an <Update> are
+// not returned.
+//
+//   boost::scoped_ptr<KmlFeatureReader> reader(
+//       KmlFeatureReader::CreateFromFile("big.kml", &errors));
+//   while (reader->Next()) {
+//     const kmldom::FeaturePtr& feature = reader->get_feature();
+//     const ContainerPath& path = reader->get_container_path();
+//     ...
+//   }
+//   if (!reader->get_errors().empty()) { ... }
+class KmlFeatureReader : private kmldom::ParserObserver {
+ public:
+  // Create a reader of the KML in the given C++ istream.  The istream must
+  // remain valid for the life of the reader.  NULL is returned if input is
+  // NULL.
+  static KmlFeatureReader* CreateFromIstream(std::istream* input);
+
+  // Create a reader of the KML file of the given name.  On failure to open
+  // the file NULL is returned and an error message is set to the given
+  // error string if one is supplied.
+  static KmlFeatureReader* CreateFromFile(const string& filename,
+                                          string* errors);
+
+  virtual ~KmlFeatureReader();
+
+  // This advances to the next Feature reading more input as needed.  False
+  // is returned at the end of input or on any parse or I/O error, in which
+  // case get_errors() is not empty.  Features which precede an error are
+  // returned.
+  bool Next();
+
+  // This returns the Feature the last call to Next() advanced to.
+  const kmldom::FeaturePtr& get_feature() const {
+    return feature_;
+  }
+
+  // This returns the Containers enclosing the current Feature, outermost
+  // first.  This is empty for a Feature which is the child of <kml>.
+  const ContainerPath& get_container_path() const {
+    return container_path_;
+  }
+
+  // This returns the shared styles seen so far.
+  const SharedStyleMap& get_shared_style_map() const {
+    return shared_style_map_;
+  }
+
+  // This returns the name'ed Schemas seen so far.
+  const SchemaNameMap& get_schema_name_map() const {
+    return schema_name_map_;
+  }
+
+  // This returns any parse or I/O error message.
+  const string& get_errors() const {
+    return errors_;
+  }
+
+ private:
+  // Constructor is private.  Use static creation methods.
+  explicit KmlFeatureReader(std::istream* input);
+
+  // ParserObserver methods.  NewElement() tracks the Containers entered.
+  // EndElement() holds back completed Features from their parent and
+  // queues them for Next(), and holds back completed Containers such that
+  // each is released once its end is reached.
+  virtual bool NewElement(const kmldom::ElementPtr& element);
+  virtual bool EndElement(const kmldom::ElementPtr& parent,
+                          const kmldom::ElementPtr& child);
+
+  // This parses the next block of input.  False is returned at the end of
+  // input or on error.
+  bool ParseNextBlock();
+
+  struct QueuedFeature {
+    kmldom::FeaturePtr feature;
+    ContainerPath container_path;
+  };
+
+  boost::scoped_ptr<std::ifstream> file_;
+  std::istream* input_;
+  SharedStyleMap shared_style_map_;
+  SchemaNameMap schema_name_map_;
+  kmldom::parser_observer_vector_t observers_;
+  boost::scoped_ptr<kmldom::ParserObserver> shared_style_parser_observer_;
+  boost::scoped_ptr<kmldom::ParserObserver> schema_parser_observer_;
+  boost::scoped_ptr<kmldom::KmlHandler> kml_handler_;
+  boost::scoped_ptr<kmlbase::ExpatParser> expat_parser_;
+  bool done_;
+  string errors_;
+  // The Containers open at the current point in the parse.
+  ContainerPath open_containers_;
+  // The nesting depth of <Update> at the current point in the parse.
+  int update_depth_;
+  // Features completed by the parse but not yet returned by Next().  A
+  // block of input typically completes several.
+  std::deque<QueuedFeature> queue_;
+  kmldom::FeaturePtr feature_;
+  ContainerPath container_path_;
+
+  LIBKML_DISALLOW_EVIL_CONSTRUCTORS(KmlFeatureReader);
+};
+
+}  // end namespace kmlengine
+
+#endif  // KML_ENGINE_KML_FEATURE_READER_H__
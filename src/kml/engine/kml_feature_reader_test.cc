@@ -0,0 +1,263 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the unit tests for the KmlFeatureReader class.
+
+#include "kml/engine/kml_feature_reader.h"
+#include <sstream>
+#include "boost/scoped_ptr.hpp"
+#include "gtest/gtest.h"
+#include "kml/base/file.h"
+#include "kml/dom.h"
+
+#ifndef DATADIR
+#error *** DATADIR must be defined! ***
+#endif
+
+using kmldom::AsContainer;
+using kmldom::AsFolder;
+using kmldom::ContainerPtr;
+using kmldom::ElementPtr;
+using kmldom::FeaturePtr;
+
+namespace kmlengine {
+
+// This reads all Features from the given KML returning the name of each
+// Feature and the names of its enclosing Containers as "a/b/feature".
+static bool ReadFeatureNames(const string& kml, std::vector<string>* names,
+                             string* errors) {
+  std::istringstream input(kml);
+  boost::scoped_ptr<KmlFeatureReader> reader(
+      KmlFeatureReader::CreateFromIstream(&input));
+  while (reader->Next()) {
+    string name;
+    const ContainerPath& path = reader->get_container_path();
+    for (size_t i = 0; i < path.size(); ++i) {
+      name.append(path[i]->get_name()).append("/");
+    }
+    names->push_back(name + reader->get_feature()->get_name());
+  }
+  *errors = reader->get_errors();
+  return errors->empty();
+}
+
+TEST(KmlFeatureReaderTest, TestNullInput) {
+  ASSERT_FALSE(KmlFeatureReader::CreateFromIstream(NULL));
+  string errors;
+  ASSERT_FALSE(KmlFeatureReader::CreateFromFile(
+      kmlbase::File::JoinPaths(DATADIR, "no-such-file.kml"), &errors));
+  ASSERT_FALSE(errors.empty());
+}
+
+TEST(KmlFeatureReaderTest, TestNestedFeatures) {
+  const string kKml(
+    "<kml xmlns=\"http://www.opengis.net/kml/2.2\">"
+    "<Document>"
+    "<name>d</name>"
+    "<Style id=\"s\"/>"
+    "<Schema name=\"n\" id=\"i\"/>"
+    "<Folder>"
+    "<name>f</name>"
+    "<Placemark><name>a</name><Point><coordinates>1,2</coordinates></Point>"
+    "</Placemark>"
+    "<Folder><name>g</name>"
+    "<GroundOverlay><name>b</name></GroundOverlay>"
+    "</Folder>"
+    "<NetworkLink><name>c</name></NetworkLink>"
+    "</Folder>"
+    "<Placemark><name>e</name></Placemark>"
+    "</Document>"
+    "</kml>");
+  std::istringstream input(kKml);
+  boost::scoped_ptr<KmlFeatureReader> reader(
+      KmlFeatureReader::CreateFromIstream(&input));
+  ASSERT_TRUE(reader.get());
+
+  ASSERT_TRUE(reader->Next());
+  ASSERT_EQ(kmldom::Type_Placemark, reader->get_feature()->Type());
+  ASSERT_EQ(string("a"), reader->get_feature()->get_name());
+  ASSERT_TRUE(kmldom::AsPlacemark(reader->get_feature())->has_geometry());
+  ContainerPath path = reader->get_container_path();
+  ASSERT_EQ(static_cast<size_t>(2), path.size());
+  ASSERT_EQ(kmldom::Type_Document, path[0]->Type());
+  ASSERT_EQ(string("d"), path[0]->get_name());
+  ASSERT_EQ(string("f"), path[1]->get_name());
+  // The shared style and Schema which came before are available.
+  ASSERT_EQ(static_cast<size_t>(1), reader->get_shared_style_map().size());
+  ASSERT_TRUE(reader->get_shared_style_map().find("s") !=
+              reader->get_shared_style_map().end());
+  ASSERT_EQ(static_cast<size_t>(1), reader->get_schema_name_map().size());
+  ASSERT_TRUE(reader->get_schema_name_map().find("n") !=
+              reader->get_schema_name_map().end());
+  // The Containers do not hold the Features returned.
+  ASSERT_EQ(static_cast<size_t>(0), path[1]->get_feature_array_size());
+
+  ASSERT_TRUE(reader->Next());
+  ASSERT_EQ(kmldom::Type_GroundOverlay, reader->get_feature()->Type());
+  ASSERT_EQ(static_cast<size_t>(3), reader->get_container_path().size());
+  ASSERT_EQ(string("g"), reader->get_container_path()[2]->get_name());
+
+  ASSERT_TRUE(reader->Next());
+  ASSERT_EQ(kmldom::Type_NetworkLink, reader->get_feature()->Type());
+  ASSERT_EQ(static_cast<size_t>(2), reader->get_container_path().size());
+
+  ASSERT_TRUE(reader->Next());
+  ASSERT_EQ(string("e"), reader->get_feature()->get_name());
+  ASSERT_EQ(static_cast<size_t>(1), reader->get_container_path().size());
+  // The Folder ended and is not held by the Document.
+  ASSERT_EQ(static_cast<size_t>(0),
+            reader->get_container_path()[0]->get_feature_array_size());
+
+  ASSERT_FALSE(reader->Next());
+  ASSERT_FALSE(reader->get_feature());
+  ASSERT_TRUE(reader->get_container_path().empty());
+  ASSERT_TRUE(reader->get_errors().empty());
+  ASSERT_FALSE(reader->Next());
+}
+
+TEST(KmlFeatureReaderTest, TestRootFeatures) {
+  std::vector<string> names;
+  string errors;
+  ASSERT_TRUE(ReadFeatureNames("<kml><Placemark><name>a</name></Placemark>"
+                               "</kml>", &names, &errors));
+  ASSERT_EQ(static_cast<size_t>(1), names.size());
+  ASSERT_EQ(string("a"), names[0]);
+
+  names.clear();
+  ASSERT_TRUE(ReadFeatureNames("<Placemark><name>b</name></Placemark>",
+                               &names, &errors));
+  ASSERT_EQ(static_cast<size_t>(1), names.size());
+  ASSERT_EQ(string("b"), names[0]);
+
+  names.clear();
+  ASSERT_TRUE(ReadFeatureNames("<Folder><name>f</name>"
+                               "<Placemark><name>c</name></Placemark>"
+                               "</Folder>", &names, &errors));
+  ASSERT_EQ(static_cast<size_t>(1), names.size());
+  ASSERT_EQ(string("f/c"), names[0]);
+
+  names.clear();
+  ASSERT_TRUE(ReadFeatureNames("<kml><Document/></kml>", &names, &errors));
+  ASSERT_TRUE(names.empty());
+}
+
+TEST(KmlFeatureReaderTest, TestUpdateFeaturesNotReturned) {
+  const string kKml(
+    "<kml>"
+    "<NetworkLinkControl><Update>"
+    "<Create><Folder targetId=\"t\">"
+    "<Placemark><name>created</name></Placemark>"
+    "</Folder></Create>"
+    "<Change><Placemark targetId=\"p\"><name>changed</name></Placemark>"
+    "</Change>"
+    "</Update></NetworkLinkControl>"
+    "<Folder><name>f</name><Placemark><name>a</name></Placemark></Folder>"
+    "</kml>");
+  std::vector<string> names;
+  string errors;
+  ASSERT_TRUE(ReadFeatureNames(kKml, &names, &errors));
+  ASSERT_EQ(static_cast<size_t>(1), names.size());
+  ASSERT_EQ(string("f/a"), names[0]);
+}
+
+TEST(KmlFeatureReaderTest, TestParseError) {
+  std::vector<string> names;
+  string errors;
+  ASSERT_FALSE(ReadFeatureNames("", &names, &errors));
+  ASSERT_FALSE(errors.empty());
+
+  // Features before the error are returned.
+  names.clear();
+  errors.clear();
+  ASSERT_FALSE(ReadFeatureNames("<Folder><Placemark><name>a</name>"
+                                "</Placemark><Placemark></Folder>",
+                                &names, &errors));
+  ASSERT_FALSE(errors.empty());
+  ASSERT_EQ(static_cast<size_t>(1), names.size());
+}
+
+TEST(KmlFeatureReaderTest, TestManyFeatures) {
+  // Enough Features that the input spans many blocks.
+  const int kCount = 5000;
+  std::ostringstream kml;
+  kml << "<kml><Document><name>d</name>";
+  for (int i = 0; i < kCount; ++i) {
+    kml << "<Placemark><name>" << i << "</name>"
+        << "<Point><coordinates>" << i << ",1</coordinates></Point>"
+        << "</Placemark>";
+  }
+  kml << "</Document></kml>";
+  std::vector<string> names;
+  string errors;
+  ASSERT_TRUE(ReadFeatureNames(kml.str(), &names, &errors));
+  ASSERT_EQ(static_cast<size_t>(kCount), names.size());
+  for (int i = 0; i < kCount; ++i) {
+    std::ostringstream expected;
+    expected << "d/" << i;
+    ASSERT_EQ(expected.str(), names[i]);
+  }
+}
+
+// Count the non-Container Features outside any Update.
+static size_t CountFeatures(const ElementPtr& element) {
+  if (ContainerPtr container = AsContainer(element)) {
+    size_t count = 0;
+    for (size_t i = 0; i < container->get_feature_array_size(); ++i) {
+      count += CountFeatures(container->get_feature_array_at(i));
+    }
+    return count;
+  }
+  if (kmldom::KmlPtr kml = kmldom::AsKml(element)) {
+    return kml->has_feature() ? CountFeatures(kml->get_feature()) : 0;
+  }
+  return kmldom::AsFeature(element) ? 1 : 0;
+}
+
+TEST(KmlFeatureReaderTest, TestCreateFromFile) {
+  const string kKmlSamples(
+      kmlbase::File::JoinPaths(DATADIR, kmlbase::File::JoinPaths(
+          "kml", "kmlsamples.kml")));
+  string kml;
+  ASSERT_TRUE(kmlbase::File::ReadFileToString(kKmlSamples, &kml));
+  const size_t expected = CountFeatures(kmldom::Parse(kml, NULL));
+  ASSERT_LT(static_cast<size_t>(10), expected);
+
+  string errors;
+  boost::scoped_ptr<KmlFeatureReader> reader(
+      KmlFeatureReader::CreateFromFile(kKmlSamples, &errors));
+  ASSERT_TRUE(reader.get());
+  size_t count = 0;
+  while (reader->Next()) {
+    ASSERT_TRUE(reader->get_feature());
+    ASSERT_FALSE(AsContainer(reader->get_feature()));
+    ASSERT_FALSE(reader->get_container_path().empty());
+    ++count;
+  }
+  ASSERT_TRUE(reader->get_errors().empty());
+  ASSERT_EQ(expected, count);
+  ASSERT_FALSE(reader->get_shared_style_map().empty());
+}
+
+}  // end namespace kmlengine
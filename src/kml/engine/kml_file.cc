@@ -26,11 +26,14 @@
 // This file contains the implementation of the KmlFile class methods.
 
 #include "kml/engine/kml_file.h"
+#include "kml/base/file.h"
 #include "kml/base/xml_namespaces.h"
+#include "kml/base/zip_file.h"
 #include "kml/engine/find_xml_namespaces.h"
 #include "kml/engine/id_mapper.h"
 #include "kml/engine/kmz_file.h"
 #include "kml/dom.h"
+#include "kml/dom/serializer.h"
 #include "kml/dom/xml_serializer.h"
 
 using kmlbase::FindXmlNamespaceAndPrefix;
@@ -44,9 +47,17 @@ static const char kDefaultEncoding[] = "utf-8";
 // static
 KmlFile* KmlFile::CreateFromParse(const string& kml_or_kmz_data,
                                   string* errors) {
+  return CreateFromParse(kml_or_kmz_data, kmldom::ParseOptions(), errors);
+}
+
+// static
+KmlFile* KmlFile::CreateFromParse(const string& kml_or_kmz_data,
+                                  const kmldom::ParseOptions& options,
+                                  string* errors) {
   // Here our focus is on managing the KmlFile storage.  If _CreateFromParse()
   // fails we release the storage else we return a pointer to it.
   KmlFile* kml_file = new KmlFile;
+  kml_file->parse_options_ = options;
   if (kml_file->_CreateFromParse(kml_or_kmz_data, errors)) {
     return kml_file;
   }
@@ -54,6 +65,85 @@ KmlFile* KmlFile::CreateFromParse(const string& kml_or_kmz_data,
   return NULL;
 }
 
+// static
+KmlFile* KmlFile::CreateFromFile(const string& filename, string* errors) {
+  return CreateFromFile(filename, kmldom::ParseOptions(), errors);
+}
+
+// static
+KmlFile* KmlFile::CreateFromFile(const string& filename,
+                                 const kmldom::ParseOptions& options,
+                                 string* errors) {
+  boost::scoped_ptr<kmlbase::MappedFile> mapped_file(
+      kmlbase::MappedFile::Open(filename));
+  if (!mapped_file.get()) {
+    // Fall back to reading the file if it can't be mapped.
+    string data;
+    if (!kmlbase::File::ReadFileToString(filename, &data)) {
+      if (errors) {
+        *errors = "could not read " + filename;
+      }
+      return NULL;
+    }
+    return CreateFromParse(data, options, errors);
+  }
+  KmlFile* kml_file = new KmlFile;
+  kml_file->parse_options_ = options;
+  bool status = false;
+  if (kmlbase::ZipFile::IsZipData(mapped_file->data(), mapped_file->size())) {
+    // The KmzFile maps the file for itself.
+    mapped_file.reset();
+    string kml_data;
+    KmzFilePtr kmz_file = KmzFile::OpenFromFile(filename.c_str());
+    if (!kmz_file) {
+      if (errors) {
+        *errors = "could not open KMZ " + filename;
+      }
+    } else if (!kmz_file->ReadKml(&kml_data)) {
+      if (errors) {
+        *errors = "no KML in KMZ " + filename;
+      }
+    } else {
+      status = kml_file->ParseFromString(kml_data, errors);
+    }
+  } else {
+    status = kml_file->ParseFromMappedFile(mapped_file.get(), errors);
+  }
+  if (status) {
+    return kml_file;
+  }
+  delete kml_file;
+  return NULL;
+}
+
+// static
+KmlFile* KmlFile::CreateFromParseLazy(const string& kml_or_kmz_data,
+                                      string* errors) {
+  return CreateFromParseLazy(kml_or_kmz_data, kmldom::ParseOptions(), errors);
+}
+
+// static
+KmlFile* KmlFile::CreateFromParseLazy(const string& kml_or_kmz_data,
+                                      const kmldom::ParseOptions& options,
+                                      string* errors) {
+  KmlFile* kml_file = new KmlFile;
+  kml_file->parse_options_ = options;
+  bool status = false;
+  if (KmzFile::IsKmz(kml_or_kmz_data)) {
+    string kml_data;
+    KmzFilePtr kmz_file = KmzFile::OpenFromString(kml_or_kmz_data);
+    status = kmz_file && kmz_file->ReadKml(&kml_data) &&
+             kml_file->ParseLazyWithObservers(kml_data, errors);
+  } else {
+    status = kml_file->ParseLazyWithObservers(kml_or_kmz_data, errors);
+  }
+  if (status) {
+    return kml_file;
+  }
+  delete kml_file;
+  return NULL;
+}
+
 // static
 KmlFile* KmlFile::CreateFromStringWithUrl(const string& kml_data,
                                           const string& url,
@@ -95,13 +185,35 @@ bool KmlFile::OpenAndParseKmz(const string& kmz_data,
 KmlFile::KmlFile()
   : encoding_(kDefaultEncoding),
     kml_cache_(NULL),
-    strict_parse_(false) {
+    strict_parse_(false),
+    frozen_(false) {
+}
+
+KmlFile::~KmlFile() {
+  // The Elements may outlive this KmlFile and its observers.
+  if (lazy_container_) {
+    lazy_container_->get_lazy_feature_source()->ClearObservers();
+  }
 }
 
 // private
 bool KmlFile::ParseFromString(const string& kml, string* errors) {
+  return ParseWithObservers(kml, NULL, errors);
+}
+
+// private
+bool KmlFile::ParseFromMappedFile(kmlbase::MappedFile* mapped_file,
+                                  string* errors) {
+  return ParseWithObservers(string(), mapped_file, errors);
+}
+
+// private
+bool KmlFile::ParseWithObservers(const string& kml,
+                                 kmlbase::MappedFile* mapped_file,
+                                 string* errors) {
   // Create a parser object.
   kmldom::Parser parser;
+  parser.set_options(parse_options_);
 
   // Create a ParserObserver both to save the id's of all Objects as well as
   // check for duplicates if strict parsing has been enabled. If set, this
@@ -122,7 +234,9 @@ bool KmlFile::ParseFromString(const string& kml, string* errors) {
   parser.AddObserver(&get_link_parents);
 
   // Actually perform the parse.
-  if (kmldom::ElementPtr root = parser.Parse(kml, errors)) {
+  kmldom::ElementPtr root = mapped_file ?
+      parser.ParseMappedFile(mapped_file, errors) : parser.Parse(kml, errors);
+  if (root) {
     // TODO: set encoding, xmlns, etc from parse
     set_root(root);
     return true;
@@ -130,6 +244,38 @@ bool KmlFile::ParseFromString(const string& kml, string* errors) {
   return false;
 }
 
+// private
+bool KmlFile::ParseLazyWithObservers(const string& kml, string* errors) {
+  kmldom::Parser parser;
+  parser.set_options(parse_options_);
+  // As in ParseWithObservers() but these live on to observe the parse of
+  // each Feature.
+  object_id_parser_observer_.reset(
+      new ObjectIdParserObserver(&object_id_map_, strict_parse_));
+  parser.AddObserver(object_id_parser_observer_.get());
+  shared_style_parser_observer_.reset(
+      new SharedStyleParserObserver(&shared_style_map_, strict_parse_));
+  parser.AddObserver(shared_style_parser_observer_.get());
+  get_link_parents_.reset(
+      new GetLinkParentsParserObserver(&link_parent_vector_));
+  parser.AddObserver(get_link_parents_.get());
+
+  kmldom::ElementPtr root = parser.ParseLazy(kml, errors);
+  if (!root) {
+    return false;
+  }
+  kmldom::ContainerPtr container = kmldom::AsContainer(root);
+  if (kmldom::KmlPtr kml_element = kmldom::AsKml(root)) {
+    container = kmldom::AsContainer(kml_element->get_feature());
+  }
+  if (container && container->get_lazy_feature_source()) {
+    lazy_container_ = container;
+    lazy_feature_source_ = container->get_lazy_feature_source();
+  }
+  set_root(root);
+  return true;
+}
+
 // static
 KmlFile* KmlFile::CreateFromImportInternal(const kmldom::ElementPtr& element,
                                            bool strict) {
@@ -182,8 +328,11 @@ bool KmlFile::SerializeToOstream(std::ostream* xml_output) const {
   // Find all xml namespaces known to libkml used by all elements descending
   // from the root and insert the appropriate xmlns attributes to the root
   // element.  See kmlengine::FindAndInsertXmlNamespaces() for more info on
-  // how KML vs other namespaces are treated.
-  FindAndInsertXmlNamespaces(get_root());
+  // how KML vs other namespaces are treated.  Freeze() did this once for a
+  // frozen KmlFile.
+  if (!frozen_) {
+    FindAndInsertXmlNamespaces(get_root());
+  }
 
   // Append the serialization to the XML header.
   kmldom::XmlSerializer<std::ostream>::Serialize(get_root(), "\n",
@@ -201,8 +350,11 @@ bool KmlFile::SerializeToString(string* xml_output) const {
   // Find all xml namespaces known to libkml used by all elements descending
   // from the root and insert the appropriate xmlns attributes to the root
   // element.  See kmlengine::FindAndInsertXmlNamespaces() for more info on
-  // how KML vs other namespaces are treated.
-  FindAndInsertXmlNamespaces(get_root());
+  // how KML vs other namespaces are treated.  Freeze() did this once for a
+  // frozen KmlFile.
+  if (!frozen_) {
+    FindAndInsertXmlNamespaces(get_root());
+  }
 
   // Append the serialization to the XML header.
   kmldom::StringAdapter string_adapter(xml_output);
@@ -211,11 +363,93 @@ bool KmlFile::SerializeToString(string* xml_output) const {
   return true;
 }
 
+bool KmlFile::SerializeToFile(const string& filename) const {
+  return SerializeToFile(filename, kmlbase::FileWriter::Options());
+}
+
+bool KmlFile::SerializeToFile(
+    const string& filename, const kmlbase::FileWriter::Options& options) const {
+  if (!get_root()) {
+    return false;
+  }
+  boost::scoped_ptr<kmlbase::FileWriter> file_writer(
+      kmlbase::FileWriter::Open(filename, options));
+  if (!file_writer.get()) {
+    return false;
+  }
+  const string xml_header = CreateXmlHeader();
+  file_writer->write(xml_header.data(), xml_header.size());
+
+  // See SerializeToString().
+  if (!frozen_) {
+    FindAndInsertXmlNamespaces(get_root());
+  }
+
+  kmldom::XmlSerializer<kmlbase::FileWriter>::Serialize(
+      get_root(), "\n", "  ", file_writer.get());
+  return file_writer->Close();
+}
+
+// This makes the reference count of each Element it visits atomic and decodes
+// any deferred coordinates.
+class ElementFreezer : public kmldom::Serializer {
+ public:
+  virtual void SaveElement(const kmldom::ElementPtr& element) {
+    Freeze(element);
+    kmldom::Serializer::SaveElement(element);
+  }
+
+  void Freeze(const kmldom::ElementPtr& element) {
+    element->SetThreadShared();
+    if (kmldom::CoordinatesPtr coordinates =
+            kmldom::AsCoordinates(element)) {
+      coordinates->get_coordinates_array_size();
+    }
+    // Misplaced Elements are serialized but not saved.
+    for (size_t i = 0; i < element->get_misplaced_elements_array_size();
+         ++i) {
+      Freeze(element->get_misplaced_elements_array_at(i));
+    }
+  }
+};
+
+void KmlFile::Freeze() {
+  if (frozen_) {
+    return;
+  }
+  if (kmldom::ElementPtr root = get_root()) {
+    // Serializing the root parses all lazily parsed Features.
+    FindAndInsertXmlNamespaces(root);
+    ElementFreezer element_freezer;
+    element_freezer.SaveElement(root);
+  }
+  if (lazy_container_) {
+    lazy_container_->get_lazy_feature_source()->ClearObservers();
+    lazy_container_ = NULL;
+  }
+  set_thread_shared();
+  frozen_ = true;
+}
+
 kmldom::ObjectPtr KmlFile::GetObjectById(const string& id) const {
   ObjectIdMap::const_iterator find = object_id_map_.find(id);
+  if (find == object_id_map_.end() && lazy_container_) {
+    // Parsing the Feature holding the id adds its Objects to the map.
+    const size_t index = lazy_container_->FindLazyFeatureById(id);
+    if (index < lazy_container_->get_feature_array_size()) {
+      lazy_container_->get_feature_array_at(index);
+      find = object_id_map_.find(id);
+    }
+  }
   return find != object_id_map_.end() ? kmldom::AsObject(find->second) : NULL;
 }
 
+const string& KmlFile::get_lazy_parse_errors() const {
+  static const string kNoErrors;
+  return lazy_feature_source_ ? lazy_feature_source_->get_errors() :
+                                kNoErrors;
+}
+
 kmldom::StyleSelectorPtr KmlFile::GetSharedStyleById(
     const string& id) const {
   SharedStyleMap::const_iterator find = shared_style_map_.find(id);
@@ -32,6 +32,7 @@
 #include <vector>
 #include "boost/scoped_ptr.hpp"
 #include "kml/base/attributes.h"
+#include "kml/base/file.h"
 #include "kml/base/referent.h"
 #include "kml/base/xml_namespaces.h"
 #include "kml/base/util.h"
@@ -42,6 +43,10 @@
 #include "kml/engine/object_id_parser_observer.h"
 #include "kml/engine/shared_style_parser_observer.h"
 
+namespace kmlbase {
+class MappedFile;
+}
+
 namespace kmlengine {
 
 class KmlCache;
@@ -61,6 +66,43 @@ class KmlFile : public kmlbase::XmlFile {
   static KmlFile* CreateFromParse(const string& kml_or_kmz_data,
                                   string *errors);
 
+  // As CreateFromParse, but the DOM is built as selected by the given
+  // ParseOptions.  For example a type filter skips the Elements not needed,
+  // and those Elements are then also not in the maps of ids and shared
+  // styles.
+  static KmlFile* CreateFromParse(const string& kml_or_kmz_data,
+                                  const kmldom::ParseOptions& options,
+                                  string* errors);
+
+  // This creates a KmlFile from the KML or KMZ file at the given path as
+  // CreateFromParse does but without first reading the file into a string.
+  // KML is parsed directly from a memory mapping of the file.  KMZ is opened
+  // with KmzFile::OpenFromFile which reads the archive from a mapping.  On
+  // any I/O or parse errors NULL is returned and a human readable error
+  // message is saved in the supplied string.
+  static KmlFile* CreateFromFile(const string& filename, string* errors);
+  static KmlFile* CreateFromFile(const string& filename,
+                                 const kmldom::ParseOptions& options,
+                                 string* errors);
+
+  // This creates a KmlFile as CreateFromParse does but defers the parse of
+  // each Feature of the top-level <Document> or <Folder> until it is first
+  // accessed: see kmldom::Parser::ParseLazy.  The KML is retained with the
+  // KmlFile such that opening a large file costs a tokenization of it rather
+  // than the building of all its Elements.  A malformed document is rejected
+  // here as by CreateFromParse().  A Feature is parsed when it is fetched
+  // from its Container or when GetObjectById() looks up an id within it.
+  // Only the parsed Features are in the maps of ids and shared styles and in
+  // get_link_parent_vector(), and with set_strict_parse(true) duplicate ids
+  // are found only as Features are parsed.  Serializing or visiting the
+  // Container parses all its Features.  A Feature whose parse an observer
+  // terminates is reported by get_lazy_parse_errors().
+  static KmlFile* CreateFromParseLazy(const string& kml_or_kmz_data,
+                                      string* errors);
+  static KmlFile* CreateFromParseLazy(const string& kml_or_kmz_data,
+                                      const kmldom::ParseOptions& options,
+                                      string* errors);
+
   // This method is for use with NetCache CacheItem.
   static KmlFile* CreateFromString(const string& kml_or_kmz_data) {
     // Internal KML fetch/parse (styleUrl, etc) errors are quietly ignored.
@@ -81,6 +123,8 @@ class KmlFile : public kmlbase::XmlFile {
   // CreateFromImport employs a "last one wins" strategy for id duplicates.
   static KmlFile* CreateFromImportLax(const kmldom::ElementPtr& element);
 
+  virtual ~KmlFile();
+
   // This returns the root element of this KML file.
   const kmldom::ElementPtr get_root() const {
     return kmldom::AsElement(XmlFile::get_root());
@@ -103,6 +147,14 @@ class KmlFile : public kmlbase::XmlFile {
   // This does as SerializeToString() except to an ostream.
   bool SerializeToOstream(std::ostream* xml_output) const;
 
+  // This does as SerializeToString() except to the named file, which is
+  // created or truncated.  The file is written in large blocks through a
+  // kmlbase::FileWriter such that no copy of the whole document is held in
+  // memory.  Returns false if the file could not be written.
+  bool SerializeToFile(const string& filename) const;
+  bool SerializeToFile(const string& filename,
+                       const kmlbase::FileWriter::Options& options) const;
+
   // This returns the XML header including the encoding:
   // The default is this: "<?version="1.0" encoding="utf-8"?>
   const string CreateXmlHeader() const;
@@ -117,14 +169,25 @@ class KmlFile : public kmlbase::XmlFile {
   }
 
   // This returns the Object Element with the given id.  A NULL Object is
-  // returned if no Object with this id exists in the KML file.
+  // returned if no Object with this id exists in the KML file.  If the
+  // KmlFile was created with CreateFromParseLazy() the Feature holding the
+  // Object is parsed if it has not been.
   kmldom::ObjectPtr GetObjectById(const string& id) const;
 
+  // This returns the errors of the Features parsed since
+  // CreateFromParseLazy(), one per line, or an empty string if there were
+  // none: see kmldom::LazyFeatureSource::get_errors().
+  const string& get_lazy_parse_errors() const;
+
   // This returns the shared StyleSelector Element with the given id.  NULL is
   // returned if no StyleSelector with this id exists as a shared style
   // selector in the KML file.
   kmldom::StyleSelectorPtr GetSharedStyleById(const string& id) const;
 
+  const ObjectIdMap& get_object_id_map() const {
+    return object_id_map_;
+  }
+
   const SharedStyleMap& get_shared_style_map() const {
     return shared_style_map_;
   }
@@ -141,6 +204,19 @@ class KmlFile : public kmlbase::XmlFile {
     return kml_cache_;
   }
 
+  // This readies this KmlFile to be read from several threads at once.  Any
+  // Features not yet parsed lazily and any deferred coordinates are parsed,
+  // the xmlns attributes of the root are settled, and the reference counts of
+  // the KmlFile and of each Element are made atomic.  After this neither the
+  // KmlFile nor any of its Elements may be changed, but any number of threads
+  // may use their const methods, serialize the KmlFile and copy and release
+  // KmlFilePtrs and ElementPtrs to them without locking.
+  void Freeze();
+
+  bool is_frozen() const {
+    return frozen_;
+  }
+
   // Duplicate id attributes are illegal and should cause the parse to fail.
   // However, Google Earth never enforced this in its KML ingest and thus the
   // web has a lot of invalid KML. We attempt to parse this by default. A
@@ -161,6 +237,14 @@ class KmlFile : public kmlbase::XmlFile {
 
   // This is an internal method used in the static Create methods.
   bool ParseFromString(const string& kml, string* errors);
+  bool ParseFromMappedFile(kmlbase::MappedFile* mapped_file, string* errors);
+  // This is the implementation of both of the above: the KML parsed is that
+  // of the mapped_file if one is given, else that of the kml string.
+  bool ParseWithObservers(const string& kml, kmlbase::MappedFile* mapped_file,
+                          string* errors);
+  // This is as ParseFromString() for CreateFromParseLazy().  The observers
+  // are kept for the Features parsed later.
+  bool ParseLazyWithObservers(const string& kml, string* errors);
 
   // Only static Create methods can set the KmlCache.
   void set_kml_cache(KmlCache* kml_cache) {
@@ -177,6 +261,15 @@ class KmlFile : public kmlbase::XmlFile {
   ElementVector link_parent_vector_;
   KmlCache* kml_cache_;
   bool strict_parse_;
+  kmldom::ParseOptions parse_options_;
+  // These are set only by CreateFromParseLazy().  The lazy_container_ is the
+  // Container whose Features are parsed lazily.
+  boost::scoped_ptr<ObjectIdParserObserver> object_id_parser_observer_;
+  boost::scoped_ptr<SharedStyleParserObserver> shared_style_parser_observer_;
+  boost::scoped_ptr<GetLinkParentsParserObserver> get_link_parents_;
+  kmldom::ContainerPtr lazy_container_;
+  kmldom::LazyFeatureSourcePtr lazy_feature_source_;
+  bool frozen_;
   LIBKML_DISALLOW_EVIL_CONSTRUCTORS(KmlFile);
 };
 
@@ -30,8 +30,10 @@
 #include "kml/base/file.h"
 #include "kml/base/net_cache.h"
 #include "kml/base/tempfile.h"
+#include "kml/base/thread.h"
 #include "gtest/gtest.h"
 #include "kml/dom.h"
+#include "kml/engine/find.h"
 #include "kml/engine/kml_cache.h"
 
 // The following define is a convenience for testing inside Google.
@@ -242,6 +244,326 @@ TEST_F(KmlFileTest, TestCreateFromParseOfKmz) {
   VerifyIsPlacemarkWithName(kml_file_->root(), kName);
 }
 
+// Verify the CreateFromFile() static method on KML and KMZ files.
+TEST_F(KmlFileTest, TestCreateFromFile) {
+  const string kKmlSamples = string(DATADIR) + "/kml/kmlsamples.kml";
+  string kml;
+  ASSERT_TRUE(kmlbase::File::ReadFileToString(kKmlSamples, &kml));
+  KmlFilePtr expected = KmlFile::CreateFromParse(kml, NULL);
+  ASSERT_TRUE(expected);
+  string errors;
+  kml_file_ = KmlFile::CreateFromFile(kKmlSamples, &errors);
+  ASSERT_TRUE(kml_file_);
+  ASSERT_TRUE(errors.empty());
+  ASSERT_EQ(kmldom::SerializePretty(expected->get_root()),
+            kmldom::SerializePretty(kml_file_->get_root()));
+  ASSERT_EQ(expected->get_shared_style_map().size(),
+            kml_file_->get_shared_style_map().size());
+  ASSERT_TRUE(kml_file_->GetObjectById("downArrowIcon"));
+
+  kml_file_ = KmlFile::CreateFromFile(string(DATADIR) + "/kmz/doc.kmz",
+                                      &errors);
+  ASSERT_TRUE(kml_file_);
+  VerifyIsPlacemarkWithName(kml_file_->get_root(), "a.kml");
+}
+
+// Verify the CreateFromParseLazy() static method.
+TEST_F(KmlFileTest, TestCreateFromParseLazy) {
+  const string kKml(
+      "<kml><Document><Style id=\"s\"/>"
+      "<Placemark id=\"p0\"><name>0</name></Placemark>"
+      "<Folder id=\"f1\"><Placemark id=\"p1\"><name>1</name></Placemark>"
+      "<NetworkLink><Link><href>a.kml</href></Link></NetworkLink></Folder>"
+      "<Placemark id=\"p2\"><name>2</name></Placemark>"
+      "</Document></kml>");
+  string errors;
+  kml_file_ = KmlFile::CreateFromParseLazy(kKml, &errors);
+  ASSERT_TRUE(kml_file_);
+  ASSERT_TRUE(errors.empty());
+  const kmldom::DocumentPtr document = kmldom::AsDocument(
+      kmldom::AsKml(kml_file_->get_root())->get_feature());
+  ASSERT_TRUE(document->has_lazy_features());
+  ASSERT_TRUE(kml_file_->GetSharedStyleById("s"));
+  ASSERT_TRUE(kml_file_->get_link_parent_vector().empty());
+
+  // Looking up an id parses the Feature holding it.
+  PlacemarkPtr placemark = kmldom::AsPlacemark(kml_file_->GetObjectById("p1"));
+  ASSERT_TRUE(placemark);
+  ASSERT_EQ(string("1"), placemark->get_name());
+  ASSERT_EQ(document->get_feature_array_at(1), placemark->GetParent());
+  ASSERT_TRUE(kml_file_->GetObjectById("f1"));
+  ASSERT_EQ(static_cast<size_t>(1),
+            kml_file_->get_link_parent_vector().size());
+  ASSERT_FALSE(kml_file_->GetObjectById("nope"));
+  ASSERT_TRUE(document->has_lazy_features());
+
+  // Fetching a Feature adds its ids.
+  ASSERT_EQ(string("2"), document->get_feature_array_at(2)->get_name());
+  ASSERT_TRUE(kml_file_->GetObjectById("p2"));
+
+  string xml;
+  ASSERT_TRUE(kml_file_->SerializeToString(&xml));
+  ASSERT_FALSE(document->has_lazy_features());
+  KmlFilePtr expected = KmlFile::CreateFromParse(kKml, NULL);
+  string expected_xml;
+  ASSERT_TRUE(expected->SerializeToString(&expected_xml));
+  ASSERT_EQ(expected_xml, xml);
+
+  // The Elements may outlive the KmlFile.
+  kml_file_ = KmlFile::CreateFromParseLazy(kKml, NULL);
+  ElementPtr root = kml_file_->get_root();
+  kml_file_ = NULL;
+  ASSERT_EQ(string("0"), kmldom::AsDocument(kmldom::AsKml(root)->get_feature())
+                             ->get_feature_array_at(0)->get_name());
+
+  // KMZ.
+  string kmz_data;
+  KmlToKmz(kKml, &kmz_data);
+  kml_file_ = KmlFile::CreateFromParseLazy(kmz_data, &errors);
+  ASSERT_TRUE(kml_file_);
+  ASSERT_TRUE(kml_file_->GetObjectById("p2"));
+
+  ASSERT_FALSE(KmlFile::CreateFromParseLazy("<kml><Document>", &errors));
+  ASSERT_FALSE(errors.empty());
+
+  // A malformed Feature is rejected at once as by CreateFromParse() rather
+  // than dropped when it is parsed.
+  string malformed(kKml);
+  malformed.replace(malformed.find("</name>"), 7, "</nam>");
+  string lazy_errors;
+  ASSERT_FALSE(KmlFile::CreateFromParseLazy(malformed, &lazy_errors));
+  errors.clear();
+  ASSERT_FALSE(KmlFile::CreateFromParse(malformed, &errors));
+  ASSERT_FALSE(errors.empty());
+  ASSERT_EQ(errors, lazy_errors);
+
+  kml_file_ = KmlFile::CreateFromParseLazy(kKml, NULL);
+  ASSERT_TRUE(kml_file_->SerializeToString(&xml));
+  ASSERT_TRUE(kml_file_->get_lazy_parse_errors().empty());
+}
+
+TEST_F(KmlFileTest, TestCreateFromParseWithOptions) {
+  const string kKml(
+      "<kml><Document><Style id=\"s\"/>"
+      "<Placemark id=\"p0\"><name>0</name></Placemark>"
+      "<Folder id=\"f1\"><Placemark id=\"p1\"><name>1</name></Placemark>"
+      "</Folder></Document></kml>");
+  kmldom::ParseOptions options;
+  options.exclude_types.insert(kmldom::Type_StyleSelector);
+  options.exclude_types.insert(kmldom::Type_Folder);
+  string errors;
+  kml_file_ = KmlFile::CreateFromParse(kKml, options, &errors);
+  ASSERT_TRUE(kml_file_);
+  ASSERT_TRUE(errors.empty());
+  // The Elements filtered out are not in the maps.
+  ASSERT_TRUE(kml_file_->GetObjectById("p0"));
+  ASSERT_FALSE(kml_file_->GetObjectById("f1"));
+  ASSERT_FALSE(kml_file_->GetObjectById("p1"));
+  ASSERT_FALSE(kml_file_->GetSharedStyleById("s"));
+
+  // A filtered parse is not deferred.
+  kml_file_ = KmlFile::CreateFromParseLazy(kKml, options, &errors);
+  ASSERT_TRUE(kml_file_);
+  const kmldom::DocumentPtr document = kmldom::AsDocument(
+      kmldom::AsKml(kml_file_->get_root())->get_feature());
+  ASSERT_FALSE(document->has_lazy_features());
+  ASSERT_EQ(static_cast<size_t>(1), document->get_feature_array_size());
+}
+
+// Verify that the Elements of a KmlFile parsed with an Arena are in the Arena
+// and that the Arena is freed with the last of them.
+TEST_F(KmlFileTest, TestCreateFromParseWithArena) {
+  const string kKml(
+      "<kml><Document>"
+      "<Placemark id=\"p0\"><name>0</name></Placemark>"
+      "<Placemark id=\"p1\"><name>1</name></Placemark>"
+      "</Document></kml>");
+  kmldom::ArenaPtr arena = new kmldom::Arena;
+  kmldom::ParseOptions options;
+  options.arena = arena;
+  string errors;
+  kml_file_ = KmlFile::CreateFromParse(kKml, options, &errors);
+  options.arena = NULL;
+  ASSERT_TRUE(kml_file_);
+  ASSERT_TRUE(errors.empty());
+  ASSERT_LT(static_cast<size_t>(0), arena->get_allocated_size());
+  // The Arena is held by the KmlFile and each of its Elements.
+  ASSERT_LT(5, arena->get_ref_count());
+  const kmldom::ObjectPtr p1 = kml_file_->GetObjectById("p1");
+  ASSERT_TRUE(p1);
+  kml_file_ = NULL;
+  ASSERT_LT(1, arena->get_ref_count());
+  ASSERT_EQ(string("1"), kmldom::AsPlacemark(p1)->get_name());
+}
+
+// Verify Freeze() parses all that is parsed lazily and marks the KmlFile and
+// each Element as shared between threads.
+TEST_F(KmlFileTest, TestFreeze) {
+  const string kKml(
+      "<kml><Document><Style id=\"s\"/>"
+      "<Placemark id=\"p0\"><LineString>"
+      "<coordinates>1,2,3 4,5,6</coordinates></LineString></Placemark>"
+      "<Folder id=\"f1\"><Placemark id=\"p1\"><name>1</name>"
+      "<Point><coordinates>7,8</coordinates></Point></Placemark></Folder>"
+      "</Document></kml>");
+  kmldom::ParseOptions options;
+  options.defer_coordinates = true;
+  options.arena = new kmldom::Arena;
+  kml_file_ = KmlFile::CreateFromParseLazy(kKml, options, NULL);
+  ASSERT_TRUE(kml_file_);
+  ASSERT_FALSE(kml_file_->is_frozen());
+  ASSERT_FALSE(kml_file_->is_thread_shared());
+  kml_file_->Freeze();
+  ASSERT_TRUE(kml_file_->is_frozen());
+  ASSERT_TRUE(kml_file_->is_thread_shared());
+  ASSERT_TRUE(options.arena->is_thread_shared());
+  const kmldom::DocumentPtr document = kmldom::AsDocument(
+      kmldom::AsKml(kml_file_->get_root())->get_feature());
+  ASSERT_FALSE(document->has_lazy_features());
+
+  ElementVector elements;
+  GetChildElements(kml_file_->get_root(), true, &elements);
+  ASSERT_EQ(static_cast<size_t>(9), elements.size());
+  for (size_t i = 0; i < elements.size(); ++i) {
+    ASSERT_TRUE(elements[i]->is_thread_shared());
+    if (kmldom::CoordinatesPtr coordinates =
+            kmldom::AsCoordinates(elements[i])) {
+      ASSERT_FALSE(coordinates->is_deferred());
+    }
+  }
+  ASSERT_TRUE(kml_file_->GetObjectById("p1"));
+  ASSERT_TRUE(kml_file_->GetSharedStyleById("s"));
+
+  // A frozen KmlFile serializes as any other.
+  string xml;
+  ASSERT_TRUE(kml_file_->SerializeToString(&xml));
+  options.arena = NULL;
+  KmlFilePtr expected = KmlFile::CreateFromParse(kKml, options, NULL);
+  string expected_xml;
+  ASSERT_TRUE(expected->SerializeToString(&expected_xml));
+  ASSERT_EQ(expected_xml, xml);
+  xml.clear();
+  ASSERT_TRUE(kml_file_->SerializeToString(&xml));
+  ASSERT_EQ(expected_xml, xml);
+
+  // Freezing again does nothing.
+  kml_file_->Freeze();
+  ASSERT_TRUE(kml_file_->is_frozen());
+}
+
+// This reads a frozen KmlFile many times over: each pass walks all Elements,
+// looks up an id and serializes the KmlFile.  The outcome is checked after
+// all threads are done.
+class FrozenKmlFileReader : public kmlbase::Runnable {
+ public:
+  FrozenKmlFileReader(const KmlFilePtr& kml_file, const string& expected_xml,
+                      size_t expected_element_count)
+    : kml_file_(kml_file),
+      expected_xml_(expected_xml),
+      expected_element_count_(expected_element_count),
+      ok_(false) {
+  }
+
+  virtual void Run() {
+    ok_ = true;
+    for (int i = 0; i < 20; ++i) {
+      const KmlFilePtr kml_file = kml_file_;
+      ElementVector elements;
+      GetChildElements(kml_file->get_root(), true, &elements);
+      ok_ = ok_ && elements.size() == expected_element_count_;
+      // Copying the vector takes and releases a reference to each Element.
+      for (int j = 0; j < 50; ++j) {
+        ElementVector copy(elements);
+      }
+      for (size_t j = 0; j < elements.size(); ++j) {
+        const kmldom::CoordinatesPtr coordinates =
+            kmldom::AsCoordinates(elements[j]);
+        if (coordinates && coordinates->get_coordinates_array_size() > 0) {
+          coordinates->get_coordinates_array_at(0);
+        }
+      }
+      ok_ = ok_ && kml_file->GetObjectById("simple-placemark");
+      string xml;
+      ok_ = ok_ && kml_file->SerializeToString(&xml) && xml == expected_xml_;
+    }
+  }
+
+  bool ok() const {
+    return ok_;
+  }
+
+ private:
+  const KmlFilePtr& kml_file_;
+  const string& expected_xml_;
+  const size_t expected_element_count_;
+  bool ok_;
+};
+
+// Verify many threads may read one frozen KmlFile at once.
+TEST_F(KmlFileTest, TestFreezeReadFromThreads) {
+  string kml;
+  ASSERT_TRUE(kmlbase::File::ReadFileToString(
+      string(DATADIR) + "/kml/kmlsamples.kml", &kml));
+  kmldom::ParseOptions options;
+  options.defer_coordinates = true;
+  string expected_xml;
+  KmlFilePtr expected = KmlFile::CreateFromParse(kml, options, NULL);
+  ASSERT_TRUE(expected);
+  ASSERT_TRUE(expected->SerializeToString(&expected_xml));
+  const size_t element_count =
+      GetChildElements(expected->get_root(), true, NULL);
+
+  options.arena = new kmldom::Arena;
+  kml_file_ = KmlFile::CreateFromParseLazy(kml, options, NULL);
+  options.arena = NULL;
+  ASSERT_TRUE(kml_file_);
+  kml_file_->Freeze();
+  const ElementPtr root = kml_file_->get_root();
+  const int root_ref_count = root->get_ref_count();
+  const int kml_file_ref_count = kml_file_->get_ref_count();
+
+  const size_t kThreadCount = 8;
+  std::vector<FrozenKmlFileReader*> readers;
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    readers.push_back(new FrozenKmlFileReader(kml_file_, expected_xml,
+                                              element_count));
+  }
+  kmlbase::RunInParallel(
+      std::vector<kmlbase::Runnable*>(readers.begin(), readers.end()),
+      kThreadCount);
+  size_t ok_count = 0;
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    ok_count += readers[i]->ok();
+    delete readers[i];
+  }
+  ASSERT_EQ(kThreadCount, ok_count);
+  // Every reference taken by a reader was released.
+  ASSERT_EQ(root_ref_count, root->get_ref_count());
+  ASSERT_EQ(kml_file_ref_count, kml_file_->get_ref_count());
+}
+
+// Verify the CreateFromFile() static method on bad files.
+TEST_F(KmlFileTest, TestCreateFromBadFile) {
+  string errors;
+  ASSERT_FALSE(KmlFile::CreateFromFile(
+      string(DATADIR) + "/kml/nosuchfile.kml", &errors));
+  ASSERT_FALSE(errors.empty());
+  errors.clear();
+  ASSERT_FALSE(KmlFile::CreateFromFile(string(DATADIR) + "/kmz/bad.kmz",
+                                       &errors));
+  ASSERT_FALSE(errors.empty());
+  // A KMZ read from a mapping of the file reports its failures too.
+  const string kNoKml(string(DATADIR) + "/kmz/nokml.kmz");
+  errors.clear();
+  ASSERT_FALSE(KmlFile::CreateFromFile(kNoKml, &errors));
+  ASSERT_EQ("no KML in KMZ " + kNoKml, errors);
+  const string kBadPkData(string(DATADIR) + "/kmz/bad-pk-data.kmz");
+  errors.clear();
+  ASSERT_FALSE(KmlFile::CreateFromFile(kBadPkData, &errors));
+  ASSERT_EQ("no KML in KMZ " + kBadPkData, errors);
+  ASSERT_FALSE(KmlFile::CreateFromFile(kNoKml, NULL));
+}
+
 // Verify that GetParentLinkParserObservers finds all kinds of parents of
 // links in a KML file.
 TEST_F(KmlFileTest, TestGetLinkParents) {
@@ -468,4 +790,32 @@ TEST_F(KmlFileTest, TestBasicSerializeToOstream) {
   ASSERT_EQ(kExpected, kActual);
 }
 
+TEST_F(KmlFileTest, TestSerializeToFile) {
+  kml_file_ = KmlFile::CreateFromString(
+      "<Document><gx:Tour><atom:author/></gx:Tour>"
+      "<Placemark><Point><coordinates>1,2 3,4</coordinates></Point>"
+      "</Placemark></Document>");
+  ASSERT_TRUE(kml_file_);
+  string expected;
+  ASSERT_TRUE(kml_file_->SerializeToString(&expected));
+  kmlbase::TempFilePtr tempfile = kmlbase::TempFile::CreateTempFile();
+  ASSERT_TRUE(tempfile);
+  ASSERT_TRUE(kml_file_->SerializeToFile(tempfile->name()));
+  string actual;
+  ASSERT_TRUE(kmlbase::File::ReadFileToString(tempfile->name(), &actual));
+  ASSERT_EQ(expected, actual);
+
+  // The options of the FileWriter make no difference to the content.
+  kmlbase::FileWriter::Options options;
+  options.block_size = 16;
+  options.direct_io = true;
+  options.drop_cache = true;
+  ASSERT_TRUE(kml_file_->SerializeToFile(tempfile->name(), options));
+  ASSERT_TRUE(kmlbase::File::ReadFileToString(tempfile->name(), &actual));
+  ASSERT_EQ(expected, actual);
+
+  ASSERT_FALSE(kml_file_->SerializeToFile(""));
+  ASSERT_FALSE(kml_file_->SerializeToFile(DATADIR));
+}
+
 }  // end namespace kmlengine
@@ -37,6 +37,12 @@ namespace kmlengine {
 
 KmlStream* KmlStream::ParseFromIstream(
     std::istream* input, string* errors, ParserObserver* observer) {
+  return ParseFromIstream(input, errors, observer, kmldom::ParseOptions());
+}
+
+KmlStream* KmlStream::ParseFromIstream(
+    std::istream* input, string* errors, ParserObserver* observer,
+    const kmldom::ParseOptions& options) {
   if (!input) {
     return NULL;
   }
@@ -46,7 +52,7 @@ KmlStream* KmlStream::ParseFromIstream(
   if (observer) {
     observers.push_back(observer);
   }
-  kmldom::KmlHandler kml_handler(observers);
+  kmldom::KmlHandler kml_handler(observers, options);
 
   // Perform buffered parse
   kmlbase::ExpatParser parser(&kml_handler, false);
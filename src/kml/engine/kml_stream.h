@@ -52,6 +52,12 @@ class KmlStream : public kmlbase::XmlFile {
   static KmlStream* ParseFromIstream(std::istream* input, string* errors,
                                      kmldom::ParserObserver* observer);
 
+  // As above, but the DOM is built as selected by the given ParseOptions.
+  // For example a type filter skips the Elements not needed.
+  static KmlStream* ParseFromIstream(std::istream* input, string* errors,
+                                     kmldom::ParserObserver* observer,
+                                     const kmldom::ParseOptions& options);
+
   // This returns the root element of this KML stream.
   const kmldom::ElementPtr get_root() const {
     return kmldom::AsElement(XmlFile::get_root());
@@ -183,4 +183,24 @@ TEST(KmlStreamTest, TestParseFromIstreamWithObserver) {
   ASSERT_EQ(kFeatureCount + 1, parser_observer.get_feature_count());
 }
 
+TEST(KmlStreamTest, TestParseFromIstreamWithOptions) {
+  std::istringstream string_stream(
+    "<Placemark>"
+    "<name>hello</name>"
+    "<description><![CDATA[<h1>big</h1>]]></description>"
+    "<Point><coordinates>1,2,3</coordinates></Point>"
+    "</Placemark>");
+  kmldom::ParseOptions options;
+  options.exclude_types.insert(kmldom::Type_description);
+  options.exclude_types.insert(kmldom::Type_Geometry);
+  boost::scoped_ptr<KmlStream> kml_stream(
+      KmlStream::ParseFromIstream(&string_stream, NULL, NULL, options));
+  ASSERT_TRUE(kml_stream.get());
+  PlacemarkPtr placemark = AsPlacemark(kml_stream->get_root());
+  ASSERT_TRUE(placemark);
+  ASSERT_EQ(string("hello"), placemark->get_name());
+  ASSERT_FALSE(placemark->has_description());
+  ASSERT_FALSE(placemark->has_geometry());
+}
+
 }  // end namespace kmlengine
@@ -53,7 +53,8 @@ class KmzFile : public kmlbase::Referent {
 
   // Open a KMZ file from a file path. Returns a pointer to a KmzFile object
   // if the file could be opened and read, and the data was recognizably KMZ.
-  // Otherwise returns NULL.
+  // Otherwise returns NULL.  The file is memory mapped where possible and
+  // archived files are read directly from the mapping.
   static KmzFile* OpenFromFile(const char* kmz_filepath);
 
   // Open a KMZ file from a string. Returns a pointer to a KmzFile object if a
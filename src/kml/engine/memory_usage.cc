@@ -0,0 +1,247 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of the ComputeMemoryUsage()
+// function.
+
+#include "kml/engine/memory_usage.h"
+#include <vector>
+#include "kml/base/attributes.h"
+#include "kml/dom/serializer.h"
+#include "kml/dom/xsd.h"
+#include "kml/engine/kml_file.h"
+
+using kmlbase::Attributes;
+using kmldom::Element;
+using kmldom::ElementPtr;
+using kmldom::KmlDomType;
+
+namespace kmlengine {
+
+// Private.  The bytes of a std::map node beyond its value: the color and the
+// parent, left and right links.
+static const size_t kMapNodeBytes = 4 * sizeof(void*);
+
+// Private.  This returns the size of the object of the given type.
+static size_t GetObjectBytes(KmlDomType type_id) {
+  return kmldom::KmlFactory::GetFactory()->GetElementSize(type_id);
+}
+
+// Private.  This returns the heap storage of the string.
+static size_t GetStringBytes(const string& value) {
+  static const size_t kInlineCapacity = string().capacity();
+  return value.capacity() > kInlineCapacity ? value.capacity() + 1 : 0;
+}
+
+// Private.  This returns the bytes of the Attributes and the strings in it.
+static size_t GetAttributesBytes(const Attributes* attributes) {
+  if (!attributes) {
+    return 0;
+  }
+  size_t bytes = sizeof(Attributes);
+  kmlbase::StringMapIterator iter = attributes->CreateIterator();
+  for (; !iter.AtEnd(); iter.Advance()) {
+    bytes += kMapNodeBytes + 2 * sizeof(string) +
+        GetStringBytes(iter.Data().first) + GetStringBytes(iter.Data().second);
+  }
+  return bytes;
+}
+
+// Private.  This returns the bytes of the nodes of the map and their keys.
+template<class M>
+static size_t GetMapBytes(const M& map) {
+  size_t bytes = map.size() * (kMapNodeBytes + sizeof(typename M::value_type));
+  typename M::const_iterator iter = map.begin();
+  for (; iter != map.end(); ++iter) {
+    bytes += GetStringBytes(iter->first);
+  }
+  return bytes;
+}
+
+// This Serializer gathers the ElementMemoryUsage of the Elements saved to
+// it.  The Element itself is accounted for in BeginById() and the fields
+// and content saved between it and End() are accounted to it.  A misplaced
+// Element is serialized directly by its parent without SaveElement() and is
+// taken from the parent instead.  A lazy Feature yet to be parsed is
+// accounted for as its KML and is left unparsed.
+class MemoryUsageSerializer : public kmldom::Serializer {
+ public:
+  MemoryUsageSerializer(MemoryUsage* memory_usage)
+    : memory_usage_(memory_usage),
+      element_usage_(&memory_usage->element_usage),
+      next_element_(NULL),
+      unknown_count_(0) {
+  }
+
+  virtual void SaveElement(const ElementPtr& element) {
+    next_element_ = element.get();
+    Serializer::SaveElement(element);
+  }
+
+  virtual void BeginById(int type_id, const Attributes& attributes) {
+    const Element* element = next_element_;
+    next_element_ = NULL;
+    if (!element) {
+      Frame& parent = stack_.back();
+      element = parent.element->get_misplaced_elements_array_at(
+          parent.misplaced_index++).get();
+    }
+    Frame frame;
+    frame.element = element;
+    frame.usage = &(*element_usage_)[element->Type()];
+    frame.misplaced_index = 0;
+    stack_.push_back(frame);
+    ElementMemoryUsage* usage = frame.usage;
+
+    ++usage->element_count;
+    usage->object_bytes += GetObjectBytes(element->Type());
+    usage->string_bytes += GetStringBytes(element->get_char_data());
+
+    // The unknown attributes and the xmlns attributes are merged into the
+    // attributes serialized.  The rest are held by the Element as strings.
+    const Attributes* unknown_attributes = element->GetUnknownAttributes();
+    const Attributes* xmlns = element->GetXmlns();
+    usage->attribute_bytes += GetAttributesBytes(unknown_attributes) +
+        GetAttributesBytes(xmlns);
+    kmlbase::StringMapIterator iter = attributes.CreateIterator();
+    for (; !iter.AtEnd(); iter.Advance()) {
+      const string& key = iter.Data().first;
+      if ((unknown_attributes && unknown_attributes->FindValue(key, NULL)) ||
+          key.compare(0, 5, "xmlns") == 0) {
+        continue;
+      }
+      usage->string_bytes += GetStringBytes(iter.Data().second);
+    }
+
+    usage->unknown_bytes += element->GetExtensionBytes();
+    size_t unknown_size = element->get_unknown_elements_array_size();
+    for (size_t i = 0; i < unknown_size; ++i) {
+      usage->unknown_bytes += sizeof(string) +
+          GetStringBytes(element->get_unknown_elements_array_at(i));
+    }
+    usage->unknown_bytes +=
+        element->get_misplaced_elements_array_size() * sizeof(ElementPtr);
+
+    if (element->Type() == kmldom::Type_coordinates) {
+      usage->coordinates_bytes += static_cast<const kmldom::Coordinates*>(
+          element)->GetAllocatedBytes();
+    }
+  }
+
+  virtual void End() {
+    stack_.pop_back();
+  }
+
+  virtual void SaveStringFieldById(int type_id, string value) {
+    // Enumerations, numbers and bools are not held as strings.
+    if (xsd_.IsStringElement(type_id)) {
+      stack_.back().usage->string_bytes += GetStringBytes(value);
+    }
+  }
+
+  virtual void SaveContent(const string& content, bool maybe_quote) {
+    // The unknown elements are accounted for in BeginById().
+    if (unknown_count_ > 0) {
+      --unknown_count_;
+      return;
+    }
+    stack_.back().usage->string_bytes += GetStringBytes(content);
+  }
+
+  // The unchanged character data of deferred <coordinates> is accounted for
+  // in BeginById().  Saying it is saved keeps it from being decoded.
+  virtual bool SaveCoordinatesText(const string& char_data) {
+    return true;
+  }
+
+  // Saying an unparsed Feature is saved keeps it from being parsed.
+  virtual bool SaveUnparsedFeature(size_t kml_size) {
+    ++memory_usage_->unparsed_feature_count;
+    memory_usage_->unparsed_feature_bytes += kml_size;
+    return true;
+  }
+
+  // The tuples of <coordinates> are accounted for in BeginById().
+  virtual void SaveVec3(const kmlbase::Vec3& vec3) {
+  }
+
+  // The tuples of <gx:coord> are held in a std::vector<kmlbase::Vec3>.
+  virtual void SaveSimpleVec3(int type_id, const kmlbase::Vec3& vec3,
+                              const string& delimiter) {
+    stack_.back().usage->coordinates_bytes += sizeof(kmlbase::Vec3);
+  }
+
+  virtual void BeginElementArray(int type_id, size_t element_count) {
+    if (type_id == kmldom::Type_Unknown) {
+      unknown_count_ = element_count;
+    }
+  }
+
+ private:
+  struct Frame {
+    const Element* element;
+    ElementMemoryUsage* usage;
+    size_t misplaced_index;
+  };
+  MemoryUsage* memory_usage_;
+  ElementMemoryUsageMap* element_usage_;
+  const Element* next_element_;
+  std::vector<Frame> stack_;
+  size_t unknown_count_;
+};
+
+ElementMemoryUsage MemoryUsage::GetElementTotal() const {
+  ElementMemoryUsage total;
+  ElementMemoryUsageMap::const_iterator iter = element_usage.begin();
+  for (; iter != element_usage.end(); ++iter) {
+    const ElementMemoryUsage& usage = iter->second;
+    total.element_count += usage.element_count;
+    total.object_bytes += usage.object_bytes;
+    total.string_bytes += usage.string_bytes;
+    total.coordinates_bytes += usage.coordinates_bytes;
+    total.unknown_bytes += usage.unknown_bytes;
+    total.attribute_bytes += usage.attribute_bytes;
+  }
+  return total;
+}
+
+size_t MemoryUsage::GetTotal() const {
+  return GetElementTotal().GetTotal() + unparsed_feature_bytes +
+      object_id_map_bytes + shared_style_map_bytes + link_parent_vector_bytes;
+}
+
+MemoryUsage ComputeMemoryUsage(const KmlFile& kml_file) {
+  MemoryUsage memory_usage;
+  MemoryUsageSerializer serializer(&memory_usage);
+  serializer.SaveElement(kml_file.get_root());
+  memory_usage.object_id_map_bytes = GetMapBytes(kml_file.get_object_id_map());
+  memory_usage.shared_style_map_bytes =
+      GetMapBytes(kml_file.get_shared_style_map());
+  memory_usage.link_parent_vector_bytes =
+      kml_file.get_link_parent_vector().capacity() * sizeof(ElementPtr);
+  return memory_usage;
+}
+
+}  // end namespace kmlengine
@@ -0,0 +1,114 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the declaration of the ComputeMemoryUsage() function
+// which accounts for the memory held by a KmlFile.
+
+#ifndef KML_ENGINE_MEMORY_USAGE_H__
+#define KML_ENGINE_MEMORY_USAGE_H__
+
+#include <map>
+#include "kml/dom.h"
+
+namespace kmlengine {
+
+class KmlFile;
+
+// The bytes held by all Elements of one KmlDomType.  The heap storage of a
+// string is taken to be its capacity and terminator if it does not fit in
+// the string itself.  The bytes of the allocator's own bookkeeping are not
+// counted.
+struct ElementMemoryUsage {
+  ElementMemoryUsage()
+    : element_count(0),
+      object_bytes(0),
+      string_bytes(0),
+      coordinates_bytes(0),
+      unknown_bytes(0),
+      attribute_bytes(0) {
+  }
+
+  size_t GetTotal() const {
+    return object_bytes + string_bytes + coordinates_bytes + unknown_bytes +
+        attribute_bytes;
+  }
+
+  size_t element_count;
+  // The Element objects themselves.
+  size_t object_bytes;
+  // The heap storage of the string fields, attributes and character data.
+  size_t string_bytes;
+  // The storage of the tuples of <coordinates> and <gx:coord>.  Storage
+  // shared with a clone (see Clone()) is counted for each <coordinates>.
+  size_t coordinates_bytes;
+  // The unknown and misplaced elements and the block holding them.
+  size_t unknown_bytes;
+  // The maps of the unknown attributes and the xmlns attributes.
+  size_t attribute_bytes;
+};
+
+typedef std::map<kmldom::KmlDomType, ElementMemoryUsage> ElementMemoryUsageMap;
+
+// The memory held by a KmlFile.
+struct MemoryUsage {
+  MemoryUsage()
+    : unparsed_feature_count(0),
+      unparsed_feature_bytes(0),
+      object_id_map_bytes(0),
+      shared_style_map_bytes(0),
+      link_parent_vector_bytes(0) {
+  }
+
+  // This returns the sum over all KmlDomTypes.
+  ElementMemoryUsage GetElementTotal() const;
+
+  // This returns the bytes of the Elements, the KML of the unparsed Features
+  // and the maps of the KmlFile.
+  size_t GetTotal() const;
+
+  // The Elements by their KmlDomType.
+  ElementMemoryUsageMap element_usage;
+  // The Features of a KmlFile from KmlFile::CreateFromParseLazy() which are
+  // yet to be parsed, and the bytes of their KML in the document retained
+  // for them.
+  size_t unparsed_feature_count;
+  size_t unparsed_feature_bytes;
+  // The maps of ids and shared styles and the vector of link parents held
+  // by the KmlFile, less the Elements they refer to.
+  size_t object_id_map_bytes;
+  size_t shared_style_map_bytes;
+  size_t link_parent_vector_bytes;
+};
+
+// This walks the DOM of the KmlFile and returns the memory held by it.  The
+// walk neither changes the KmlFile, decodes deferred <coordinates> nor
+// parses lazy Features, but it does take time proportional to the size of
+// the DOM.  Strings shared by the Elements of an Arena are counted for each
+// Element holding them.
+MemoryUsage ComputeMemoryUsage(const KmlFile& kml_file);
+
+}  // end namespace kmlengine
+
+#endif  // KML_ENGINE_MEMORY_USAGE_H__
@@ -0,0 +1,196 @@
+// Copyright 2008, Google Inc. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//  3. Neither the name of Google Inc. nor the names of its contributors may be
+//     used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+// EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the unit tests for the ComputeMemoryUsage() function.
+
+#include "kml/engine/memory_usage.h"
+#include "gtest/gtest.h"
+#include "kml/dom.h"
+#include "kml/engine/kml_file.h"
+
+using kmldom::CoordinatesPtr;
+using kmldom::KmlDomType;
+using kmldom::PlacemarkPtr;
+
+namespace kmlengine {
+
+class MemoryUsageTest : public testing::Test {
+ protected:
+  const ElementMemoryUsage& GetUsage(KmlDomType type_id) {
+    return memory_usage_.element_usage[type_id];
+  }
+
+  KmlFilePtr kml_file_;
+  MemoryUsage memory_usage_;
+};
+
+TEST_F(MemoryUsageTest, TestEmpty) {
+  kml_file_ = KmlFile::CreateFromParse("<kml/>", NULL);
+  ASSERT_TRUE(kml_file_);
+  memory_usage_ = ComputeMemoryUsage(*kml_file_);
+  ASSERT_EQ(static_cast<size_t>(1), memory_usage_.element_usage.size());
+  ASSERT_EQ(static_cast<size_t>(1), GetUsage(kmldom::Type_kml).element_count);
+  ASSERT_EQ(sizeof(kmldom::Kml), GetUsage(kmldom::Type_kml).object_bytes);
+  ASSERT_EQ(sizeof(kmldom::Kml), memory_usage_.GetTotal());
+}
+
+TEST_F(MemoryUsageTest, TestElements) {
+  const string kLongName(100, 'x');
+  kml_file_ = KmlFile::CreateFromParse(
+      "<kml><Document>"
+      "<Style id=\"s\"/>"
+      "<Placemark id=\"p0\"><name>" + kLongName + "</name>"
+      "<styleUrl>#s</styleUrl>"
+      "<Point><coordinates>1,2,3 4,5,6</coordinates></Point></Placemark>"
+      "<Placemark id=\"p1\"><name>short</name>"
+      "<Point><coordinates>7,8</coordinates></Point></Placemark>"
+      "</Document></kml>", NULL);
+  ASSERT_TRUE(kml_file_);
+  memory_usage_ = ComputeMemoryUsage(*kml_file_);
+  ASSERT_EQ(static_cast<size_t>(6), memory_usage_.element_usage.size());
+
+  const ElementMemoryUsage& placemark = GetUsage(kmldom::Type_Placemark);
+  ASSERT_EQ(static_cast<size_t>(2), placemark.element_count);
+  ASSERT_EQ(2 * sizeof(kmldom::Placemark), placemark.object_bytes);
+  // Only the long name is not held within the string.
+  ASSERT_LE(kLongName.size() + 1, placemark.string_bytes);
+  ASSERT_GT(2 * kLongName.size(), placemark.string_bytes);
+  ASSERT_EQ(static_cast<size_t>(0), placemark.coordinates_bytes);
+  ASSERT_EQ(static_cast<size_t>(0), placemark.unknown_bytes);
+  ASSERT_EQ(static_cast<size_t>(0), placemark.attribute_bytes);
+
+  const ElementMemoryUsage& coordinates = GetUsage(kmldom::Type_coordinates);
+  ASSERT_EQ(static_cast<size_t>(2), coordinates.element_count);
+  ASSERT_LE(3 * sizeof(kmlbase::Vec3), coordinates.coordinates_bytes);
+  ASSERT_EQ(static_cast<size_t>(0), coordinates.string_bytes);
+
+  ASSERT_EQ(static_cast<size_t>(2), GetUsage(kmldom::Type_Point).element_count);
+  ASSERT_EQ(static_cast<size_t>(1), GetUsage(kmldom::Type_Style).element_count);
+
+  // The ids of the Style and the Placemarks.
+  ASSERT_LT(static_cast<size_t>(0), memory_usage_.object_id_map_bytes);
+  ASSERT_LT(static_cast<size_t>(0), memory_usage_.shared_style_map_bytes);
+  ASSERT_LT(memory_usage_.shared_style_map_bytes,
+            memory_usage_.object_id_map_bytes);
+
+  const ElementMemoryUsage total = memory_usage_.GetElementTotal();
+  ASSERT_EQ(static_cast<size_t>(9), total.element_count);
+  ASSERT_EQ(total.GetTotal() + memory_usage_.object_id_map_bytes +
+            memory_usage_.shared_style_map_bytes +
+            memory_usage_.link_parent_vector_bytes,
+            memory_usage_.GetTotal());
+}
+
+// A string field is counted whatever its value and a number never is.
+TEST_F(MemoryUsageTest, TestFieldStorage) {
+  const string kLongNumber(100, '1');
+  kml_file_ = KmlFile::CreateFromParse(
+      "<kml><Placemark><name>" + kLongNumber + "</name>"
+      "<description>-</description>"
+      "<visibility>0</visibility><open>1</open></Placemark></kml>", NULL);
+  ASSERT_TRUE(kml_file_);
+  memory_usage_ = ComputeMemoryUsage(*kml_file_);
+  const ElementMemoryUsage& placemark = GetUsage(kmldom::Type_Placemark);
+  ASSERT_LE(kLongNumber.size() + 1, placemark.string_bytes);
+  ASSERT_GT(2 * kLongNumber.size(), placemark.string_bytes);
+}
+
+TEST_F(MemoryUsageTest, TestUnknown) {
+  kml_file_ = KmlFile::CreateFromParse(
+      "<kml xmlns=\"http://www.opengis.net/kml/2.2\">"
+      "<Placemark unknown=\"attribute\"><Document/>"
+      "<unknown>some unknown element</unknown></Placemark></kml>", NULL);
+  ASSERT_TRUE(kml_file_);
+  memory_usage_ = ComputeMemoryUsage(*kml_file_);
+  const ElementMemoryUsage& placemark = GetUsage(kmldom::Type_Placemark);
+  ASSERT_EQ(static_cast<size_t>(1), placemark.element_count);
+  ASSERT_LT(static_cast<size_t>(0), placemark.unknown_bytes);
+  ASSERT_LT(sizeof(kmlbase::Attributes), placemark.attribute_bytes);
+  // The misplaced Document is found.
+  ASSERT_EQ(static_cast<size_t>(1),
+            GetUsage(kmldom::Type_Document).element_count);
+  // The xmlns of <kml> is accounted to the Kml.
+  ASSERT_LT(sizeof(kmlbase::Attributes),
+            GetUsage(kmldom::Type_kml).attribute_bytes);
+}
+
+TEST_F(MemoryUsageTest, TestDeferredCoordinates) {
+  kmldom::ParseOptions options;
+  options.defer_coordinates = true;
+  kml_file_ = KmlFile::CreateFromParse(
+      "<kml><Placemark><LineString><coordinates>"
+      "1.1,2.2,3.3 4.4,5.5,6.6 7.7,8.8,9.9"
+      "</coordinates></LineString></Placemark></kml>", options, NULL);
+  ASSERT_TRUE(kml_file_);
+  memory_usage_ = ComputeMemoryUsage(*kml_file_);
+  const ElementMemoryUsage& coordinates = GetUsage(kmldom::Type_coordinates);
+  ASSERT_EQ(static_cast<size_t>(1), coordinates.element_count);
+  // The character data is held and the tuples are not decoded.
+  ASSERT_LT(static_cast<size_t>(0), coordinates.string_bytes);
+  ASSERT_EQ(static_cast<size_t>(0), coordinates.coordinates_bytes);
+  const PlacemarkPtr placemark = kmldom::AsPlacemark(
+      kmldom::AsKml(kml_file_->get_root())->get_feature());
+  const CoordinatesPtr coordinates_element = kmldom::AsLineString(
+      placemark->get_geometry())->get_coordinates();
+  ASSERT_TRUE(coordinates_element->is_deferred());
+}
+
+TEST_F(MemoryUsageTest, TestLazyFeatures) {
+  const string kPlacemark0("<Placemark id=\"p0\"><name>a</name></Placemark>");
+  const string kPlacemark1("<Placemark><Point><coordinates>1,2"
+                           "</coordinates></Point></Placemark>");
+  kml_file_ = KmlFile::CreateFromParseLazy(
+      "<kml><Document><name>d</name>" + kPlacemark0 + kPlacemark1 +
+      "</Document></kml>", NULL);
+  ASSERT_TRUE(kml_file_);
+  memory_usage_ = ComputeMemoryUsage(*kml_file_);
+  // The unparsed Features are counted as their KML and are not parsed.
+  ASSERT_EQ(static_cast<size_t>(2), memory_usage_.unparsed_feature_count);
+  ASSERT_EQ(kPlacemark0.size() + kPlacemark1.size(),
+            memory_usage_.unparsed_feature_bytes);
+  ASSERT_EQ(static_cast<size_t>(0),
+            GetUsage(kmldom::Type_Placemark).element_count);
+  ASSERT_EQ(static_cast<size_t>(1),
+            GetUsage(kmldom::Type_Document).element_count);
+  const kmldom::DocumentPtr document = kmldom::AsDocument(
+      kmldom::AsKml(kml_file_->get_root())->get_feature());
+  ASSERT_TRUE(document->has_lazy_features());
+  ASSERT_EQ(memory_usage_.GetElementTotal().GetTotal() +
+            memory_usage_.unparsed_feature_bytes +
+            memory_usage_.object_id_map_bytes +
+            memory_usage_.shared_style_map_bytes +
+            memory_usage_.link_parent_vector_bytes,
+            memory_usage_.GetTotal());
+
+  // A parsed Feature is counted as its Elements.
+  ASSERT_TRUE(document->get_feature_array_at(1));
+  memory_usage_ = ComputeMemoryUsage(*kml_file_);
+  ASSERT_EQ(static_cast<size_t>(1), memory_usage_.unparsed_feature_count);
+  ASSERT_EQ(kPlacemark0.size(), memory_usage_.unparsed_feature_bytes);
+  ASSERT_EQ(static_cast<size_t>(1),
+            GetUsage(kmldom::Type_Placemark).element_count);
+}
+
+}  // end namespace kmlengine